@@ -0,0 +1,59 @@
+// Markers are measured even in release builds
+#define D3D_TOOLS_ENABLE_ANNOTATIONS 1
+
+#include <string>
+#include <vector>
+#include "D3D_Tools/Annotation.h"
+#include "Benchmark.h"
+
+using namespace d3d_tools;
+using namespace d3d_tools_benchmarks;
+
+int main(int argc, char** argv) {
+    auto options = ParseOptions(argc, argv);
+    size_t markersCount = options.quick ? 1000 : 1000000;
+    size_t repeats = options.quick ? 1 : 5;
+
+    Device::CreateParams params{};
+    params.debugDevice = false;
+    Device device(params);
+
+    // Runtime titles, as in per-object markers
+    std::vector<std::wstring> titles;
+    for (size_t i = 0; i < 256; ++i) {
+        titles.push_back(L"Object " + std::to_wstring(i));
+    }
+
+    auto seconds = Measure(repeats, [&] {
+        for (size_t i = 0; i < markersCount; ++i) {
+            D3D_TOOLS_SCOPED_ANNOTATION(&device, L"Constant title");
+        }
+    });
+    Report("Interned once per call site", seconds, double(markersCount), "markers");
+
+    seconds = Measure(repeats, [&] {
+        for (size_t i = 0; i < markersCount; ++i) {
+            auto annotation = CreateScopedAnnotation(&device, titles[i % titles.size()].c_str());
+        }
+    });
+    Report("Runtime title", seconds, double(markersCount), "markers");
+
+    seconds = Measure(repeats, [&] {
+        for (size_t i = 0; i < markersCount; ++i) {
+            ScopedAnnotation annotation(&device, InternAnnotationLabel(titles[i % titles.size()]));
+        }
+    });
+    Report("Runtime title, interned per marker", seconds, double(markersCount), "markers");
+
+    GpuProfiler profiler(&device);
+    seconds = Measure(repeats, [&] {
+        profiler.BeginFrame();
+        for (size_t i = 0; i < markersCount; ++i) {
+            D3D_TOOLS_SCOPED_PROFILE_ANNOTATION(&device, &profiler, L"Profiled title");
+        }
+        profiler.EndFrame();
+    });
+    Report("Interned once per call site, profiled", seconds, double(markersCount), "markers");
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "D3D_Tools/AssetContainer.h"
+#include "Benchmark.h"
+
+using namespace d3d_tools;
+using namespace d3d_tools_benchmarks;
+
+namespace {
+    // Reads every chunk through the mapping, as texture and buffer creation would
+    uint64_t TouchAssets(const AssetContainer& container) {
+        uint64_t sum = 0;
+        auto touch = [&sum](const void* data, uint64_t size) {
+            auto bytes = static_cast<const uint8_t*>(data);
+            for (uint64_t i = 0; i < size; i += 64) {
+                sum += bytes[i];
+            }
+        };
+        for (size_t i = 0; i < container.GetAssetsCount(); ++i) {
+            switch (container.GetAssetType(i)) {
+            case AssetType::Texture:
+                for (auto& subresource : container.GetTexture(i).subresources) {
+                    touch(subresource.data, subresource.size);
+                }
+                break;
+            case AssetType::VertexStream: {
+                auto stream = container.GetVertexStream(i);
+                touch(stream.data, uint64_t(stream.vertexCount) * stream.stride);
+                break;
+            }
+            case AssetType::IndexStream: {
+                auto stream = container.GetIndexStream(i);
+                touch(stream.data, uint64_t(stream.indexCount) * stream.indexSize);
+                break;
+            }
+            case AssetType::Shader: {
+                auto shader = container.GetShader(i);
+                touch(shader.bytecode, shader.size);
+                break;
+            }
+            }
+        }
+        return sum;
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = ParseOptions(argc, argv);
+    uint32_t meshesCount = options.quick ? 16 : 2000;
+    uint32_t texturesCount = options.quick ? 4 : 200;
+    uint32_t textureSize = options.quick ? 64 : 512;
+    size_t repeats = options.quick ? 1 : 10;
+
+    // A level's worth of assets: meshes of 32 byte vertices with 32 bit indices, BC1 textures with full mip chains
+    std::vector<uint8_t> vertices(4096 * 32, 1);
+    std::vector<uint8_t> indices(12288 * 4, 2);
+    std::vector<uint8_t> bytecode(4096, 3);
+    TextureAssetDesc textureDesc{ textureSize, textureSize, ComputeMipLevelsCount(textureSize, textureSize), 1, TextureFormat::BC1_UNORM };
+    std::vector<std::vector<uint8_t>> texels;
+    std::vector<AssetSubresource> subresources;
+    for (uint32_t mip = 0; mip < textureDesc.mipLevels; ++mip) {
+        auto extent = ComputeMipExtent(textureSize, mip);
+        texels.emplace_back(ComputeSlicePitch(textureDesc.format, extent, extent), uint8_t(mip));
+    }
+    for (auto& mip : texels) {
+        subresources.push_back(AssetSubresource{ mip.data(), mip.size(), 0, 0 });
+    }
+
+    AssetContainerWriter writer;
+    std::vector<VertexElement> elements{
+        VertexElement{ "POSITION", 0, VertexFormat::R32_G32_B32_FLOAT, 0, 12 },
+        VertexElement{ "NORMAL", 0, VertexFormat::R32_G32_B32_FLOAT, 12, 12 },
+        VertexElement{ "TEXCOORD", 0, VertexFormat::R32_G32_FLOAT, 24, 8 } };
+    for (uint32_t i = 0; i < meshesCount; ++i) {
+        auto name = "mesh" + std::to_string(i);
+        writer.AddVertexStream(name + "/vertices", 4096, 32, elements, vertices.data());
+        writer.AddIndexStream(name + "/indices", 12288, 4, indices.data());
+    }
+    for (uint32_t i = 0; i < texturesCount; ++i) {
+        writer.AddTexture("texture" + std::to_string(i), textureDesc, subresources);
+        writer.AddShader("shader" + std::to_string(i), 0, bytecode.data(), bytecode.size());
+    }
+
+    auto path = std::filesystem::temp_directory_path() / "d3d_tools_asset_container_benchmark.dda";
+    uint64_t fileSize = 0;
+    auto seconds = Measure(1, [&] {
+        fileSize = writer.WriteFile(path);
+    });
+    Report("Write", seconds, double(fileSize), "B");
+
+    // Map and validate the table: the cost before the first asset is usable
+    auto assetsCount = double(meshesCount) * 2 + double(texturesCount) * 2;
+    seconds = Measure(repeats, [&] {
+        AssetContainer container(path);
+        DoNotOptimize(container.GetAssetsCount());
+    });
+    Report("Open", seconds, assetsCount, "assets");
+
+    seconds = Measure(repeats, [&] {
+        AssetContainer container(path);
+        for (size_t i = 0; i < container.GetAssetsCount(); ++i) {
+            DoNotOptimize(container.FindAsset(container.GetAssetName(i)));
+        }
+    });
+    Report("Open and find every asset", seconds, assetsCount, "assets");
+
+    // Page cache is warm after the write, so this is mapping throughput rather than disk.
+    // The sum goes to a volatile, otherwise the reads are dropped as unused
+    volatile uint64_t checksum = 0;
+    seconds = Measure(repeats, [&] {
+        AssetContainer container(path);
+        checksum = TouchAssets(container);
+    });
+    Report("Open and read all data", seconds, double(fileSize), "B");
+
+    std::error_code error;
+    std::filesystem::remove(path, error);
+}
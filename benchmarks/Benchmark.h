@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// Minimal timing helpers. Every benchmark is a separate executable; pass --quick to run
+// a short smoke version of it (this is how ctest runs them)
+namespace d3d_tools_benchmarks {
+    struct Options {
+        bool quick = false;
+    };
+
+    inline Options ParseOptions(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--quick") == 0) {
+                options.quick = true;
+            }
+        }
+        return options;
+    }
+
+    // Keeps the compiler from throwing away the computation that produced the value
+    template<typename T>
+    void DoNotOptimize(const T& value) {
+        auto volatile sink = &value;
+        (void)sink;
+    }
+
+    // Best time of several runs, in seconds
+    template<typename F>
+    double Measure(size_t repeats, F&& f) {
+        using Clock = std::chrono::steady_clock;
+        double best = 0.0;
+        for (size_t i = 0; i < std::max<size_t>(repeats, 1); ++i) {
+            auto start = Clock::now();
+            f();
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            best = i == 0 ? seconds : std::min(best, seconds);
+        }
+        return best;
+    }
+
+    // Prints time and throughput: itemsCount of unit processed in seconds
+    inline void Report(const char* name, double seconds, double itemsCount, const char* unit) {
+        std::printf("%-48s %10.3f ms %12.2f M%s/s\n", name, seconds * 1000.0, itemsCount / seconds / 1e6, unit);
+    }
+}
@@ -0,0 +1,87 @@
+#include <cmath>
+#include <random>
+#include "D3D_Tools/BlockCompression.h"
+#include "Benchmark.h"
+
+using namespace d3d_tools;
+using namespace d3d_tools_benchmarks;
+
+namespace {
+    // Smooth gradients with some noise: closer to real textures than pure noise
+    std::vector<uint8_t> MakeImage(uint32_t width, uint32_t height) {
+        std::mt19937 random(3);
+        std::vector<uint8_t> result(size_t(width) * height * 4);
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                auto pixel = &result[(size_t(y) * width + x) * 4];
+                pixel[0] = static_cast<uint8_t>(128 + 100 * std::sin(x * 0.05));
+                pixel[1] = static_cast<uint8_t>(128 + 90 * std::cos(y * 0.03 + x * 0.01));
+                pixel[2] = static_cast<uint8_t>(((x ^ y) & 255) / 2 + random() % 8);
+                pixel[3] = static_cast<uint8_t>(size_t(x) * 255 / width);
+            }
+        }
+        return result;
+    }
+
+    // Peak signal to noise ratio over the channels the format keeps, in dB
+    double ComputePsnr(const std::vector<uint8_t>& original, const std::vector<uint8_t>& decoded, uint32_t channelsCount) {
+        double error = 0.0;
+        size_t count = 0;
+        for (size_t i = 0; i < original.size(); ++i) {
+            if (i % 4 < channelsCount) {
+                double difference = double(original[i]) - decoded[i];
+                error += difference * difference;
+                ++count;
+            }
+        }
+        error /= double(count);
+        return error == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / error);
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = ParseOptions(argc, argv);
+    uint32_t width = options.quick ? 128 : 2048;
+    uint32_t height = options.quick ? 64 : 2048;
+    size_t repeats = options.quick ? 1 : 5;
+
+    auto pixels = MakeImage(width, height);
+    ThreadPool threadPool;
+    std::printf("%ux%u RGBA8 source, %zu pool threads\n", width, height, threadPool.GetThreadsCount());
+
+    struct Case {
+        const char* name;
+        TextureFormat format;
+        // Leading RGBA channels the format keeps
+        uint32_t channelsCount;
+    };
+    const Case cases[] = {
+        { "BC1", TextureFormat::BC1_UNORM, 3 },
+        { "BC3", TextureFormat::BC3_UNORM, 4 },
+        { "BC4", TextureFormat::BC4_UNORM, 1 },
+        { "BC5", TextureFormat::BC5_UNORM, 2 },
+    };
+
+    double pixelsCount = double(width) * height;
+    for (auto& c : cases) {
+        char name[64];
+        std::vector<uint8_t> blocks;
+        for (auto pool : { static_cast<ThreadPool*>(nullptr), &threadPool }) {
+            auto seconds = Measure(repeats, [&] {
+                blocks = CompressTexture(pixels.data(), width, height, width * 4, TextureFormat::R8_G8_B8_A8_UNORM, c.format, pool);
+            });
+            std::snprintf(name, sizeof(name), "%s encode, %s", c.name, pool ? "pool" : "serial");
+            Report(name, seconds, pixelsCount, "pixels");
+        }
+
+        std::vector<uint8_t> decoded;
+        auto seconds = Measure(repeats, [&] {
+            decoded = DecompressTexture(blocks.data(), width, height, c.format);
+        });
+        std::snprintf(name, sizeof(name), "%s decode, serial", c.name);
+        Report(name, seconds, pixelsCount, "pixels");
+        std::printf("%-48s %10.2f dB PSNR\n", c.name, ComputePsnr(pixels, decoded, c.channelsCount));
+    }
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "D3D_Tools/CommandStream.h"
+#include "Benchmark.h"
+
+using namespace d3d_tools;
+using namespace d3d_tools_benchmarks;
+
+namespace {
+    // Typical draw: material textures, per draw constants, mesh buffers and the draw itself
+    void RecordDraw(CommandRecorder& recorder, uint32_t index) {
+        const void* views[2]{ &recorder, &recorder };
+        const void* buffers[1]{ &recorder };
+        RecordedVertexBuffer vertexBuffer{ &recorder, 32, 0 };
+        recorder.SetShaderResources(4, 0, views, 2);
+        recorder.SetConstantBuffers(5, 1, buffers, 1);
+        recorder.SetVertexBuffers(0, &vertexBuffer, 1);
+        recorder.SetIndexBuffer(&recorder, 57, 0);
+        recorder.DrawIndexed(index % 3000 + 3, 0, 0);
+    }
+
+    // Counts the work a context would be asked to do
+    struct Counter {
+        void SetShader(uint32_t, const void*) { ++calls; }
+        void SetShaderResources(uint32_t, uint32_t, const void* const*, uint32_t count) { calls += count; }
+        void SetSamplers(uint32_t, uint32_t, const void* const*, uint32_t count) { calls += count; }
+        void SetConstantBuffers(uint32_t, uint32_t, const void* const*, uint32_t count) { calls += count; }
+        void SetVertexBuffers(uint32_t, const RecordedVertexBuffer*, uint32_t count) { calls += count; }
+        void SetInputLayout(const void*) { ++calls; }
+        void SetPrimitiveTopology(uint32_t) { ++calls; }
+        void SetViewports(const RecordedViewport*, uint32_t) { ++calls; }
+        void SetRenderTargets(const void* const*, uint32_t, const void*) { ++calls; }
+        void ClearRenderTarget(const void*, const float (&)[4]) { ++calls; }
+        void ClearDepthStencil(const void*, float, uint8_t, uint32_t) { ++calls; }
+        void Draw(uint32_t count, uint32_t) { calls += count; }
+        void SetIndexBuffer(const void*, uint32_t, uint32_t) { ++calls; }
+        void DrawIndexed(uint32_t count, uint32_t, int32_t) { calls += count; }
+        void DrawInstanced(uint32_t count, uint32_t, uint32_t, uint32_t) { calls += count; }
+        void DrawIndexedInstanced(uint32_t count, uint32_t, uint32_t, int32_t, uint32_t) { calls += count; }
+
+        size_t calls = 0;
+    };
+}
+
+int main(int argc, char** argv) {
+    auto options = ParseOptions(argc, argv);
+    uint32_t drawsCount = options.quick ? 1000 : 200000;
+    size_t jobsCount = 64;
+    size_t repeats = options.quick ? 1 : 10;
+    // 5 commands per draw
+    double commandsCount = 5.0 * drawsCount;
+
+    std::printf("%u draws of 5 commands per frame\n", drawsCount);
+
+    // Memory is kept between frames, as in steady state
+    CommandRecorder recorder;
+    auto seconds = Measure(repeats, [&] {
+        recorder.Clear();
+        for (uint32_t i = 0; i < drawsCount; ++i) {
+            RecordDraw(recorder, i);
+        }
+    });
+    Report("Record, one thread", seconds, commandsCount, "commands");
+    std::printf("%-48s %10.1f bytes per command\n", "Stream size", double(recorder.GetSizeInBytes()) / recorder.GetCommandsCount());
+
+    seconds = Measure(repeats, [&] {
+        Counter counter;
+        recorder.Replay(counter);
+        DoNotOptimize(counter.calls);
+    });
+    Report("Replay", seconds, commandsCount, "commands");
+
+    ThreadPool threadPool;
+    std::vector<CommandRecorder> recorders;
+    seconds = Measure(repeats, [&] {
+        RecordCommandsInParallel(threadPool, recorders, jobsCount, [&](size_t job, CommandRecorder& jobRecorder) {
+            auto begin = static_cast<uint32_t>(drawsCount * job / jobsCount);
+            auto end = static_cast<uint32_t>(drawsCount * (job + 1) / jobsCount);
+            for (auto i = begin; i < end; ++i) {
+                RecordDraw(jobRecorder, i);
+            }
+        });
+    });
+    char name[64];
+    std::snprintf(name, sizeof(name), "Record, %zu jobs on %zu threads", jobsCount, threadPool.GetThreadsCount());
+    Report(name, seconds, commandsCount, "commands");
+
+    return 0;
+}
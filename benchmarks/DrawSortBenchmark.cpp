@@ -0,0 +1,84 @@
+#include <random>
+#include <vector>
+#include "D3D_Tools/DrawSortKey.h"
+#include "Benchmark.h"
+
+using namespace d3d_tools;
+using namespace d3d_tools_benchmarks;
+
+namespace {
+    using Item = KeyIndexRadixSorter::Item;
+
+    // A frame worth of draws in submission order: a few targets, 10% translucent
+    std::vector<Item> MakeDraws(size_t count) {
+        std::mt19937 random(5);
+        std::uniform_real_distribution<float> depths(0.1f, 1000.0f);
+        std::vector<Item> items(count);
+        for (size_t i = 0; i < count; ++i) {
+            auto target = random() % 4;
+            auto shader = random() % 64;
+            auto material = random() % 500;
+            auto depth = DrawSortKey::QuantizeDepth(depths(random), 0.1f, 1000.0f);
+            auto key = random() % 10 == 0
+                ? DrawSortKey::MakeTranslucent(target, shader, material, depth)
+                : DrawSortKey::MakeOpaque(target, shader, material, depth);
+            items[i] = { key, static_cast<uint32_t>(i) };
+        }
+        return items;
+    }
+
+    DrawSortKeyTransitions CountTransitions(const std::vector<Item>& items) {
+        std::vector<uint64_t> keys(items.size());
+        for (size_t i = 0; i < items.size(); ++i) {
+            keys[i] = items[i].key;
+        }
+        return CountKeyTransitions(keys.data(), keys.size());
+    }
+
+    void PrintTransitions(const char* name, const DrawSortKeyTransitions& transitions) {
+        std::printf("%-48s %10zu targets %8zu shaders %8zu materials\n", name,
+            transitions.targetChanges, transitions.shaderChanges, transitions.materialChanges);
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = ParseOptions(argc, argv);
+    size_t repeats = options.quick ? 1 : 10;
+    std::vector<size_t> counts = options.quick ? std::vector<size_t>{ 1000 } : std::vector<size_t>{ 1000, 10000, 100000, 1000000 };
+
+    for (auto count : counts) {
+        auto draws = MakeDraws(count);
+        std::vector<Item> items;
+        char name[64];
+
+        KeyIndexRadixSorter sorter;
+        auto seconds = Measure(repeats, [&] {
+            items = draws;
+            sorter.Sort(items);
+        });
+        std::snprintf(name, sizeof(name), "Radix sort, %zu draws", count);
+        Report(name, seconds, double(count), "keys");
+
+        std::vector<Item> reference;
+        seconds = Measure(repeats, [&] {
+            reference = draws;
+            std::stable_sort(reference.begin(), reference.end(), [](const Item& a, const Item& b) {
+                return a.key < b.key;
+            });
+        });
+        std::snprintf(name, sizeof(name), "std::stable_sort, %zu draws", count);
+        Report(name, seconds, double(count), "keys");
+
+        for (size_t i = 0; i < count; ++i) {
+            if (items[i].key != reference[i].key || items[i].index != reference[i].index) {
+                std::printf("Radix sort order differs from std::stable_sort at %zu\n", i);
+                return 1;
+            }
+        }
+
+        PrintTransitions("  State changes, submission order", CountTransitions(draws));
+        PrintTransitions("  State changes, sorted", CountTransitions(items));
+    }
+
+    return 0;
+}
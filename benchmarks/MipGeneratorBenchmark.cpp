@@ -0,0 +1,50 @@
+#include <random>
+#include "D3D_Tools/MipGenerator.h"
+#include "Benchmark.h"
+
+using namespace d3d_tools;
+using namespace d3d_tools_benchmarks;
+
+int main(int argc, char** argv) {
+    auto options = ParseOptions(argc, argv);
+    uint32_t extent = options.quick ? 128 : 2048;
+    size_t repeats = options.quick ? 1 : 5;
+
+    std::mt19937 random(1);
+    std::vector<uint8_t> pixels(size_t(extent) * extent * 4);
+    for (auto& value : pixels) {
+        value = static_cast<uint8_t>(random());
+    }
+
+    ThreadPool threadPool;
+    std::printf("Full mip chain of %ux%u, %zu pool threads\n", extent, extent, threadPool.GetThreadsCount());
+
+    struct Case {
+        const char* name;
+        TextureFormat format;
+        uint32_t channels;
+        MipFilter filter;
+    };
+    const Case cases[] = {
+        { "RGBA8 box", TextureFormat::R8_G8_B8_A8_UNORM, 4, MipFilter::Box },
+        { "RGBA8 kaiser", TextureFormat::R8_G8_B8_A8_UNORM, 4, MipFilter::Kaiser },
+        { "R8 box", TextureFormat::R8_UNORM, 1, MipFilter::Box },
+        { "R8 kaiser", TextureFormat::R8_UNORM, 1, MipFilter::Kaiser },
+    };
+
+    for (auto& c : cases) {
+        // Source megapixels per second
+        double megapixels = double(extent) * extent;
+        for (auto pool : { static_cast<ThreadPool*>(nullptr), &threadPool }) {
+            auto seconds = Measure(repeats, [&] {
+                auto chain = GenerateMipChain(pixels.data(), extent, extent, extent * c.channels, c.format, c.filter, pool);
+                DoNotOptimize(chain.data[0]);
+            });
+            char name[64];
+            std::snprintf(name, sizeof(name), "%s, %s", c.name, pool ? "pool" : "serial");
+            Report(name, seconds, megapixels, "pixels");
+        }
+    }
+
+    return 0;
+}
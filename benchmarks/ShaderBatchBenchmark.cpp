@@ -0,0 +1,109 @@
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "D3D_Tools/ShaderBytecodeBatch.h"
+#include "Benchmark.h"
+
+using namespace d3d_tools;
+using namespace d3d_tools_benchmarks;
+
+namespace {
+    // Stands in for D3DCompile: CPU bound work that grows with the source, about a millisecond per shader
+    std::vector<uint8_t> SyntheticCompile(const ShaderCompileRequest& request) {
+        Hasher hasher;
+        for (int pass = 0; pass < 200; ++pass) {
+            hasher.Add(request.source);
+            for (auto& macro : request.macros) {
+                hasher.Add(macro.name);
+                hasher.Add(macro.value);
+            }
+        }
+        std::vector<uint8_t> bytecode(1024);
+        auto value = hasher.GetValue();
+        for (auto& byte : bytecode) {
+            value = value * Hasher::Prime + 1;
+            byte = static_cast<uint8_t>(value >> 56);
+        }
+        return bytecode;
+    }
+
+    std::vector<ShaderBytecodeJob> MakePermutations(size_t count) {
+        std::string source(4096, ' ');
+        for (size_t i = 0; i < source.size(); ++i) {
+            source[i] = static_cast<char>('a' + i % 26);
+        }
+
+        std::vector<ShaderBytecodeJob> jobs;
+        jobs.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            ShaderBytecodeJob job;
+            job.code = source;
+            job.entryPoint = "main";
+            job.target = "ps_5_0";
+            job.macros.push_back(ShaderMacroDefinition{ "SHADOWS", std::to_string(i % 2) });
+            job.macros.push_back(ShaderMacroDefinition{ "LIGHTS", std::to_string(i / 2) });
+            jobs.push_back(std::move(job));
+        }
+        return jobs;
+    }
+
+    // Shaders are too slow for Report's millions per second
+    void ReportShaders(const char* name, double seconds, size_t shadersCount) {
+        std::printf("%-48s %10.3f ms %12.1f shaders/s\n", name, seconds * 1000.0, double(shadersCount) / seconds);
+    }
+
+    double CompileBatch(ShaderBytecodeBatchCompiler& compiler, size_t jobsCount, size_t repeats) {
+        return Measure(repeats, [&] {
+            auto futures = compiler.Submit(MakePermutations(jobsCount));
+            size_t size = 0;
+            for (auto& future : futures) {
+                size += compiler.Get(future).size();
+            }
+            DoNotOptimize(size);
+        });
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = ParseOptions(argc, argv);
+    size_t jobsCount = options.quick ? 32 : 2000;
+    size_t repeats = options.quick ? 1 : 3;
+    size_t maxThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    std::printf("%zu permutations with a synthetic compiler, %zu hardware threads\n", jobsCount, maxThreads);
+
+    // Powers of two and the hardware thread count
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    double singleThreaded = 0.0;
+    for (auto threads : threadCounts) {
+        ThreadPool pool(threads);
+        ShaderBytecodeBatchCompiler compiler(pool, SyntheticCompile);
+        auto seconds = CompileBatch(compiler, jobsCount, repeats);
+        if (threads == 1) {
+            singleThreaded = seconds;
+        }
+        char name[64];
+        std::snprintf(name, sizeof(name), "Batch, %zu threads (x%.2f)", threads, singleThreaded / seconds);
+        ReportShaders(name, seconds, jobsCount);
+    }
+
+    // Second run of the same permutations is served from the cache
+    auto directory = std::filesystem::temp_directory_path() / "d3d_tools_shader_batch_benchmark";
+    std::filesystem::remove_all(directory);
+    {
+        ShaderCache cache(directory);
+        ThreadPool pool(maxThreads);
+        ShaderBytecodeBatchCompiler compiler(pool, SyntheticCompile, &cache);
+        ReportShaders("Batch, cold cache", CompileBatch(compiler, jobsCount, 1), jobsCount);
+        ReportShaders("Batch, warm cache", CompileBatch(compiler, jobsCount, repeats), jobsCount);
+    }
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "D3D_Tools/ThreadPool.h"
+#include "Benchmark.h"
+
+using namespace d3d_tools;
+using namespace d3d_tools_benchmarks;
+
+namespace {
+    // Some arithmetic per element so the work is compute bound rather than memory bound
+    float Work(float value) {
+        for (int i = 0; i < 16; ++i) {
+            value = std::sqrt(value * value + 1.0f) * 0.5f;
+        }
+        return value;
+    }
+
+    double RunParallelFor(ThreadPool& pool, std::vector<float>& data, size_t grain, size_t repeats) {
+        return Measure(repeats, [&] {
+            pool.ParallelFor(data.size(), grain, [&](size_t begin, size_t end) {
+                for (auto i = begin; i < end; ++i) {
+                    data[i] = Work(data[i]);
+                }
+            });
+            DoNotOptimize(data[0]);
+        });
+    }
+
+    double RunSmallTasks(ThreadPool& pool, size_t tasksCount, size_t repeats) {
+        return Measure(repeats, [&] {
+            std::vector<std::future<size_t>> futures;
+            futures.reserve(tasksCount);
+            for (size_t i = 0; i < tasksCount; ++i) {
+                futures.push_back(pool.Submit([i] { return i * 2; }));
+            }
+            size_t sum = 0;
+            for (auto& future : futures) {
+                sum += pool.Wait(future);
+            }
+            DoNotOptimize(sum);
+        });
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = ParseOptions(argc, argv);
+    size_t elementsCount = options.quick ? (1 << 14) : (1 << 22);
+    size_t tasksCount = options.quick ? 1000 : 100000;
+    size_t repeats = options.quick ? 1 : 5;
+    size_t maxThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+    std::vector<float> data(elementsCount, 1.0f);
+    std::printf("ParallelFor over %zu elements and %zu small tasks, %zu hardware threads\n",
+        elementsCount, tasksCount, maxThreads);
+
+    // Powers of two and the hardware thread count
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    double singleThreaded = 0.0;
+    for (auto threads : threadCounts) {
+        ThreadPool pool(threads);
+        char name[64];
+
+        auto seconds = RunParallelFor(pool, data, 4096, repeats);
+        if (threads == 1) {
+            singleThreaded = seconds;
+        }
+        std::snprintf(name, sizeof(name), "ParallelFor, %zu threads (x%.2f)", threads, singleThreaded / seconds);
+        Report(name, seconds, double(elementsCount), "elements");
+
+        std::snprintf(name, sizeof(name), "Submit and Wait, %zu threads", threads);
+        Report(name, RunSmallTasks(pool, tasksCount, repeats), double(tasksCount), "tasks");
+    }
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include "D3D_Tools/VertexQuantization.h"
+#include "Benchmark.h"
+
+using namespace d3d_tools;
+using namespace d3d_tools_benchmarks;
+using namespace d3d_tools::quantization;
+
+namespace {
+    // Random unit normals with a handedness sign in w, as tangents have
+    std::vector<float> MakeUnitVectors(size_t count, std::mt19937& random) {
+        std::normal_distribution<float> distribution;
+        std::vector<float> result(count * 4);
+        for (size_t i = 0; i < count; ++i) {
+            float x = distribution(random);
+            float y = distribution(random);
+            float z = distribution(random);
+            auto inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+            result[i * 4] = x * inverseLength;
+            result[i * 4 + 1] = y * inverseLength;
+            result[i * 4 + 2] = z * inverseLength;
+            result[i * 4 + 3] = i % 2 ? 1.0f : -1.0f;
+        }
+        return result;
+    }
+
+    double AngleInDegrees(const float* a, const float* b) {
+        double dot = double(a[0]) * b[0] + double(a[1]) * b[1] + double(a[2]) * b[2];
+        return std::acos(std::min(std::max(dot, -1.0), 1.0)) * 180.0 / 3.14159265358979;
+    }
+
+    void PrintError(const char* name, double maxError, const char* unit) {
+        std::printf("%-48s %14.6f %s max error\n", name, maxError, unit);
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = ParseOptions(argc, argv);
+    size_t count = options.quick ? 4096 : (1 << 20);
+    size_t repeats = options.quick ? 1 : 10;
+
+#ifdef D3D_TOOLS_VERTEX_QUANTIZATION_F16C
+    std::printf("Halfs: F16C\n");
+#else
+    std::printf("Halfs: scalar\n");
+#endif
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> positions(-100.0f, 100.0f);
+    std::vector<float> values(count * 4);
+    for (auto& value : values) {
+        value = positions(random);
+    }
+    auto normals = MakeUnitVectors(count, random);
+
+    // Throughput, components or vectors per second
+    std::vector<uint16_t> halfs(values.size());
+    auto seconds = Measure(repeats, [&] {
+        EncodeHalfs(values.data(), halfs.data(), values.size());
+        DoNotOptimize(halfs.front());
+    });
+    Report("Half, bulk", seconds, double(values.size()), "values");
+
+    seconds = Measure(repeats, [&] {
+        for (size_t i = 0; i < values.size(); ++i) {
+            halfs[i] = FloatToHalf(values[i]);
+        }
+        DoNotOptimize(halfs.front());
+    });
+    Report("Half, scalar", seconds, double(values.size()), "values");
+
+    std::vector<int16_t> snorms(normals.size());
+    seconds = Measure(repeats, [&] {
+        EncodeSnorm16(normals.data(), snorms.data(), normals.size());
+        DoNotOptimize(snorms.front());
+    });
+    Report("Snorm16, bulk", seconds, double(normals.size()), "values");
+
+    std::vector<uint32_t> packed(count);
+    seconds = Measure(repeats, [&] {
+        EncodeR10G10B10A2(normals.data(), 4, packed.data(), count);
+        DoNotOptimize(packed.front());
+    });
+    Report("R10G10B10A2, bulk", seconds, double(count), "vectors");
+
+    std::vector<int16_t> octahedral(count * 2);
+    seconds = Measure(repeats, [&] {
+        EncodeOctahedralSnorm16(normals.data(), 4, octahedral.data(), count);
+        DoNotOptimize(octahedral.front());
+    });
+    Report("Octahedral snorm16, bulk", seconds, double(count), "vectors");
+
+    seconds = Measure(repeats, [&] {
+        for (size_t i = 0; i < count; ++i) {
+            float u, v;
+            EncodeOctahedral(normals[i * 4], normals[i * 4 + 1], normals[i * 4 + 2], u, v);
+            octahedral[i * 2] = FloatToSnorm16(u);
+            octahedral[i * 2 + 1] = FloatToSnorm16(v);
+        }
+        DoNotOptimize(octahedral.front());
+    });
+    Report("Octahedral snorm16, scalar", seconds, double(count), "vectors");
+
+    // Position, normal, tangent and uv: 48 bytes as floats
+    QuantizedVertexStreamBuilder builder(count);
+    builder.AddAttribute("POSITION", 0, values.data(), 3, VertexEncoding::Half);
+    builder.AddAttribute("NORMAL", 0, normals.data(), 4, VertexEncoding::OctahedralSnorm16);
+    builder.AddAttribute("TANGENT", 0, normals.data(), 4, VertexEncoding::R10G10B10A2);
+    builder.AddAttribute("TEXCOORD", 0, values.data(), 2, VertexEncoding::Half);
+    std::vector<uint8_t> stream;
+    seconds = Measure(repeats, [&] {
+        stream = builder.Build();
+    });
+    char name[64];
+    std::snprintf(name, sizeof(name), "Vertex stream, 48 -> %u bytes per vertex", builder.GetStride());
+    Report(name, seconds, double(count), "vertices");
+
+    // Errors of the last encodings
+    EncodeHalfs(values.data(), halfs.data(), values.size());
+    double halfError = 0.0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        halfError = std::max(halfError, std::abs(double(HalfToFloat(halfs[i])) - values[i]) / std::abs(values[i]));
+    }
+    PrintError("Half", halfError, "relative");
+
+    double snormError = 0.0;
+    for (size_t i = 0; i < normals.size(); ++i) {
+        snormError = std::max(snormError, std::abs(double(Snorm16ToFloat(snorms[i])) - normals[i]));
+    }
+    PrintError("Snorm16", snormError, "absolute");
+
+    double packedError = 0.0;
+    double octahedralError = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        auto normal = normals.data() + i * 4;
+        float decoded[4];
+        DecodeR10G10B10A2(packed[i], decoded);
+        for (int c = 0; c < 3; ++c) {
+            packedError = std::max(packedError, std::abs(double(decoded[c]) - normal[c]));
+        }
+        if (decoded[3] * normal[3] < 0.0f) {
+            std::printf("R10G10B10A2 lost the sign of w at %zu\n", i);
+            return 1;
+        }
+
+        DecodeOctahedral(Snorm16ToFloat(octahedral[i * 2]), Snorm16ToFloat(octahedral[i * 2 + 1]), decoded);
+        octahedralError = std::max(octahedralError, AngleInDegrees(decoded, normal));
+    }
+    PrintError("R10G10B10A2", packedError, "absolute");
+    PrintError("Octahedral snorm16", octahedralError, "degrees");
+
+    return 0;
+}
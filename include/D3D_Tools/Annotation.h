@@ -1,34 +1,167 @@
 #pragma once
 
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include "EverydayTools\Exception\CallAndRethrow.h"
 #include "WinWrappers\ComPtr.h"
 #include "Device.h"
+#include "GpuProfiler.h"
+
+// Define to 0 to compile PIX markers out. By default they are removed from release (NDEBUG) builds.
+// Profiler scopes attached to annotations are kept either way
+#ifndef D3D_TOOLS_ENABLE_ANNOTATIONS
+#ifdef NDEBUG
+#define D3D_TOOLS_ENABLE_ANNOTATIONS 0
+#else
+#define D3D_TOOLS_ENABLE_ANNOTATIONS 1
+#endif
+#endif
 
 namespace d3d_tools {
+    static constexpr bool AnnotationsEnabled = D3D_TOOLS_ENABLE_ANNOTATIONS != 0;
+
+    // Marker title prepared once: the wide title for PIX and UTF-8 name for the profiler
+    struct AnnotationLabel {
+        std::wstring title;
+        std::string name;
+        uint32_t id;
+    };
+
+    // Interns annotation titles. Labels have stable addresses and are never removed,
+    // so call sites may keep references to them
+    class AnnotationLabelTable {
+    public:
+        const AnnotationLabel& Intern(std::wstring_view title) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_indices.find(title);
+            if (it != m_indices.end()) {
+                return m_labels[it->second];
+            }
+
+            auto id = static_cast<uint32_t>(m_labels.size());
+            m_labels.push_back(AnnotationLabel{ std::wstring(title), ConvertToUtf8(title), id });
+            auto& label = m_labels.back();
+            m_indices.emplace(std::wstring_view(label.title), id);
+            return label;
+        }
+
+        size_t GetSize() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_labels.size();
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+        std::deque<AnnotationLabel> m_labels;
+        std::unordered_map<std::wstring_view, uint32_t> m_indices;
+    };
+
+    inline AnnotationLabelTable& GetAnnotationLabels() {
+        static AnnotationLabelTable table;
+        return table;
+    }
+
+    inline const AnnotationLabel& InternAnnotationLabel(std::wstring_view title) {
+        return GetAnnotationLabels().Intern(title);
+    }
+
+    // PIX marker for the lifetime of the object. With a profiler the same scope is also timed on CPU and GPU
     class ScopedAnnotation {
     public:
-        ScopedAnnotation(ComPtr<ID3DUserDefinedAnnotation> ptr, const wchar_t* title) :
-            m_p(ptr)
+        // Uses the interface cached by the device: no QueryInterface and no reference counting per marker
+        ScopedAnnotation(Device* device, const AnnotationLabel& label, GpuProfiler* profiler = nullptr) :
+            m_profiler(profiler)
+        {
+            if constexpr (AnnotationsEnabled) {
+                m_p = device->GetAnnotation();
+                m_p->BeginEvent(label.title.c_str());
+            }
+            if (m_profiler) {
+                m_scope = m_profiler->BeginScope(label.name);
+            }
+        }
+
+        // For titles built at runtime: nothing is interned, and with markers compiled out
+        // and no profiler nothing is done at all
+        ScopedAnnotation(Device* device, const wchar_t* title, GpuProfiler* profiler = nullptr) :
+            m_profiler(profiler)
+        {
+            if constexpr (AnnotationsEnabled) {
+                m_p = device->GetAnnotation();
+                m_p->BeginEvent(title);
+            }
+            if (m_profiler) {
+                m_scope = m_profiler->BeginScope(ConvertToUtf8(title));
+            }
+        }
+
+        ScopedAnnotation(ComPtr<ID3DUserDefinedAnnotation> ptr, const wchar_t* title, GpuProfiler* profiler = nullptr) :
+            m_holder(ptr),
+            m_profiler(profiler)
         {
-            m_p->BeginEvent(title);
+            if constexpr (AnnotationsEnabled) {
+                m_p = m_holder.Get();
+                m_p->BeginEvent(title);
+            }
+            if (m_profiler) {
+                m_scope = m_profiler->BeginScope(ConvertToUtf8(title));
+            }
         }
 
+        ScopedAnnotation(const ScopedAnnotation&) = delete;
+        ScopedAnnotation& operator=(const ScopedAnnotation&) = delete;
+
         ~ScopedAnnotation() {
-            m_p->EndEvent();
+            if (m_profiler) {
+                m_profiler->EndScope(m_scope);
+            }
+            if constexpr (AnnotationsEnabled) {
+                m_p->EndEvent();
+            }
         }
 
     private:
-        ComPtr<ID3DUserDefinedAnnotation> m_p;
+        ComPtr<ID3DUserDefinedAnnotation> m_holder;
+        ID3DUserDefinedAnnotation* m_p = nullptr;
+        GpuProfiler* m_profiler;
+        GpuProfileScope m_scope;
     };
 
-    inline ScopedAnnotation CreateScopedAnnotation(Device* device, const wchar_t* title) {
-        return ScopedAnnotation(device->CreateAnnotation(), title);
+    // Converts the title for the profiler on every call; prefer D3D_TOOLS_SCOPED_PROFILE_ANNOTATION in hot code
+    inline ScopedAnnotation CreateScopedAnnotation(Device* device, const wchar_t* title, GpuProfiler* profiler = nullptr) {
+        return ScopedAnnotation(device, title, profiler);
     }
 
+    template<typename F>
+    inline decltype(auto) Annotate(Device* device, const wchar_t* title, F&& f) {
+        ScopedAnnotation annotation(device, title);
+        return static_cast<decltype(f.operator()())>(f());
+    }
 
     template<typename F>
-	inline decltype(auto) Annotate(Device* device, const wchar_t* title, F&& f) {
-        ScopedAnnotation annotation(device->CreateAnnotation(), title);
+    inline decltype(auto) Annotate(Device* device, GpuProfiler* profiler, const wchar_t* title, F&& f) {
+        ScopedAnnotation annotation(device, title, profiler);
         return static_cast<decltype(f.operator()())>(f());
     }
-}
\ No newline at end of file
+}
+
+#define D3D_TOOLS_ANNOTATION_CONCAT_IMPL(a, b) a##b
+#define D3D_TOOLS_ANNOTATION_CONCAT(a, b) D3D_TOOLS_ANNOTATION_CONCAT_IMPL(a, b)
+
+// Marker until the end of the enclosing scope. The title is interned once per call site;
+// the whole statement disappears when annotations are disabled
+#if D3D_TOOLS_ENABLE_ANNOTATIONS
+#define D3D_TOOLS_SCOPED_ANNOTATION(device, title) \
+    static const ::d3d_tools::AnnotationLabel& D3D_TOOLS_ANNOTATION_CONCAT(d3dToolsLabel, __LINE__) = ::d3d_tools::InternAnnotationLabel(title); \
+    ::d3d_tools::ScopedAnnotation D3D_TOOLS_ANNOTATION_CONCAT(d3dToolsAnnotation, __LINE__)(device, D3D_TOOLS_ANNOTATION_CONCAT(d3dToolsLabel, __LINE__))
+#else
+#define D3D_TOOLS_SCOPED_ANNOTATION(device, title) ((void)0)
+#endif
+
+// Same with profiler scope. Kept in release builds, only the marker part is compiled out
+#define D3D_TOOLS_SCOPED_PROFILE_ANNOTATION(device, profiler, title) \
+    static const ::d3d_tools::AnnotationLabel& D3D_TOOLS_ANNOTATION_CONCAT(d3dToolsLabel, __LINE__) = ::d3d_tools::InternAnnotationLabel(title); \
+    ::d3d_tools::ScopedAnnotation D3D_TOOLS_ANNOTATION_CONCAT(d3dToolsAnnotation, __LINE__)(device, D3D_TOOLS_ANNOTATION_CONCAT(d3dToolsLabel, __LINE__), profiler)
@@ -0,0 +1,561 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Hash.h"
+#include "MappedFile.h"
+#include "TextureFormat.h"
+#include "VertexLayout.h"
+
+namespace d3d_tools {
+    // Binary container of ready-to-upload assets. Little endian, laid out as:
+    //     FileHeader
+    //     AssetRecord[assetsCount]
+    //     ChunkRecord[chunksCount]
+    //     ElementRecord[elementsCount]  vertex stream layouts
+    //     names                         null terminated, D3D takes semantics as C strings
+    //     chunk data                    every chunk starts at DataAlignment
+    // The table (everything before the data) is checksummed. Chunks are referenced in place from the
+    // mapped file, so loading is one mmap and creation calls read the pages directly
+    enum class AssetType : uint32_t {
+        Texture,
+        VertexStream,
+        IndexStream,
+        Shader
+    };
+
+    namespace asset_details {
+        // Change it when the layout changes
+        static constexpr uint32_t FormatVersion = 1;
+        static constexpr uint32_t FileMagic = 0x41534444; // 'DDSA'
+        static constexpr uint64_t DataAlignment = 16;
+
+        struct FileHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t assetsCount;
+            uint32_t chunksCount;
+            uint32_t elementsCount;
+            uint32_t namesSize;
+            uint64_t tableSize;
+            uint64_t fileSize;
+            uint64_t tableChecksum;
+        };
+
+        // Meaning of the parameters depends on the type:
+        //     Texture:      width, height, mipLevels, arraySize, TextureFormat
+        //     VertexStream: vertexCount, stride, first element, elements count
+        //     IndexStream:  indexCount, index size (2 or 4)
+        //     Shader:       shader type as the engine numbers it
+        struct AssetRecord {
+            AssetType type;
+            uint32_t nameOffset;
+            uint32_t nameSize;
+            uint32_t firstChunk;
+            uint32_t chunksCount;
+            uint32_t parameters[5];
+        };
+
+        struct ChunkRecord {
+            uint64_t offset;
+            uint64_t size;
+            uint32_t rowPitch;
+            uint32_t slicePitch;
+        };
+
+        struct ElementRecord {
+            uint32_t semanticOffset;
+            uint32_t semanticSize;
+            uint32_t semanticIndex;
+            uint32_t format;
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        inline uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        template<typename T>
+        T ReadRecord(const uint8_t* data) {
+            T result;
+            std::memcpy(&result, data, sizeof(T));
+            return result;
+        }
+    }
+
+    struct TextureAssetDesc {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipLevels = 1;
+        uint32_t arraySize = 1;
+        TextureFormat format = TextureFormat::R8_G8_B8_A8_UNORM;
+    };
+
+    struct AssetSubresource {
+        const void* data;
+        uint64_t size;
+        uint32_t rowPitch;
+        uint32_t slicePitch;
+    };
+
+    // Subresources in D3D order: all mips of slice 0, then all mips of slice 1 and so on
+    struct TextureAsset {
+        TextureAssetDesc desc;
+        std::vector<AssetSubresource> subresources;
+    };
+
+    struct VertexStreamAsset {
+        uint32_t vertexCount;
+        uint32_t stride;
+        const uint8_t* data;
+        // Semantics point into the container
+        std::vector<VertexElement> elements;
+    };
+
+    struct IndexStreamAsset {
+        uint32_t indexCount;
+        // 2 or 4
+        uint32_t indexSize;
+        const void* data;
+    };
+
+    struct ShaderAsset {
+        uint32_t shaderType;
+        const void* bytecode;
+        size_t size;
+    };
+
+    // Collects assets and writes the container. Data is not copied: it must live until Write
+    class AssetContainerWriter {
+    public:
+        // subresources.size() must be mipLevels * arraySize. Pitches default to tightly packed ones
+        void AddTexture(std::string name, const TextureAssetDesc& desc, const std::vector<AssetSubresource>& subresources) {
+            if (subresources.size() != size_t(desc.mipLevels) * desc.arraySize) {
+                throw std::invalid_argument("Texture asset needs data for every subresource");
+            }
+
+            auto& asset = AddAsset(AssetType::Texture, std::move(name));
+            asset.record.parameters[0] = desc.width;
+            asset.record.parameters[1] = desc.height;
+            asset.record.parameters[2] = desc.mipLevels;
+            asset.record.parameters[3] = desc.arraySize;
+            asset.record.parameters[4] = static_cast<uint32_t>(desc.format);
+            for (uint32_t slice = 0; slice < desc.arraySize; ++slice) {
+                for (uint32_t mip = 0; mip < desc.mipLevels; ++mip) {
+                    auto subresource = subresources[slice * desc.mipLevels + mip];
+                    auto width = ComputeMipExtent(desc.width, mip);
+                    auto height = ComputeMipExtent(desc.height, mip);
+                    if (subresource.rowPitch == 0) {
+                        subresource.rowPitch = ComputeRowPitch(desc.format, width);
+                        subresource.slicePitch = subresource.rowPitch * ComputeRowsCount(desc.format, height);
+                    }
+                    if (subresource.size < uint64_t(subresource.rowPitch) * ComputeRowsCount(desc.format, height)) {
+                        throw std::invalid_argument("Texture subresource is smaller than its pitch requires");
+                    }
+                    AddChunk(asset, subresource.data, subresource.size, subresource.rowPitch, subresource.slicePitch);
+                }
+            }
+        }
+
+        void AddVertexStream(std::string name, uint32_t vertexCount, uint32_t stride, const std::vector<VertexElement>& elements, const void* data) {
+            auto& asset = AddAsset(AssetType::VertexStream, std::move(name));
+            asset.record.parameters[0] = vertexCount;
+            asset.record.parameters[1] = stride;
+            asset.record.parameters[2] = static_cast<uint32_t>(m_elements.size());
+            asset.record.parameters[3] = static_cast<uint32_t>(elements.size());
+            for (auto& element : elements) {
+                if (element.offset + element.size > stride) {
+                    throw std::invalid_argument("Vertex element is out of the vertex");
+                }
+                asset_details::ElementRecord record{};
+                record.semanticOffset = AddName(element.semantic);
+                record.semanticSize = static_cast<uint32_t>(element.semantic.size());
+                record.semanticIndex = element.semanticIndex;
+                record.format = static_cast<uint32_t>(element.format);
+                record.offset = element.offset;
+                record.size = element.size;
+                m_elements.push_back(record);
+            }
+            AddChunk(asset, data, uint64_t(vertexCount) * stride);
+        }
+
+        template<typename Vertex>
+        void AddVertexStream(std::string name, const std::vector<Vertex>& vertices) {
+            auto& layout = VertexLayoutOf<Vertex>;
+            AddVertexStream(std::move(name), static_cast<uint32_t>(vertices.size()), layout.stride,
+                std::vector<VertexElement>(layout.elements.begin(), layout.elements.end()), vertices.data());
+        }
+
+        void AddIndexStream(std::string name, uint32_t indexCount, uint32_t indexSize, const void* data) {
+            if (indexSize != 2 && indexSize != 4) {
+                throw std::invalid_argument("Indices must be 16 or 32 bit");
+            }
+            auto& asset = AddAsset(AssetType::IndexStream, std::move(name));
+            asset.record.parameters[0] = indexCount;
+            asset.record.parameters[1] = indexSize;
+            AddChunk(asset, data, uint64_t(indexCount) * indexSize);
+        }
+
+        void AddShader(std::string name, uint32_t shaderType, const void* bytecode, size_t size) {
+            auto& asset = AddAsset(AssetType::Shader, std::move(name));
+            asset.record.parameters[0] = shaderType;
+            AddChunk(asset, bytecode, size);
+        }
+
+        // Returns bytes written. Chunks are streamed, the container is never assembled in memory
+        uint64_t Write(std::ostream& output) const {
+            using namespace asset_details;
+            auto chunksCount = m_chunks.size();
+            uint64_t tableSize =
+                sizeof(FileHeader) +
+                m_assets.size() * sizeof(AssetRecord) +
+                chunksCount * sizeof(ChunkRecord) +
+                m_elements.size() * sizeof(ElementRecord) +
+                m_names.size();
+
+            // Place chunks
+            std::vector<ChunkRecord> chunks(chunksCount);
+            auto offset = AlignUp(tableSize, DataAlignment);
+            for (size_t i = 0; i < chunksCount; ++i) {
+                chunks[i] = m_chunks[i].record;
+                chunks[i].offset = offset;
+                offset = AlignUp(offset + chunks[i].size, DataAlignment);
+            }
+
+            std::vector<uint8_t> table(tableSize);
+            auto cursor = table.data() + sizeof(FileHeader);
+            auto append = [&cursor](const void* data, size_t size) {
+                if (size > 0) {
+                    std::memcpy(cursor, data, size);
+                    cursor += size;
+                }
+            };
+            for (auto& asset : m_assets) {
+                append(&asset.record, sizeof(AssetRecord));
+            }
+            append(chunks.data(), chunks.size() * sizeof(ChunkRecord));
+            append(m_elements.data(), m_elements.size() * sizeof(ElementRecord));
+            append(m_names.data(), m_names.size());
+
+            FileHeader header{};
+            header.magic = FileMagic;
+            header.version = FormatVersion;
+            header.assetsCount = static_cast<uint32_t>(m_assets.size());
+            header.chunksCount = static_cast<uint32_t>(chunksCount);
+            header.elementsCount = static_cast<uint32_t>(m_elements.size());
+            header.namesSize = static_cast<uint32_t>(m_names.size());
+            header.tableSize = tableSize;
+            header.fileSize = offset;
+            header.tableChecksum = ComputeHash(table.data() + sizeof(FileHeader), tableSize - sizeof(FileHeader));
+            std::memcpy(table.data(), &header, sizeof(header));
+
+            static const char padding[DataAlignment] = {};
+            output.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size()));
+            auto written = tableSize;
+            for (size_t i = 0; i < chunksCount; ++i) {
+                output.write(padding, static_cast<std::streamsize>(chunks[i].offset - written));
+                output.write(static_cast<const char*>(m_chunks[i].data), static_cast<std::streamsize>(chunks[i].size));
+                written = chunks[i].offset + chunks[i].size;
+            }
+            output.write(padding, static_cast<std::streamsize>(offset - written));
+
+            if (!output) {
+                throw std::runtime_error("Failed to write asset container");
+            }
+            return offset;
+        }
+
+        uint64_t WriteFile(const std::filesystem::path& path) const {
+            std::ofstream output(path, std::ios::binary | std::ios::trunc);
+            if (!output) {
+                throw std::runtime_error("Failed to open " + path.string() + " for writing");
+            }
+            return Write(output);
+        }
+
+    private:
+        struct PendingAsset {
+            asset_details::AssetRecord record;
+        };
+
+        struct PendingChunk {
+            asset_details::ChunkRecord record;
+            const void* data;
+        };
+
+        PendingAsset& AddAsset(AssetType type, std::string name) {
+            PendingAsset asset{};
+            asset.record.type = type;
+            asset.record.nameOffset = AddName(name);
+            asset.record.nameSize = static_cast<uint32_t>(name.size());
+            asset.record.firstChunk = static_cast<uint32_t>(m_chunks.size());
+            m_assets.push_back(asset);
+            return m_assets.back();
+        }
+
+        void AddChunk(PendingAsset& asset, const void* data, uint64_t size, uint32_t rowPitch = 0, uint32_t slicePitch = 0) {
+            PendingChunk chunk{};
+            chunk.record.size = size;
+            chunk.record.rowPitch = rowPitch;
+            chunk.record.slicePitch = slicePitch;
+            chunk.data = data;
+            m_chunks.push_back(chunk);
+            ++asset.record.chunksCount;
+        }
+
+        uint32_t AddName(std::string_view name) {
+            auto offset = static_cast<uint32_t>(m_names.size());
+            m_names.append(name);
+            m_names.push_back('\0');
+            return offset;
+        }
+
+    private:
+        std::vector<PendingAsset> m_assets;
+        std::vector<PendingChunk> m_chunks;
+        std::vector<asset_details::ElementRecord> m_elements;
+        std::string m_names;
+    };
+
+    // Memory mapped container. Returned assets point into the mapping: they are valid while the container lives.
+    // The table is validated on open, so malformed files throw instead of reading out of bounds
+    class AssetContainer {
+    public:
+        explicit AssetContainer(const std::filesystem::path& path) :
+            AssetContainer(MappedFile(path))
+        {
+        }
+
+        explicit AssetContainer(MappedFile&& file) :
+            m_file(std::move(file))
+        {
+            using namespace asset_details;
+            if (!m_file.IsValid()) {
+                throw std::runtime_error("Failed to map asset container");
+            }
+            Open(m_file.GetData(), m_file.GetSize());
+        }
+
+        size_t GetAssetsCount() const {
+            return m_assets.size();
+        }
+
+        AssetType GetAssetType(size_t index) const {
+            return m_assets.at(index).type;
+        }
+
+        std::string_view GetAssetName(size_t index) const {
+            auto& record = m_assets.at(index);
+            return std::string_view(m_names + record.nameOffset, record.nameSize);
+        }
+
+        static constexpr size_t NotFound = ~size_t(0);
+
+        size_t FindAsset(std::string_view name) const {
+            auto it = m_byName.find(name);
+            return it == m_byName.end() ? NotFound : it->second;
+        }
+
+        TextureAsset GetTexture(std::string_view name) const {
+            return GetTexture(GetIndex(name));
+        }
+
+        TextureAsset GetTexture(size_t index) const {
+            auto& record = GetRecord(index, AssetType::Texture);
+            TextureAsset result;
+            result.desc.width = record.parameters[0];
+            result.desc.height = record.parameters[1];
+            result.desc.mipLevels = record.parameters[2];
+            result.desc.arraySize = record.parameters[3];
+            result.desc.format = static_cast<TextureFormat>(record.parameters[4]);
+            result.subresources.reserve(record.chunksCount);
+            for (uint32_t i = 0; i < record.chunksCount; ++i) {
+                auto& chunk = m_chunks[record.firstChunk + i];
+                result.subresources.push_back(AssetSubresource{ m_file.GetData() + chunk.offset, chunk.size, chunk.rowPitch, chunk.slicePitch });
+            }
+            return result;
+        }
+
+        VertexStreamAsset GetVertexStream(std::string_view name) const {
+            return GetVertexStream(GetIndex(name));
+        }
+
+        VertexStreamAsset GetVertexStream(size_t index) const {
+            auto& record = GetRecord(index, AssetType::VertexStream);
+            VertexStreamAsset result;
+            result.vertexCount = record.parameters[0];
+            result.stride = record.parameters[1];
+            result.data = m_file.GetData() + m_chunks[record.firstChunk].offset;
+            result.elements.reserve(record.parameters[3]);
+            for (uint32_t i = 0; i < record.parameters[3]; ++i) {
+                auto& element = m_elements[record.parameters[2] + i];
+                result.elements.push_back(VertexElement{
+                    std::string_view(m_names + element.semanticOffset, element.semanticSize),
+                    element.semanticIndex,
+                    static_cast<VertexFormat>(element.format),
+                    element.offset,
+                    element.size });
+            }
+            return result;
+        }
+
+        IndexStreamAsset GetIndexStream(std::string_view name) const {
+            return GetIndexStream(GetIndex(name));
+        }
+
+        IndexStreamAsset GetIndexStream(size_t index) const {
+            auto& record = GetRecord(index, AssetType::IndexStream);
+            return IndexStreamAsset{ record.parameters[0], record.parameters[1], m_file.GetData() + m_chunks[record.firstChunk].offset };
+        }
+
+        ShaderAsset GetShader(std::string_view name) const {
+            return GetShader(GetIndex(name));
+        }
+
+        ShaderAsset GetShader(size_t index) const {
+            auto& record = GetRecord(index, AssetType::Shader);
+            auto& chunk = m_chunks[record.firstChunk];
+            return ShaderAsset{ record.parameters[0], m_file.GetData() + chunk.offset, static_cast<size_t>(chunk.size) };
+        }
+
+    private:
+        void Open(const uint8_t* data, size_t size) {
+            using namespace asset_details;
+            auto fail = [](const char* reason) {
+                throw std::runtime_error(std::string("Invalid asset container: ") + reason);
+            };
+
+            if (size < sizeof(FileHeader)) {
+                fail("file is too small");
+            }
+            auto header = ReadRecord<FileHeader>(data);
+            if (header.magic != FileMagic) {
+                fail("wrong magic");
+            }
+            if (header.version != FormatVersion) {
+                fail("unsupported version");
+            }
+            uint64_t expectedTableSize =
+                sizeof(FileHeader) +
+                uint64_t(header.assetsCount) * sizeof(AssetRecord) +
+                uint64_t(header.chunksCount) * sizeof(ChunkRecord) +
+                uint64_t(header.elementsCount) * sizeof(ElementRecord) +
+                header.namesSize;
+            if (header.fileSize != size || header.tableSize != expectedTableSize || header.tableSize > size) {
+                fail("sizes do not match the file");
+            }
+            if (header.tableChecksum != ComputeHash(data + sizeof(FileHeader), header.tableSize - sizeof(FileHeader))) {
+                fail("table checksum mismatch");
+            }
+
+            auto cursor = data + sizeof(FileHeader);
+            for (uint32_t i = 0; i < header.assetsCount; ++i, cursor += sizeof(AssetRecord)) {
+                m_assets.push_back(ReadRecord<AssetRecord>(cursor));
+            }
+            for (uint32_t i = 0; i < header.chunksCount; ++i, cursor += sizeof(ChunkRecord)) {
+                auto chunk = ReadRecord<ChunkRecord>(cursor);
+                if (chunk.offset < header.tableSize || chunk.offset % DataAlignment != 0 ||
+                    chunk.offset > size || chunk.size > size - chunk.offset) {
+                    fail("chunk is out of the file");
+                }
+                m_chunks.push_back(chunk);
+            }
+            m_names = reinterpret_cast<const char*>(cursor + uint64_t(header.elementsCount) * sizeof(ElementRecord));
+            for (uint32_t i = 0; i < header.elementsCount; ++i, cursor += sizeof(ElementRecord)) {
+                auto element = ReadRecord<ElementRecord>(cursor);
+                if (uint64_t(element.semanticOffset) + element.semanticSize >= header.namesSize ||
+                    m_names[element.semanticOffset + element.semanticSize] != '\0') {
+                    fail("element semantic is out of the names");
+                }
+                m_elements.push_back(element);
+            }
+
+            for (size_t i = 0; i < m_assets.size(); ++i) {
+                ValidateAsset(m_assets[i], header.namesSize, fail);
+                m_byName.emplace(GetAssetName(i), i);
+            }
+        }
+
+        template<typename Fail>
+        void ValidateAsset(const asset_details::AssetRecord& record, uint32_t namesSize, Fail& fail) const {
+            if (uint64_t(record.nameOffset) + record.nameSize >= namesSize) {
+                fail("asset name is out of the names");
+            }
+            if (uint64_t(record.firstChunk) + record.chunksCount > m_chunks.size()) {
+                fail("asset chunks are out of the chunk table");
+            }
+
+            // Single-chunk assets check chunksCount first: the chunk table may be empty
+            switch (record.type) {
+            case AssetType::Texture: {
+                auto mipLevels = record.parameters[2];
+                auto arraySize = record.parameters[3];
+                auto format = static_cast<TextureFormat>(record.parameters[4]);
+                if (uint64_t(mipLevels) * arraySize != record.chunksCount) {
+                    fail("texture subresources count does not match mips and slices");
+                }
+                for (uint32_t i = 0; i < record.chunksCount; ++i) {
+                    auto& chunk = m_chunks[record.firstChunk + i];
+                    auto height = ComputeMipExtent(record.parameters[1], i % mipLevels);
+                    if (chunk.size < uint64_t(chunk.rowPitch) * ComputeRowsCount(format, height)) {
+                        fail("texture subresource is smaller than its pitch requires");
+                    }
+                }
+                break;
+            }
+            case AssetType::VertexStream:
+                if (record.chunksCount != 1 || m_chunks[record.firstChunk].size != uint64_t(record.parameters[0]) * record.parameters[1] ||
+                    uint64_t(record.parameters[2]) + record.parameters[3] > m_elements.size()) {
+                    fail("vertex stream does not match its description");
+                }
+                break;
+            case AssetType::IndexStream:
+                if (record.chunksCount != 1 || (record.parameters[1] != 2 && record.parameters[1] != 4) ||
+                    m_chunks[record.firstChunk].size != uint64_t(record.parameters[0]) * record.parameters[1]) {
+                    fail("index stream does not match its description");
+                }
+                break;
+            case AssetType::Shader:
+                if (record.chunksCount != 1) {
+                    fail("shader must have one chunk");
+                }
+                break;
+            default:
+                fail("unknown asset type");
+            }
+        }
+
+        size_t GetIndex(std::string_view name) const {
+            auto index = FindAsset(name);
+            if (index == NotFound) {
+                throw std::out_of_range("Asset container has no asset " + std::string(name));
+            }
+            return index;
+        }
+
+        const asset_details::AssetRecord& GetRecord(size_t index, AssetType type) const {
+            auto& record = m_assets.at(index);
+            if (record.type != type) {
+                throw std::invalid_argument("Asset " + std::string(GetAssetName(index)) + " has another type");
+            }
+            return record;
+        }
+
+    private:
+        MappedFile m_file;
+        std::vector<asset_details::AssetRecord> m_assets;
+        std::vector<asset_details::ChunkRecord> m_chunks;
+        std::vector<asset_details::ElementRecord> m_elements;
+        const char* m_names = nullptr;
+        std::unordered_map<std::string_view, size_t> m_byName;
+    };
+}
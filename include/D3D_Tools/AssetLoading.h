@@ -0,0 +1,59 @@
+#pragma once
+
+#include "AssetContainer.h"
+#include "GpuBuffer.h"
+#include "Shader.h"
+#include "Texture.h"
+
+namespace d3d_tools {
+    // Creation calls read straight from the mapped container: nothing is copied on the CPU side
+
+    inline Texture CreateTexture(ID3D11Device* device, const TextureAsset& asset, TextureFlags flags = TextureFlags::ShaderResource) {
+        return CallAndRethrowM + [&] {
+            std::vector<D3D11_SUBRESOURCE_DATA> subresources;
+            subresources.reserve(asset.subresources.size());
+            for (auto& subresource : asset.subresources) {
+                subresources.push_back(D3D11_SUBRESOURCE_DATA{ subresource.data, subresource.rowPitch, subresource.slicePitch });
+            }
+            return Texture(device, asset.desc.width, asset.desc.height, asset.desc.format, flags,
+                asset.desc.mipLevels, asset.desc.arraySize,
+                edt::DenseArrayView<const D3D11_SUBRESOURCE_DATA>(subresources.data(), subresources.size()));
+        };
+    }
+
+    // View for GpuBuffer<Vertex>. The stream must have been written with the layout of Vertex
+    template<typename Vertex>
+    edt::DenseArrayView<const Vertex> MakeVertexView(const VertexStreamAsset& asset) {
+        static_assert(alignof(Vertex) <= asset_details::DataAlignment, "Vertex is aligned stricter than container data");
+        return CallAndRethrowM + [&] {
+            auto& layout = VertexLayoutOf<Vertex>;
+            auto matches = asset.stride == layout.stride && asset.elements.size() == layout.elements.size();
+            for (size_t i = 0; matches && i < asset.elements.size(); ++i) {
+                auto& a = asset.elements[i];
+                auto& b = layout.elements[i];
+                matches = a.semantic == b.semantic && a.semanticIndex == b.semanticIndex && a.format == b.format && a.offset == b.offset;
+            }
+            edt::ThrowIfFailed(matches, "Vertex stream layout differs from the vertex struct");
+            return edt::DenseArrayView<const Vertex>(reinterpret_cast<const Vertex*>(asset.data), asset.vertexCount);
+        };
+    }
+
+    // View for IndexBuffer<IndexType>
+    template<typename IndexType>
+    edt::DenseArrayView<const IndexType> MakeIndexView(const IndexStreamAsset& asset) {
+        return CallAndRethrowM + [&] {
+            edt::ThrowIfFailed(asset.indexSize == sizeof(IndexType), "Index stream has another index size");
+            return edt::DenseArrayView<const IndexType>(static_cast<const IndexType*>(asset.data), asset.indexCount);
+        };
+    }
+
+    template<ShaderType shaderType>
+    ComPtr<typename shader_details::ShaderTraits<shaderType>::Interface> CreateShader(ID3D11Device* device, const ShaderAsset& asset,
+        ID3D11ClassLinkage* linkage = nullptr)
+    {
+        return CallAndRethrowM + [&] {
+            edt::ThrowIfFailed(asset.shaderType == static_cast<uint32_t>(shaderType), "Shader asset has another shader type");
+            return shader_details::ShaderTraits<shaderType>::Create(device, asset.bytecode, asset.size, linkage);
+        };
+    }
+}
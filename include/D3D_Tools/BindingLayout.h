@@ -0,0 +1,354 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace d3d_tools {
+    enum class HlslScalarType : uint8_t {
+        Float,
+        Int,
+        UInt,
+        Bool,
+        Other
+    };
+
+    enum class HlslTypeClass : uint8_t {
+        Scalar,
+        Vector,
+        // row_major matrix: every row takes a register
+        MatrixRows,
+        // column_major matrix (HLSL default): every column takes a register
+        MatrixColumns,
+        Struct
+    };
+
+    // Type of a constant buffer variable as HLSL sees it. Components are 4 bytes (bool included)
+    struct HlslType {
+        static HlslType MakeScalar(HlslScalarType scalarType = HlslScalarType::Float, uint32_t elements = 0) {
+            return HlslType{ HlslTypeClass::Scalar, scalarType, 1, 1, elements, 0 };
+        }
+
+        static HlslType MakeVector(uint32_t columns, HlslScalarType scalarType = HlslScalarType::Float, uint32_t elements = 0) {
+            return HlslType{ HlslTypeClass::Vector, scalarType, 1, columns, elements, 0 };
+        }
+
+        static HlslType MakeMatrix(uint32_t rows, uint32_t columns, bool rowMajor = false, uint32_t elements = 0) {
+            return HlslType{ rowMajor ? HlslTypeClass::MatrixRows : HlslTypeClass::MatrixColumns, HlslScalarType::Float, rows, columns, elements, 0 };
+        }
+
+        // structSize is the packed size of one struct, e.g. HlslConstantPacker::GetSize of its members
+        static HlslType MakeStruct(uint32_t structSize, uint32_t elements = 0) {
+            return HlslType{ HlslTypeClass::Struct, HlslScalarType::Other, 1, 1, elements, structSize };
+        }
+
+        HlslTypeClass typeClass = HlslTypeClass::Scalar;
+        HlslScalarType scalarType = HlslScalarType::Float;
+        uint32_t rows = 1;
+        uint32_t columns = 1;
+        // 0 for non-array variables
+        uint32_t elements = 0;
+        uint32_t structSize = 0;
+    };
+
+    // Constant buffer packing rules of HLSL (fxc):
+    //  - data goes into 16-byte registers; a variable that does not fit the rest of the current register
+    //    starts a new one
+    //  - arrays, structs and matrices always start a new register
+    //  - every array element but the last occupies whole registers
+    //  - buffer size is a multiple of 16 bytes
+    namespace hlsl_packing {
+        static constexpr uint32_t RegisterSize = 16;
+        static constexpr uint32_t ComponentSize = 4;
+
+        inline uint32_t AlignToRegister(uint32_t offset) {
+            return (offset + RegisterSize - 1) / RegisterSize * RegisterSize;
+        }
+
+        inline uint32_t ComputeElementSize(const HlslType& type) {
+            switch (type.typeClass) {
+            case HlslTypeClass::Scalar: return ComponentSize;
+            case HlslTypeClass::Vector: return type.columns * ComponentSize;
+            case HlslTypeClass::MatrixRows: return (type.rows - 1) * RegisterSize + type.columns * ComponentSize;
+            case HlslTypeClass::MatrixColumns: return (type.columns - 1) * RegisterSize + type.rows * ComponentSize;
+            case HlslTypeClass::Struct: return type.structSize;
+            default: throw std::invalid_argument("Unknown HLSL type class");
+            }
+        }
+
+        // Distance between array elements
+        inline uint32_t ComputeArrayStride(const HlslType& type) {
+            return AlignToRegister(ComputeElementSize(type));
+        }
+
+        inline uint32_t ComputeSize(const HlslType& type) {
+            auto elementSize = ComputeElementSize(type);
+            if (type.elements == 0) {
+                return elementSize;
+            }
+            return (type.elements - 1) * AlignToRegister(elementSize) + elementSize;
+        }
+
+        inline bool StartsRegister(const HlslType& type) {
+            return
+                type.elements > 0 ||
+                type.typeClass == HlslTypeClass::Struct ||
+                type.typeClass == HlslTypeClass::MatrixRows ||
+                type.typeClass == HlslTypeClass::MatrixColumns;
+        }
+
+        // Next offset where a variable of the type may be placed
+        inline uint32_t ComputeOffset(uint32_t offset, const HlslType& type) {
+            auto size = ComputeSize(type);
+            if (StartsRegister(type) || offset % RegisterSize + size > RegisterSize) {
+                return AlignToRegister(offset);
+            }
+            return offset;
+        }
+    }
+
+    // Lays variables out one after another the way the compiler does for a cbuffer
+    class HlslConstantPacker {
+    public:
+        // Returns offset of the added variable
+        uint32_t Add(const HlslType& type) {
+            auto offset = hlsl_packing::ComputeOffset(m_size, type);
+            m_size = offset + hlsl_packing::ComputeSize(type);
+            return offset;
+        }
+
+        // Bytes used so far: the size of a struct with these members
+        uint32_t GetSize() const {
+            return m_size;
+        }
+
+        uint32_t GetBufferSize() const {
+            return std::max(hlsl_packing::AlignToRegister(m_size), hlsl_packing::RegisterSize);
+        }
+
+    private:
+        uint32_t m_size = 0;
+    };
+
+    struct ConstantVariableLayout {
+        std::string name;
+        HlslType type;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    struct ConstantBufferLayout {
+        static constexpr uint32_t NotFound = ~0u;
+
+        uint32_t FindVariable(std::string_view variableName) const {
+            for (size_t i = 0; i < variables.size(); ++i) {
+                if (variables[i].name == variableName) {
+                    return static_cast<uint32_t>(i);
+                }
+            }
+            return NotFound;
+        }
+
+        // Appends a variable packed after the existing ones. For layouts built by hand
+        ConstantVariableLayout& AddVariable(std::string variableName, const HlslType& type) {
+            auto offset = variables.empty() ? 0 : variables.back().offset + variables.back().size;
+            ConstantVariableLayout variable;
+            variable.name = std::move(variableName);
+            variable.type = type;
+            variable.offset = hlsl_packing::ComputeOffset(offset, type);
+            variable.size = hlsl_packing::ComputeSize(type);
+            size = std::max(size, hlsl_packing::AlignToRegister(variable.offset + variable.size));
+            variables.push_back(std::move(variable));
+            return variables.back();
+        }
+
+        std::string name;
+        uint32_t slot = 0;
+        uint32_t size = 0;
+        std::vector<ConstantVariableLayout> variables;
+    };
+
+    enum class ShaderBindingKind : uint8_t {
+        ConstantBuffer,
+        ShaderResource,
+        Sampler,
+        UnorderedAccess
+    };
+
+    struct ShaderBinding {
+        std::string name;
+        ShaderBindingKind kind;
+        uint32_t slot;
+        uint32_t count;
+    };
+
+    // Everything a shader expects to be bound: constant buffers with their variables and resource slots
+    struct BindingLayout {
+        const ConstantBufferLayout* FindConstantBuffer(std::string_view name) const {
+            for (auto& buffer : constantBuffers) {
+                if (buffer.name == name) {
+                    return &buffer;
+                }
+            }
+            return nullptr;
+        }
+
+        const ShaderBinding* FindBinding(std::string_view name) const {
+            for (auto& binding : bindings) {
+                if (binding.name == name) {
+                    return &binding;
+                }
+            }
+            return nullptr;
+        }
+
+        uint32_t GetSlot(ShaderBindingKind kind, std::string_view name) const {
+            for (auto& binding : bindings) {
+                if (binding.kind == kind && binding.name == name) {
+                    return binding.slot;
+                }
+            }
+            throw std::out_of_range("Shader has no binding named " + std::string(name));
+        }
+
+        bool IsSlotUsed(ShaderBindingKind kind, uint32_t slot) const {
+            for (auto& binding : bindings) {
+                if (binding.kind == kind && slot >= binding.slot && slot < binding.slot + binding.count) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::vector<ConstantBufferLayout> constantBuffers;
+        // Sorted by kind, then by slot
+        std::vector<ShaderBinding> bindings;
+    };
+
+    struct ConstantBufferWriterStatistics {
+        uint64_t writesCount = 0;
+        // Writes that changed the content
+        uint64_t changesCount = 0;
+    };
+
+    // CPU copy of a constant buffer. Writes are compared with the current content, so the buffer
+    // is only uploaded when some variable really changed; the changed byte range is tracked
+    class ConstantBufferWriter {
+    public:
+        explicit ConstantBufferWriter(ConstantBufferLayout layout) :
+            m_layout(std::move(layout)),
+            m_data(m_layout.size, 0)
+        {
+            MarkDirty(0, m_layout.size);
+        }
+
+        uint32_t GetVariableIndex(std::string_view name) const {
+            auto index = m_layout.FindVariable(name);
+            if (index == ConstantBufferLayout::NotFound) {
+                throw std::out_of_range("Constant buffer " + m_layout.name + " has no variable " + std::string(name));
+            }
+            return index;
+        }
+
+        // Whole variable. T must have the HLSL layout of the variable (e.g. float4 padding in arrays)
+        template<typename T>
+        bool Set(uint32_t variableIndex, const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>, "Constant buffer values are copied as bytes");
+            auto& variable = m_layout.variables.at(variableIndex);
+            if (sizeof(T) > variable.size) {
+                throw std::invalid_argument("Value is larger than constant buffer variable " + variable.name);
+            }
+            return Write(variable.offset, &value, sizeof(T));
+        }
+
+        template<typename T>
+        bool Set(std::string_view name, const T& value) {
+            return Set(GetVariableIndex(name), value);
+        }
+
+        // Array element with its register-aligned stride
+        template<typename T>
+        bool SetElement(uint32_t variableIndex, uint32_t element, const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>, "Constant buffer values are copied as bytes");
+            auto& variable = m_layout.variables.at(variableIndex);
+            auto elementsCount = std::max(variable.type.elements, 1u);
+            if (element >= elementsCount) {
+                throw std::out_of_range("Array index is out of range for " + variable.name);
+            }
+            if (sizeof(T) > hlsl_packing::ComputeElementSize(variable.type)) {
+                throw std::invalid_argument("Value is larger than array element of " + variable.name);
+            }
+            return Write(variable.offset + element * hlsl_packing::ComputeArrayStride(variable.type), &value, sizeof(T));
+        }
+
+        // Returns true if the content changed
+        bool Write(uint32_t offset, const void* data, size_t size) {
+            if (offset + size > m_data.size()) {
+                throw std::out_of_range("Write past the end of constant buffer " + m_layout.name);
+            }
+
+            ++m_statistics.writesCount;
+            auto destination = m_data.data() + offset;
+            if (std::memcmp(destination, data, size) == 0) {
+                return false;
+            }
+
+            std::memcpy(destination, data, size);
+            MarkDirty(offset, offset + static_cast<uint32_t>(size));
+            ++m_statistics.changesCount;
+            return true;
+        }
+
+        bool IsDirty() const {
+            return m_dirtyBegin < m_dirtyEnd;
+        }
+
+        // Changed bytes since the last ClearDirty are within [begin, end)
+        uint32_t GetDirtyBegin() const {
+            return m_dirtyBegin;
+        }
+
+        uint32_t GetDirtyEnd() const {
+            return m_dirtyEnd;
+        }
+
+        void ClearDirty() {
+            m_dirtyBegin = static_cast<uint32_t>(m_data.size());
+            m_dirtyEnd = 0;
+        }
+
+        const uint8_t* GetData() const {
+            return m_data.data();
+        }
+
+        uint32_t GetSize() const {
+            return static_cast<uint32_t>(m_data.size());
+        }
+
+        const ConstantBufferLayout& GetLayout() const {
+            return m_layout;
+        }
+
+        const ConstantBufferWriterStatistics& GetStatistics() const {
+            return m_statistics;
+        }
+
+    private:
+        void MarkDirty(uint32_t begin, uint32_t end) {
+            m_dirtyBegin = std::min(m_dirtyBegin, begin);
+            m_dirtyEnd = std::max(m_dirtyEnd, end);
+        }
+
+    private:
+        ConstantBufferLayout m_layout;
+        std::vector<uint8_t> m_data;
+        uint32_t m_dirtyBegin = ~0u;
+        uint32_t m_dirtyEnd = 0;
+        ConstantBufferWriterStatistics m_statistics;
+    };
+}
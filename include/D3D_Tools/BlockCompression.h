@@ -0,0 +1,426 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "TextureFormat.h"
+#include "ThreadPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define D3D_TOOLS_BLOCK_COMPRESSION_SSE2
+#endif
+
+namespace d3d_tools {
+    namespace bc_details {
+        // 4x4 RGBA8 pixels, row by row
+        using Block = uint8_t[64];
+
+        inline uint32_t GetSourceChannelsCount(TextureFormat format) {
+            switch (format) {
+            case TextureFormat::R8_G8_B8_A8_UNORM: return 4;
+            case TextureFormat::R8_UNORM: return 1;
+            default: throw std::invalid_argument("Only R8G8B8A8 and R8 textures can be compressed");
+            }
+        }
+
+        // Pixels outside of the texture replicate the last row and column
+        inline void LoadBlock(
+            const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch, uint32_t channels,
+            uint32_t blockX, uint32_t blockY, Block& block)
+        {
+            for (uint32_t y = 0; y < 4; ++y) {
+                auto row = pixels + size_t(std::min(blockY * 4 + y, height - 1)) * rowPitch;
+                for (uint32_t x = 0; x < 4; ++x) {
+                    auto src = row + size_t(std::min(blockX * 4 + x, width - 1)) * channels;
+                    auto dst = block + (y * 4 + x) * 4;
+                    if (channels == 4) {
+                        std::memcpy(dst, src, 4);
+                    } else {
+                        dst[0] = src[0];
+                        dst[1] = 0;
+                        dst[2] = 0;
+                        dst[3] = 255;
+                    }
+                }
+            }
+        }
+
+        inline void StoreBlock(const Block& block, uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY) {
+            for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; ++y) {
+                auto row = pixels + (size_t(blockY * 4 + y) * width + blockX * 4) * 4;
+                auto count = std::min(4u, width - blockX * 4);
+                std::memcpy(row, block + y * 16, count * 4);
+            }
+        }
+
+        inline void ComputeMinMax(const Block& block, uint8_t (&minColor)[4], uint8_t (&maxColor)[4]) {
+#ifdef D3D_TOOLS_BLOCK_COMPRESSION_SSE2
+            auto row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+            auto row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16));
+            auto row2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 32));
+            auto row3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 48));
+            auto minV = _mm_min_epu8(_mm_min_epu8(row0, row1), _mm_min_epu8(row2, row3));
+            auto maxV = _mm_max_epu8(_mm_max_epu8(row0, row1), _mm_max_epu8(row2, row3));
+            minV = _mm_min_epu8(minV, _mm_srli_si128(minV, 8));
+            minV = _mm_min_epu8(minV, _mm_srli_si128(minV, 4));
+            maxV = _mm_max_epu8(maxV, _mm_srli_si128(maxV, 8));
+            maxV = _mm_max_epu8(maxV, _mm_srli_si128(maxV, 4));
+            auto minPacked = static_cast<uint32_t>(_mm_cvtsi128_si32(minV));
+            auto maxPacked = static_cast<uint32_t>(_mm_cvtsi128_si32(maxV));
+            std::memcpy(minColor, &minPacked, 4);
+            std::memcpy(maxColor, &maxPacked, 4);
+#else
+            for (uint32_t c = 0; c < 4; ++c) {
+                minColor[c] = 255;
+                maxColor[c] = 0;
+            }
+            for (uint32_t i = 0; i < 16; ++i) {
+                for (uint32_t c = 0; c < 4; ++c) {
+                    minColor[c] = std::min(minColor[c], block[i * 4 + c]);
+                    maxColor[c] = std::max(maxColor[c], block[i * 4 + c]);
+                }
+            }
+#endif
+        }
+
+        // dot(pixel - origin, axis) for every pixel of the block
+        inline void ComputeProjections(const Block& block, const int16_t (&origin)[4], const int16_t (&axis)[4], int32_t (&result)[16]) {
+#ifdef D3D_TOOLS_BLOCK_COMPRESSION_SSE2
+            const auto zero = _mm_setzero_si128();
+            const auto originV = _mm_set_epi16(origin[3], origin[2], origin[1], origin[0], origin[3], origin[2], origin[1], origin[0]);
+            const auto axisV = _mm_set_epi16(axis[3], axis[2], axis[1], axis[0], axis[3], axis[2], axis[1], axis[0]);
+            for (uint32_t i = 0; i < 4; ++i) {
+                auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+                auto lo = _mm_madd_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(pixels, zero), originV), axisV);
+                auto hi = _mm_madd_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(pixels, zero), originV), axisV);
+                // Every pixel produced two partial sums: (rg, ba)
+                auto even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+                auto odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(result + i * 4), _mm_add_epi32(even, odd));
+            }
+#else
+            for (uint32_t i = 0; i < 16; ++i) {
+                int32_t sum = 0;
+                for (uint32_t c = 0; c < 4; ++c) {
+                    sum += (block[i * 4 + c] - origin[c]) * axis[c];
+                }
+                result[i] = sum;
+            }
+#endif
+        }
+
+        inline uint16_t PackColor565(const int16_t (&color)[4]) {
+            auto r = (color[0] * 31 + 127) / 255;
+            auto g = (color[1] * 63 + 127) / 255;
+            auto b = (color[2] * 31 + 127) / 255;
+            return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+        }
+
+        inline void UnpackColor565(uint16_t value, int16_t (&color)[4]) {
+            auto r = (value >> 11) & 31;
+            auto g = (value >> 5) & 63;
+            auto b = value & 31;
+            color[0] = static_cast<int16_t>((r << 3) | (r >> 2));
+            color[1] = static_cast<int16_t>((g << 2) | (g >> 4));
+            color[2] = static_cast<int16_t>((b << 3) | (b >> 2));
+            color[3] = 255;
+        }
+
+        inline void WriteUint16(uint8_t* dst, uint16_t value) {
+            dst[0] = static_cast<uint8_t>(value);
+            dst[1] = static_cast<uint8_t>(value >> 8);
+        }
+
+        inline uint16_t ReadUint16(const uint8_t* src) {
+            return static_cast<uint16_t>(src[0] | (src[1] << 8));
+        }
+
+        // Bounding box endpoints (van Waveren) with the diagonal picked by covariance sign
+        // and inset by 1/16 of the range. Always 4-color mode: BC1 alpha is not used
+        inline void EncodeColorBlock(const Block& block, const uint8_t (&minColor)[4], const uint8_t (&maxColor)[4], uint8_t* out) {
+            int16_t low[4] = { minColor[0], minColor[1], minColor[2], 0 };
+            int16_t high[4] = { maxColor[0], maxColor[1], maxColor[2], 0 };
+
+            // Flip channels that are anticorrelated with the widest one
+            uint32_t widest = 0;
+            for (uint32_t c = 1; c < 3; ++c) {
+                if (high[c] - low[c] > high[widest] - low[widest]) {
+                    widest = c;
+                }
+            }
+
+            int32_t mean[3] = {};
+            for (uint32_t i = 0; i < 16; ++i) {
+                for (uint32_t c = 0; c < 3; ++c) {
+                    mean[c] += block[i * 4 + c];
+                }
+            }
+
+            for (uint32_t c = 0; c < 3; ++c) {
+                if (c == widest) {
+                    continue;
+                }
+                int32_t covariance = 0;
+                for (uint32_t i = 0; i < 16; ++i) {
+                    covariance += (block[i * 4 + widest] * 16 - mean[widest]) * (block[i * 4 + c] * 16 - mean[c]) / 256;
+                }
+                if (covariance < 0) {
+                    std::swap(low[c], high[c]);
+                }
+            }
+
+            for (uint32_t c = 0; c < 3; ++c) {
+                auto inset = (high[c] - low[c]) / 16;
+                low[c] = static_cast<int16_t>(low[c] + inset);
+                high[c] = static_cast<int16_t>(high[c] - inset);
+            }
+
+            auto color0 = PackColor565(high);
+            auto color1 = PackColor565(low);
+            if (color0 < color1) {
+                std::swap(color0, color1);
+            }
+
+            WriteUint16(out, color0);
+            WriteUint16(out + 2, color1);
+
+            uint32_t indices = 0;
+            if (color0 != color1) {
+                int16_t endpoint0[4];
+                int16_t endpoint1[4];
+                UnpackColor565(color0, endpoint0);
+                UnpackColor565(color1, endpoint1);
+
+                int16_t axis[4] = {
+                    static_cast<int16_t>(endpoint0[0] - endpoint1[0]),
+                    static_cast<int16_t>(endpoint0[1] - endpoint1[1]),
+                    static_cast<int16_t>(endpoint0[2] - endpoint1[2]),
+                    0
+                };
+                int32_t length = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+                int32_t projections[16];
+                ComputeProjections(block, endpoint1, axis, projections);
+
+                // Palette positions along the axis: 1 -> 0, 3 -> 1/3, 2 -> 2/3, 0 -> 1
+                for (uint32_t i = 0; i < 16; ++i) {
+                    auto t = projections[i] * 6;
+                    uint32_t index = t < length ? 1 : t < 3 * length ? 3 : t < 5 * length ? 2 : 0;
+                    indices |= index << (i * 2);
+                }
+            }
+
+            out[4] = static_cast<uint8_t>(indices);
+            out[5] = static_cast<uint8_t>(indices >> 8);
+            out[6] = static_cast<uint8_t>(indices >> 16);
+            out[7] = static_cast<uint8_t>(indices >> 24);
+        }
+
+        // BC4 block of one channel in 8-value mode
+        inline void EncodeChannelBlock(const Block& block, uint32_t channel, uint8_t low, uint8_t high, uint8_t* out) {
+            out[0] = high;
+            out[1] = low;
+
+            uint64_t indices = 0;
+            if (high != low) {
+                int32_t range = high - low;
+                for (uint32_t i = 0; i < 16; ++i) {
+                    // Nearest of 8 steps from low to high
+                    auto step = ((block[i * 4 + channel] - low) * 14 + range) / (2 * range);
+                    uint64_t index = step == 0 ? 1 : step == 7 ? 0 : 8 - step;
+                    indices |= index << (i * 3);
+                }
+            }
+
+            for (uint32_t i = 0; i < 6; ++i) {
+                out[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+            }
+        }
+
+        inline void DecodeColorBlock(const uint8_t* in, bool forceFourColors, Block& block) {
+            auto color0 = ReadUint16(in);
+            auto color1 = ReadUint16(in + 2);
+
+            int16_t palette[4][4];
+            UnpackColor565(color0, palette[0]);
+            UnpackColor565(color1, palette[1]);
+            for (uint32_t c = 0; c < 3; ++c) {
+                if (forceFourColors || color0 > color1) {
+                    palette[2][c] = static_cast<int16_t>((2 * palette[0][c] + palette[1][c] + 1) / 3);
+                    palette[3][c] = static_cast<int16_t>((palette[0][c] + 2 * palette[1][c] + 1) / 3);
+                } else {
+                    palette[2][c] = static_cast<int16_t>((palette[0][c] + palette[1][c] + 1) / 2);
+                    palette[3][c] = 0;
+                }
+            }
+            palette[2][3] = 255;
+            palette[3][3] = (forceFourColors || color0 > color1) ? 255 : 0;
+
+            uint32_t indices = in[4] | (in[5] << 8) | (in[6] << 16) | (uint32_t(in[7]) << 24);
+            for (uint32_t i = 0; i < 16; ++i) {
+                auto& color = palette[(indices >> (i * 2)) & 3];
+                for (uint32_t c = 0; c < 4; ++c) {
+                    block[i * 4 + c] = static_cast<uint8_t>(color[c]);
+                }
+            }
+        }
+
+        inline void DecodeChannelBlock(const uint8_t* in, uint32_t channel, Block& block) {
+            int32_t value0 = in[0];
+            int32_t value1 = in[1];
+
+            uint8_t palette[8];
+            palette[0] = static_cast<uint8_t>(value0);
+            palette[1] = static_cast<uint8_t>(value1);
+            if (value0 > value1) {
+                for (int32_t i = 2; i < 8; ++i) {
+                    palette[i] = static_cast<uint8_t>(((8 - i) * value0 + (i - 1) * value1 + 3) / 7);
+                }
+            } else {
+                for (int32_t i = 2; i < 6; ++i) {
+                    palette[i] = static_cast<uint8_t>(((6 - i) * value0 + (i - 1) * value1 + 2) / 5);
+                }
+                palette[6] = 0;
+                palette[7] = 255;
+            }
+
+            uint64_t indices = 0;
+            for (uint32_t i = 0; i < 6; ++i) {
+                indices |= uint64_t(in[2 + i]) << (i * 8);
+            }
+
+            for (uint32_t i = 0; i < 16; ++i) {
+                block[i * 4 + channel] = palette[(indices >> (i * 3)) & 7];
+            }
+        }
+
+        inline void EncodeBlock(TextureFormat format, const Block& block, uint8_t* out) {
+            uint8_t minColor[4];
+            uint8_t maxColor[4];
+            ComputeMinMax(block, minColor, maxColor);
+
+            switch (format) {
+            case TextureFormat::BC1_UNORM:
+                EncodeColorBlock(block, minColor, maxColor, out);
+                break;
+            case TextureFormat::BC3_UNORM:
+                EncodeChannelBlock(block, 3, minColor[3], maxColor[3], out);
+                EncodeColorBlock(block, minColor, maxColor, out + 8);
+                break;
+            case TextureFormat::BC4_UNORM:
+                EncodeChannelBlock(block, 0, minColor[0], maxColor[0], out);
+                break;
+            case TextureFormat::BC5_UNORM:
+                EncodeChannelBlock(block, 0, minColor[0], maxColor[0], out);
+                EncodeChannelBlock(block, 1, minColor[1], maxColor[1], out + 8);
+                break;
+            default:
+                throw std::invalid_argument("Encoding to this format is not implemented");
+            }
+        }
+
+        // Decoded like the GPU samples them: missing channels are 0, missing alpha is 255
+        inline void DecodeBlock(TextureFormat format, const uint8_t* in, Block& block) {
+            switch (format) {
+            case TextureFormat::BC1_UNORM:
+                DecodeColorBlock(in, false, block);
+                break;
+            case TextureFormat::BC3_UNORM:
+                DecodeColorBlock(in + 8, true, block);
+                DecodeChannelBlock(in, 3, block);
+                break;
+            case TextureFormat::BC4_UNORM:
+                std::memset(block, 0, sizeof(Block));
+                DecodeChannelBlock(in, 0, block);
+                for (uint32_t i = 0; i < 16; ++i) {
+                    block[i * 4 + 3] = 255;
+                }
+                break;
+            case TextureFormat::BC5_UNORM:
+                std::memset(block, 0, sizeof(Block));
+                DecodeChannelBlock(in, 0, block);
+                DecodeChannelBlock(in + 8, 1, block);
+                for (uint32_t i = 0; i < 16; ++i) {
+                    block[i * 4 + 3] = 255;
+                }
+                break;
+            default:
+                throw std::invalid_argument("Decoding of this format is not implemented");
+            }
+        }
+
+        template<typename F>
+        void ForEachBlockRow(uint32_t blockRowsCount, ThreadPool* threadPool, F&& f) {
+            if (threadPool) {
+                threadPool->ParallelFor(blockRowsCount, 4, f);
+            } else {
+                f(size_t(0), size_t(blockRowsCount));
+            }
+        }
+    }
+
+    // Compresses R8G8B8A8 or R8 pixels to BC1, BC3, BC4 or BC5. Rows of blocks are encoded in parallel if pool is passed.
+    // BC4 takes the red channel, BC5 takes red and green. Result is tightly packed with ComputeRowPitch(targetFormat, width)
+    inline std::vector<uint8_t> CompressTexture(
+        const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch,
+        TextureFormat sourceFormat, TextureFormat targetFormat, ThreadPool* threadPool = nullptr)
+    {
+        if (width == 0 || height == 0) {
+            throw std::invalid_argument("Texture must not be empty");
+        }
+
+        if (!IsBlockCompressed(targetFormat)) {
+            throw std::invalid_argument("Target format must be block compressed");
+        }
+
+        auto channels = bc_details::GetSourceChannelsCount(sourceFormat);
+        auto blockBytes = GetFormatBlockBytes(targetFormat);
+        auto blocksPerRow = ComputeRowPitch(targetFormat, width) / blockBytes;
+        auto blockRowsCount = ComputeRowsCount(targetFormat, height);
+
+        std::vector<uint8_t> result(ComputeSlicePitch(targetFormat, width, height));
+        bc_details::ForEachBlockRow(blockRowsCount, threadPool, [&](size_t begin, size_t end) {
+            bc_details::Block block;
+            for (auto blockY = begin; blockY < end; ++blockY) {
+                auto out = result.data() + blockY * blocksPerRow * blockBytes;
+                for (uint32_t blockX = 0; blockX < blocksPerRow; ++blockX) {
+                    bc_details::LoadBlock(pixels, width, height, rowPitch, channels, blockX, static_cast<uint32_t>(blockY), block);
+                    bc_details::EncodeBlock(targetFormat, block, out + blockX * blockBytes);
+                }
+            }
+        });
+
+        return result;
+    }
+
+    // Decompresses BC1, BC3, BC4 or BC5 blocks (tightly packed) to R8G8B8A8 pixels
+    inline std::vector<uint8_t> DecompressTexture(
+        const uint8_t* blocks, uint32_t width, uint32_t height,
+        TextureFormat format, ThreadPool* threadPool = nullptr)
+    {
+        if (!IsBlockCompressed(format)) {
+            throw std::invalid_argument("Source format must be block compressed");
+        }
+
+        auto blockBytes = GetFormatBlockBytes(format);
+        auto blocksPerRow = ComputeRowPitch(format, width) / blockBytes;
+        auto blockRowsCount = ComputeRowsCount(format, height);
+
+        std::vector<uint8_t> result(size_t(width) * height * 4);
+        bc_details::ForEachBlockRow(blockRowsCount, threadPool, [&](size_t begin, size_t end) {
+            bc_details::Block block;
+            for (auto blockY = begin; blockY < end; ++blockY) {
+                auto in = blocks + blockY * blocksPerRow * blockBytes;
+                for (uint32_t blockX = 0; blockX < blocksPerRow; ++blockX) {
+                    bc_details::DecodeBlock(format, in + blockX * blockBytes, block);
+                    bc_details::StoreBlock(block, result.data(), width, height, blockX, static_cast<uint32_t>(blockY));
+                }
+            }
+        });
+
+        return result;
+    }
+}
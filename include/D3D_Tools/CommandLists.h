@@ -0,0 +1,165 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "Device.h"
+#include "CommandStream.h"
+
+namespace d3d_tools {
+    namespace command_details {
+        static_assert(sizeof(RecordedViewport) == sizeof(D3D11_VIEWPORT), "Recorded viewport must match D3D11_VIEWPORT");
+
+        template<typename T>
+        edt::DenseArrayView<T* const> AsObjects(const void* const* pointers, uint32_t count) {
+            // Stored pointers are only read back, constness of the pointee is not part of the recording
+            return edt::DenseArrayView<T* const>(reinterpret_cast<T* const*>(const_cast<void* const*>(pointers)), count);
+        }
+
+        template<typename T>
+        T* AsObject(const void* pointer) {
+            return static_cast<T*>(const_cast<void*>(pointer));
+        }
+
+        // Sends recorded commands to the device. Goes through the state cache like direct calls
+        class DeviceReplayer {
+        public:
+            DeviceReplayer(Device& device) :
+                m_device(device)
+            {
+            }
+
+            void SetShader(uint32_t stage, const void* shader) {
+                m_device.SetShader(static_cast<ShaderType>(stage), AsObject<ID3D11DeviceChild>(shader));
+            }
+
+            void SetShaderResources(uint32_t stage, uint32_t startSlot, const void* const* views, uint32_t count) {
+                m_device.SetShaderResources(static_cast<ShaderType>(stage), startSlot, AsObjects<ID3D11ShaderResourceView>(views, count));
+            }
+
+            void SetSamplers(uint32_t stage, uint32_t startSlot, const void* const* samplers, uint32_t count) {
+                m_device.SetSamplers(static_cast<ShaderType>(stage), startSlot, AsObjects<ID3D11SamplerState>(samplers, count));
+            }
+
+            void SetConstantBuffers(uint32_t stage, uint32_t startSlot, const void* const* buffers, uint32_t count) {
+                m_device.SetConstantBuffers(static_cast<ShaderType>(stage), startSlot, AsObjects<ID3D11Buffer>(buffers, count));
+            }
+
+            void SetVertexBuffers(uint32_t startSlot, const RecordedVertexBuffer* buffers, uint32_t count) {
+                for (uint32_t i = 0; i < count; ++i) {
+                    m_device.SetVertexBuffer(AsObject<ID3D11Buffer>(buffers[i].buffer), buffers[i].stride, buffers[i].offset, startSlot + i);
+                }
+            }
+
+            void SetInputLayout(const void* layout) {
+                m_device.SetInputLayout(AsObject<ID3D11InputLayout>(layout));
+            }
+
+            void SetPrimitiveTopology(uint32_t topology) {
+                m_device.SetPrimitiveTopology(static_cast<D3D11_PRIMITIVE_TOPOLOGY>(topology));
+            }
+
+            void SetViewports(const RecordedViewport* viewports, uint32_t count) {
+                m_device.SetViewports(edt::DenseArrayView<const D3D11_VIEWPORT>(reinterpret_cast<const D3D11_VIEWPORT*>(viewports), count));
+            }
+
+            void SetRenderTargets(const void* const* views, uint32_t count, const void* depthStencil) {
+                m_device.SetRenderTargets(AsObjects<ID3D11RenderTargetView>(views, count), AsObject<ID3D11DepthStencilView>(depthStencil));
+            }
+
+            void ClearRenderTarget(const void* view, const float (&color)[4]) {
+                m_device.ClearRenderTarget(AsObject<ID3D11RenderTargetView>(view), color);
+            }
+
+            void ClearDepthStencil(const void* view, float depth, uint8_t stencil, uint32_t flags) {
+                m_device.ClearDepthStencil(AsObject<ID3D11DepthStencilView>(view), depth, stencil, flags);
+            }
+
+            void Draw(uint32_t vertexCount, uint32_t startVertex) {
+                m_device.Draw(vertexCount, startVertex);
+            }
+
+            void SetIndexBuffer(const void* buffer, uint32_t format, uint32_t offset) {
+                m_device.SetIndexBuffer(AsObject<ID3D11Buffer>(buffer), static_cast<DXGI_FORMAT>(format), offset);
+            }
+
+            void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) {
+                m_device.DrawIndexed(indexCount, startIndex, baseVertex);
+            }
+
+            void DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance) {
+                m_device.DrawInstanced(vertexCountPerInstance, instanceCount, startVertex, startInstance);
+            }
+
+            void DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) {
+                m_device.DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndex, baseVertex, startInstance);
+            }
+
+        private:
+            Device& m_device;
+        };
+    }
+
+    inline void ReplayCommands(const CommandRecorder& recorder, Device& device) {
+        CallAndRethrowM + [&] {
+            recorder.Replay(command_details::DeviceReplayer(device));
+        };
+    }
+
+    // Records command lists on worker threads, one deferred context per job,
+    // and executes them on the immediate device in job order regardless of which job finished first
+    class ParallelCommandLists {
+    public:
+        ParallelCommandLists(Device& immediate) :
+            m_immediate(immediate)
+        {
+            edt::ThrowIfFailed(!immediate.IsDeferred(), "Command lists are submitted through the immediate device");
+        }
+
+        // record(job, deferredDevice) is called once per job on the pool. Replaces lists that were not submitted
+        template<typename F>
+        void Record(ThreadPool& threadPool, size_t jobsCount, F&& record) {
+            CallAndRethrowM + [&] {
+                // Contexts are created up front: creation is not worth parallelizing
+                while (m_deferred.size() < jobsCount) {
+                    m_deferred.push_back(std::make_unique<Device>(m_immediate.CreateDeferred()));
+                }
+
+                m_commandLists.resize(jobsCount);
+                threadPool.ParallelFor(jobsCount, 1, [&](size_t begin, size_t end) {
+                    for (auto job = begin; job < end; ++job) {
+                        auto& device = *m_deferred[job];
+                        record(job, device);
+                        m_commandLists[job] = device.FinishCommandList();
+                    }
+                });
+            };
+        }
+
+        // Translates CPU recordings into command lists in parallel
+        void Record(ThreadPool& threadPool, const std::vector<CommandRecorder>& recorders) {
+            Record(threadPool, recorders.size(), [&](size_t job, Device& device) {
+                ReplayCommands(recorders[job], device);
+            });
+        }
+
+        void Submit() {
+            CallAndRethrowM + [&] {
+                for (auto& commandList : m_commandLists) {
+                    if (commandList.Get()) {
+                        m_immediate.ExecuteCommandList(commandList.Get());
+                    }
+                }
+                m_commandLists.clear();
+            };
+        }
+
+        size_t GetPendingCount() const {
+            return m_commandLists.size();
+        }
+
+    private:
+        Device& m_immediate;
+        std::vector<std::unique_ptr<Device>> m_deferred;
+        std::vector<ComPtr<ID3D11CommandList>> m_commandLists;
+    };
+}
@@ -0,0 +1,335 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "ThreadPool.h"
+
+namespace d3d_tools {
+    enum class RecordedCommandType : uint8_t {
+        SetShader,
+        SetShaderResources,
+        SetSamplers,
+        SetConstantBuffers,
+        SetVertexBuffers,
+        SetInputLayout,
+        SetPrimitiveTopology,
+        SetViewports,
+        SetRenderTargets,
+        ClearRenderTarget,
+        ClearDepthStencil,
+        Draw,
+        SetIndexBuffer,
+        DrawIndexed,
+        DrawInstanced,
+        DrawIndexedInstanced
+    };
+
+    // Same layout as D3D11_VIEWPORT
+    struct RecordedViewport {
+        float topLeftX;
+        float topLeftY;
+        float width;
+        float height;
+        float minDepth;
+        float maxDepth;
+    };
+
+    struct RecordedVertexBuffer {
+        const void* buffer;
+        uint32_t stride;
+        uint32_t offset;
+    };
+
+    // CPU command list with the Set*/Draw surface of Device. Objects are stored as opaque pointers,
+    // so recording does not touch D3D and works on any thread or platform.
+    // Commands are packed into one growing byte array; Clear keeps the memory for the next frame
+    class CommandRecorder {
+    public:
+        void SetShader(uint32_t stage, const void* shader) {
+            Write(RecordedCommandType::SetShader, stage, 0, 0, &shader, sizeof(shader));
+        }
+
+        void SetShaderResources(uint32_t stage, uint32_t startSlot, const void* const* views, uint32_t count) {
+            Write(RecordedCommandType::SetShaderResources, stage, startSlot, count, views, sizeof(void*) * count);
+        }
+
+        void SetSamplers(uint32_t stage, uint32_t startSlot, const void* const* samplers, uint32_t count) {
+            Write(RecordedCommandType::SetSamplers, stage, startSlot, count, samplers, sizeof(void*) * count);
+        }
+
+        void SetConstantBuffers(uint32_t stage, uint32_t startSlot, const void* const* buffers, uint32_t count) {
+            Write(RecordedCommandType::SetConstantBuffers, stage, startSlot, count, buffers, sizeof(void*) * count);
+        }
+
+        void SetVertexBuffers(uint32_t startSlot, const RecordedVertexBuffer* buffers, uint32_t count) {
+            Write(RecordedCommandType::SetVertexBuffers, 0, startSlot, count, buffers, sizeof(RecordedVertexBuffer) * count);
+        }
+
+        void SetInputLayout(const void* layout) {
+            Write(RecordedCommandType::SetInputLayout, 0, 0, 0, &layout, sizeof(layout));
+        }
+
+        void SetPrimitiveTopology(uint32_t topology) {
+            Write(RecordedCommandType::SetPrimitiveTopology, 0, topology, 0, nullptr, 0);
+        }
+
+        void SetViewports(const RecordedViewport* viewports, uint32_t count) {
+            Write(RecordedCommandType::SetViewports, 0, 0, count, viewports, sizeof(RecordedViewport) * count);
+        }
+
+        // Payload: render target views followed by the depth stencil view
+        void SetRenderTargets(const void* const* views, uint32_t count, const void* depthStencil) {
+            auto payload = BeginWrite(RecordedCommandType::SetRenderTargets, 0, 0, count, sizeof(void*) * (count + 1));
+            if (count > 0) {
+                std::memcpy(payload, views, sizeof(void*) * count);
+            }
+            std::memcpy(payload + sizeof(void*) * count, &depthStencil, sizeof(void*));
+        }
+
+        void ClearRenderTarget(const void* view, const float (&color)[4]) {
+            ClearRenderTargetPayload payload{ view, { color[0], color[1], color[2], color[3] } };
+            Write(RecordedCommandType::ClearRenderTarget, 0, 0, 0, &payload, sizeof(payload));
+        }
+
+        void ClearDepthStencil(const void* view, float depth, uint8_t stencil, uint32_t flags) {
+            ClearDepthStencilPayload payload{ view, depth, flags, stencil };
+            Write(RecordedCommandType::ClearDepthStencil, 0, 0, 0, &payload, sizeof(payload));
+        }
+
+        void Draw(uint32_t vertexCount, uint32_t startVertex = 0) {
+            Write(RecordedCommandType::Draw, 0, vertexCount, startVertex, nullptr, 0);
+        }
+
+        // format is DXGI_FORMAT value
+        void SetIndexBuffer(const void* buffer, uint32_t format, uint32_t offset = 0) {
+            Write(RecordedCommandType::SetIndexBuffer, 0, format, offset, &buffer, sizeof(buffer));
+        }
+
+        void DrawIndexed(uint32_t indexCount, uint32_t startIndex = 0, int32_t baseVertex = 0) {
+            Write(RecordedCommandType::DrawIndexed, 0, indexCount, startIndex, &baseVertex, sizeof(baseVertex));
+        }
+
+        void DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertex = 0, uint32_t startInstance = 0) {
+            DrawInstancedPayload payload{ vertexCountPerInstance, instanceCount, startVertex, 0, startInstance };
+            Write(RecordedCommandType::DrawInstanced, 0, 0, 0, &payload, sizeof(payload));
+        }
+
+        void DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex = 0, int32_t baseVertex = 0, uint32_t startInstance = 0) {
+            DrawInstancedPayload payload{ indexCountPerInstance, instanceCount, startIndex, baseVertex, startInstance };
+            Write(RecordedCommandType::DrawIndexedInstanced, 0, 0, 0, &payload, sizeof(payload));
+        }
+
+        // Calls visitor methods with the names of the recorded commands in recording order
+        template<typename Visitor>
+        void Replay(Visitor&& visitor) const {
+            size_t position = 0;
+            while (position < m_data.size()) {
+                Header header;
+                std::memcpy(&header, m_data.data() + position, sizeof(header));
+                auto payload = m_data.data() + position + sizeof(Header);
+                switch (header.type) {
+                case RecordedCommandType::SetShader:
+                    visitor.SetShader(header.stage, ReadPointer(payload));
+                    break;
+                case RecordedCommandType::SetShaderResources:
+                    visitor.SetShaderResources(header.stage, header.argument0, AsPointers(payload), header.argument1);
+                    break;
+                case RecordedCommandType::SetSamplers:
+                    visitor.SetSamplers(header.stage, header.argument0, AsPointers(payload), header.argument1);
+                    break;
+                case RecordedCommandType::SetConstantBuffers:
+                    visitor.SetConstantBuffers(header.stage, header.argument0, AsPointers(payload), header.argument1);
+                    break;
+                case RecordedCommandType::SetVertexBuffers:
+                    visitor.SetVertexBuffers(header.argument0, reinterpret_cast<const RecordedVertexBuffer*>(payload), header.argument1);
+                    break;
+                case RecordedCommandType::SetInputLayout:
+                    visitor.SetInputLayout(ReadPointer(payload));
+                    break;
+                case RecordedCommandType::SetPrimitiveTopology:
+                    visitor.SetPrimitiveTopology(header.argument0);
+                    break;
+                case RecordedCommandType::SetViewports:
+                    visitor.SetViewports(reinterpret_cast<const RecordedViewport*>(payload), header.argument1);
+                    break;
+                case RecordedCommandType::SetRenderTargets:
+                    visitor.SetRenderTargets(AsPointers(payload), header.argument1, ReadPointer(payload + sizeof(void*) * header.argument1));
+                    break;
+                case RecordedCommandType::ClearRenderTarget: {
+                    ClearRenderTargetPayload clear;
+                    std::memcpy(&clear, payload, sizeof(clear));
+                    visitor.ClearRenderTarget(clear.view, clear.color);
+                    break;
+                }
+                case RecordedCommandType::ClearDepthStencil: {
+                    ClearDepthStencilPayload clear;
+                    std::memcpy(&clear, payload, sizeof(clear));
+                    visitor.ClearDepthStencil(clear.view, clear.depth, clear.stencil, clear.flags);
+                    break;
+                }
+                case RecordedCommandType::Draw:
+                    visitor.Draw(header.argument0, header.argument1);
+                    break;
+                case RecordedCommandType::SetIndexBuffer:
+                    visitor.SetIndexBuffer(ReadPointer(payload), header.argument0, header.argument1);
+                    break;
+                case RecordedCommandType::DrawIndexed: {
+                    int32_t baseVertex;
+                    std::memcpy(&baseVertex, payload, sizeof(baseVertex));
+                    visitor.DrawIndexed(header.argument0, header.argument1, baseVertex);
+                    break;
+                }
+                case RecordedCommandType::DrawInstanced: {
+                    DrawInstancedPayload draw;
+                    std::memcpy(&draw, payload, sizeof(draw));
+                    visitor.DrawInstanced(draw.count, draw.instanceCount, draw.start, draw.startInstance);
+                    break;
+                }
+                case RecordedCommandType::DrawIndexedInstanced: {
+                    DrawInstancedPayload draw;
+                    std::memcpy(&draw, payload, sizeof(draw));
+                    visitor.DrawIndexedInstanced(draw.count, draw.instanceCount, draw.start, draw.baseVertex, draw.startInstance);
+                    break;
+                }
+                default:
+                    throw std::logic_error("Corrupted command stream");
+                }
+
+                position += header.size;
+            }
+        }
+
+        void Clear() {
+            m_data.clear();
+            m_commandsCount = 0;
+        }
+
+        size_t GetCommandsCount() const {
+            return m_commandsCount;
+        }
+
+        size_t GetSizeInBytes() const {
+            return m_data.size();
+        }
+
+    private:
+        // Packets are padded to this alignment so payloads can be read in place
+        static constexpr size_t PacketAlignment = 8;
+
+        struct Header {
+            RecordedCommandType type;
+            uint8_t stage;
+            uint16_t reserved;
+            uint32_t size;
+            uint32_t argument0;
+            uint32_t argument1;
+        };
+
+        static_assert(sizeof(Header) % PacketAlignment == 0, "Header breaks payload alignment");
+
+        struct ClearRenderTargetPayload {
+            const void* view;
+            float color[4];
+        };
+
+        struct ClearDepthStencilPayload {
+            const void* view;
+            float depth;
+            uint32_t flags;
+            uint8_t stencil;
+        };
+
+        struct DrawInstancedPayload {
+            uint32_t count;
+            uint32_t instanceCount;
+            uint32_t start;
+            int32_t baseVertex;
+            uint32_t startInstance;
+        };
+
+        static const void* ReadPointer(const uint8_t* payload) {
+            const void* result;
+            std::memcpy(&result, payload, sizeof(result));
+            return result;
+        }
+
+        static const void* const* AsPointers(const uint8_t* payload) {
+            return reinterpret_cast<const void* const*>(payload);
+        }
+
+        uint8_t* BeginWrite(RecordedCommandType type, uint32_t stage, uint32_t argument0, uint32_t argument1, size_t payloadSize) {
+            auto packetSize = (sizeof(Header) + payloadSize + PacketAlignment - 1) / PacketAlignment * PacketAlignment;
+
+            Header header{};
+            header.type = type;
+            header.stage = static_cast<uint8_t>(stage);
+            header.size = static_cast<uint32_t>(packetSize);
+            header.argument0 = argument0;
+            header.argument1 = argument1;
+
+            auto position = m_data.size();
+            m_data.resize(position + packetSize);
+            std::memcpy(m_data.data() + position, &header, sizeof(header));
+            ++m_commandsCount;
+            return m_data.data() + position + sizeof(header);
+        }
+
+        void Write(RecordedCommandType type, uint32_t stage, uint32_t argument0, uint32_t argument1, const void* payload, size_t payloadSize) {
+            auto destination = BeginWrite(type, stage, argument0, argument1, payloadSize);
+            if (payloadSize > 0) {
+                std::memcpy(destination, payload, payloadSize);
+            }
+        }
+
+    private:
+        // uint64_t keeps the storage aligned for in place payload reads
+        class AlignedBytes {
+        public:
+            size_t size() const {
+                return m_size;
+            }
+
+            void resize(size_t size) {
+                m_storage.resize((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+                m_size = size;
+            }
+
+            void clear() {
+                m_size = 0;
+            }
+
+            uint8_t* data() {
+                return reinterpret_cast<uint8_t*>(m_storage.data());
+            }
+
+            const uint8_t* data() const {
+                return reinterpret_cast<const uint8_t*>(m_storage.data());
+            }
+
+        private:
+            std::vector<uint64_t> m_storage;
+            size_t m_size = 0;
+        };
+
+        AlignedBytes m_data;
+        size_t m_commandsCount = 0;
+    };
+
+    // Fills recorders[i] with record(i, recorders[i]) on the thread pool.
+    // Results do not depend on scheduling: consumers replay recorders in index order
+    template<typename F>
+    void RecordCommandsInParallel(ThreadPool& threadPool, std::vector<CommandRecorder>& recorders, size_t jobsCount, F&& record) {
+        if (recorders.size() < jobsCount) {
+            recorders.resize(jobsCount);
+        }
+
+        threadPool.ParallelFor(jobsCount, 1, [&](size_t begin, size_t end) {
+            for (auto job = begin; job < end; ++job) {
+                recorders[job].Clear();
+                record(job, recorders[job]);
+            }
+        });
+    }
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include "Device.h"
+#include "EverydayTools\EnumFlag.h"
+#include "IndirectArguments.h"
+
+namespace d3d_tools {
+    enum class BufferFlags {
+        None           = 0,
+        ShaderResource = (1 << 0),
+        RandomAccess   = (1 << 1),
+        // UAV with hidden append/consume counter
+        Append         = (1 << 2),
+        // UAV with hidden counter for IncrementCounter/DecrementCounter
+        Counter        = (1 << 3)
+    };
+
+    EDT_ENUM_FLAG_OPERATORS(BufferFlags);
+
+    namespace compute_buffer_details {
+        inline bool FlagIsSet(BufferFlags flags, BufferFlags flag) {
+            return (flags & flag) != BufferFlags::None;
+        }
+
+        inline UINT MakeBindFlags(BufferFlags flags) {
+            return CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(!(FlagIsSet(flags, BufferFlags::Append) && FlagIsSet(flags, BufferFlags::Counter)),
+                    "Buffer could not have append and counter views at the same time");
+
+                UINT result = 0;
+                if (FlagIsSet(flags, BufferFlags::ShaderResource)) {
+                    result |= D3D11_BIND_SHADER_RESOURCE;
+                }
+                if (FlagIsSet(flags, BufferFlags::RandomAccess | BufferFlags::Append | BufferFlags::Counter)) {
+                    result |= D3D11_BIND_UNORDERED_ACCESS;
+                }
+                return result;
+            };
+        }
+
+        inline UINT MakeUnorderedAccessFlags(BufferFlags flags) {
+            if (FlagIsSet(flags, BufferFlags::Append)) {
+                return D3D11_BUFFER_UAV_FLAG_APPEND;
+            }
+            if (FlagIsSet(flags, BufferFlags::Counter)) {
+                return D3D11_BUFFER_UAV_FLAG_COUNTER;
+            }
+            return 0;
+        }
+    }
+
+    // StructuredBuffer<T> in HLSL, readable through SRV and writable through UAV.
+    // T must follow HLSL structured buffer packing, i.e. no implicit padding
+    template<typename ElementType>
+    class StructuredBuffer
+    {
+    public:
+        StructuredBuffer(
+            Device* device,
+            uint32_t count,
+            BufferFlags flags,
+            edt::DenseArrayView<const ElementType> initialData = edt::DenseArrayView<const ElementType>()) :
+            m_count(count)
+        {
+            CallAndRethrowM + [&] {
+                using namespace compute_buffer_details;
+                edt::ThrowIfFailed(count > 0, "Structured buffer must not be empty");
+                edt::ThrowIfFailed(initialData.GetSize() == 0 || initialData.GetSize() == count,
+                    "Initial data must be empty or match elements count");
+
+                D3D11_BUFFER_DESC desc{};
+                desc.Usage = D3D11_USAGE_DEFAULT;
+                desc.ByteWidth = static_cast<UINT>(sizeof(ElementType) * count);
+                desc.BindFlags = MakeBindFlags(flags);
+                desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+                desc.StructureByteStride = sizeof(ElementType);
+                m_buffer = device->CreateBuffer(desc, initialData.GetSize() ? initialData.GetData() : nullptr);
+
+                auto d3dDevice = device->GetDevice();
+                if (desc.BindFlags & D3D11_BIND_SHADER_RESOURCE) {
+                    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc{};
+                    viewDesc.Format = DXGI_FORMAT_UNKNOWN;
+                    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+                    viewDesc.Buffer.FirstElement = 0;
+                    viewDesc.Buffer.NumElements = count;
+                    WinAPI<char>::ThrowIfError(d3dDevice->CreateShaderResourceView(m_buffer.Get(), &viewDesc, m_shaderResource.Receive()));
+                }
+
+                if (desc.BindFlags & D3D11_BIND_UNORDERED_ACCESS) {
+                    D3D11_UNORDERED_ACCESS_VIEW_DESC viewDesc{};
+                    viewDesc.Format = DXGI_FORMAT_UNKNOWN;
+                    viewDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+                    viewDesc.Buffer.FirstElement = 0;
+                    viewDesc.Buffer.NumElements = count;
+                    viewDesc.Buffer.Flags = MakeUnorderedAccessFlags(flags);
+                    WinAPI<char>::ThrowIfError(d3dDevice->CreateUnorderedAccessView(m_buffer.Get(), &viewDesc, m_unorderedAccess.Receive()));
+                }
+            };
+        }
+
+        // Replaces whole content from the CPU
+        void Update(Device* device, edt::DenseArrayView<const ElementType> elements) {
+            CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(elements.GetSize() == m_count, "Elements count must match buffer size");
+                device->GetContext()->UpdateSubresource(m_buffer.Get(), 0, nullptr, elements.GetData(), 0, 0);
+            };
+        }
+
+        ID3D11Buffer* GetBuffer() const {
+            return m_buffer.Get();
+        }
+
+        // Null if the buffer was created without BufferFlags::ShaderResource
+        ID3D11ShaderResourceView* GetShaderResourceView() const {
+            return m_shaderResource.Get();
+        }
+
+        // Null if the buffer was created without random access flags
+        ID3D11UnorderedAccessView* GetUnorderedAccessView() const {
+            return m_unorderedAccess.Get();
+        }
+
+        uint32_t GetCount() const {
+            return m_count;
+        }
+
+    private:
+        uint32_t m_count;
+        ComPtr<ID3D11Buffer> m_buffer;
+        ComPtr<ID3D11ShaderResourceView> m_shaderResource;
+        ComPtr<ID3D11UnorderedAccessView> m_unorderedAccess;
+    };
+
+    // Source of DrawInstancedIndirect, DrawIndexedInstancedIndirect and DispatchIndirect.
+    // Structured buffers can not hold indirect arguments, so compute shaders write it through an R32_UINT view
+    // (RWBuffer<uint> in HLSL)
+    class IndirectArgumentsBuffer
+    {
+    public:
+        IndirectArgumentsBuffer(Device* device, uint32_t sizeInBytes, bool gpuWritable = true, const void* initialData = nullptr) :
+            m_size(sizeInBytes)
+        {
+            CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(sizeInBytes > 0 && sizeInBytes % IndirectArgumentsAlignment == 0,
+                    "Indirect arguments buffer size must be positive multiple of 4");
+
+                D3D11_BUFFER_DESC desc{};
+                desc.Usage = D3D11_USAGE_DEFAULT;
+                desc.ByteWidth = sizeInBytes;
+                desc.BindFlags = gpuWritable ? D3D11_BIND_UNORDERED_ACCESS : 0;
+                desc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS;
+                m_buffer = device->CreateBuffer(desc, initialData);
+
+                if (gpuWritable) {
+                    D3D11_UNORDERED_ACCESS_VIEW_DESC viewDesc{};
+                    viewDesc.Format = DXGI_FORMAT_R32_UINT;
+                    viewDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+                    viewDesc.Buffer.FirstElement = 0;
+                    viewDesc.Buffer.NumElements = sizeInBytes / sizeof(uint32_t);
+                    WinAPI<char>::ThrowIfError(device->GetDevice()->CreateUnorderedAccessView(
+                        m_buffer.Get(), &viewDesc, m_unorderedAccess.Receive()));
+                }
+            };
+        }
+
+        IndirectArgumentsBuffer(Device* device, const IndirectArgumentsWriter& arguments, bool gpuWritable = true) :
+            IndirectArgumentsBuffer(device, arguments.GetSizeInBytes(), gpuWritable, arguments.GetData())
+        {
+        }
+
+        // Replaces the beginning of the buffer with CPU-written arguments
+        void Update(Device* device, const IndirectArgumentsWriter& arguments) {
+            CallAndRethrowM + [&] {
+                auto size = arguments.GetSizeInBytes();
+                edt::ThrowIfFailed(size <= m_size, GetErrorDescription(IndirectArgumentsError::OutOfBufferBounds));
+                if (size == 0) {
+                    return;
+                }
+
+                D3D11_BOX box{};
+                box.left = 0;
+                box.right = size;
+                box.bottom = 1;
+                box.back = 1;
+                device->GetContext()->UpdateSubresource(m_buffer.Get(), 0, &box, arguments.GetData(), 0, 0);
+            };
+        }
+
+        // Throws if arguments of this type at offset would read past the end of the buffer
+        template<typename Args>
+        void CheckLocation(uint32_t offset) const {
+            auto error = ValidateArgumentsLocation<Args>(m_size, offset);
+            edt::ThrowIfFailed(error == IndirectArgumentsError::None, GetErrorDescription(error));
+        }
+
+        void DrawInstanced(Device* device, uint32_t offset = 0) {
+            CallAndRethrowM + [&] {
+                CheckLocation<DrawInstancedIndirectArgs>(offset);
+                device->DrawInstancedIndirect(m_buffer.Get(), offset);
+            };
+        }
+
+        void DrawIndexedInstanced(Device* device, uint32_t offset = 0) {
+            CallAndRethrowM + [&] {
+                CheckLocation<DrawIndexedInstancedIndirectArgs>(offset);
+                device->DrawIndexedInstancedIndirect(m_buffer.Get(), offset);
+            };
+        }
+
+        void Dispatch(Device* device, uint32_t offset = 0) {
+            CallAndRethrowM + [&] {
+                CheckLocation<DispatchIndirectArgs>(offset);
+                device->DispatchIndirect(m_buffer.Get(), offset);
+            };
+        }
+
+        ID3D11Buffer* GetBuffer() const {
+            return m_buffer.Get();
+        }
+
+        // Null if the buffer is not GPU writable
+        ID3D11UnorderedAccessView* GetUnorderedAccessView() const {
+            return m_unorderedAccess.Get();
+        }
+
+        uint32_t GetSizeInBytes() const {
+            return m_size;
+        }
+
+    private:
+        uint32_t m_size;
+        ComPtr<ID3D11Buffer> m_buffer;
+        ComPtr<ID3D11UnorderedAccessView> m_unorderedAccess;
+    };
+}
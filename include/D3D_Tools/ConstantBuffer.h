@@ -0,0 +1,86 @@
+#pragma once
+
+#include "BindingLayout.h"
+#include "BufferMapper.h"
+#include "Device.h"
+
+namespace d3d_tools {
+    struct ConstantBufferStatistics {
+        uint64_t commitsCount = 0;
+        // Commits that mapped the buffer: the rest found nothing changed
+        uint64_t uploadsCount = 0;
+    };
+
+    // Dynamic constant buffer with the layout of a reflected cbuffer. Variables are written to the
+    // CPU copy and the buffer is mapped only on Commit after something really changed.
+    // Constant buffers can not be partially updated in D3D 11.0, so a commit uploads the whole buffer
+    class ConstantBuffer {
+    public:
+        ConstantBuffer(Device* device, ConstantBufferLayout layout) :
+            m_writer(std::move(layout))
+        {
+            CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(m_writer.GetSize() > 0 && m_writer.GetSize() % hlsl_packing::RegisterSize == 0,
+                    "Constant buffer size must be a non-zero multiple of 16");
+                D3D11_BUFFER_DESC desc{};
+                desc.Usage = D3D11_USAGE_DYNAMIC;
+                desc.ByteWidth = m_writer.GetSize();
+                desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+                desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+                m_buffer = device->CreateBuffer(desc);
+            };
+        }
+
+        ConstantBufferWriter& GetWriter() {
+            return m_writer;
+        }
+
+        const ConstantBufferWriter& GetWriter() const {
+            return m_writer;
+        }
+
+        template<typename T>
+        bool Set(std::string_view name, const T& value) {
+            return m_writer.Set(name, value);
+        }
+
+        // Returns true if the buffer was uploaded
+        bool Commit(Device* device) {
+            return CallAndRethrowM + [&] {
+                ++m_statistics.commitsCount;
+                if (!m_writer.IsDirty()) {
+                    return false;
+                }
+
+                BufferMapper<uint8_t> mapper(m_buffer, device->GetContext(), D3D11_MAP_WRITE_DISCARD);
+                mapper.Write(m_writer.GetData(), m_writer.GetSize());
+                m_writer.ClearDirty();
+                ++m_statistics.uploadsCount;
+                return true;
+            };
+        }
+
+        // Binds to the slot the shader reflection reported
+        void Bind(Device* device, ShaderType shaderType) {
+            device->SetConstantBuffer(m_buffer.Get(), shaderType, m_writer.GetLayout().slot);
+        }
+
+        void CommitAndBind(Device* device, ShaderType shaderType) {
+            Commit(device);
+            Bind(device, shaderType);
+        }
+
+        ID3D11Buffer* GetBuffer() const {
+            return m_buffer.Get();
+        }
+
+        const ConstantBufferStatistics& GetStatistics() const {
+            return m_statistics;
+        }
+
+    private:
+        ConstantBufferWriter m_writer;
+        ComPtr<ID3D11Buffer> m_buffer;
+        ConstantBufferStatistics m_statistics;
+    };
+}
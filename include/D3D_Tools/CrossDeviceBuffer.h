@@ -1,16 +1,28 @@
 #pragma once
 
 #include "GpuBuffer.h"
+#include "DirtyRanges.h"
 
 namespace d3d_tools {
+    struct CrossDeviceBufferSyncPolicy {
+        // Dirty ranges closer than this number of elements are uploaded as one range
+        size_t mergeGap = 64;
+        // Whole buffer is uploaded at once if dirty part is bigger than this fraction
+        float fullUploadThreshold = 0.5f;
+        // Whole buffer is uploaded at once if there are too many separate ranges
+        size_t maxRangesCount = 64;
+    };
+
     class ICrossDeviceBuffer
     {
     public:
         virtual ~ICrossDeviceBuffer() = default;
         virtual std::shared_ptr<IGpuBuffer> GetGpuBuffer() const = 0;
         virtual void BeginUpdate() = 0;
+        virtual void BeginUpdate(size_t firstElement, size_t count) = 0;
         virtual void EndUpdate() = 0;
         virtual void Sync(Device* device) = 0;
+        virtual size_t GetLastSyncUploadedBytes() const = 0;
     };
 
     template<typename ElementType>
@@ -19,8 +31,12 @@ namespace d3d_tools {
     public:
         CrossDeviceBuffer(
             Device* device, D3D_PRIMITIVE_TOPOLOGY topology,
-            edt::DenseArrayView<const ElementType> elements) :
-            m_gpuBuffer(std::make_shared<GpuBuffer<ElementType>>(device, topology, elements))
+            edt::DenseArrayView<const ElementType> elements,
+            CrossDeviceBufferSyncPolicy policy = CrossDeviceBufferSyncPolicy()) :
+            m_policy(policy),
+            m_dirtyRanges(policy.mergeGap),
+            // Default usage is required to update parts of the buffer with UpdateSubresource
+            m_gpuBuffer(std::make_shared<GpuBuffer<ElementType>>(device, topology, elements, D3D11_USAGE_DEFAULT))
         {
             auto count = elements.GetSize();
             if (count == 0) {
@@ -41,8 +57,16 @@ namespace d3d_tools {
             return m_gpuBuffer;
         }
 
+        // Marks the whole buffer as modified
         virtual void BeginUpdate() override {
-            m_dirty = true;
+            m_dirtyRanges.Add(0, m_cpuMirror.size());
+        }
+
+        virtual void BeginUpdate(size_t firstElement, size_t count) override {
+            CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(firstElement + count <= m_cpuMirror.size(), "Updated range is out of buffer bounds");
+                m_dirtyRanges.Add(firstElement, count);
+            };
         }
 
         edt::DenseArrayView<ElementType> MakeView()
@@ -52,23 +76,66 @@ namespace d3d_tools {
             };
         }
 
+        edt::DenseArrayView<ElementType> MakeView(size_t firstElement, size_t count)
+        {
+            return CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(firstElement + count <= m_cpuMirror.size(), "View is out of buffer bounds");
+                return edt::DenseArrayView<ElementType>(m_cpuMirror.data() + firstElement, count);
+            };
+        }
+
         virtual void EndUpdate() override {
             // For now
         }
 
         virtual void Sync(Device* device) override {
-            if (!m_dirty) {
+            m_lastSyncUploadedBytes = 0;
+            if (m_dirtyRanges.IsEmpty() || m_cpuMirror.empty()) {
                 return;
             }
 
-            auto mapper = m_gpuBuffer->MakeBufferMapper(device, D3D11_MAP_WRITE_DISCARD);
-            mapper.Write(m_cpuMirror.data(), m_cpuMirror.size());
-            m_dirty = false;
+            CallAndRethrowM + [&] {
+                auto context = device->GetContext();
+                auto buffer = m_gpuBuffer->GetBuffer();
+                auto& ranges = m_dirtyRanges.GetRanges();
+                auto dirtyCount = m_dirtyRanges.GetDirtyCount();
+                auto fullUpload =
+                    ranges.size() > m_policy.maxRangesCount ||
+                    dirtyCount >= m_policy.fullUploadThreshold * m_cpuMirror.size();
+
+                if (fullUpload) {
+                    context->UpdateSubresource(buffer, 0, nullptr, m_cpuMirror.data(), 0, 0);
+                    m_lastSyncUploadedBytes = m_cpuMirror.size() * sizeof(ElementType);
+                } else {
+                    for (auto& range : ranges) {
+                        D3D11_BOX box{};
+                        box.left = static_cast<UINT>(range.begin * sizeof(ElementType));
+                        box.right = static_cast<UINT>(range.end * sizeof(ElementType));
+                        box.bottom = 1;
+                        box.back = 1;
+                        context->UpdateSubresource(buffer, 0, &box, m_cpuMirror.data() + range.begin, 0, 0);
+                        m_lastSyncUploadedBytes += range.GetSize() * sizeof(ElementType);
+                    }
+                }
+
+                m_dirtyRanges.Clear();
+            };
+        }
+
+        virtual size_t GetLastSyncUploadedBytes() const override {
+            return m_lastSyncUploadedBytes;
+        }
+
+        void SetSyncPolicy(CrossDeviceBufferSyncPolicy policy) {
+            m_policy = policy;
+            m_dirtyRanges.SetMergeGap(policy.mergeGap);
         }
 
     private:
-        bool m_dirty = true;
+        CrossDeviceBufferSyncPolicy m_policy;
+        DirtyRangeTracker m_dirtyRanges;
+        size_t m_lastSyncUploadedBytes = 0;
         std::shared_ptr<GpuBuffer<ElementType>> m_gpuBuffer;
         std::vector<ElementType> m_cpuMirror;
     };
-}
\ No newline at end of file
+}
@@ -7,10 +7,140 @@
 #include "EverydayTools/Exception/ThrowIfFailed.h"
 #include "WinWrappers\ComPtr.h"
 #include "WinWrappers\WinWrappers.h"
+#include "IndirectArguments.h"
+#include "PipelineState.h"
 #include "Texture.h"
 #include "Shader.h"
+#include "StateCache.h"
 
 namespace d3d_tools {
+    namespace device_details {
+        struct StageMethods {
+            void (ID3D11DeviceContext::*setShaderResources)(UINT, UINT, ID3D11ShaderResourceView* const *);
+            void (ID3D11DeviceContext::*setSamplers)(UINT, UINT, ID3D11SamplerState* const *);
+            void (ID3D11DeviceContext::*setConstantBuffers)(UINT, UINT, ID3D11Buffer* const *);
+        };
+
+        inline const StageMethods& GetStageMethods(ShaderType shaderType) {
+            static const StageMethods compute{
+                &ID3D11DeviceContext::CSSetShaderResources,
+                &ID3D11DeviceContext::CSSetSamplers,
+                &ID3D11DeviceContext::CSSetConstantBuffers };
+            static const StageMethods domain{
+                &ID3D11DeviceContext::DSSetShaderResources,
+                &ID3D11DeviceContext::DSSetSamplers,
+                &ID3D11DeviceContext::DSSetConstantBuffers };
+            static const StageMethods geometry{
+                &ID3D11DeviceContext::GSSetShaderResources,
+                &ID3D11DeviceContext::GSSetSamplers,
+                &ID3D11DeviceContext::GSSetConstantBuffers };
+            static const StageMethods hull{
+                &ID3D11DeviceContext::HSSetShaderResources,
+                &ID3D11DeviceContext::HSSetSamplers,
+                &ID3D11DeviceContext::HSSetConstantBuffers };
+            static const StageMethods pixel{
+                &ID3D11DeviceContext::PSSetShaderResources,
+                &ID3D11DeviceContext::PSSetSamplers,
+                &ID3D11DeviceContext::PSSetConstantBuffers };
+            static const StageMethods vertex{
+                &ID3D11DeviceContext::VSSetShaderResources,
+                &ID3D11DeviceContext::VSSetSamplers,
+                &ID3D11DeviceContext::VSSetConstantBuffers };
+
+            switch (shaderType)
+            {
+            case ShaderType::Compute: return compute;
+            case ShaderType::Domain: return domain;
+            case ShaderType::Geometry: return geometry;
+            case ShaderType::Hull: return hull;
+            case ShaderType::Pixel: return pixel;
+            case ShaderType::Vertex: return vertex;
+            default: throw std::invalid_argument("Not implemented for this shader type");
+            }
+        }
+
+        // Calls of BindingCache performed on a D3D11 context. Stages are numbered as ShaderType
+        struct ContextBindings {
+            using Shader = ID3D11DeviceChild;
+            using ShaderResource = ID3D11ShaderResourceView;
+            using Sampler = ID3D11SamplerState;
+            using Buffer = ID3D11Buffer;
+            using InputLayout = ID3D11InputLayout;
+            using Topology = D3D11_PRIMITIVE_TOPOLOGY;
+            using IndexFormat = DXGI_FORMAT;
+            using BlendState = ID3D11BlendState;
+            using DepthStencilState = ID3D11DepthStencilState;
+            using RasterizerState = ID3D11RasterizerState;
+
+            static constexpr uint32_t StagesCount = static_cast<uint32_t>(ShaderType::Vertex) + 1;
+            static constexpr uint32_t ShaderResourceSlotsCount = D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT;
+            static constexpr uint32_t SamplerSlotsCount = D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT;
+            static constexpr uint32_t ConstantBufferSlotsCount = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+            static constexpr uint32_t VertexBufferSlotsCount = D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+
+            template<ShaderType shaderType>
+            void SetShader(ID3D11DeviceChild* shader) {
+                using Traits = shader_details::ShaderTraits<shaderType>;
+                Traits::Set(context, static_cast<typename Traits::Interface*>(shader), nullptr, 0);
+            }
+
+            void SetShader(uint32_t stage, ID3D11DeviceChild* shader) {
+                switch (static_cast<ShaderType>(stage)) {
+                case ShaderType::Compute: SetShader<ShaderType::Compute>(shader); break;
+                case ShaderType::Domain: SetShader<ShaderType::Domain>(shader); break;
+                case ShaderType::Geometry: SetShader<ShaderType::Geometry>(shader); break;
+                case ShaderType::Hull: SetShader<ShaderType::Hull>(shader); break;
+                case ShaderType::Pixel: SetShader<ShaderType::Pixel>(shader); break;
+                case ShaderType::Vertex: SetShader<ShaderType::Vertex>(shader); break;
+                default: throw std::invalid_argument("Not implemented for this shader type");
+                }
+            }
+
+            void SetShaderResources(uint32_t stage, uint32_t startSlot, uint32_t count, ID3D11ShaderResourceView* const* views) {
+                (context->*GetStageMethods(static_cast<ShaderType>(stage)).setShaderResources)(startSlot, count, views);
+            }
+
+            void SetSamplers(uint32_t stage, uint32_t startSlot, uint32_t count, ID3D11SamplerState* const* samplers) {
+                (context->*GetStageMethods(static_cast<ShaderType>(stage)).setSamplers)(startSlot, count, samplers);
+            }
+
+            void SetConstantBuffers(uint32_t stage, uint32_t startSlot, uint32_t count, ID3D11Buffer* const* buffers) {
+                (context->*GetStageMethods(static_cast<ShaderType>(stage)).setConstantBuffers)(startSlot, count, buffers);
+            }
+
+            void SetVertexBuffers(uint32_t startSlot, uint32_t count, ID3D11Buffer* const* buffers, const uint32_t* strides, const uint32_t* offsets) {
+                context->IASetVertexBuffers(startSlot, count, buffers, strides, offsets);
+            }
+
+            void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, uint32_t offset) {
+                context->IASetIndexBuffer(buffer, format, offset);
+            }
+
+            void SetInputLayout(ID3D11InputLayout* layout) {
+                context->IASetInputLayout(layout);
+            }
+
+            void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) {
+                context->IASetPrimitiveTopology(topology);
+            }
+
+            void SetBlendState(ID3D11BlendState* state, const float* factor, uint32_t sampleMask) {
+                context->OMSetBlendState(state, factor, sampleMask);
+            }
+
+            void SetDepthStencilState(ID3D11DepthStencilState* state, uint32_t stencilRef) {
+                context->OMSetDepthStencilState(state, stencilRef);
+            }
+
+            void SetRasterizerState(ID3D11RasterizerState* state) {
+                context->RSSetState(state);
+            }
+
+            // Owned by Device
+            ID3D11DeviceContext* context = nullptr;
+        };
+    }
+
     class Device {
     public:
         struct CreateParams {
@@ -18,7 +148,9 @@ namespace d3d_tools {
             bool noDeviceMultithreading = false;
         };
 
-        Device(CreateParams params) {
+        Device(CreateParams params) :
+            m_multithreaded(!params.noDeviceMultithreading)
+        {
             CallAndRethrowM + [&] {
                 unsigned flags = 0;
                 if (params.debugDevice) {
@@ -41,6 +173,47 @@ namespace d3d_tools {
                     m_device.Receive(),
                     nullptr,
                     m_deviceContext.Receive()));
+                m_bindings.GetContext().context = m_deviceContext.Get();
+            };
+        }
+
+        // Device that records into a new deferred context. Its commands reach the GPU
+        // only through FinishCommandList and ExecuteCommandList of the immediate device
+        Device CreateDeferred() const {
+            return CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(m_multithreaded, "Deferred contexts require multithreaded device");
+                ComPtr<ID3D11DeviceContext> context;
+                WinAPI<char>::ThrowIfError(m_device->CreateDeferredContext(0, context.Receive()));
+                return Device(m_device, std::move(context), m_multithreaded, true);
+            };
+        }
+
+        bool IsDeferred() const {
+            return m_deferred;
+        }
+
+        // Context state is reset to defaults afterwards unless restoreState is set
+        ComPtr<ID3D11CommandList> FinishCommandList(bool restoreState = false) {
+            return CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(m_deferred, "Only deferred device can finish command list");
+                FlushBindings();
+                ComPtr<ID3D11CommandList> commandList;
+                WinAPI<char>::ThrowIfError(m_deviceContext->FinishCommandList(restoreState ? TRUE : FALSE, commandList.Receive()));
+                if (!restoreState) {
+                    InvalidateStateCache();
+                }
+                return commandList;
+            };
+        }
+
+        void ExecuteCommandList(ID3D11CommandList* commandList, bool restoreState = false) {
+            CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(!m_deferred, "Command lists are executed by the immediate device");
+                FlushBindings();
+                m_deviceContext->ExecuteCommandList(commandList, restoreState ? TRUE : FALSE);
+                if (!restoreState) {
+                    InvalidateStateCache();
+                }
             };
         }
 
@@ -52,11 +225,17 @@ namespace d3d_tools {
             return m_deviceContext;
         }
 
+        // ID3D11Device methods may be called from several threads
+        bool IsMultithreaded() const {
+            return m_multithreaded;
+        }
+
         template<ShaderType shaderType>
-        decltype(auto) CreateShader(const char* code, const char* entryPoint, ShaderVersion shaderVersion, edt::SparseArrayView<const ShaderMacro> definitions) {
+        decltype(auto) CreateShader(const char* code, const char* entryPoint, ShaderVersion shaderVersion, edt::SparseArrayView<const ShaderMacro> definitions,
+            ShaderCache* cache = nullptr, const ShaderCompiler& compiler = nullptr) {
             return CallAndRethrowM + [&] {
                 Shader<shaderType> result;
-                result.Compile(code, entryPoint, shaderVersion, definitions);
+                result.Compile(code, entryPoint, shaderVersion, definitions, cache, compiler);
                 result.Create(m_device.Get());
                 return result;
             };
@@ -84,23 +263,55 @@ namespace d3d_tools {
 
         template<ShaderType shaderType>
         void SetShader(Shader<shaderType>& shader) {
+            SetShader<shaderType>(shader.shader.Get());
+        }
+
+        template<ShaderType shaderType>
+        void SetShader(typename shader_details::ShaderTraits<shaderType>::Interface* shader) {
             CallAndRethrowM + [&] {
-                using Traits = shader_details::ShaderTraits<shaderType>;
-                Traits::Set(
-                    m_deviceContext.Get(),
-                    shader.shader.Get(),
-                    nullptr,
-                    0);
+                // Compute shaders are not part of a pipeline state, so dispatches keep the fast path
+                if (shaderType != ShaderType::Compute) {
+                    m_pipeline = nullptr;
+                }
+                m_bindings.SetShader(static_cast<uint32_t>(shaderType), shader);
             };
         }
 
+        // For callers that know shader type only at runtime. The object must match the type
+        void SetShader(ShaderType shaderType, ID3D11DeviceChild* shader) {
+            using namespace shader_details;
+            switch (shaderType) {
+            case ShaderType::Compute: SetShader<ShaderType::Compute>(static_cast<ShaderTraits<ShaderType::Compute>::Interface*>(shader)); break;
+            case ShaderType::Domain: SetShader<ShaderType::Domain>(static_cast<ShaderTraits<ShaderType::Domain>::Interface*>(shader)); break;
+            case ShaderType::Geometry: SetShader<ShaderType::Geometry>(static_cast<ShaderTraits<ShaderType::Geometry>::Interface*>(shader)); break;
+            case ShaderType::Hull: SetShader<ShaderType::Hull>(static_cast<ShaderTraits<ShaderType::Hull>::Interface*>(shader)); break;
+            case ShaderType::Pixel: SetShader<ShaderType::Pixel>(static_cast<ShaderTraits<ShaderType::Pixel>::Interface*>(shader)); break;
+            case ShaderType::Vertex: SetShader<ShaderType::Vertex>(static_cast<ShaderTraits<ShaderType::Vertex>::Interface*>(shader)); break;
+            default: throw std::invalid_argument("Not implemented for this shader type");
+            }
+        }
+
         void SetRenderTarget(TextureView<ResourceViewType::RenderTarget>& rtv, TextureView<ResourceViewType::DepthStencil>* dsv = nullptr) {
-            auto pRTV = rtv.GetView();
+            ID3D11RenderTargetView* pRTV = rtv.GetView();
             ID3D11DepthStencilView* pDSV = nullptr;
             if (dsv) {
                 pDSV = dsv->GetView();
             }
-            m_deviceContext->OMSetRenderTargets(1, &pRTV, pDSV);
+            SetRenderTargets(edt::DenseArrayView<ID3D11RenderTargetView* const>(&pRTV, 1), pDSV);
+        }
+
+        void SetRenderTargets(edt::DenseArrayView<ID3D11RenderTargetView* const> views, ID3D11DepthStencilView* depthStencil = nullptr) {
+            // The device silently unbinds shader resources that become outputs, so the cached ones can not be trusted
+            m_bindings.InvalidateShaderResources();
+            m_deviceContext->OMSetRenderTargets(static_cast<UINT>(views.GetSize()), views.GetData(), depthStencil);
+        }
+
+        void ClearRenderTarget(ID3D11RenderTargetView* view, const float (&color)[4]) {
+            m_deviceContext->ClearRenderTargetView(view, color);
+        }
+
+        void ClearDepthStencil(ID3D11DepthStencilView* view, float depth = 1.0f, uint8_t stencil = 0, UINT flags = D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL) {
+            m_deviceContext->ClearDepthStencilView(view, flags, depth, stencil);
         }
 
         void SetViewports(edt::DenseArrayView<const D3D11_VIEWPORT> viewports) {
@@ -110,108 +321,239 @@ namespace d3d_tools {
         }
 
         void Draw(unsigned vertexCount, unsigned startvert = 0) {
+            FlushBindings();
             m_deviceContext->Draw(vertexCount, startvert);
         }
 
+        void DrawIndexed(unsigned indexCount, unsigned startIndex = 0, int baseVertex = 0) {
+            FlushBindings();
+            m_deviceContext->DrawIndexed(indexCount, startIndex, baseVertex);
+        }
+
+        void DrawInstanced(unsigned vertexCountPerInstance, unsigned instanceCount, unsigned startVertex = 0, unsigned startInstance = 0) {
+            FlushBindings();
+            m_deviceContext->DrawInstanced(vertexCountPerInstance, instanceCount, startVertex, startInstance);
+        }
+
+        // startInstance is added to the instance index before per-instance data is fetched,
+        // so several batches may share one instance buffer
+        void DrawIndexedInstanced(unsigned indexCountPerInstance, unsigned instanceCount, unsigned startIndex = 0, int baseVertex = 0, unsigned startInstance = 0) {
+            FlushBindings();
+            m_deviceContext->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndex, baseVertex, startInstance);
+        }
+
         void SetInputLayout(ID3D11InputLayout* layout) {
-            m_deviceContext->IASetInputLayout(layout);
-        }
-
-		void SetShaderResource(uint32_t slot, ShaderType shaderType, ID3D11ShaderResourceView* view) {
-			using Method = void (ID3D11DeviceContext::*)(UINT, UINT, ID3D11ShaderResourceView* const *);
-			Method method = nullptr;
-
-			switch (shaderType)
-			{
-			case d3d_tools::ShaderType::Compute:
-				method = &ID3D11DeviceContext::CSSetShaderResources;
-				break;
-			case d3d_tools::ShaderType::Domain:
-				method = &ID3D11DeviceContext::DSSetShaderResources;
-				break;
-			case d3d_tools::ShaderType::Geometry:
-				method = &ID3D11DeviceContext::GSSetShaderResources;
-				break;
-			case d3d_tools::ShaderType::Hull:
-				method = &ID3D11DeviceContext::HSSetShaderResources;
-				break;
-			case d3d_tools::ShaderType::Pixel:
-				method = &ID3D11DeviceContext::PSSetShaderResources;
-				break;
-			case d3d_tools::ShaderType::Vertex:
-				method = &ID3D11DeviceContext::VSSetShaderResources;
-				break;
-			}
-
-			edt::ThrowIfFailed(method != nullptr, "Not implemented for this shader type");
-			(*m_deviceContext.*method)(slot, 1, &view);
-		}
-
-		void SetSampler(uint32_t slot, ID3D11SamplerState* sampler, ShaderType shaderType) {
-			using Method = void (ID3D11DeviceContext::*)(UINT, UINT, ID3D11SamplerState* const *);
-			Method method = nullptr;
-
-			switch (shaderType)
-			{
-			case d3d_tools::ShaderType::Compute:
-				method = &ID3D11DeviceContext::CSSetSamplers;
-				break;
-			case d3d_tools::ShaderType::Domain:
-				method = &ID3D11DeviceContext::DSSetSamplers;
-				break;
-			case d3d_tools::ShaderType::Geometry:
-				method = &ID3D11DeviceContext::GSSetSamplers;
-				break;
-			case d3d_tools::ShaderType::Hull:
-				method = &ID3D11DeviceContext::HSSetSamplers;
-				break;
-			case d3d_tools::ShaderType::Pixel:
-				method = &ID3D11DeviceContext::PSSetSamplers;
-				break;
-			case d3d_tools::ShaderType::Vertex:
-				method = &ID3D11DeviceContext::VSSetSamplers;
-				break;
-			}
-
-			edt::ThrowIfFailed(method != nullptr, "Not implemented for this shader type");
-			(*m_deviceContext.*method)(slot, 1, &sampler);
-		}
-
-        void SetVertexBuffer(ID3D11Buffer* buffer, unsigned stride, unsigned offset) {
-            m_deviceContext->IASetVertexBuffers(0, 1, &buffer, &stride, &offset);
-        }
-
-        void SetConstantBuffer(ID3D11Buffer* buffer, ShaderType shaderType) {
-            using Method = void (ID3D11DeviceContext::*)(UINT, UINT, ID3D11Buffer* const *);
-            Method method = nullptr;
+            m_pipeline = nullptr;
+            m_bindings.SetInputLayout(layout);
+        }
 
-            switch (shaderType)
-            {
-            case d3d_tools::ShaderType::Compute:
-                method = &ID3D11DeviceContext::CSSetConstantBuffers;
-                break;
-            case d3d_tools::ShaderType::Domain:
-                method = &ID3D11DeviceContext::DSSetConstantBuffers;
-                break;
-            case d3d_tools::ShaderType::Geometry:
-                method = &ID3D11DeviceContext::GSSetConstantBuffers;
-                break;
-            case d3d_tools::ShaderType::Hull:
-                method = &ID3D11DeviceContext::HSSetConstantBuffers;
-                break;
-            case d3d_tools::ShaderType::Pixel:
-                method = &ID3D11DeviceContext::PSSetConstantBuffers;
-                break;
-            case d3d_tools::ShaderType::Vertex:
-                method = &ID3D11DeviceContext::VSSetConstantBuffers;
-                break;
-            }
-            edt::ThrowIfFailed(method != nullptr, "Not implemented for this shader type");
-            (*m_deviceContext.*method)(0, 1, &buffer);
+        void SetShaderResource(uint32_t slot, ShaderType shaderType, ID3D11ShaderResourceView* view) {
+            SetShaderResources(shaderType, slot, edt::DenseArrayView<ID3D11ShaderResourceView* const>(&view, 1));
+        }
+
+        void SetShaderResources(ShaderType shaderType, uint32_t startSlot, edt::DenseArrayView<ID3D11ShaderResourceView* const> views) {
+            CallAndRethrowM + [&] {
+                m_bindings.SetShaderResources(static_cast<uint32_t>(shaderType), startSlot, static_cast<uint32_t>(views.GetSize()), views.GetData());
+            };
+        }
+
+        void SetSampler(uint32_t slot, ID3D11SamplerState* sampler, ShaderType shaderType) {
+            SetSamplers(shaderType, slot, edt::DenseArrayView<ID3D11SamplerState* const>(&sampler, 1));
+        }
+
+        void SetSamplers(ShaderType shaderType, uint32_t startSlot, edt::DenseArrayView<ID3D11SamplerState* const> samplers) {
+            CallAndRethrowM + [&] {
+                m_bindings.SetSamplers(static_cast<uint32_t>(shaderType), startSlot, static_cast<uint32_t>(samplers.GetSize()), samplers.GetData());
+            };
+        }
+
+        void SetConstantBuffer(ID3D11Buffer* buffer, ShaderType shaderType, uint32_t slot = 0) {
+            SetConstantBuffers(shaderType, slot, edt::DenseArrayView<ID3D11Buffer* const>(&buffer, 1));
+        }
+
+        void SetConstantBuffers(ShaderType shaderType, uint32_t startSlot, edt::DenseArrayView<ID3D11Buffer* const> buffers) {
+            CallAndRethrowM + [&] {
+                m_bindings.SetConstantBuffers(static_cast<uint32_t>(shaderType), startSlot, static_cast<uint32_t>(buffers.GetSize()), buffers.GetData());
+            };
+        }
+
+        void SetVertexBuffer(ID3D11Buffer* buffer, unsigned stride, unsigned offset, uint32_t slot = 0) {
+            UINT strideValue = stride;
+            UINT offsetValue = offset;
+            SetVertexBuffers(slot,
+                edt::DenseArrayView<ID3D11Buffer* const>(&buffer, 1),
+                edt::DenseArrayView<const UINT>(&strideValue, 1),
+                edt::DenseArrayView<const UINT>(&offsetValue, 1));
+        }
+
+        void SetVertexBuffers(
+            uint32_t startSlot,
+            edt::DenseArrayView<ID3D11Buffer* const> buffers,
+            edt::DenseArrayView<const UINT> strides,
+            edt::DenseArrayView<const UINT> offsets)
+        {
+            CallAndRethrowM + [&] {
+                auto count = buffers.GetSize();
+                edt::ThrowIfFailed(strides.GetSize() == count && offsets.GetSize() == count,
+                    "Buffers, strides and offsets must have the same size");
+                m_bindings.SetVertexBuffers(startSlot, static_cast<uint32_t>(count), buffers.GetData(), strides.GetData(), offsets.GetData());
+            };
+        }
+
+        // Arguments are read by the GPU from buffer at offset. The buffer must be created with D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS
+        void DrawInstancedIndirect(ID3D11Buffer* arguments, unsigned offset = 0) {
+            CallAndRethrowM + [&] {
+                ThrowIfMisaligned(offset);
+                FlushBindings();
+                m_deviceContext->DrawInstancedIndirect(arguments, offset);
+            };
+        }
+
+        void DrawIndexedInstancedIndirect(ID3D11Buffer* arguments, unsigned offset = 0) {
+            CallAndRethrowM + [&] {
+                ThrowIfMisaligned(offset);
+                FlushBindings();
+                m_deviceContext->DrawIndexedInstancedIndirect(arguments, offset);
+            };
+        }
+
+        void Dispatch(unsigned threadGroupsX, unsigned threadGroupsY = 1, unsigned threadGroupsZ = 1) {
+            CallAndRethrowM + [&] {
+                auto error = ValidateArguments(DispatchIndirectArgs{ threadGroupsX, threadGroupsY, threadGroupsZ });
+                edt::ThrowIfFailed(error == IndirectArgumentsError::None, GetErrorDescription(error));
+                FlushBindings();
+                m_deviceContext->Dispatch(threadGroupsX, threadGroupsY, threadGroupsZ);
+            };
+        }
+
+        void DispatchIndirect(ID3D11Buffer* arguments, unsigned offset = 0) {
+            CallAndRethrowM + [&] {
+                ThrowIfMisaligned(offset);
+                FlushBindings();
+                m_deviceContext->DispatchIndirect(arguments, offset);
+            };
+        }
+
+        // Compute stage UAVs are not cached. initialCounts sets hidden counters of append and counter views,
+        // empty view keeps them
+        void SetUnorderedAccessViews(uint32_t startSlot, edt::DenseArrayView<ID3D11UnorderedAccessView* const> views,
+            edt::DenseArrayView<const UINT> initialCounts = edt::DenseArrayView<const UINT>())
+        {
+            CallAndRethrowM + [&] {
+                auto count = views.GetSize();
+                edt::ThrowIfFailed(startSlot + count <= D3D11_PS_CS_UAV_REGISTER_COUNT, "Slot index is out of range");
+                edt::ThrowIfFailed(initialCounts.GetSize() == 0 || initialCounts.GetSize() == count,
+                    "Initial counts must be empty or match views count");
+
+                // Resources bound as UAV are unbound from shader resource slots by the device
+                m_bindings.InvalidateShaderResources();
+
+                UINT keepCounters[D3D11_PS_CS_UAV_REGISTER_COUNT];
+                std::fill(std::begin(keepCounters), std::end(keepCounters), static_cast<UINT>(-1));
+                m_deviceContext->CSSetUnorderedAccessViews(startSlot, static_cast<UINT>(count), views.GetData(),
+                    initialCounts.GetSize() ? initialCounts.GetData() : keepCounters);
+            };
+        }
+
+        void SetUnorderedAccessView(uint32_t slot, ID3D11UnorderedAccessView* view) {
+            SetUnorderedAccessViews(slot, edt::DenseArrayView<ID3D11UnorderedAccessView* const>(&view, 1));
+        }
+
+        // Writes the hidden counter of an append or counter view as uint32 into destination at offset.
+        // Typical use: instance count of indirect arguments after GPU culling
+        void CopyStructureCount(ID3D11Buffer* destination, unsigned offset, ID3D11UnorderedAccessView* source) {
+            CallAndRethrowM + [&] {
+                ThrowIfMisaligned(offset);
+                m_deviceContext->CopyStructureCount(destination, offset, source);
+            };
+        }
+
+        // format is DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT
+        void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned offset = 0) {
+            CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(format == DXGI_FORMAT_R16_UINT || format == DXGI_FORMAT_R32_UINT, "Index format must be R16_UINT or R32_UINT");
+                m_bindings.SetIndexBuffer(buffer, format, offset);
+            };
+        }
+
+        // Sends accumulated slot changes to the context. Draw calls do it automatically
+        void FlushBindings() {
+            CallAndRethrowM + [&] {
+                m_bindings.Flush();
+            };
         }
 
         void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topo) {
-            m_deviceContext->IASetPrimitiveTopology(topo);
+            m_pipeline = nullptr;
+            m_bindings.SetPrimitiveTopology(topo);
+        }
+
+        // Null blend factor means { 1, 1, 1, 1 }
+        void SetBlendState(ID3D11BlendState* state, const FLOAT* blendFactor = nullptr, UINT sampleMask = 0xffffffff) {
+            m_pipeline = nullptr;
+            m_bindings.SetBlendState(state, blendFactor, sampleMask);
+        }
+
+        void SetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef = 0) {
+            m_pipeline = nullptr;
+            m_bindings.SetDepthStencilState(state, stencilRef);
+        }
+
+        void SetRasterizerState(ID3D11RasterizerState* state) {
+            m_pipeline = nullptr;
+            m_bindings.SetRasterizerState(state);
+        }
+
+        // Setting the same pipeline again is a pointer compare. Otherwise only the parts that differ
+        // from the current state reach the context
+        void SetPipelineState(const PipelineState& pipeline) {
+            CallAndRethrowM + [&] {
+                if (m_pipeline == &pipeline) {
+                    m_bindings.CountRedundantBind();
+                    return;
+                }
+
+                auto& desc = pipeline.GetDescription();
+                SetShader<ShaderType::Vertex>(desc.vertexShader);
+                SetShader<ShaderType::Hull>(desc.hullShader);
+                SetShader<ShaderType::Domain>(desc.domainShader);
+                SetShader<ShaderType::Geometry>(desc.geometryShader);
+                SetShader<ShaderType::Pixel>(desc.pixelShader);
+                SetInputLayout(desc.inputLayout);
+                SetPrimitiveTopology(desc.topology);
+                SetBlendState(pipeline.GetBlendState(), desc.blendFactor, desc.sampleMask);
+                SetDepthStencilState(pipeline.GetDepthStencilState(), desc.stencilRef);
+                SetRasterizerState(pipeline.GetRasterizerState());
+                m_pipeline = &pipeline;
+            };
+        }
+
+        // Null if state was changed by other calls after the last SetPipelineState
+        const PipelineState* GetPipelineState() const {
+            return m_pipeline;
+        }
+
+        // Must be called if someone changed the context state bypassing this object (i.e. through GetContext())
+        void InvalidateStateCache() {
+            m_bindings.Invalidate();
+            m_pipeline = nullptr;
+        }
+
+        const StateCacheStatistics& GetStateCacheStatistics() const {
+            return m_bindings.GetStatistics();
+        }
+
+        void ResetStateCacheStatistics() {
+            m_bindings.ResetStatistics();
+        }
+
+        // Queried once per device and kept: markers are emitted far too often for QueryInterface per scope.
+        // The pointer is valid while the device lives
+        ID3DUserDefinedAnnotation* GetAnnotation() {
+            if (!m_annotation.Get()) {
+                m_annotation = CreateAnnotation();
+            }
+            return m_annotation.Get();
         }
 
         ComPtr<ID3DUserDefinedAnnotation> CreateAnnotation() const {
@@ -247,7 +589,24 @@ namespace d3d_tools {
                         onReflectError);
 
                     if (!error) {
-                        // TODO:
+                        // Shader inputs next to provided elements: mismatched semantics are seen at once
+                        D3D11_SHADER_DESC shaderDesc;
+                        pShaderReflector->GetDesc(&shaderDesc);
+                        reflectionExtraInfo += "Shader inputs:\n";
+                        for (uint32_t i = 0; i < shaderDesc.InputParameters; ++i) {
+                            D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
+                            pShaderReflector->GetInputParameterDesc(i, &paramDesc);
+                            reflectionExtraInfo += "    " + std::string(paramDesc.SemanticName) + std::to_string(paramDesc.SemanticIndex) +
+                                " components mask: " + std::to_string(paramDesc.Mask) +
+                                " component type: " + std::to_string(static_cast<int>(paramDesc.ComponentType)) + '\n';
+                        }
+                        reflectionExtraInfo += "Provided elements:\n";
+                        for (uint32_t i = 0; i < elementsCount; ++i) {
+                            auto& element = elementDescriptor[i];
+                            reflectionExtraInfo += "    " + std::string(element.SemanticName) + std::to_string(element.SemanticIndex) +
+                                " format: " + std::to_string(static_cast<int>(element.Format)) +
+                                " slot: " + std::to_string(element.InputSlot) + '\n';
+                        }
                     }
 
                     throw std::runtime_error(
@@ -282,7 +641,26 @@ namespace d3d_tools {
         }
 
     private:
+        Device(ComPtr<ID3D11Device> device, ComPtr<ID3D11DeviceContext> context, bool multithreaded, bool deferred) :
+            m_multithreaded(multithreaded),
+            m_deferred(deferred),
+            m_device(std::move(device)),
+            m_deviceContext(std::move(context))
+        {
+            m_bindings.GetContext().context = m_deviceContext.Get();
+        }
+
+        static void ThrowIfMisaligned(unsigned offset) {
+            edt::ThrowIfFailed(offset % IndirectArgumentsAlignment == 0, GetErrorDescription(IndirectArgumentsError::MisalignedOffset));
+        }
+
+    private:
+        bool m_multithreaded;
+        bool m_deferred = false;
         ComPtr<ID3D11Device> m_device;
         ComPtr<ID3D11DeviceContext> m_deviceContext;
+        ComPtr<ID3DUserDefinedAnnotation> m_annotation;
+        BindingCache<device_details::ContextBindings> m_bindings;
+        const PipelineState* m_pipeline = nullptr;
     };
 }
\ No newline at end of file
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "Device.h"
+#include "DeviceResourcePool.h"
+#include "RenderGraph.h"
+#include "Texture.h"
+
+namespace d3d_tools {
+    // Pooled texture of the render graph together with the views its bind flags allow
+    struct RenderGraphTextureResource {
+        ComPtr<ID3D11Texture2D> texture;
+        std::unique_ptr<TextureView<ResourceViewType::RenderTarget>> renderTarget;
+        std::unique_ptr<TextureView<ResourceViewType::DepthStencil>> depthStencil;
+        std::unique_ptr<TextureView<ResourceViewType::ShaderResource>> shaderResource;
+    };
+
+    class RenderGraphTextureFactory {
+    public:
+        using Description = D3D11_TEXTURE2D_DESC;
+        using Resource = RenderGraphTextureResource;
+        using DescriptionHash = resource_pool_details::TextureDescriptionHash;
+        using DescriptionEqual = resource_pool_details::TextureDescriptionEqual;
+
+        RenderGraphTextureFactory(Device* device) :
+            m_device(device)
+        {
+        }
+
+        Resource Create(const Description& description) {
+            return CallAndRethrowM + [&] {
+                auto device = m_device->GetDevice().Get();
+
+                Resource result;
+                WinAPI<char>::ThrowIfError(device->CreateTexture2D(&description, nullptr, result.texture.Receive()));
+
+                // Depth textures that are also sampled are created typeless
+                auto format = texture_details::ConvertFormat(description.Format);
+                auto depthFormat = format == TextureFormat::R24_G8_TYPELESS ? TextureFormat::D24_UNORM_S8_UINT : format;
+                auto shaderFormat = format == TextureFormat::R24_G8_TYPELESS ? TextureFormat::R24_UNORM_X8_TYPELESS : format;
+
+                if (description.BindFlags & D3D11_BIND_RENDER_TARGET) {
+                    result.renderTarget = std::make_unique<TextureView<ResourceViewType::RenderTarget>>(device, result.texture.Get(), format);
+                }
+                if (description.BindFlags & D3D11_BIND_DEPTH_STENCIL) {
+                    result.depthStencil = std::make_unique<TextureView<ResourceViewType::DepthStencil>>(device, result.texture.Get(), depthFormat);
+                }
+                if (description.BindFlags & D3D11_BIND_SHADER_RESOURCE) {
+                    result.shaderResource = std::make_unique<TextureView<ResourceViewType::ShaderResource>>(device, result.texture.Get(), shaderFormat);
+                }
+                return result;
+            };
+        }
+
+        static size_t ComputeSize(const Description& description) {
+            return TextureResourceFactory::ComputeSize(description);
+        }
+
+    private:
+        Device* m_device;
+    };
+
+    using RenderGraphTexturePool = ResourcePool<RenderGraphTextureFactory>;
+
+    // Executes render graph on the device. Transient textures come from a pool owned by the backend,
+    // so physical textures of one frame are reused by the next one
+    class DeviceRenderGraphBackend : public IRenderGraphBackend {
+    public:
+        DeviceRenderGraphBackend(Device* device, ResourcePoolSettings poolSettings = ResourcePoolSettings()) :
+            m_device(device),
+            m_pool(RenderGraphTextureFactory(device), poolSettings),
+            m_shaderResourceStages{ ShaderType::Pixel, ShaderType::Compute }
+        {
+        }
+
+        // Stages that get the textures a pass reads, pixel and compute by default
+        void SetShaderResourceStages(std::vector<ShaderType> stages) {
+            m_shaderResourceStages = std::move(stages);
+        }
+
+        // Views of an imported texture for the current frame. Not needed views may be null
+        void SetImportedTexture(
+            RenderGraphTexture texture,
+            ID3D11RenderTargetView* renderTarget,
+            ID3D11DepthStencilView* depthStencil = nullptr,
+            ID3D11ShaderResourceView* shaderResource = nullptr)
+        {
+            m_imported[texture.index] = Views{ renderTarget, depthStencil, shaderResource };
+        }
+
+        ID3D11ShaderResourceView* GetShaderResource(const RenderGraphPassContext& context, RenderGraphTexture texture) const {
+            return GetSlot(context.GetPhysicalTexture(texture)).views.shaderResource;
+        }
+
+        ID3D11RenderTargetView* GetRenderTarget(const RenderGraphPassContext& context, RenderGraphTexture texture) const {
+            return GetSlot(context.GetPhysicalTexture(texture)).views.renderTarget;
+        }
+
+        ID3D11DepthStencilView* GetDepthStencil(const RenderGraphPassContext& context, RenderGraphTexture texture) const {
+            return GetSlot(context.GetPhysicalTexture(texture)).views.depthStencil;
+        }
+
+        virtual void AcquireTexture(uint32_t physicalIndex, const RenderGraphPhysicalTexture& texture) override {
+            CallAndRethrowM + [&] {
+                if (m_slots.size() <= physicalIndex) {
+                    m_slots.resize(physicalIndex + 1);
+                }
+
+                auto& slot = m_slots[physicalIndex];
+                slot.width = texture.desc.width;
+                slot.height = texture.desc.height;
+
+                if (texture.imported.IsValid()) {
+                    auto it = m_imported.find(texture.imported.index);
+                    edt::ThrowIfFailed(it != m_imported.end(), "Imported render graph texture has no views");
+                    slot.views = it->second;
+                    return;
+                }
+
+                slot.lease = m_pool.Acquire(MakeTextureDescription(texture));
+                auto& resource = slot.lease.Get();
+                slot.views.renderTarget = resource.renderTarget ? resource.renderTarget->GetView() : nullptr;
+                slot.views.depthStencil = resource.depthStencil ? resource.depthStencil->GetView() : nullptr;
+                slot.views.shaderResource = resource.shaderResource ? resource.shaderResource->GetView() : nullptr;
+            };
+        }
+
+        virtual void ReleaseTexture(uint32_t physicalIndex) override {
+            auto& slot = m_slots[physicalIndex];
+            slot.lease.Release();
+            slot.views = Views();
+        }
+
+        virtual void BeginPass(const RenderGraphPassBindings& bindings) override {
+            CallAndRethrowM + [&] {
+                m_shaderResources.clear();
+                for (auto physicalTexture : bindings.shaderResources) {
+                    m_shaderResources.push_back(GetSlot(physicalTexture).views.shaderResource);
+                }
+                SetShaderResources();
+
+                ID3D11RenderTargetView* renderTargets[RenderGraph::MaxRenderTargets]{};
+                uint32_t width = 0;
+                uint32_t height = 0;
+
+                for (size_t i = 0; i < bindings.renderTargets.size(); ++i) {
+                    auto& attachment = bindings.renderTargets[i];
+                    auto& slot = GetSlot(attachment.physicalTexture);
+                    renderTargets[i] = slot.views.renderTarget;
+                    if (attachment.clear.enabled) {
+                        float color[4] = { attachment.clear.color[0], attachment.clear.color[1], attachment.clear.color[2], attachment.clear.color[3] };
+                        m_device->ClearRenderTarget(slot.views.renderTarget, color);
+                    }
+                    width = slot.width;
+                    height = slot.height;
+                }
+
+                ID3D11DepthStencilView* depthStencil = nullptr;
+                if (bindings.hasDepthStencil) {
+                    auto& attachment = bindings.depthStencil;
+                    auto& slot = GetSlot(attachment.physicalTexture);
+                    depthStencil = slot.views.depthStencil;
+                    if (attachment.clear.enabled) {
+                        m_device->ClearDepthStencil(depthStencil, attachment.clear.depth, attachment.clear.stencil);
+                    }
+                    width = slot.width;
+                    height = slot.height;
+                }
+
+                if (bindings.renderTargets.empty() && !bindings.hasDepthStencil) {
+                    return;
+                }
+
+                m_device->SetRenderTargets(
+                    edt::DenseArrayView<ID3D11RenderTargetView* const>(renderTargets, bindings.renderTargets.size()),
+                    depthStencil);
+
+                D3D11_VIEWPORT viewport{};
+                viewport.Width = static_cast<float>(width);
+                viewport.Height = static_cast<float>(height);
+                viewport.MaxDepth = 1.0f;
+                m_device->SetViewports(edt::DenseArrayView<const D3D11_VIEWPORT>(&viewport, 1));
+            };
+        }
+
+        // Inputs and outputs are unbound so the next passes can write and read them
+        virtual void EndPass(const RenderGraphPassBindings& bindings) override {
+            CallAndRethrowM + [&] {
+                std::fill(m_shaderResources.begin(), m_shaderResources.end(), nullptr);
+                SetShaderResources();
+
+                if (bindings.renderTargets.empty() && !bindings.hasDepthStencil) {
+                    return;
+                }
+
+                m_device->SetRenderTargets(edt::DenseArrayView<ID3D11RenderTargetView* const>(), nullptr);
+            };
+        }
+
+        // Lets the pool recycle textures that were not used for a while
+        void EndFrame() {
+            m_imported.clear();
+            m_pool.EndFrame();
+        }
+
+        const RenderGraphTexturePool& GetPool() const {
+            return m_pool;
+        }
+
+    private:
+        struct Views {
+            ID3D11RenderTargetView* renderTarget = nullptr;
+            ID3D11DepthStencilView* depthStencil = nullptr;
+            ID3D11ShaderResourceView* shaderResource = nullptr;
+        };
+
+        struct Slot {
+            RenderGraphTexturePool::Lease lease;
+            Views views;
+            uint32_t width = 0;
+            uint32_t height = 0;
+        };
+
+        static D3D11_TEXTURE2D_DESC MakeTextureDescription(const RenderGraphPhysicalTexture& texture) {
+            TextureFlags flags = TextureFlags::None;
+            if (texture.usage & RenderGraphUsageRenderTarget) {
+                flags = flags | TextureFlags::RenderTarget;
+            }
+            if (texture.usage & RenderGraphUsageDepthStencil) {
+                flags = flags | TextureFlags::DepthStencil;
+            }
+            if (texture.usage & RenderGraphUsageShaderResource) {
+                flags = flags | TextureFlags::ShaderResource;
+            }
+
+            auto format = texture.desc.format;
+            if (format == TextureFormat::D24_UNORM_S8_UINT && (texture.usage & RenderGraphUsageShaderResource)) {
+                format = TextureFormat::R24_G8_TYPELESS;
+            }
+
+            return Texture::MakeTextureDescription(texture.desc.width, texture.desc.height, format, flags,
+                texture.desc.mipLevels, texture.desc.arraySize);
+        }
+
+        void SetShaderResources() {
+            if (m_shaderResources.empty()) {
+                return;
+            }
+
+            edt::DenseArrayView<ID3D11ShaderResourceView* const> views(m_shaderResources.data(), m_shaderResources.size());
+            for (auto stage : m_shaderResourceStages) {
+                m_device->SetShaderResources(stage, 0, views);
+            }
+        }
+
+        const Slot& GetSlot(uint32_t physicalIndex) const {
+            edt::ThrowIfFailed(physicalIndex < m_slots.size(), "Render graph texture is not acquired");
+            return m_slots[physicalIndex];
+        }
+
+    private:
+        Device* m_device;
+        RenderGraphTexturePool m_pool;
+        std::vector<Slot> m_slots;
+        std::unordered_map<uint32_t, Views> m_imported;
+        std::vector<ShaderType> m_shaderResourceStages;
+        // Views of the current pass reads
+        std::vector<ID3D11ShaderResourceView*> m_shaderResources;
+    };
+}
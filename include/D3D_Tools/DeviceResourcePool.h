@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Device.h"
+#include "DxgiFormat.h"
+#include "Hash.h"
+#include "ResourcePool.h"
+#include "Texture.h"
+
+namespace d3d_tools {
+    namespace resource_pool_details {
+        // Field by field: descriptions are hashed without relying on their padding
+        struct TextureDescriptionHash {
+            size_t operator()(const D3D11_TEXTURE2D_DESC& d) const {
+                Hasher hasher;
+                hasher.AddValue(d.Width).AddValue(d.Height).AddValue(d.MipLevels).AddValue(d.ArraySize);
+                hasher.AddValue(d.Format).AddValue(d.SampleDesc.Count).AddValue(d.SampleDesc.Quality);
+                hasher.AddValue(d.Usage).AddValue(d.BindFlags).AddValue(d.CPUAccessFlags).AddValue(d.MiscFlags);
+                return static_cast<size_t>(hasher.GetValue());
+            }
+        };
+
+        struct TextureDescriptionEqual {
+            bool operator()(const D3D11_TEXTURE2D_DESC& a, const D3D11_TEXTURE2D_DESC& b) const {
+                return
+                    a.Width == b.Width &&
+                    a.Height == b.Height &&
+                    a.MipLevels == b.MipLevels &&
+                    a.ArraySize == b.ArraySize &&
+                    a.Format == b.Format &&
+                    a.SampleDesc.Count == b.SampleDesc.Count &&
+                    a.SampleDesc.Quality == b.SampleDesc.Quality &&
+                    a.Usage == b.Usage &&
+                    a.BindFlags == b.BindFlags &&
+                    a.CPUAccessFlags == b.CPUAccessFlags &&
+                    a.MiscFlags == b.MiscFlags;
+            }
+        };
+
+        struct BufferDescriptionHash {
+            size_t operator()(const D3D11_BUFFER_DESC& d) const {
+                Hasher hasher;
+                hasher.AddValue(d.ByteWidth).AddValue(d.Usage).AddValue(d.BindFlags);
+                hasher.AddValue(d.CPUAccessFlags).AddValue(d.MiscFlags).AddValue(d.StructureByteStride);
+                return static_cast<size_t>(hasher.GetValue());
+            }
+        };
+
+        struct BufferDescriptionEqual {
+            bool operator()(const D3D11_BUFFER_DESC& a, const D3D11_BUFFER_DESC& b) const {
+                return
+                    a.ByteWidth == b.ByteWidth &&
+                    a.Usage == b.Usage &&
+                    a.BindFlags == b.BindFlags &&
+                    a.CPUAccessFlags == b.CPUAccessFlags &&
+                    a.MiscFlags == b.MiscFlags &&
+                    a.StructureByteStride == b.StructureByteStride;
+            }
+        };
+    }
+
+    class TextureResourceFactory {
+    public:
+        using Description = D3D11_TEXTURE2D_DESC;
+        using Resource = ComPtr<ID3D11Texture2D>;
+        using DescriptionHash = resource_pool_details::TextureDescriptionHash;
+        using DescriptionEqual = resource_pool_details::TextureDescriptionEqual;
+
+        TextureResourceFactory(Device* device) :
+            m_device(device)
+        {
+        }
+
+        Resource Create(const Description& description) {
+            return CallAndRethrowM + [&] {
+                Resource result;
+                WinAPI<char>::ThrowIfError(m_device->GetDevice()->CreateTexture2D(&description, nullptr, result.Receive()));
+                return result;
+            };
+        }
+
+        // Estimation: drivers may pad or compress the actual allocation
+        static size_t ComputeSize(const Description& description) {
+            return CallAndRethrowM + [&] {
+                auto format = description.Format;
+                auto mipLevels = description.MipLevels == 0
+                    ? ComputeMipLevelsCount(description.Width, description.Height)
+                    : description.MipLevels;
+
+                size_t result = 0;
+                for (uint32_t level = 0; level < mipLevels; ++level) {
+                    result += ComputeSlicePitch(format,
+                        ComputeMipExtent(description.Width, level),
+                        ComputeMipExtent(description.Height, level));
+                }
+                return result * description.ArraySize * std::max<UINT>(1, description.SampleDesc.Count);
+            };
+        }
+
+    private:
+        Device* m_device;
+    };
+
+    class BufferResourceFactory {
+    public:
+        using Description = D3D11_BUFFER_DESC;
+        using Resource = ComPtr<ID3D11Buffer>;
+        using DescriptionHash = resource_pool_details::BufferDescriptionHash;
+        using DescriptionEqual = resource_pool_details::BufferDescriptionEqual;
+
+        BufferResourceFactory(Device* device) :
+            m_device(device)
+        {
+        }
+
+        Resource Create(const Description& description) {
+            return m_device->CreateBuffer(description);
+        }
+
+        static size_t ComputeSize(const Description& description) {
+            return description.ByteWidth;
+        }
+
+    private:
+        Device* m_device;
+    };
+
+    using TexturePool = ResourcePool<TextureResourceFactory>;
+    using BufferPool = ResourcePool<BufferResourceFactory>;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace d3d_tools {
+    struct ElementRange {
+        size_t GetSize() const {
+            return end - begin;
+        }
+
+        size_t begin;
+        size_t end;
+    };
+
+    // Keeps sorted list of modified element ranges.
+    // Ranges closer than mergeGap elements are merged to keep the number of uploads low
+    class DirtyRangeTracker {
+    public:
+        DirtyRangeTracker(size_t mergeGap = 0) :
+            m_mergeGap(mergeGap)
+        {
+        }
+
+        void Add(size_t first, size_t count) {
+            if (count == 0) {
+                return;
+            }
+
+            ElementRange range{ first, first + count };
+
+            // First range that may touch the new one
+            auto it = std::lower_bound(m_ranges.begin(), m_ranges.end(), range.begin,
+                [&](const ElementRange& existing, size_t begin) {
+                    return existing.end + m_mergeGap < begin;
+                });
+
+            auto last = it;
+            while (last != m_ranges.end() && last->begin <= range.end + m_mergeGap) {
+                range.begin = std::min(range.begin, last->begin);
+                range.end = std::max(range.end, last->end);
+                ++last;
+            }
+
+            it = m_ranges.erase(it, last);
+            m_ranges.insert(it, range);
+        }
+
+        void Clear() {
+            m_ranges.clear();
+        }
+
+        bool IsEmpty() const {
+            return m_ranges.empty();
+        }
+
+        // Number of elements covered by ranges (including merged gaps)
+        size_t GetDirtyCount() const {
+            size_t result = 0;
+            for (auto& range : m_ranges) {
+                result += range.GetSize();
+            }
+            return result;
+        }
+
+        const std::vector<ElementRange>& GetRanges() const {
+            return m_ranges;
+        }
+
+        // A bigger gap merges the ranges that are already tracked
+        void SetMergeGap(size_t mergeGap) {
+            m_mergeGap = mergeGap;
+            if (m_ranges.empty()) {
+                return;
+            }
+
+            auto merged = m_ranges.begin();
+            for (auto it = std::next(merged); it != m_ranges.end(); ++it) {
+                if (it->begin <= merged->end + m_mergeGap) {
+                    merged->end = std::max(merged->end, it->end);
+                } else {
+                    *++merged = *it;
+                }
+            }
+            m_ranges.erase(std::next(merged), m_ranges.end());
+        }
+
+    private:
+        size_t m_mergeGap;
+        std::vector<ElementRange> m_ranges;
+    };
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cassert>
+#include <vector>
+#include "Device.h"
+#include "DrawSortKey.h"
+
+namespace d3d_tools {
+    // Everything one draw needs. Pointers are not owned: objects must live until Submit
+    struct DrawPacket {
+        static constexpr uint32_t MaxTextures = 8;
+        static constexpr uint32_t MaxSamplers = 4;
+
+        uint64_t sortKey = 0;
+
+        ID3D11RenderTargetView* renderTarget = nullptr;
+        ID3D11DepthStencilView* depthStencil = nullptr;
+
+        ID3D11VertexShader* vertexShader = nullptr;
+        ID3D11PixelShader* pixelShader = nullptr;
+        ID3D11InputLayout* inputLayout = nullptr;
+        D3D11_PRIMITIVE_TOPOLOGY topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+
+        ID3D11Buffer* vertexBuffer = nullptr;
+        uint32_t vertexStride = 0;
+        uint32_t vertexOffset = 0;
+
+        // Indexed draw when set: indexCount, startIndex and baseVertex are used instead of the vertex range
+        ID3D11Buffer* indexBuffer = nullptr;
+        DXGI_FORMAT indexFormat = DXGI_FORMAT_R16_UINT;
+
+        // Pixel shader material
+        ID3D11ShaderResourceView* textures[MaxTextures]{};
+        uint32_t texturesCount = 0;
+        ID3D11SamplerState* samplers[MaxSamplers]{};
+        uint32_t samplersCount = 0;
+
+        ID3D11Buffer* vertexConstants = nullptr;
+        ID3D11Buffer* pixelConstants = nullptr;
+
+        uint32_t vertexCount = 0;
+        uint32_t startVertex = 0;
+
+        uint32_t indexCount = 0;
+        uint32_t startIndex = 0;
+        int32_t baseVertex = 0;
+    };
+
+    struct DrawQueueStatistics {
+        size_t drawsCount = 0;
+        size_t renderTargetChanges = 0;
+        size_t shaderChanges = 0;
+        size_t materialChanges = 0;
+    };
+
+    // Collects draws during the frame and issues them sorted by key, so draws that share
+    // render target, shaders and material go together. Equal keys keep submission order
+    class DrawQueue {
+    public:
+        void Add(const DrawPacket& packet) {
+            CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(packet.texturesCount <= DrawPacket::MaxTextures, "Draw packet has more textures than it can hold");
+                edt::ThrowIfFailed(packet.samplersCount <= DrawPacket::MaxSamplers, "Draw packet has more samplers than it can hold");
+            };
+            m_items.push_back(KeyIndexRadixSorter::Item{ packet.sortKey, static_cast<uint32_t>(m_packets.size()) });
+            m_packets.push_back(packet);
+        }
+
+        // Sorts, submits and clears the queue
+        void Submit(Device& device) {
+            CallAndRethrowM + [&] {
+                m_sorter.Sort(m_items);
+
+                m_statistics = DrawQueueStatistics();
+                const DrawPacket* previous = nullptr;
+                for (auto& item : m_items) {
+                    auto& packet = m_packets[item.index];
+                    Apply(device, packet, previous);
+                    if (packet.indexBuffer) {
+                        device.DrawIndexed(packet.indexCount, packet.startIndex, packet.baseVertex);
+                    } else {
+                        device.Draw(packet.vertexCount, packet.startVertex);
+                    }
+                    previous = &packet;
+                }
+
+                m_statistics.drawsCount = m_items.size();
+                Clear();
+            };
+        }
+
+        void Clear() {
+            m_items.clear();
+            m_packets.clear();
+        }
+
+        size_t GetSize() const {
+            return m_packets.size();
+        }
+
+        // Of the last Submit
+        const DrawQueueStatistics& GetStatistics() const {
+            return m_statistics;
+        }
+
+    private:
+        static bool SameMaterial(const DrawPacket& a, const DrawPacket& b) {
+            return
+                a.texturesCount == b.texturesCount &&
+                a.samplersCount == b.samplersCount &&
+                std::equal(a.textures, a.textures + a.texturesCount, b.textures) &&
+                std::equal(a.samplers, a.samplers + a.samplersCount, b.samplers);
+        }
+
+        // Device filters redundant binds itself; here changes are only counted and render targets are compared
+        // because output merger is not cached by Device
+        void Apply(Device& device, const DrawPacket& packet, const DrawPacket* previous) {
+            // Checked by Add
+            assert(packet.texturesCount <= DrawPacket::MaxTextures && packet.samplersCount <= DrawPacket::MaxSamplers);
+            if (!previous || previous->renderTarget != packet.renderTarget || previous->depthStencil != packet.depthStencil) {
+                auto renderTarget = packet.renderTarget;
+                device.SetRenderTargets(
+                    edt::DenseArrayView<ID3D11RenderTargetView* const>(&renderTarget, renderTarget ? 1 : 0),
+                    packet.depthStencil);
+                ++m_statistics.renderTargetChanges;
+            }
+
+            if (!previous || previous->vertexShader != packet.vertexShader || previous->pixelShader != packet.pixelShader) {
+                ++m_statistics.shaderChanges;
+            }
+            device.SetShader<ShaderType::Vertex>(packet.vertexShader);
+            device.SetShader<ShaderType::Pixel>(packet.pixelShader);
+            device.SetInputLayout(packet.inputLayout);
+            device.SetPrimitiveTopology(packet.topology);
+            device.SetVertexBuffer(packet.vertexBuffer, packet.vertexStride, packet.vertexOffset);
+            if (packet.indexBuffer) {
+                device.SetIndexBuffer(packet.indexBuffer, packet.indexFormat);
+            }
+
+            if (!previous || !SameMaterial(*previous, packet)) {
+                ++m_statistics.materialChanges;
+            }
+            if (packet.texturesCount > 0) {
+                device.SetShaderResources(ShaderType::Pixel, 0,
+                    edt::DenseArrayView<ID3D11ShaderResourceView* const>(packet.textures, packet.texturesCount));
+            }
+            if (packet.samplersCount > 0) {
+                device.SetSamplers(ShaderType::Pixel, 0,
+                    edt::DenseArrayView<ID3D11SamplerState* const>(packet.samplers, packet.samplersCount));
+            }
+
+            if (packet.vertexConstants) {
+                device.SetConstantBuffer(packet.vertexConstants, ShaderType::Vertex);
+            }
+            if (packet.pixelConstants) {
+                device.SetConstantBuffer(packet.pixelConstants, ShaderType::Pixel);
+            }
+        }
+
+    private:
+        std::vector<DrawPacket> m_packets;
+        std::vector<KeyIndexRadixSorter::Item> m_items;
+        KeyIndexRadixSorter m_sorter;
+        DrawQueueStatistics m_statistics;
+    };
+}
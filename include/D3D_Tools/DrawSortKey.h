@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace d3d_tools {
+    // 64-bit draw sort key. Fields from the most significant bits:
+    //   opaque:      target(6) | translucent=0(1) | shader(12) | material(16) | depth(20) | user(9)
+    //   translucent: target(6) | translucent=1(1) | ~depth(20) | shader(12) | material(16) | user(9)
+    // Opaque draws are grouped by state and go front to back, translucent ones go back to front
+    class DrawSortKey {
+    public:
+        static constexpr uint32_t TargetBits = 6;
+        static constexpr uint32_t ShaderBits = 12;
+        static constexpr uint32_t MaterialBits = 16;
+        static constexpr uint32_t DepthBits = 20;
+        static constexpr uint32_t UserBits = 9;
+
+        static constexpr uint32_t UserShift = 0;
+        static constexpr uint32_t TranslucentShift = 64 - TargetBits - 1;
+        static constexpr uint32_t TargetShift = 64 - TargetBits;
+
+        static uint64_t MakeOpaque(uint32_t target, uint32_t shader, uint32_t material, uint32_t depth, uint32_t user = 0) {
+            uint64_t key = 0;
+            key |= Field(target, TargetBits) << TargetShift;
+            key |= Field(shader, ShaderBits) << (TranslucentShift - ShaderBits);
+            key |= Field(material, MaterialBits) << (TranslucentShift - ShaderBits - MaterialBits);
+            key |= Field(depth, DepthBits) << (UserBits);
+            key |= Field(user, UserBits);
+            return key;
+        }
+
+        static uint64_t MakeTranslucent(uint32_t target, uint32_t shader, uint32_t material, uint32_t depth, uint32_t user = 0) {
+            uint64_t key = 0;
+            key |= Field(target, TargetBits) << TargetShift;
+            key |= uint64_t(1) << TranslucentShift;
+            key |= Field(MaxValue(DepthBits) - Field(depth, DepthBits), DepthBits) << (TranslucentShift - DepthBits);
+            key |= Field(shader, ShaderBits) << (MaterialBits + UserBits);
+            key |= Field(material, MaterialBits) << UserBits;
+            key |= Field(user, UserBits);
+            return key;
+        }
+
+        // Maps view depth in [nearZ, farZ] to the depth field. Values outside are clamped,
+        // an empty range and NaN map to 0
+        static uint32_t QuantizeDepth(float depth, float nearZ, float farZ) {
+            auto range = farZ - nearZ;
+            auto t = range != 0.0f ? (depth - nearZ) / range : 0.0f;
+            // Written so that NaN fails the comparison: converting it to an integer is undefined
+            t = t > 0.0f ? std::min(t, 1.0f) : 0.0f;
+            return static_cast<uint32_t>(t * MaxValue(DepthBits));
+        }
+
+        static bool IsTranslucent(uint64_t key) {
+            return ((key >> TranslucentShift) & 1) != 0;
+        }
+
+        static uint32_t GetTarget(uint64_t key) {
+            return static_cast<uint32_t>(key >> TargetShift);
+        }
+
+        static uint32_t GetShader(uint64_t key) {
+            auto shift = IsTranslucent(key) ? MaterialBits + UserBits : TranslucentShift - ShaderBits;
+            return static_cast<uint32_t>((key >> shift) & MaxValue(ShaderBits));
+        }
+
+        static uint32_t GetMaterial(uint64_t key) {
+            auto shift = IsTranslucent(key) ? UserBits : TranslucentShift - ShaderBits - MaterialBits;
+            return static_cast<uint32_t>((key >> shift) & MaxValue(MaterialBits));
+        }
+
+    private:
+        static constexpr uint64_t MaxValue(uint32_t bits) {
+            return (uint64_t(1) << bits) - 1;
+        }
+
+        static uint64_t Field(uint64_t value, uint32_t bits) {
+            return value & MaxValue(bits);
+        }
+    };
+
+    struct DrawSortKeyTransitions {
+        size_t targetChanges = 0;
+        size_t shaderChanges = 0;
+        size_t materialChanges = 0;
+    };
+
+    // Field changes along a sequence of keys: what the state changes of the submission would be
+    inline DrawSortKeyTransitions CountKeyTransitions(const uint64_t* keys, size_t count) {
+        DrawSortKeyTransitions result;
+        for (size_t i = 0; i < count; ++i) {
+            auto key = keys[i];
+            if (i == 0 || DrawSortKey::GetTarget(key) != DrawSortKey::GetTarget(keys[i - 1])) {
+                ++result.targetChanges;
+            }
+            if (i == 0 || DrawSortKey::GetShader(key) != DrawSortKey::GetShader(keys[i - 1])) {
+                ++result.shaderChanges;
+            }
+            if (i == 0 || DrawSortKey::GetMaterial(key) != DrawSortKey::GetMaterial(keys[i - 1])) {
+                ++result.materialChanges;
+            }
+        }
+        return result;
+    }
+
+    // LSD radix sort of (key, index) pairs, 8 bits per pass. Stable.
+    // Passes over bytes that are equal in all keys are skipped, so short keys cost less.
+    // Buffers are kept between calls
+    class KeyIndexRadixSorter {
+    public:
+        struct Item {
+            uint64_t key;
+            uint32_t index;
+        };
+
+        // Sorts items in place
+        void Sort(std::vector<Item>& items) {
+            auto count = items.size();
+            if (count < 2) {
+                return;
+            }
+
+            std::array<std::array<uint32_t, 256>, 8> histograms{};
+            for (auto& item : items) {
+                for (uint32_t pass = 0; pass < 8; ++pass) {
+                    ++histograms[pass][(item.key >> (pass * 8)) & 0xFF];
+                }
+            }
+
+            m_buffer.resize(count);
+            auto* source = &items;
+            auto* destination = &m_buffer;
+            for (uint32_t pass = 0; pass < 8; ++pass) {
+                auto& histogram = histograms[pass];
+                auto shift = pass * 8;
+                if (histogram[(items[0].key >> shift) & 0xFF] == count) {
+                    continue;
+                }
+
+                uint32_t offsets[256];
+                uint32_t sum = 0;
+                for (uint32_t bucket = 0; bucket < 256; ++bucket) {
+                    offsets[bucket] = sum;
+                    sum += histogram[bucket];
+                }
+
+                auto& from = *source;
+                auto& to = *destination;
+                for (size_t i = 0; i < count; ++i) {
+                    auto& item = from[i];
+                    to[offsets[(item.key >> shift) & 0xFF]++] = item;
+                }
+                std::swap(source, destination);
+            }
+
+            if (source != &items) {
+                items.swap(m_buffer);
+            }
+        }
+
+    private:
+        std::vector<Item> m_buffer;
+    };
+}
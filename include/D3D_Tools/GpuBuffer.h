@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <type_traits>
 #include "BufferMapper.h"
 
 namespace d3d_tools {
@@ -17,8 +19,10 @@ namespace d3d_tools {
         GpuBuffer(
             Device* device,
             D3D_PRIMITIVE_TOPOLOGY topology,
-            edt::DenseArrayView<const ElementType> elements) :
-            m_topology(topology)
+            edt::DenseArrayView<const ElementType> elements,
+            D3D11_USAGE usage = D3D11_USAGE_DYNAMIC) :
+            m_topology(topology),
+            m_usage(usage)
         {
             auto count = elements.GetSize();
             if (count == 0) {
@@ -26,29 +30,105 @@ namespace d3d_tools {
             }
 
             D3D11_BUFFER_DESC desc{};
-            desc.Usage = D3D11_USAGE_DYNAMIC;
+            desc.Usage = usage;
             desc.ByteWidth = static_cast<UINT>(sizeof(ElementType) * count);
             desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-            desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+            if (usage == D3D11_USAGE_DYNAMIC) {
+                desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+            }
             m_buffer = device->CreateBuffer(desc, elements.GetData());
         }
 
         virtual void Activate(Device* device, uint32_t offset = 0) override {
             CallAndRethrowM + [&] {
-                auto pBuffer = m_buffer.Get();
-                auto pContext = device->GetContext();
-                UINT stride = sizeof(ElementType);
-                pContext->IASetVertexBuffers(0, 1, &pBuffer, &stride, &offset);
-                pContext->IASetPrimitiveTopology(m_topology);
+                device->SetVertexBuffer(m_buffer.Get(), sizeof(ElementType), offset);
+                device->SetPrimitiveTopology(m_topology);
             };
         }
 
+        ID3D11Buffer* GetBuffer() const {
+            return m_buffer.Get();
+        }
+
+        // Only dynamic and staging buffers can be mapped. Default usage buffers (e.g. the GPU copy of
+        // CrossDeviceBuffer) are updated with UpdateSubresource instead
         d3d_tools::BufferMapper<ElementType> MakeBufferMapper(Device* device, D3D11_MAP map) {
-            return d3d_tools::BufferMapper<ElementType>(m_buffer, device->GetContext(), map);
+            return CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(m_usage == D3D11_USAGE_DYNAMIC || m_usage == D3D11_USAGE_STAGING,
+                    "Only dynamic and staging buffers can be mapped");
+                return d3d_tools::BufferMapper<ElementType>(m_buffer, device->GetContext(), map);
+            };
         }
 
     private:
         ComPtr<ID3D11Buffer> m_buffer;
         D3D_PRIMITIVE_TOPOLOGY m_topology;
+        D3D11_USAGE m_usage;
+    };
+
+    namespace gpu_buffer_details {
+        template<typename IndexType>
+        struct IndexFormat;
+
+        template<>
+        struct IndexFormat<uint16_t> {
+            static constexpr DXGI_FORMAT Value = DXGI_FORMAT_R16_UINT;
+        };
+
+        template<>
+        struct IndexFormat<uint32_t> {
+            static constexpr DXGI_FORMAT Value = DXGI_FORMAT_R32_UINT;
+        };
+    }
+
+    // 16-bit indices halve index fetch bandwidth and are enough for meshes under 65536 vertices
+    template<typename IndexType>
+    class IndexBuffer
+    {
+    public:
+        static_assert(std::is_same<IndexType, uint16_t>::value || std::is_same<IndexType, uint32_t>::value,
+            "Index type must be uint16_t or uint32_t");
+
+        static constexpr DXGI_FORMAT Format = gpu_buffer_details::IndexFormat<IndexType>::Value;
+
+        IndexBuffer(
+            Device* device,
+            edt::DenseArrayView<const IndexType> indices,
+            D3D11_USAGE usage = D3D11_USAGE_IMMUTABLE) :
+            m_count(static_cast<uint32_t>(indices.GetSize()))
+        {
+            if (m_count == 0) {
+                return;
+            }
+
+            D3D11_BUFFER_DESC desc{};
+            desc.Usage = usage;
+            desc.ByteWidth = static_cast<UINT>(sizeof(IndexType) * m_count);
+            desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+            if (usage == D3D11_USAGE_DYNAMIC) {
+                desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+            }
+            m_buffer = device->CreateBuffer(desc, indices.GetData());
+        }
+
+        void Activate(Device* device, uint32_t offset = 0) {
+            device->SetIndexBuffer(m_buffer.Get(), Format, offset);
+        }
+
+        ID3D11Buffer* GetBuffer() const {
+            return m_buffer.Get();
+        }
+
+        uint32_t GetCount() const {
+            return m_count;
+        }
+
+        d3d_tools::BufferMapper<IndexType> MakeBufferMapper(Device* device, D3D11_MAP map) {
+            return d3d_tools::BufferMapper<IndexType>(m_buffer, device->GetContext(), map);
+        }
+
+    private:
+        ComPtr<ID3D11Buffer> m_buffer;
+        uint32_t m_count = 0;
     };
-}
\ No newline at end of file
+}
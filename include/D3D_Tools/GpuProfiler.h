@@ -0,0 +1,254 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <vector>
+#include "Device.h"
+#include "ProfileTrace.h"
+
+namespace d3d_tools {
+    struct GpuProfilerStatistics {
+        uint64_t completedFrames = 0;
+        // Frames whose queries were not ready when their ring slot was needed again
+        uint64_t droppedFrames = 0;
+        uint64_t disjointFrames = 0;
+    };
+
+    // Scope begun in a particular frame. Ending it once that frame is over does nothing
+    struct GpuProfileScope {
+        uint64_t frameIndex = 0;
+        uint32_t index = ProfileScope::NoParent;
+    };
+
+    // Measures nested scopes on CPU and GPU. Every frame owns a disjoint query and a pair of
+    // timestamp queries per scope; frames live in a ring and are read back with DONOTFLUSH polling,
+    // so results arrive framesInFlight frames later and the CPU never waits for the GPU.
+    // Works on the immediate device only: timestamp disjoint queries are not available in deferred contexts
+    class GpuProfiler {
+    public:
+        GpuProfiler(Device* device, uint32_t framesInFlight = 4, size_t keptFramesCount = 256) :
+            m_device(device->GetDevice()),
+            m_context(device->GetContext()),
+            m_keptFramesCount(keptFramesCount),
+            m_clockOrigin(std::chrono::steady_clock::now())
+        {
+            CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(!device->IsDeferred(), "GPU profiler requires the immediate device");
+                edt::ThrowIfFailed(framesInFlight > 0, "At least one frame must be in flight");
+                m_ring.resize(framesInFlight);
+                for (auto& slot : m_ring) {
+                    slot.disjoint = CreateQuery(D3D11_QUERY_TIMESTAMP_DISJOINT);
+                }
+            };
+        }
+
+        void BeginFrame() {
+            CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(!m_frameActive, "Previous profiler frame was not ended");
+                CollectResults();
+
+                auto& slot = m_ring[m_frameIndex % m_ring.size()];
+                if (slot.pending) {
+                    // GPU is further behind than the ring allows: results are lost instead of stalling
+                    slot.pending = false;
+                    ++m_statistics.droppedFrames;
+                }
+
+                slot.builder.Reset(m_frameIndex);
+                slot.usedQueries = 0;
+                slot.scopeQueries.clear();
+                m_context->Begin(slot.disjoint.Get());
+                m_frameActive = true;
+            };
+        }
+
+        void EndFrame() {
+            CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(m_frameActive, "Profiler frame was not begun");
+                auto& slot = GetCurrentSlot();
+                edt::ThrowIfFailed(slot.builder.GetOpenScopesCount() == 0, "Not all profile scopes were ended");
+                m_context->End(slot.disjoint.Get());
+                slot.pending = true;
+                m_frameActive = false;
+                ++m_frameIndex;
+                CollectResults();
+            };
+        }
+
+        // Returns the scope to pass to EndScope. Outside of a frame scopes are ignored
+        GpuProfileScope BeginScope(std::string_view name) {
+            return CallAndRethrowM + [&] {
+                GpuProfileScope scope;
+                if (!m_frameActive) {
+                    return scope;
+                }
+
+                auto& slot = GetCurrentSlot();
+                auto queryIndex = AllocateQueries(slot);
+                scope.frameIndex = m_frameIndex;
+                scope.index = slot.builder.BeginScope(name, GetCpuTime());
+                slot.scopeQueries.push_back(queryIndex);
+                m_context->End(slot.timestamps[queryIndex].Get());
+                return scope;
+            };
+        }
+
+        // Scopes of other frames and improperly nested ones are ignored. Never throws: called from destructors
+        void EndScope(const GpuProfileScope& scope) noexcept {
+            if (!m_frameActive || scope.index == ProfileScope::NoParent || scope.frameIndex != m_frameIndex) {
+                return;
+            }
+
+            auto& slot = GetCurrentSlot();
+            if (slot.builder.EndScope(scope.index, GetCpuTime())) {
+                m_context->End(slot.timestamps[slot.scopeQueries[scope.index] + 1].Get());
+            }
+        }
+
+        // Polls pending frames without waiting. Called by BeginFrame and EndFrame
+        void CollectResults() {
+            CallAndRethrowM + [&] {
+                // Oldest frame first: a newer frame can not complete before an older one
+                for (size_t i = 0; i < m_ring.size(); ++i) {
+                    auto& slot = m_ring[(m_frameIndex + i) % m_ring.size()];
+                    if (!slot.pending) {
+                        continue;
+                    }
+                    if (!TryReadFrame(slot)) {
+                        break;
+                    }
+                    slot.pending = false;
+                }
+            };
+        }
+
+        // Completed frames, oldest first. At most keptFramesCount of them are kept
+        const std::deque<ProfileFrame>& GetCompletedFrames() const {
+            return m_completed;
+        }
+
+        const ProfileAggregator& GetAggregator() const {
+            return m_aggregator;
+        }
+
+        ProfileAggregator& GetAggregator() {
+            return m_aggregator;
+        }
+
+        const GpuProfilerStatistics& GetStatistics() const {
+            return m_statistics;
+        }
+
+        void WriteChromeTrace(std::ostream& output) const {
+            d3d_tools::WriteChromeTrace(output, std::vector<ProfileFrame>(m_completed.begin(), m_completed.end()));
+        }
+
+    private:
+        struct FrameSlot {
+            ComPtr<ID3D11Query> disjoint;
+            // Begin and end timestamps of scope i are at scopeQueries[i] and scopeQueries[i] + 1
+            std::vector<ComPtr<ID3D11Query>> timestamps;
+            std::vector<uint32_t> scopeQueries;
+            uint32_t usedQueries = 0;
+            ProfileFrameBuilder builder;
+            bool pending = false;
+        };
+
+        ComPtr<ID3D11Query> CreateQuery(D3D11_QUERY type) {
+            D3D11_QUERY_DESC desc{};
+            desc.Query = type;
+            ComPtr<ID3D11Query> query;
+            WinAPI<char>::ThrowIfError(m_device->CreateQuery(&desc, query.Receive()));
+            return query;
+        }
+
+        // Queries are created on first use and reused by later frames of the same slot
+        uint32_t AllocateQueries(FrameSlot& slot) {
+            auto index = slot.usedQueries;
+            while (slot.timestamps.size() < index + 2) {
+                slot.timestamps.push_back(CreateQuery(D3D11_QUERY_TIMESTAMP));
+            }
+            slot.usedQueries += 2;
+            return index;
+        }
+
+        template<typename T>
+        bool TryGetData(ID3D11Query* query, T& result) {
+            auto hr = m_context->GetData(query, &result, sizeof(T), D3D11_ASYNC_GETDATA_DONOTFLUSH);
+            WinAPI<char>::ThrowIfError(hr);
+            return hr == S_OK;
+        }
+
+        bool TryReadFrame(FrameSlot& slot) {
+            D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+            if (!TryGetData(slot.disjoint.Get(), disjoint)) {
+                return false;
+            }
+
+            // The disjoint query ends after all timestamps, so they are ready too
+            auto& builder = slot.builder;
+            for (uint32_t scope = 0; scope < slot.scopeQueries.size(); ++scope) {
+                UINT64 begin = 0;
+                UINT64 end = 0;
+                auto queryIndex = slot.scopeQueries[scope];
+                if (TryGetData(slot.timestamps[queryIndex].Get(), begin) && TryGetData(slot.timestamps[queryIndex + 1].Get(), end)) {
+                    builder.SetGpuTime(scope, begin, end);
+                }
+            }
+            builder.SetGpuClock(disjoint.Frequency, disjoint.Disjoint != FALSE);
+
+            auto& frame = builder.GetFrame();
+            ++m_statistics.completedFrames;
+            if (frame.disjoint) {
+                ++m_statistics.disjointFrames;
+            }
+            m_aggregator.Add(frame);
+            m_completed.push_back(frame);
+            while (m_completed.size() > m_keptFramesCount) {
+                m_completed.pop_front();
+            }
+            return true;
+        }
+
+        FrameSlot& GetCurrentSlot() {
+            return m_ring[m_frameIndex % m_ring.size()];
+        }
+
+        uint64_t GetCpuTime() const {
+            auto elapsed = std::chrono::steady_clock::now() - m_clockOrigin;
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+
+    private:
+        ComPtr<ID3D11Device> m_device;
+        ComPtr<ID3D11DeviceContext> m_context;
+        std::vector<FrameSlot> m_ring;
+        uint64_t m_frameIndex = 0;
+        bool m_frameActive = false;
+        size_t m_keptFramesCount;
+        std::chrono::steady_clock::time_point m_clockOrigin;
+        std::deque<ProfileFrame> m_completed;
+        ProfileAggregator m_aggregator;
+        GpuProfilerStatistics m_statistics;
+    };
+
+    class ScopedProfile {
+    public:
+        ScopedProfile(GpuProfiler& profiler, std::string_view name) :
+            m_profiler(profiler),
+            m_scope(profiler.BeginScope(name))
+        {
+        }
+
+        ScopedProfile(const ScopedProfile&) = delete;
+        ScopedProfile& operator=(const ScopedProfile&) = delete;
+
+        ~ScopedProfile() {
+            m_profiler.EndScope(m_scope);
+        }
+
+    private:
+        GpuProfiler& m_profiler;
+        GpuProfileScope m_scope;
+    };
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace d3d_tools {
+    // 64-bit FNV-1a. Stable between runs and platforms, so it may be stored on disk
+    class Hasher {
+    public:
+        static constexpr uint64_t OffsetBasis = 14695981039346656037ull;
+        static constexpr uint64_t Prime = 1099511628211ull;
+
+        Hasher& Add(const void* data, size_t size) {
+            auto bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; ++i) {
+                m_value ^= bytes[i];
+                m_value *= Prime;
+            }
+            return *this;
+        }
+
+        // Length is hashed as well so that ("ab", "c") and ("a", "bc") differ
+        Hasher& Add(std::string_view str) {
+            AddValue(static_cast<uint64_t>(str.size()));
+            return Add(str.data(), str.size());
+        }
+
+        template<typename T>
+        Hasher& AddValue(const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types could be hashed as bytes");
+            return Add(&value, sizeof(T));
+        }
+
+        uint64_t GetValue() const {
+            return m_value;
+        }
+
+    private:
+        uint64_t m_value = OffsetBasis;
+    };
+
+    inline uint64_t ComputeHash(const void* data, size_t size) {
+        return Hasher().Add(data, size).GetValue();
+    }
+
+    inline void CombineHash(uint64_t& seed, uint64_t value) {
+        seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+    }
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace d3d_tools {
+    // Layouts the GPU reads from indirect argument buffers
+    struct DrawInstancedIndirectArgs {
+        uint32_t vertexCountPerInstance;
+        uint32_t instanceCount;
+        uint32_t startVertex;
+        uint32_t startInstance;
+    };
+
+    struct DrawIndexedInstancedIndirectArgs {
+        uint32_t indexCountPerInstance;
+        uint32_t instanceCount;
+        uint32_t startIndex;
+        int32_t baseVertex;
+        uint32_t startInstance;
+    };
+
+    struct DispatchIndirectArgs {
+        uint32_t threadGroupsX;
+        uint32_t threadGroupsY;
+        uint32_t threadGroupsZ;
+    };
+
+    static_assert(sizeof(DrawInstancedIndirectArgs) == 16, "Layout must match D3D11 indirect draw arguments");
+    static_assert(sizeof(DrawIndexedInstancedIndirectArgs) == 20, "Layout must match D3D11 indirect indexed draw arguments");
+    static_assert(sizeof(DispatchIndirectArgs) == 12, "Layout must match D3D11 indirect dispatch arguments");
+
+    // Offsets into argument buffers must be multiple of this
+    static constexpr uint32_t IndirectArgumentsAlignment = 4;
+    // D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION
+    static constexpr uint32_t MaxThreadGroupsPerDimension = 65535;
+
+    enum class IndirectArgumentsError {
+        None,
+        MisalignedOffset,
+        OutOfBufferBounds,
+        TooManyThreadGroups,
+        VertexRangeOutOfBounds,
+        IndexRangeOutOfBounds,
+        InstanceRangeOutOfBounds
+    };
+
+    inline const char* GetErrorDescription(IndirectArgumentsError error) {
+        switch (error) {
+        case IndirectArgumentsError::None: return "No error";
+        case IndirectArgumentsError::MisalignedOffset: return "Indirect arguments offset is not 4-byte aligned";
+        case IndirectArgumentsError::OutOfBufferBounds: return "Indirect arguments do not fit the buffer";
+        case IndirectArgumentsError::TooManyThreadGroups: return "Thread groups count exceeds 65535 in some dimension";
+        case IndirectArgumentsError::VertexRangeOutOfBounds: return "Vertex range exceeds vertex buffer";
+        case IndirectArgumentsError::IndexRangeOutOfBounds: return "Index range exceeds index buffer";
+        case IndirectArgumentsError::InstanceRangeOutOfBounds: return "Instance range exceeds instance buffer";
+        default: return "Unknown indirect arguments error";
+        }
+    }
+
+    template<typename Args>
+    IndirectArgumentsError ValidateArgumentsLocation(uint64_t bufferSize, uint64_t offset) {
+        if (offset % IndirectArgumentsAlignment != 0) {
+            return IndirectArgumentsError::MisalignedOffset;
+        }
+        if (offset > bufferSize || bufferSize - offset < sizeof(Args)) {
+            return IndirectArgumentsError::OutOfBufferBounds;
+        }
+        return IndirectArgumentsError::None;
+    }
+
+    namespace indirect_details {
+        // Checks [start, start + count) against [0, capacity) without overflow
+        inline bool RangeFits(uint64_t start, uint64_t count, uint64_t capacity) {
+            return start <= capacity && count <= capacity - start;
+        }
+
+        static constexpr uint32_t NoLimit = std::numeric_limits<uint32_t>::max();
+    }
+
+    inline IndirectArgumentsError ValidateArguments(const DispatchIndirectArgs& args) {
+        if (args.threadGroupsX > MaxThreadGroupsPerDimension ||
+            args.threadGroupsY > MaxThreadGroupsPerDimension ||
+            args.threadGroupsZ > MaxThreadGroupsPerDimension) {
+            return IndirectArgumentsError::TooManyThreadGroups;
+        }
+        return IndirectArgumentsError::None;
+    }
+
+    // Capacities are element counts of the bound buffers. Pass the default to skip a check
+    inline IndirectArgumentsError ValidateArguments(
+        const DrawInstancedIndirectArgs& args,
+        uint32_t vertexCapacity,
+        uint32_t instanceCapacity = indirect_details::NoLimit)
+    {
+        if (!indirect_details::RangeFits(args.startVertex, args.vertexCountPerInstance, vertexCapacity)) {
+            return IndirectArgumentsError::VertexRangeOutOfBounds;
+        }
+        if (!indirect_details::RangeFits(args.startInstance, args.instanceCount, instanceCapacity)) {
+            return IndirectArgumentsError::InstanceRangeOutOfBounds;
+        }
+        return IndirectArgumentsError::None;
+    }
+
+    // Vertex range depends on index values and is not checked
+    inline IndirectArgumentsError ValidateArguments(
+        const DrawIndexedInstancedIndirectArgs& args,
+        uint32_t indexCapacity,
+        uint32_t instanceCapacity = indirect_details::NoLimit)
+    {
+        if (!indirect_details::RangeFits(args.startIndex, args.indexCountPerInstance, indexCapacity)) {
+            return IndirectArgumentsError::IndexRangeOutOfBounds;
+        }
+        if (!indirect_details::RangeFits(args.startInstance, args.instanceCount, instanceCapacity)) {
+            return IndirectArgumentsError::InstanceRangeOutOfBounds;
+        }
+        return IndirectArgumentsError::None;
+    }
+
+    inline uint32_t ComputeThreadGroupsCount(uint32_t itemsCount, uint32_t groupSize) {
+        if (groupSize == 0) {
+            throw std::invalid_argument("Thread group size must not be zero");
+        }
+        return static_cast<uint32_t>((uint64_t(itemsCount) + groupSize - 1) / groupSize);
+    }
+
+    // Groups for a 1D workload. Counts above the per-dimension limit spill into Y,
+    // so the shader has to flatten (x, y) and skip items past itemsCount
+    inline DispatchIndirectArgs MakeDispatchArguments(uint32_t itemsCount, uint32_t groupSize) {
+        auto groups = ComputeThreadGroupsCount(itemsCount, groupSize);
+        if (groups <= MaxThreadGroupsPerDimension) {
+            return DispatchIndirectArgs{ groups, 1, 1 };
+        }
+        auto rows = ComputeThreadGroupsCount(groups, MaxThreadGroupsPerDimension);
+        return DispatchIndirectArgs{ MaxThreadGroupsPerDimension, rows, 1 };
+    }
+
+    // Packs argument records of any kind into one block for an argument buffer.
+    // Append returns the byte offset to pass to the indirect call
+    class IndirectArgumentsWriter {
+    public:
+        template<typename Args>
+        uint32_t Append(const Args& args) {
+            static_assert(sizeof(Args) % IndirectArgumentsAlignment == 0, "Arguments must keep the block aligned");
+            auto offset = static_cast<uint32_t>(m_words.size() * sizeof(uint32_t));
+            m_words.resize(m_words.size() + sizeof(Args) / sizeof(uint32_t));
+            std::memcpy(m_words.data() + offset / sizeof(uint32_t), &args, sizeof(Args));
+            return offset;
+        }
+
+        template<typename Args>
+        Args Read(uint32_t offset) const {
+            Args result;
+            std::memcpy(&result, reinterpret_cast<const uint8_t*>(m_words.data()) + offset, sizeof(Args));
+            return result;
+        }
+
+        const void* GetData() const {
+            return m_words.data();
+        }
+
+        uint32_t GetSizeInBytes() const {
+            return static_cast<uint32_t>(m_words.size() * sizeof(uint32_t));
+        }
+
+        void Clear() {
+            m_words.clear();
+        }
+
+    private:
+        std::vector<uint32_t> m_words;
+    };
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "Device.h"
+#include "Hash.h"
+#include "VertexLayout.h"
+
+namespace d3d_tools {
+    inline DXGI_FORMAT ConvertVertexFormat(VertexFormat format) {
+        switch (format) {
+        case VertexFormat::R32_FLOAT: return DXGI_FORMAT_R32_FLOAT;
+        case VertexFormat::R32_G32_FLOAT: return DXGI_FORMAT_R32G32_FLOAT;
+        case VertexFormat::R32_G32_B32_FLOAT: return DXGI_FORMAT_R32G32B32_FLOAT;
+        case VertexFormat::R32_G32_B32_A32_FLOAT: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        case VertexFormat::R32_UINT: return DXGI_FORMAT_R32_UINT;
+        case VertexFormat::R32_G32_UINT: return DXGI_FORMAT_R32G32_UINT;
+        case VertexFormat::R32_G32_B32_UINT: return DXGI_FORMAT_R32G32B32_UINT;
+        case VertexFormat::R32_G32_B32_A32_UINT: return DXGI_FORMAT_R32G32B32A32_UINT;
+        case VertexFormat::R32_SINT: return DXGI_FORMAT_R32_SINT;
+        case VertexFormat::R32_G32_SINT: return DXGI_FORMAT_R32G32_SINT;
+        case VertexFormat::R32_G32_B32_SINT: return DXGI_FORMAT_R32G32B32_SINT;
+        case VertexFormat::R32_G32_B32_A32_SINT: return DXGI_FORMAT_R32G32B32A32_SINT;
+        case VertexFormat::R16_G16_FLOAT: return DXGI_FORMAT_R16G16_FLOAT;
+        case VertexFormat::R16_G16_B16_A16_FLOAT: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        case VertexFormat::R16_G16_UNORM: return DXGI_FORMAT_R16G16_UNORM;
+        case VertexFormat::R16_G16_B16_A16_UNORM: return DXGI_FORMAT_R16G16B16A16_UNORM;
+        case VertexFormat::R16_G16_SNORM: return DXGI_FORMAT_R16G16_SNORM;
+        case VertexFormat::R16_G16_B16_A16_SNORM: return DXGI_FORMAT_R16G16B16A16_SNORM;
+        case VertexFormat::R16_G16_UINT: return DXGI_FORMAT_R16G16_UINT;
+        case VertexFormat::R16_G16_B16_A16_UINT: return DXGI_FORMAT_R16G16B16A16_UINT;
+        case VertexFormat::R16_G16_SINT: return DXGI_FORMAT_R16G16_SINT;
+        case VertexFormat::R16_G16_B16_A16_SINT: return DXGI_FORMAT_R16G16B16A16_SINT;
+        case VertexFormat::R8_G8_B8_A8_UNORM: return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case VertexFormat::R8_G8_B8_A8_SNORM: return DXGI_FORMAT_R8G8B8A8_SNORM;
+        case VertexFormat::R8_G8_B8_A8_UINT: return DXGI_FORMAT_R8G8B8A8_UINT;
+        case VertexFormat::R10_G10_B10_A2_UNORM: return DXGI_FORMAT_R10G10B10A2_UNORM;
+        default: throw std::invalid_argument("This vertex format is not implemented here");
+        }
+    }
+
+    // Appends elements read from one input slot. Semantic names are not copied: they must outlive the result
+    inline void AppendInputElements(std::vector<D3D11_INPUT_ELEMENT_DESC>& result, edt::DenseArrayView<const VertexElement> elements,
+        uint32_t slot = 0, D3D11_INPUT_CLASSIFICATION classification = D3D11_INPUT_PER_VERTEX_DATA, uint32_t stepRate = 0)
+    {
+        CallAndRethrowM + [&] {
+            for (auto& element : elements) {
+                result.push_back(D3D11_INPUT_ELEMENT_DESC{
+                    element.semantic.data(),
+                    element.semanticIndex,
+                    ConvertVertexFormat(element.format),
+                    slot,
+                    element.offset,
+                    classification,
+                    classification == D3D11_INPUT_PER_VERTEX_DATA ? 0 : stepRate });
+            }
+        };
+    }
+
+    // Semantic names of vertex structs point to string literals, so these elements may be kept
+    template<typename Vertex>
+    void AppendInputElements(std::vector<D3D11_INPUT_ELEMENT_DESC>& result, uint32_t slot = 0,
+        D3D11_INPUT_CLASSIFICATION classification = D3D11_INPUT_PER_VERTEX_DATA, uint32_t stepRate = 0)
+    {
+        auto& elements = VertexLayoutOf<Vertex>.elements;
+        AppendInputElements(result, edt::DenseArrayView<const VertexElement>(elements.data(), elements.size()), slot, classification, stepRate);
+    }
+
+    template<typename Vertex>
+    std::vector<D3D11_INPUT_ELEMENT_DESC> MakeInputElements(uint32_t slot = 0) {
+        std::vector<D3D11_INPUT_ELEMENT_DESC> result;
+        AppendInputElements<Vertex>(result, slot);
+        return result;
+    }
+
+    inline uint64_t ComputeInputLayoutHash(edt::DenseArrayView<const D3D11_INPUT_ELEMENT_DESC> elements) {
+        Hasher hasher;
+        hasher.AddValue(static_cast<uint64_t>(elements.GetSize()));
+        for (auto& element : elements) {
+            hasher.Add(std::string_view(element.SemanticName));
+            hasher.AddValue(element.SemanticIndex).AddValue(element.Format).AddValue(element.InputSlot);
+            hasher.AddValue(element.AlignedByteOffset).AddValue(element.InputSlotClass).AddValue(element.InstanceDataStepRate);
+        }
+        return hasher.GetValue();
+    }
+
+    // Shaders with equal input signatures accept the same input layouts
+    inline uint64_t ComputeInputSignatureHash(ID3D10Blob* shaderBytecode) {
+        return CallAndRethrowM + [&] {
+            ComPtr<ID3DBlob> signature;
+            WinAPI<char>::ThrowIfError(D3DGetInputSignatureBlob(
+                shaderBytecode->GetBufferPointer(), shaderBytecode->GetBufferSize(), signature.Receive()));
+            return ComputeHash(signature->GetBufferPointer(), signature->GetBufferSize());
+        };
+    }
+
+    struct InputLayoutCacheStatistics {
+        uint64_t requestsCount = 0;
+        uint64_t createdCount = 0;
+    };
+
+    // Creates one input layout per (elements, shader input signature) pair, so vertex shaders with
+    // equal inputs share layouts. Layouts live as long as the cache. Not thread safe
+    class InputLayoutCache {
+    public:
+        InputLayoutCache(Device* device) :
+            m_device(device)
+        {
+        }
+
+        ID3D11InputLayout* GetOrCreate(edt::DenseArrayView<const D3D11_INPUT_ELEMENT_DESC> elements, ID3D10Blob* shaderBytecode) {
+            return CallAndRethrowM + [&] {
+                return GetOrCreate(elements, shaderBytecode, ComputeInputSignatureHash(shaderBytecode));
+            };
+        }
+
+        // For callers that keep the signature hash of their shaders
+        ID3D11InputLayout* GetOrCreate(edt::DenseArrayView<const D3D11_INPUT_ELEMENT_DESC> elements, ID3D10Blob* shaderBytecode,
+            uint64_t signatureHash)
+        {
+            return CallAndRethrowM + [&] {
+                ++m_statistics.requestsCount;
+                Key key{ ComputeInputLayoutHash(elements), signatureHash };
+                auto it = m_layouts.find(key);
+                if (it != m_layouts.end()) {
+                    return it->second.Get();
+                }
+
+                auto layout = m_device->CreateInputLayout(elements, shaderBytecode);
+                ++m_statistics.createdCount;
+                return m_layouts.emplace(key, std::move(layout)).first->second.Get();
+            };
+        }
+
+        template<typename Vertex>
+        ID3D11InputLayout* GetOrCreate(ID3D10Blob* shaderBytecode) {
+            auto elements = MakeInputElements<Vertex>();
+            return GetOrCreate(edt::DenseArrayView<const D3D11_INPUT_ELEMENT_DESC>(elements.data(), elements.size()), shaderBytecode);
+        }
+
+        size_t GetSize() const {
+            return m_layouts.size();
+        }
+
+        const InputLayoutCacheStatistics& GetStatistics() const {
+            return m_statistics;
+        }
+
+    private:
+        struct Key {
+            bool operator==(const Key& other) const {
+                return layoutHash == other.layoutHash && signatureHash == other.signatureHash;
+            }
+
+            uint64_t layoutHash;
+            uint64_t signatureHash;
+        };
+
+        struct KeyHash {
+            size_t operator()(const Key& key) const {
+                auto seed = key.layoutHash;
+                CombineHash(seed, key.signatureHash);
+                return static_cast<size_t>(seed);
+            }
+        };
+
+    private:
+        Device* m_device;
+        std::unordered_map<Key, ComPtr<ID3D11InputLayout>, KeyHash> m_layouts;
+        InputLayoutCacheStatistics m_statistics;
+    };
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace d3d_tools {
+    // Groups per-instance data by draw key, so every distinct key becomes one instanced draw.
+    // Batches keep the order in which their keys were first added; instances keep the order
+    // in which they were added within a batch. Memory is kept between frames
+    template<typename Key, typename InstanceData, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+    class InstanceBatcher {
+    public:
+        struct Batch {
+            Key key;
+            uint32_t firstInstance;
+            uint32_t instancesCount;
+        };
+
+        void Add(const Key& key, const InstanceData& instance) {
+            auto it = m_batchIndices.find(key);
+            if (it == m_batchIndices.end()) {
+                it = m_batchIndices.emplace(key, static_cast<uint32_t>(m_batches.size())).first;
+                m_batches.push_back(Batch{ key, 0, 0 });
+            }
+
+            auto batchIndex = it->second;
+            ++m_batches[batchIndex].instancesCount;
+            m_added.push_back(instance);
+            m_addedBatches.push_back(batchIndex);
+            m_built = false;
+        }
+
+        // Lays instances out contiguously per batch: one counting sort pass
+        void Build() {
+            uint32_t first = 0;
+            for (auto& batch : m_batches) {
+                batch.firstInstance = first;
+                first += batch.instancesCount;
+            }
+
+            m_cursors.resize(m_batches.size());
+            for (size_t i = 0; i < m_batches.size(); ++i) {
+                m_cursors[i] = m_batches[i].firstInstance;
+            }
+
+            m_instances.resize(m_added.size());
+            for (size_t i = 0; i < m_added.size(); ++i) {
+                m_instances[m_cursors[m_addedBatches[i]]++] = m_added[i];
+            }
+            m_built = true;
+        }
+
+        // Valid after Build
+        const std::vector<Batch>& GetBatches() const {
+            return m_batches;
+        }
+
+        // Valid after Build. Instances of a batch are [firstInstance, firstInstance + instancesCount)
+        const std::vector<InstanceData>& GetInstances() const {
+            return m_instances;
+        }
+
+        bool IsBuilt() const {
+            return m_built;
+        }
+
+        size_t GetInstancesCount() const {
+            return m_added.size();
+        }
+
+        void Clear() {
+            m_batchIndices.clear();
+            m_batches.clear();
+            m_added.clear();
+            m_addedBatches.clear();
+            m_instances.clear();
+            m_built = false;
+        }
+
+    private:
+        std::unordered_map<Key, uint32_t, Hash, Equal> m_batchIndices;
+        std::vector<Batch> m_batches;
+        std::vector<InstanceData> m_added;
+        std::vector<uint32_t> m_addedBatches;
+        std::vector<uint32_t> m_cursors;
+        std::vector<InstanceData> m_instances;
+        bool m_built = false;
+    };
+}
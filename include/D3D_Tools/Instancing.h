@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include "Device.h"
+#include "BufferMapper.h"
+#include "Hash.h"
+#include "InstanceBatcher.h"
+
+namespace d3d_tools {
+    inline D3D11_INPUT_ELEMENT_DESC MakeVertexElement(const char* semantic, uint32_t semanticIndex, DXGI_FORMAT format,
+        uint32_t slot = 0, uint32_t offset = D3D11_APPEND_ALIGNED_ELEMENT)
+    {
+        return D3D11_INPUT_ELEMENT_DESC{ semantic, semanticIndex, format, slot, offset, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+    }
+
+    // Element read once per stepRate instances instead of once per vertex
+    inline D3D11_INPUT_ELEMENT_DESC MakeInstanceElement(const char* semantic, uint32_t semanticIndex, DXGI_FORMAT format,
+        uint32_t slot = 1, uint32_t offset = D3D11_APPEND_ALIGNED_ELEMENT, uint32_t stepRate = 1)
+    {
+        return D3D11_INPUT_ELEMENT_DESC{ semantic, semanticIndex, format, slot, offset, D3D11_INPUT_PER_INSTANCE_DATA, stepRate };
+    }
+
+    // Dynamic vertex buffer holding per-instance data. Rewritten with WRITE_DISCARD every Update
+    // and grown by doubling when the data does not fit
+    template<typename InstanceData>
+    class InstanceBuffer {
+    public:
+        InstanceBuffer(Device* device, uint32_t capacity = 256) {
+            Reserve(device, capacity);
+        }
+
+        void Update(Device* device, edt::DenseArrayView<const InstanceData> instances) {
+            CallAndRethrowM + [&] {
+                auto count = static_cast<uint32_t>(instances.GetSize());
+                if (count == 0) {
+                    return;
+                }
+
+                if (count > m_capacity) {
+                    Reserve(device, std::max(count, m_capacity * 2));
+                }
+
+                BufferMapper<InstanceData> mapper(m_buffer, device->GetContext(), D3D11_MAP_WRITE_DISCARD);
+                mapper.Write(instances.GetData(), count);
+            };
+        }
+
+        void Activate(Device* device, uint32_t slot = 1) {
+            device->SetVertexBuffer(m_buffer.Get(), sizeof(InstanceData), 0, slot);
+        }
+
+        ID3D11Buffer* GetBuffer() const {
+            return m_buffer.Get();
+        }
+
+        uint32_t GetCapacity() const {
+            return m_capacity;
+        }
+
+    private:
+        void Reserve(Device* device, uint32_t capacity) {
+            D3D11_BUFFER_DESC desc{};
+            desc.Usage = D3D11_USAGE_DYNAMIC;
+            desc.ByteWidth = static_cast<UINT>(sizeof(InstanceData) * std::max(capacity, 1u));
+            desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+            desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+            m_buffer = device->CreateBuffer(desc);
+            m_capacity = std::max(capacity, 1u);
+        }
+
+    private:
+        ComPtr<ID3D11Buffer> m_buffer;
+        uint32_t m_capacity = 0;
+    };
+
+    // Everything that must be equal for two draws to become one instanced draw.
+    // Pointers are not owned: objects must live until Submit
+    struct InstancedMesh {
+        static constexpr uint32_t MaxTextures = 4;
+
+        bool operator==(const InstancedMesh& other) const {
+            return
+                vertexBuffer == other.vertexBuffer &&
+                vertexStride == other.vertexStride &&
+                vertexOffset == other.vertexOffset &&
+                indexBuffer == other.indexBuffer &&
+                indexFormat == other.indexFormat &&
+                inputLayout == other.inputLayout &&
+                topology == other.topology &&
+                vertexShader == other.vertexShader &&
+                pixelShader == other.pixelShader &&
+                std::equal(textures, textures + MaxTextures, other.textures) &&
+                sampler == other.sampler &&
+                count == other.count &&
+                start == other.start &&
+                baseVertex == other.baseVertex;
+        }
+
+        ID3D11Buffer* vertexBuffer = nullptr;
+        uint32_t vertexStride = 0;
+        uint32_t vertexOffset = 0;
+
+        // Draws are not indexed when there is no index buffer
+        ID3D11Buffer* indexBuffer = nullptr;
+        DXGI_FORMAT indexFormat = DXGI_FORMAT_R16_UINT;
+
+        ID3D11InputLayout* inputLayout = nullptr;
+        D3D11_PRIMITIVE_TOPOLOGY topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+        ID3D11VertexShader* vertexShader = nullptr;
+        ID3D11PixelShader* pixelShader = nullptr;
+
+        // Pixel shader material. Unused slots are null
+        ID3D11ShaderResourceView* textures[MaxTextures]{};
+        ID3D11SamplerState* sampler = nullptr;
+
+        // Index or vertex count and first index or vertex of one instance
+        uint32_t count = 0;
+        uint32_t start = 0;
+        int32_t baseVertex = 0;
+    };
+
+    struct InstancedMeshHash {
+        size_t operator()(const InstancedMesh& mesh) const {
+            Hasher hasher;
+            hasher.AddValue(mesh.vertexBuffer).AddValue(mesh.vertexStride).AddValue(mesh.vertexOffset);
+            hasher.AddValue(mesh.indexBuffer).AddValue(mesh.indexFormat);
+            hasher.AddValue(mesh.inputLayout).AddValue(mesh.topology);
+            hasher.AddValue(mesh.vertexShader).AddValue(mesh.pixelShader);
+            hasher.AddValue(mesh.textures).AddValue(mesh.sampler);
+            hasher.AddValue(mesh.count).AddValue(mesh.start).AddValue(mesh.baseVertex);
+            return static_cast<size_t>(hasher.GetValue());
+        }
+    };
+
+    struct InstancedDrawStatistics {
+        size_t instancesCount = 0;
+        size_t drawsCount = 0;
+    };
+
+    // Turns many draws of identical meshes into one instanced draw per mesh.
+    // All instances of a frame go into one instance buffer; batches select their range with startInstance
+    template<typename InstanceData>
+    class InstancedDrawBatcher {
+    public:
+        using Batcher = InstanceBatcher<InstancedMesh, InstanceData, InstancedMeshHash>;
+
+        InstancedDrawBatcher(Device* device, uint32_t instanceSlot = 1, uint32_t initialCapacity = 256) :
+            m_instanceSlot(instanceSlot),
+            m_instanceBuffer(device, initialCapacity)
+        {
+        }
+
+        void Add(const InstancedMesh& mesh, const InstanceData& instance) {
+            m_batcher.Add(mesh, instance);
+        }
+
+        // Uploads instance data, issues one draw per distinct mesh and clears the batcher
+        void Submit(Device& device) {
+            CallAndRethrowM + [&] {
+                m_statistics = InstancedDrawStatistics();
+                if (m_batcher.GetInstancesCount() == 0) {
+                    return;
+                }
+
+                m_batcher.Build();
+                auto& instances = m_batcher.GetInstances();
+                m_instanceBuffer.Update(&device, edt::DenseArrayView<const InstanceData>(instances.data(), instances.size()));
+                m_instanceBuffer.Activate(&device, m_instanceSlot);
+
+                for (auto& batch : m_batcher.GetBatches()) {
+                    auto& mesh = batch.key;
+                    Apply(device, mesh);
+                    if (mesh.indexBuffer) {
+                        device.DrawIndexedInstanced(mesh.count, batch.instancesCount, mesh.start, mesh.baseVertex, batch.firstInstance);
+                    } else {
+                        device.DrawInstanced(mesh.count, batch.instancesCount, mesh.start, batch.firstInstance);
+                    }
+                }
+
+                m_statistics.instancesCount = instances.size();
+                m_statistics.drawsCount = m_batcher.GetBatches().size();
+                m_batcher.Clear();
+            };
+        }
+
+        // Of the last Submit
+        const InstancedDrawStatistics& GetStatistics() const {
+            return m_statistics;
+        }
+
+    private:
+        static void Apply(Device& device, const InstancedMesh& mesh) {
+            device.SetShader<ShaderType::Vertex>(mesh.vertexShader);
+            device.SetShader<ShaderType::Pixel>(mesh.pixelShader);
+            device.SetInputLayout(mesh.inputLayout);
+            device.SetPrimitiveTopology(mesh.topology);
+            device.SetVertexBuffer(mesh.vertexBuffer, mesh.vertexStride, mesh.vertexOffset);
+            if (mesh.indexBuffer) {
+                device.SetIndexBuffer(mesh.indexBuffer, mesh.indexFormat);
+            }
+            device.SetShaderResources(ShaderType::Pixel, 0,
+                edt::DenseArrayView<ID3D11ShaderResourceView* const>(mesh.textures, InstancedMesh::MaxTextures));
+            if (mesh.sampler) {
+                device.SetSampler(0, mesh.sampler, ShaderType::Pixel);
+            }
+        }
+
+    private:
+        uint32_t m_instanceSlot;
+        InstanceBuffer<InstanceData> m_instanceBuffer;
+        Batcher m_batcher;
+        InstancedDrawStatistics m_statistics;
+    };
+}
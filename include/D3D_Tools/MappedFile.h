@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace d3d_tools {
+    // Read-only view of the whole file. Invalid if the file could not be opened or is empty
+    class MappedFile {
+    public:
+        MappedFile() = default;
+
+        MappedFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+            m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (m_file == INVALID_HANDLE_VALUE) {
+                m_file = nullptr;
+                return;
+            }
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+                Close();
+                return;
+            }
+
+            m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (m_mapping == nullptr) {
+                Close();
+                return;
+            }
+
+            m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+            if (m_data == nullptr) {
+                Close();
+                return;
+            }
+
+            m_size = static_cast<size_t>(size.QuadPart);
+#else
+            m_file = open(path.c_str(), O_RDONLY);
+            if (m_file < 0) {
+                return;
+            }
+
+            struct stat info;
+            if (fstat(m_file, &info) != 0 || info.st_size == 0) {
+                Close();
+                return;
+            }
+
+            auto data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+            if (data == MAP_FAILED) {
+                Close();
+                return;
+            }
+
+            m_data = data;
+            m_size = static_cast<size_t>(info.st_size);
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept {
+            MoveFrom(other);
+        }
+
+        MappedFile& operator=(MappedFile&& other) noexcept {
+            if (this != &other) {
+                Close();
+                MoveFrom(other);
+            }
+            return *this;
+        }
+
+        ~MappedFile() {
+            Close();
+        }
+
+        bool IsValid() const {
+            return m_data != nullptr;
+        }
+
+        const uint8_t* GetData() const {
+            return static_cast<const uint8_t*>(m_data);
+        }
+
+        size_t GetSize() const {
+            return m_size;
+        }
+
+    private:
+        void Close() {
+#ifdef _WIN32
+            if (m_data) {
+                UnmapViewOfFile(m_data);
+            }
+
+            if (m_mapping) {
+                CloseHandle(m_mapping);
+            }
+
+            if (m_file) {
+                CloseHandle(m_file);
+            }
+
+            m_mapping = nullptr;
+            m_file = nullptr;
+#else
+            if (m_data) {
+                munmap(m_data, m_size);
+            }
+
+            if (m_file >= 0) {
+                close(m_file);
+            }
+
+            m_file = -1;
+#endif
+            m_data = nullptr;
+            m_size = 0;
+        }
+
+        void MoveFrom(MappedFile& other) {
+            m_data = other.m_data;
+            m_size = other.m_size;
+            m_file = other.m_file;
+            other.m_data = nullptr;
+            other.m_size = 0;
+#ifdef _WIN32
+            m_mapping = other.m_mapping;
+            other.m_mapping = nullptr;
+            other.m_file = nullptr;
+#else
+            other.m_file = -1;
+#endif
+        }
+
+    private:
+        void* m_data = nullptr;
+        size_t m_size = 0;
+#ifdef _WIN32
+        HANDLE m_file = nullptr;
+        HANDLE m_mapping = nullptr;
+#else
+        int m_file = -1;
+#endif
+    };
+}
@@ -0,0 +1,514 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "Hash.h"
+#include "VertexQuantization.h"
+
+namespace d3d_tools {
+    // Mesh processing for indexed triangle lists. Vertices are opaque blobs of `stride` bytes,
+    // so any vertex struct (or a quantized stream) can go through it
+    namespace mesh_details {
+        static constexpr uint32_t InvalidIndex = ~0u;
+
+        struct VertexBytesHash {
+            size_t operator()(uint32_t index) const {
+                return static_cast<size_t>(ComputeHash(vertices + size_t(index) * stride, stride));
+            }
+
+            const uint8_t* vertices;
+            size_t stride;
+        };
+
+        struct VertexBytesEqual {
+            bool operator()(uint32_t a, uint32_t b) const {
+                return std::memcmp(vertices + size_t(a) * stride, vertices + size_t(b) * stride, stride) == 0;
+            }
+
+            const uint8_t* vertices;
+            size_t stride;
+        };
+
+        // Triangles using each vertex: triangles of vertex v are at [offsets[v], offsets[v + 1])
+        struct TriangleAdjacency {
+            TriangleAdjacency(const uint32_t* indices, size_t indicesCount, uint32_t vertexCount) :
+                offsets(vertexCount + 1, 0),
+                triangles(indicesCount)
+            {
+                for (size_t i = 0; i < indicesCount; ++i) {
+                    ++offsets[indices[i] + 1];
+                }
+                for (uint32_t v = 0; v < vertexCount; ++v) {
+                    offsets[v + 1] += offsets[v];
+                }
+                std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+                for (size_t i = 0; i < indicesCount; ++i) {
+                    triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+
+            std::vector<uint32_t> offsets;
+            std::vector<uint32_t> triangles;
+        };
+
+        // FIFO post-transform cache: a vertex is in it while fewer than cacheSize vertices were transformed after it
+        class VertexCacheSimulator {
+        public:
+            VertexCacheSimulator(uint32_t vertexCount, uint32_t cacheSize) :
+                m_transformedAt(vertexCount, NotTransformed),
+                m_cacheSize(cacheSize)
+            {
+            }
+
+            // Returns true when the vertex has to be transformed
+            bool Use(uint32_t vertex) {
+                auto& transformedAt = m_transformedAt[vertex];
+                if (transformedAt != NotTransformed && m_time - transformedAt < m_cacheSize) {
+                    return false;
+                }
+                transformedAt = m_time++;
+                return true;
+            }
+
+            uint32_t UseTriangle(const uint32_t* triangle) {
+                return uint32_t(Use(triangle[0])) + uint32_t(Use(triangle[1])) + uint32_t(Use(triangle[2]));
+            }
+
+            // Empties the cache
+            void Flush() {
+                m_time += m_cacheSize;
+            }
+
+        private:
+            static constexpr uint64_t NotTransformed = ~0ull;
+
+            std::vector<uint64_t> m_transformedAt;
+            uint64_t m_time = 0;
+            uint32_t m_cacheSize;
+        };
+
+        inline void ReadPosition(const uint8_t* vertex, VertexFormat format, float* result) {
+            switch (format) {
+            case VertexFormat::R32_G32_B32_FLOAT:
+            case VertexFormat::R32_G32_B32_A32_FLOAT:
+                std::memcpy(result, vertex, 3 * sizeof(float));
+                return;
+            case VertexFormat::R16_G16_B16_A16_FLOAT:
+            case VertexFormat::R16_G16_B16_A16_SNORM:
+            case VertexFormat::R16_G16_B16_A16_UNORM:
+                for (int i = 0; i < 3; ++i) {
+                    uint16_t value;
+                    std::memcpy(&value, vertex + i * sizeof(value), sizeof(value));
+                    if (format == VertexFormat::R16_G16_B16_A16_FLOAT) {
+                        result[i] = quantization::HalfToFloat(value);
+                    }
+                    else if (format == VertexFormat::R16_G16_B16_A16_SNORM) {
+                        result[i] = quantization::Snorm16ToFloat(static_cast<int16_t>(value));
+                    }
+                    else {
+                        result[i] = value / 65535.0f;
+                    }
+                }
+                return;
+            default:
+                throw std::invalid_argument("Vertex format can not be used for positions");
+            }
+        }
+
+        inline void CheckIndices(const uint32_t* indices, size_t indicesCount, uint32_t vertexCount) {
+            if (indicesCount % 3 != 0) {
+                throw std::invalid_argument("Index count of a triangle list must be a multiple of 3");
+            }
+            for (size_t i = 0; i < indicesCount; ++i) {
+                if (indices[i] >= vertexCount) {
+                    throw std::out_of_range("Index refers to a vertex out of range");
+                }
+            }
+        }
+    }
+
+    // remap[oldVertex] is the new index of the vertex, or InvalidIndex if the vertex is dropped
+    struct VertexRemap {
+        static constexpr uint32_t InvalidIndex = mesh_details::InvalidIndex;
+
+        std::vector<uint32_t> remap;
+        uint32_t vertexCount = 0;
+    };
+
+    // Merges vertices with equal bytes. Without indices every vertex is used (an unindexed list);
+    // apply the result with RemapIndices to get the index buffer. Floats are compared by bits: 0 and -0 differ
+    inline VertexRemap DeduplicateVertices(const void* vertices, uint32_t vertexCount, size_t stride,
+        const uint32_t* indices = nullptr, size_t indicesCount = 0)
+    {
+        auto bytes = static_cast<const uint8_t*>(vertices);
+        VertexRemap result;
+        result.remap.assign(vertexCount, VertexRemap::InvalidIndex);
+
+        std::unordered_map<uint32_t, uint32_t, mesh_details::VertexBytesHash, mesh_details::VertexBytesEqual> unique(
+            vertexCount, mesh_details::VertexBytesHash{ bytes, stride }, mesh_details::VertexBytesEqual{ bytes, stride });
+        auto add = [&](uint32_t vertex) {
+            if (result.remap[vertex] != VertexRemap::InvalidIndex) {
+                return;
+            }
+            auto it = unique.emplace(vertex, result.vertexCount).first;
+            if (it->second == result.vertexCount) {
+                ++result.vertexCount;
+            }
+            result.remap[vertex] = it->second;
+        };
+
+        if (indices) {
+            mesh_details::CheckIndices(indices, indicesCount, vertexCount);
+            for (size_t i = 0; i < indicesCount; ++i) {
+                add(indices[i]);
+            }
+        }
+        else {
+            for (uint32_t v = 0; v < vertexCount; ++v) {
+                add(v);
+            }
+        }
+        return result;
+    }
+
+    // For unindexed input pass indices == nullptr: the result is the index buffer of the list
+    inline std::vector<uint32_t> RemapIndices(const VertexRemap& remap, const uint32_t* indices, size_t indicesCount) {
+        std::vector<uint32_t> result(indices ? indicesCount : remap.remap.size());
+        for (size_t i = 0; i < result.size(); ++i) {
+            result[i] = remap.remap[indices ? indices[i] : i];
+        }
+        return result;
+    }
+
+    inline std::vector<uint8_t> RemapVertices(const VertexRemap& remap, const void* vertices, size_t stride) {
+        auto bytes = static_cast<const uint8_t*>(vertices);
+        std::vector<uint8_t> result(size_t(remap.vertexCount) * stride);
+        for (size_t v = 0; v < remap.remap.size(); ++v) {
+            if (remap.remap[v] != VertexRemap::InvalidIndex) {
+                std::memcpy(result.data() + size_t(remap.remap[v]) * stride, bytes + v * stride, stride);
+            }
+        }
+        return result;
+    }
+
+    struct VertexCacheStatistics {
+        uint64_t trianglesCount = 0;
+        // Vertex shader invocations with a FIFO post-transform cache
+        uint64_t verticesTransformed = 0;
+        uint64_t verticesUsed = 0;
+        // Average cache miss ratio: transformed vertices per triangle. 3 is the worst, about 0.5 the best for grids
+        double acmr = 0.0;
+        // Average transform to vertex ratio: 1 means every vertex is transformed once
+        double atvr = 0.0;
+    };
+
+    // Simulates a FIFO cache of cacheSize vertices, which is how post-transform caches behave on most GPUs
+    inline VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indicesCount, uint32_t vertexCount, uint32_t cacheSize = 16) {
+        mesh_details::CheckIndices(indices, indicesCount, vertexCount);
+        VertexCacheStatistics result;
+        result.trianglesCount = indicesCount / 3;
+
+        mesh_details::VertexCacheSimulator cache(vertexCount, cacheSize);
+        std::vector<bool> used(vertexCount, false);
+        for (size_t i = 0; i < indicesCount; ++i) {
+            auto v = indices[i];
+            if (!used[v]) {
+                used[v] = true;
+                ++result.verticesUsed;
+            }
+            if (cache.Use(v)) {
+                ++result.verticesTransformed;
+            }
+        }
+
+        if (result.trianglesCount > 0) {
+            result.acmr = double(result.verticesTransformed) / double(result.trianglesCount);
+            result.atvr = double(result.verticesTransformed) / double(result.verticesUsed);
+        }
+        return result;
+    }
+
+    // Reorders triangles for the post-transform cache with Tipsify (Sander, Nehab, Barczak 2007):
+    // fans around vertices, choosing the next fan among recently used vertices that are still in the cache.
+    // Linear time; vertex order is not changed
+    inline std::vector<uint32_t> OptimizeVertexCache(const uint32_t* indices, size_t indicesCount, uint32_t vertexCount, uint32_t cacheSize = 16) {
+        using mesh_details::InvalidIndex;
+        mesh_details::CheckIndices(indices, indicesCount, vertexCount);
+
+        std::vector<uint32_t> result;
+        result.reserve(indicesCount);
+        if (indicesCount == 0) {
+            return result;
+        }
+
+        mesh_details::TriangleAdjacency adjacency(indices, indicesCount, vertexCount);
+        std::vector<uint32_t> liveTriangles(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+        }
+
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        std::vector<bool> emitted(indicesCount / 3, false);
+        std::vector<uint32_t> deadEnd;
+        std::vector<uint32_t> candidates;
+        uint32_t time = cacheSize + 1;
+        uint32_t cursor = 0;
+
+        // Dead end: no candidate has live triangles. Take a recent vertex, then the next one in input order
+        auto skipDeadEnd = [&]() {
+            while (!deadEnd.empty()) {
+                auto v = deadEnd.back();
+                deadEnd.pop_back();
+                if (liveTriangles[v] > 0) {
+                    return v;
+                }
+            }
+            for (; cursor < vertexCount; ++cursor) {
+                if (liveTriangles[cursor] > 0) {
+                    return cursor;
+                }
+            }
+            return InvalidIndex;
+        };
+
+        auto fanning = skipDeadEnd();
+        while (fanning != InvalidIndex) {
+            candidates.clear();
+            for (auto i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; ++i) {
+                auto triangle = adjacency.triangles[i];
+                if (emitted[triangle]) {
+                    continue;
+                }
+                emitted[triangle] = true;
+                for (uint32_t corner = 0; corner < 3; ++corner) {
+                    auto v = indices[triangle * 3 + corner];
+                    result.push_back(v);
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    --liveTriangles[v];
+                    if (time - cacheTime[v] > cacheSize) {
+                        cacheTime[v] = time++;
+                    }
+                }
+            }
+
+            // Prefer the oldest candidate that stays in the cache while its remaining triangles are emitted
+            fanning = InvalidIndex;
+            int64_t bestPriority = -1;
+            for (auto v : candidates) {
+                if (liveTriangles[v] == 0) {
+                    continue;
+                }
+                int64_t priority = 0;
+                if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize) {
+                    priority = time - cacheTime[v];
+                }
+                if (priority > bestPriority) {
+                    bestPriority = priority;
+                    fanning = v;
+                }
+            }
+            if (fanning == InvalidIndex) {
+                fanning = skipDeadEnd();
+            }
+        }
+        return result;
+    }
+
+    // Reorders triangles so that the ones likely to occlude others are drawn first, keeping most of the
+    // vertex cache efficiency (Sander, Nehab, Barczak 2007). Run it on the output of OptimizeVertexCache:
+    // the triangles are split into clusters whose cache miss ratio is at most `threshold` times the one of
+    // the input, then clusters facing away from the mesh center go first.
+    // Positions are read from `positionOffset` bytes into every vertex of `stride` bytes; the format may be
+    // a three or four component float, or a four component half, snorm16 or unorm16 one
+    inline std::vector<uint32_t> OptimizeOverdraw(const uint32_t* indices, size_t indicesCount,
+        const void* vertices, uint32_t vertexCount, size_t stride, size_t positionOffset, VertexFormat positionFormat,
+        float threshold = 1.05f, uint32_t cacheSize = 16)
+    {
+        mesh_details::CheckIndices(indices, indicesCount, vertexCount);
+        if (positionOffset + GetVertexFormatSize(positionFormat) > stride) {
+            throw std::invalid_argument("Position does not fit the vertex");
+        }
+
+        auto trianglesCount = static_cast<uint32_t>(indicesCount / 3);
+        if (trianglesCount == 0) {
+            return {};
+        }
+
+        // Hard boundaries: triangles that miss the cache on every vertex, where a new fan sequence starts
+        mesh_details::VertexCacheSimulator cache(vertexCount, cacheSize);
+        std::vector<uint32_t> hardBoundaries;
+        for (uint32_t t = 0; t < trianglesCount; ++t) {
+            if (cache.UseTriangle(indices + t * 3) == 3) {
+                hardBoundaries.push_back(t);
+            }
+        }
+        hardBoundaries.push_back(trianglesCount);
+
+        // Soft boundaries: a cluster ends as soon as its own miss ratio reaches the target
+        std::vector<uint32_t> clusters;
+        for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h) {
+            auto begin = hardBoundaries[h];
+            auto end = hardBoundaries[h + 1];
+
+            cache.Flush();
+            uint32_t misses = 0;
+            for (auto t = begin; t < end; ++t) {
+                misses += cache.UseTriangle(indices + t * 3);
+            }
+            auto target = threshold * misses / (end - begin);
+
+            auto first = clusters.size();
+            clusters.push_back(begin);
+            cache.Flush();
+            uint32_t runningMisses = 0;
+            uint32_t runningTriangles = 0;
+            for (auto t = begin; t < end; ++t) {
+                runningMisses += cache.UseTriangle(indices + t * 3);
+                ++runningTriangles;
+                if (runningMisses <= target * runningTriangles) {
+                    clusters.push_back(t + 1);
+                    cache.Flush();
+                    runningMisses = 0;
+                    runningTriangles = 0;
+                }
+            }
+            // Drop the empty cluster after the last cut, or merge the rest that never reached the target
+            if (clusters.back() == end || clusters.size() > first + 1) {
+                clusters.pop_back();
+            }
+        }
+        auto clustersCount = clusters.size();
+        clusters.push_back(trianglesCount);
+
+        auto bytes = static_cast<const uint8_t*>(vertices);
+        std::vector<float> positions(size_t(vertexCount) * 3);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            mesh_details::ReadPosition(bytes + v * stride + positionOffset, positionFormat, positions.data() + v * 3);
+        }
+
+        float meshCenter[3]{};
+        for (size_t i = 0; i < indicesCount; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                meshCenter[c] += positions[indices[i] * 3 + c] / indicesCount;
+            }
+        }
+
+        // How much a cluster faces away from the mesh center: the distance from the center along its average normal
+        std::vector<float> keys(clustersCount);
+        for (size_t cluster = 0; cluster < clustersCount; ++cluster) {
+            float center[3]{};
+            float normal[3]{};
+            float area = 0.0f;
+            for (auto t = clusters[cluster]; t < clusters[cluster + 1]; ++t) {
+                auto a = positions.data() + indices[t * 3] * 3;
+                auto b = positions.data() + indices[t * 3 + 1] * 3;
+                auto c = positions.data() + indices[t * 3 + 2] * 3;
+                float ab[3]{ b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+                float ac[3]{ c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+                float cross[3]{ ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+                auto triangleArea = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+                for (int i = 0; i < 3; ++i) {
+                    center[i] += (a[i] + b[i] + c[i]) / 3.0f * triangleArea;
+                    normal[i] += cross[i];
+                }
+                area += triangleArea;
+            }
+
+            auto normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            if (area == 0.0f || normalLength == 0.0f) {
+                continue;
+            }
+            for (int i = 0; i < 3; ++i) {
+                keys[cluster] += (center[i] / area - meshCenter[i]) * normal[i] / normalLength;
+            }
+        }
+
+        std::vector<uint32_t> order(clustersCount);
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return keys[a] > keys[b];
+        });
+
+        std::vector<uint32_t> result;
+        result.reserve(indicesCount);
+        for (auto cluster : order) {
+            result.insert(result.end(), indices + clusters[cluster] * 3, indices + clusters[cluster + 1] * 3);
+        }
+        return result;
+    }
+
+    // Numbers vertices in the order the index buffer first uses them, so vertex fetch walks memory
+    // forward. Unused vertices are dropped. Apply with RemapIndices and RemapVertices
+    inline VertexRemap OptimizeVertexFetch(const uint32_t* indices, size_t indicesCount, uint32_t vertexCount) {
+        mesh_details::CheckIndices(indices, indicesCount, vertexCount);
+        VertexRemap result;
+        result.remap.assign(vertexCount, VertexRemap::InvalidIndex);
+        for (size_t i = 0; i < indicesCount; ++i) {
+            auto& index = result.remap[indices[i]];
+            if (index == VertexRemap::InvalidIndex) {
+                index = result.vertexCount++;
+            }
+        }
+        return result;
+    }
+
+    struct MeshOptimizationReport {
+        uint32_t inputVertexCount = 0;
+        uint32_t outputVertexCount = 0;
+        VertexCacheStatistics before;
+        VertexCacheStatistics after;
+    };
+
+    // Whole pipeline in place: deduplication, triangle reordering for the vertex cache and vertex
+    // reordering for fetch. Empty indices mean the vertices are an unindexed triangle list
+    inline MeshOptimizationReport OptimizeMesh(std::vector<uint8_t>& vertices, size_t stride, std::vector<uint32_t>& indices,
+        uint32_t cacheSize = 16)
+    {
+        if (stride == 0 || vertices.size() % stride != 0) {
+            throw std::invalid_argument("Vertex data size must be a multiple of the stride");
+        }
+
+        MeshOptimizationReport report;
+        report.inputVertexCount = static_cast<uint32_t>(vertices.size() / stride);
+        if (indices.empty()) {
+            indices.resize(report.inputVertexCount);
+            for (uint32_t i = 0; i < report.inputVertexCount; ++i) {
+                indices[i] = i;
+            }
+        }
+        report.before = AnalyzeVertexCache(indices.data(), indices.size(), report.inputVertexCount, cacheSize);
+
+        auto unique = DeduplicateVertices(vertices.data(), report.inputVertexCount, stride, indices.data(), indices.size());
+        indices = RemapIndices(unique, indices.data(), indices.size());
+        vertices = RemapVertices(unique, vertices.data(), stride);
+
+        indices = OptimizeVertexCache(indices.data(), indices.size(), unique.vertexCount, cacheSize);
+
+        auto fetch = OptimizeVertexFetch(indices.data(), indices.size(), unique.vertexCount);
+        indices = RemapIndices(fetch, indices.data(), indices.size());
+        vertices = RemapVertices(fetch, vertices.data(), stride);
+
+        report.outputVertexCount = fetch.vertexCount;
+        report.after = AnalyzeVertexCache(indices.data(), indices.size(), fetch.vertexCount, cacheSize);
+        return report;
+    }
+
+    template<typename Vertex>
+    MeshOptimizationReport OptimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t cacheSize = 16) {
+        static_assert(std::is_trivially_copyable_v<Vertex>, "Vertices are moved as bytes");
+        std::vector<uint8_t> bytes(vertices.size() * sizeof(Vertex));
+        std::memcpy(bytes.data(), vertices.data(), bytes.size());
+        auto report = OptimizeMesh(bytes, sizeof(Vertex), indices, cacheSize);
+        vertices.resize(report.outputVertexCount);
+        std::memcpy(vertices.data(), bytes.data(), bytes.size());
+        return report;
+    }
+}
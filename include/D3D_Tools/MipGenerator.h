@@ -0,0 +1,339 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "TextureFormat.h"
+#include "ThreadPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define D3D_TOOLS_MIP_GENERATOR_SSE2
+#endif
+
+namespace d3d_tools {
+    enum class MipFilter {
+        // 2x2 average. Fast, but lets some aliasing through
+        Box,
+        // Kaiser-windowed sinc, 6 taps per axis. Sharper and with less aliasing
+        Kaiser
+    };
+
+    struct MipLevel {
+        size_t offset;
+        uint32_t width;
+        uint32_t height;
+        uint32_t rowPitch;
+        uint32_t slicePitch;
+    };
+
+    // All levels are tightly packed in one allocation, level 0 first
+    struct MipChain {
+        std::vector<uint8_t> data;
+        std::vector<MipLevel> levels;
+    };
+
+    namespace mip_details {
+        inline uint32_t GetChannelsCount(TextureFormat format) {
+            switch (format) {
+            case TextureFormat::R8_G8_B8_A8_UNORM: return 4;
+            case TextureFormat::R8_UNORM: return 1;
+            default: throw std::invalid_argument("Mip generation is not supported for this format");
+            }
+        }
+
+        inline double BesselI0(double x) {
+            double sum = 1.0;
+            double term = 1.0;
+            for (int k = 1; k < 32; ++k) {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+            }
+            return sum;
+        }
+
+        static constexpr int KaiserTaps = 6;
+
+        // Weights for taps at source pixels [2x - 2, 2x + 3] of destination pixel x
+        inline const std::array<float, KaiserTaps>& GetKaiserWeights() {
+            static const auto weights = [] {
+                const double alpha = 4.0;
+                const double radius = KaiserTaps / 2.0;
+                const double pi = 3.14159265358979323846;
+                std::array<float, KaiserTaps> result{};
+                double sum = 0.0;
+                std::array<double, KaiserTaps> raw{};
+                for (int i = 0; i < KaiserTaps; ++i) {
+                    // Distance from destination pixel center in source pixels
+                    double d = (i - 2) - 0.5;
+                    double x = d / 2.0;
+                    double sinc = x == 0.0 ? 1.0 : std::sin(pi * x) / (pi * x);
+                    double t = d / radius;
+                    double window = BesselI0(alpha * std::sqrt(std::max(0.0, 1.0 - t * t))) / BesselI0(alpha);
+                    raw[i] = sinc * window;
+                    sum += raw[i];
+                }
+                for (int i = 0; i < KaiserTaps; ++i) {
+                    result[i] = static_cast<float>(raw[i] / sum);
+                }
+                return result;
+            }();
+            return weights;
+        }
+
+        inline uint8_t ToUnorm8(float value) {
+            value = std::min(std::max(value, 0.0f), 255.0f);
+            return static_cast<uint8_t>(value + 0.5f);
+        }
+
+        inline void BoxRows(
+            const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint32_t srcPitch,
+            uint8_t* dst, uint32_t dstWidth, uint32_t dstPitch,
+            uint32_t channels, size_t rowBegin, size_t rowEnd)
+        {
+            for (auto y = rowBegin; y < rowEnd; ++y) {
+                auto row0 = src + std::min<size_t>(2 * y, srcHeight - 1) * srcPitch;
+                auto row1 = src + std::min<size_t>(2 * y + 1, srcHeight - 1) * srcPitch;
+                auto out = dst + y * dstPitch;
+                uint32_t x = 0;
+
+#ifdef D3D_TOOLS_MIP_GENERATOR_SSE2
+                // 4 destination pixels of RGBA8 (16 bytes) per iteration
+                if (channels == 4) {
+                    const auto zero = _mm_setzero_si128();
+                    const auto two = _mm_set1_epi16(2);
+                    for (; x + 4 <= dstWidth && 2 * x + 8 <= srcWidth; x += 4) {
+                        auto a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x));
+                        auto a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x + 16));
+                        auto b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x));
+                        auto b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x + 16));
+
+                        // Vertical sums of 16-bit channels: p0 p1 | p2 p3 | ...
+                        auto s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+                        auto s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+                        auto s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+                        auto s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+                        // Horizontal sums: every register holds two neighbour pixels
+                        auto h0 = _mm_add_epi16(s0, _mm_srli_si128(s0, 8));
+                        auto h1 = _mm_add_epi16(s1, _mm_srli_si128(s1, 8));
+                        auto h2 = _mm_add_epi16(s2, _mm_srli_si128(s2, 8));
+                        auto h3 = _mm_add_epi16(s3, _mm_srli_si128(s3, 8));
+
+                        auto lo = _mm_unpacklo_epi64(h0, h1);
+                        auto hi = _mm_unpacklo_epi64(h2, h3);
+                        lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+                        hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * x), _mm_packus_epi16(lo, hi));
+                    }
+                }
+#endif
+
+                for (; x < dstWidth; ++x) {
+                    auto x0 = std::min<size_t>(2 * x, srcWidth - 1) * channels;
+                    auto x1 = std::min<size_t>(2 * x + 1, srcWidth - 1) * channels;
+                    for (uint32_t c = 0; c < channels; ++c) {
+                        uint32_t sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+                        out[x * channels + c] = static_cast<uint8_t>((sum + 2) / 4);
+                    }
+                }
+            }
+        }
+
+        // Filters one destination pixel clamping taps to the row
+        inline void KaiserPixel(const uint8_t* row, uint32_t srcWidth, float* out, uint32_t x, uint32_t channels) {
+            auto& weights = GetKaiserWeights();
+            for (uint32_t c = 0; c < channels; ++c) {
+                float sum = 0.0f;
+                for (int t = 0; t < KaiserTaps; ++t) {
+                    auto sx = std::min<int64_t>(std::max<int64_t>(2 * int64_t(x) + t - 2, 0), srcWidth - 1);
+                    sum += weights[t] * row[sx * channels + c];
+                }
+                out[x * channels + c] = sum;
+            }
+        }
+
+#ifdef D3D_TOOLS_MIP_GENERATOR_SSE2
+        // Two RGBA8 pixels to float channels
+        inline void LoadPixelPair(const uint8_t* pixels, __m128& first, __m128& second) {
+            const auto zero = _mm_setzero_si128();
+            auto words = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels)), zero);
+            first = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+            second = _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero));
+        }
+#endif
+
+        // Horizontal pass into float rows: srcHeight x dstWidth
+        inline void KaiserHorizontal(
+            const uint8_t* src, uint32_t srcWidth, uint32_t srcPitch,
+            float* dst, uint32_t dstWidth, uint32_t channels, size_t rowBegin, size_t rowEnd)
+        {
+            for (auto y = rowBegin; y < rowEnd; ++y) {
+                auto row = src + y * srcPitch;
+                auto out = dst + y * dstWidth * channels;
+                uint32_t x = 0;
+
+#ifdef D3D_TOOLS_MIP_GENERATOR_SSE2
+                // RGBA8 pixels whose taps are all inside the row: 4 channels at once.
+                // Same operations in the same order as KaiserPixel, so results are identical
+                if (channels == 4) {
+                    auto& weights = GetKaiserWeights();
+                    __m128 w[KaiserTaps];
+                    for (int t = 0; t < KaiserTaps; ++t) {
+                        w[t] = _mm_set1_ps(weights[t]);
+                    }
+
+                    for (; x < dstWidth && 2 * x < 2; ++x) {
+                        KaiserPixel(row, srcWidth, out, x, channels);
+                    }
+                    for (; x < dstWidth && 2 * x + 3 < srcWidth; ++x) {
+                        auto pixels = row + (2 * x - 2) * 4;
+                        __m128 p[KaiserTaps];
+                        LoadPixelPair(pixels, p[0], p[1]);
+                        LoadPixelPair(pixels + 8, p[2], p[3]);
+                        LoadPixelPair(pixels + 16, p[4], p[5]);
+                        auto sum = _mm_setzero_ps();
+                        for (int t = 0; t < KaiserTaps; ++t) {
+                            sum = _mm_add_ps(sum, _mm_mul_ps(w[t], p[t]));
+                        }
+                        _mm_storeu_ps(out + 4 * x, sum);
+                    }
+                }
+#endif
+
+                for (; x < dstWidth; ++x) {
+                    KaiserPixel(row, srcWidth, out, x, channels);
+                }
+            }
+        }
+
+        inline void KaiserVertical(
+            const float* src, uint32_t srcHeight,
+            uint8_t* dst, uint32_t dstWidth, uint32_t dstPitch, uint32_t channels, size_t rowBegin, size_t rowEnd)
+        {
+            auto& weights = GetKaiserWeights();
+            auto rowSize = size_t(dstWidth) * channels;
+            for (auto y = rowBegin; y < rowEnd; ++y) {
+                const float* rows[KaiserTaps];
+                for (int t = 0; t < KaiserTaps; ++t) {
+                    auto sy = std::min<int64_t>(std::max<int64_t>(2 * int64_t(y) + t - 2, 0), srcHeight - 1);
+                    rows[t] = src + sy * rowSize;
+                }
+
+                auto out = dst + y * dstPitch;
+                size_t i = 0;
+
+#ifdef D3D_TOOLS_MIP_GENERATOR_SSE2
+                // 16 values per iteration, converted the same way as ToUnorm8
+                const auto lowest = _mm_setzero_ps();
+                const auto highest = _mm_set1_ps(255.0f);
+                const auto half = _mm_set1_ps(0.5f);
+                __m128 w[KaiserTaps];
+                for (int t = 0; t < KaiserTaps; ++t) {
+                    w[t] = _mm_set1_ps(weights[t]);
+                }
+
+                for (; i + 16 <= rowSize; i += 16) {
+                    __m128i words[4];
+                    for (int part = 0; part < 4; ++part) {
+                        auto sum = _mm_setzero_ps();
+                        for (int t = 0; t < KaiserTaps; ++t) {
+                            sum = _mm_add_ps(sum, _mm_mul_ps(w[t], _mm_loadu_ps(rows[t] + i + 4 * part)));
+                        }
+                        sum = _mm_min_ps(_mm_max_ps(sum, lowest), highest);
+                        words[part] = _mm_cvttps_epi32(_mm_add_ps(sum, half));
+                    }
+                    auto lo = _mm_packs_epi32(words[0], words[1]);
+                    auto hi = _mm_packs_epi32(words[2], words[3]);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(lo, hi));
+                }
+#endif
+
+                for (; i < rowSize; ++i) {
+                    float sum = 0.0f;
+                    for (int t = 0; t < KaiserTaps; ++t) {
+                        sum += weights[t] * rows[t][i];
+                    }
+                    out[i] = ToUnorm8(sum);
+                }
+            }
+        }
+    }
+
+    // Builds full mip chain on CPU. Rows of every level are processed in parallel if pool is passed.
+    // Supported formats: R8_G8_B8_A8_UNORM and R8_UNORM (values are treated as linear)
+    inline MipChain GenerateMipChain(
+        const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch,
+        TextureFormat format, MipFilter filter, ThreadPool* threadPool = nullptr, uint32_t mipLevels = 0)
+    {
+        if (width == 0 || height == 0) {
+            throw std::invalid_argument("Texture must not be empty");
+        }
+
+        auto channels = mip_details::GetChannelsCount(format);
+        auto fullChain = ComputeMipLevelsCount(width, height);
+        if (mipLevels == 0 || mipLevels > fullChain) {
+            mipLevels = fullChain;
+        }
+
+        MipChain result;
+        size_t totalSize = 0;
+        for (uint32_t level = 0; level < mipLevels; ++level) {
+            MipLevel info;
+            info.offset = totalSize;
+            info.width = ComputeMipExtent(width, level);
+            info.height = ComputeMipExtent(height, level);
+            info.rowPitch = info.width * channels;
+            info.slicePitch = info.rowPitch * info.height;
+            totalSize += info.slicePitch;
+            result.levels.push_back(info);
+        }
+
+        result.data.resize(totalSize);
+        auto& top = result.levels[0];
+        for (uint32_t y = 0; y < height; ++y) {
+            std::copy(pixels + size_t(y) * rowPitch, pixels + size_t(y) * rowPitch + top.rowPitch,
+                result.data.begin() + top.offset + size_t(y) * top.rowPitch);
+        }
+
+        // rowBytes is the work per row of the level being processed
+        auto parallelFor = [&](size_t count, size_t rowBytes, auto&& f) {
+            if (threadPool) {
+                // Grain keeps tasks big enough to not drown in scheduling
+                threadPool->ParallelFor(count, 16384 / rowBytes + 1, f);
+            } else {
+                f(size_t(0), count);
+            }
+        };
+
+        std::vector<float> temporary;
+        for (uint32_t level = 1; level < mipLevels; ++level) {
+            auto& src = result.levels[level - 1];
+            auto& dst = result.levels[level];
+            auto srcData = result.data.data() + src.offset;
+            auto dstData = result.data.data() + dst.offset;
+
+            if (filter == MipFilter::Box) {
+                parallelFor(dst.height, dst.rowPitch, [&](size_t begin, size_t end) {
+                    mip_details::BoxRows(srcData, src.width, src.height, src.rowPitch,
+                        dstData, dst.width, dst.rowPitch, channels, begin, end);
+                });
+            } else {
+                temporary.resize(size_t(src.height) * dst.width * channels);
+                parallelFor(src.height, src.rowPitch, [&](size_t begin, size_t end) {
+                    mip_details::KaiserHorizontal(srcData, src.width, src.rowPitch,
+                        temporary.data(), dst.width, channels, begin, end);
+                });
+                parallelFor(dst.height, dst.rowPitch, [&](size_t begin, size_t end) {
+                    mip_details::KaiserVertical(temporary.data(), src.height,
+                        dstData, dst.width, dst.rowPitch, channels, begin, end);
+                });
+            }
+        }
+
+        return result;
+    }
+}
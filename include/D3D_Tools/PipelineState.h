@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include "d3d11.h"
+#include "Hash.h"
+#include "StateDescriptions.h"
+
+namespace d3d_tools {
+    // Full graphics pipeline of a draw. Shaders and input layout are not owned: they must outlive
+    // pipeline states created from the description. Null shader means the stage is disabled
+    struct PipelineStateDescription {
+        ID3D11VertexShader* vertexShader = nullptr;
+        ID3D11HullShader* hullShader = nullptr;
+        ID3D11DomainShader* domainShader = nullptr;
+        ID3D11GeometryShader* geometryShader = nullptr;
+        ID3D11PixelShader* pixelShader = nullptr;
+        ID3D11InputLayout* inputLayout = nullptr;
+        D3D11_PRIMITIVE_TOPOLOGY topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+
+        D3D11_BLEND_DESC blend = MakeDefaultBlendDescription();
+        D3D11_RASTERIZER_DESC rasterizer = MakeDefaultRasterizerDescription();
+        D3D11_DEPTH_STENCIL_DESC depthStencil = MakeDefaultDepthStencilDescription();
+
+        float blendFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        UINT sampleMask = 0xffffffff;
+        UINT stencilRef = 0;
+    };
+
+    struct PipelineStateDescriptionHash {
+        size_t operator()(const PipelineStateDescription& desc) const {
+            Hasher hasher;
+            hasher.AddValue(desc.vertexShader).AddValue(desc.hullShader).AddValue(desc.domainShader);
+            hasher.AddValue(desc.geometryShader).AddValue(desc.pixelShader);
+            hasher.AddValue(desc.inputLayout).AddValue(desc.topology);
+            state_details::AddDescription(hasher, desc.blend);
+            state_details::AddDescription(hasher, desc.rasterizer);
+            state_details::AddDescription(hasher, desc.depthStencil);
+            for (auto value : desc.blendFactor) {
+                state_details::AddFloat(hasher, value);
+            }
+            hasher.AddValue(desc.sampleMask).AddValue(desc.stencilRef);
+            return static_cast<size_t>(hasher.GetValue());
+        }
+    };
+
+    struct PipelineStateDescriptionEqual {
+        bool operator()(const PipelineStateDescription& a, const PipelineStateDescription& b) const {
+            using namespace state_details;
+            return
+                a.vertexShader == b.vertexShader &&
+                a.hullShader == b.hullShader &&
+                a.domainShader == b.domainShader &&
+                a.geometryShader == b.geometryShader &&
+                a.pixelShader == b.pixelShader &&
+                a.inputLayout == b.inputLayout &&
+                a.topology == b.topology &&
+                AreEqual(a.blend, b.blend) &&
+                AreEqual(a.rasterizer, b.rasterizer) &&
+                AreEqual(a.depthStencil, b.depthStencil) &&
+                std::equal(a.blendFactor, a.blendFactor + 4, b.blendFactor) &&
+                a.sampleMask == b.sampleMask &&
+                a.stencilRef == b.stencilRef;
+        }
+    };
+
+    template<typename StateObjects>
+    class BasicPipelineStateCache;
+
+    // Immutable bundle of everything a draw sets besides resources. Created by PipelineStateCache only,
+    // so equal descriptions share one object and comparing pipelines is comparing pointers.
+    // State objects are owned by the StateObjectCache of the pipeline cache
+    class PipelineState {
+    public:
+        PipelineState(const PipelineState&) = delete;
+        PipelineState& operator=(const PipelineState&) = delete;
+
+        const PipelineStateDescription& GetDescription() const {
+            return m_description;
+        }
+
+        // Dense and unique within the cache, e.g. for draw sort keys
+        uint32_t GetId() const {
+            return m_id;
+        }
+
+        ID3D11BlendState* GetBlendState() const {
+            return m_blendState;
+        }
+
+        ID3D11RasterizerState* GetRasterizerState() const {
+            return m_rasterizerState;
+        }
+
+        ID3D11DepthStencilState* GetDepthStencilState() const {
+            return m_depthStencilState;
+        }
+
+    private:
+        template<typename StateObjects>
+        friend class BasicPipelineStateCache;
+
+        PipelineState(
+            const PipelineStateDescription& description,
+            uint32_t id,
+            ID3D11BlendState* blendState,
+            ID3D11RasterizerState* rasterizerState,
+            ID3D11DepthStencilState* depthStencilState) :
+            m_description(description),
+            m_id(id),
+            m_blendState(blendState),
+            m_rasterizerState(rasterizerState),
+            m_depthStencilState(depthStencilState)
+        {
+        }
+
+    private:
+        PipelineStateDescription m_description;
+        uint32_t m_id;
+        ID3D11BlendState* m_blendState;
+        ID3D11RasterizerState* m_rasterizerState;
+        ID3D11DepthStencilState* m_depthStencilState;
+    };
+
+    struct PipelineStateCacheStatistics {
+        uint64_t requestsCount = 0;
+        uint64_t createdCount = 0;
+    };
+
+    // Owns pipeline states; they live as long as the cache. Blend, rasterizer and depth stencil objects
+    // come from StateObjects, so pipelines that differ only in shaders share them. StateObjects provides
+    //     GetBlendState(desc), GetRasterizerState(desc), GetDepthStencilState(desc).
+    // PipelineStateCache uses StateObjectCache, so the cache itself knows nothing about D3D. Not thread safe
+    template<typename StateObjects>
+    class BasicPipelineStateCache {
+    public:
+        // stateObjects must outlive the pipeline cache
+        BasicPipelineStateCache(StateObjects* stateObjects) :
+            m_stateObjects(stateObjects)
+        {
+        }
+
+        const PipelineState& GetOrCreate(const PipelineStateDescription& description) {
+            ++m_statistics.requestsCount;
+            auto it = m_states.find(description);
+            if (it != m_states.end()) {
+                return *it->second;
+            }
+
+            std::unique_ptr<PipelineState> state(new PipelineState(
+                description,
+                static_cast<uint32_t>(m_states.size()),
+                m_stateObjects->GetBlendState(description.blend),
+                m_stateObjects->GetRasterizerState(description.rasterizer),
+                m_stateObjects->GetDepthStencilState(description.depthStencil)));
+            ++m_statistics.createdCount;
+
+            auto& result = *state;
+            m_states.emplace(description, std::move(state));
+            return result;
+        }
+
+        size_t GetSize() const {
+            return m_states.size();
+        }
+
+        const PipelineStateCacheStatistics& GetStatistics() const {
+            return m_statistics;
+        }
+
+        StateObjects& GetStateObjects() const {
+            return *m_stateObjects;
+        }
+
+    private:
+        StateObjects* m_stateObjects;
+        std::unordered_map<PipelineStateDescription, std::unique_ptr<PipelineState>,
+            PipelineStateDescriptionHash, PipelineStateDescriptionEqual> m_states;
+        PipelineStateCacheStatistics m_statistics;
+    };
+}
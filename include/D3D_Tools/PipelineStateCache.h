@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Device.h"
+#include "PipelineState.h"
+#include "StateObjectCache.h"
+
+namespace d3d_tools {
+    // State objects are created on the device of the StateObjectCache, which must outlive the pipeline cache
+    using PipelineStateCache = BasicPipelineStateCache<StateObjectCache>;
+}
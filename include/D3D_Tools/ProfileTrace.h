@@ -0,0 +1,320 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Hash.h"
+
+namespace d3d_tools {
+    // One timed scope of a frame. CPU times are in nanoseconds of any monotonic clock,
+    // GPU times are raw timestamp ticks of the frame's frequency
+    struct ProfileScope {
+        static constexpr uint32_t NoParent = ~0u;
+
+        std::string name;
+        uint32_t parent = NoParent;
+        uint32_t depth = 0;
+        uint64_t cpuBegin = 0;
+        uint64_t cpuEnd = 0;
+        uint64_t gpuBegin = 0;
+        uint64_t gpuEnd = 0;
+        bool hasGpuTime = false;
+    };
+
+    struct ProfileFrame {
+        double GetCpuMilliseconds(const ProfileScope& scope) const {
+            return (scope.cpuEnd - scope.cpuBegin) * 1e-6;
+        }
+
+        // GPU time is meaningless when the frame is disjoint (e.g. clock changed) or the scope was not measured
+        bool HasGpuTime(const ProfileScope& scope) const {
+            return scope.hasGpuTime && !disjoint && gpuFrequency != 0 && scope.gpuEnd >= scope.gpuBegin;
+        }
+
+        double GetGpuMilliseconds(const ProfileScope& scope) const {
+            return HasGpuTime(scope) ? (scope.gpuEnd - scope.gpuBegin) * 1000.0 / gpuFrequency : 0.0;
+        }
+
+        uint64_t frameIndex = 0;
+        uint64_t gpuFrequency = 0;
+        bool disjoint = false;
+        // Parents go before children, siblings in the order they began
+        std::vector<ProfileScope> scopes;
+    };
+
+    // Builds scope hierarchy of one frame from begin/end calls
+    class ProfileFrameBuilder {
+    public:
+        void Reset(uint64_t frameIndex) {
+            m_frame.frameIndex = frameIndex;
+            m_frame.gpuFrequency = 0;
+            m_frame.disjoint = false;
+            m_frame.scopes.clear();
+            m_stack.clear();
+        }
+
+        uint32_t BeginScope(std::string_view name, uint64_t cpuTime) {
+            auto index = static_cast<uint32_t>(m_frame.scopes.size());
+            ProfileScope scope;
+            scope.name.assign(name.data(), name.size());
+            scope.parent = m_stack.empty() ? ProfileScope::NoParent : m_stack.back();
+            scope.depth = static_cast<uint32_t>(m_stack.size());
+            scope.cpuBegin = cpuTime;
+            m_frame.scopes.push_back(std::move(scope));
+            m_stack.push_back(index);
+            return index;
+        }
+
+        // Scopes must end in reverse order of beginning. Any other end is ignored and returns false:
+        // scopes are ended from destructors, so this must not throw
+        bool EndScope(uint32_t index, uint64_t cpuTime) noexcept {
+            if (m_stack.empty() || m_stack.back() != index) {
+                return false;
+            }
+            m_frame.scopes[index].cpuEnd = cpuTime;
+            m_stack.pop_back();
+            return true;
+        }
+
+        void SetGpuTime(uint32_t index, uint64_t gpuBegin, uint64_t gpuEnd) {
+            auto& scope = m_frame.scopes[index];
+            scope.gpuBegin = gpuBegin;
+            scope.gpuEnd = gpuEnd;
+            scope.hasGpuTime = true;
+        }
+
+        void SetGpuClock(uint64_t frequency, bool disjoint) {
+            m_frame.gpuFrequency = frequency;
+            m_frame.disjoint = disjoint;
+        }
+
+        size_t GetOpenScopesCount() const {
+            return m_stack.size();
+        }
+
+        const ProfileFrame& GetFrame() const {
+            return m_frame;
+        }
+
+        ProfileFrame& GetFrame() {
+            return m_frame;
+        }
+
+    private:
+        ProfileFrame m_frame;
+        std::vector<uint32_t> m_stack;
+    };
+
+    // Per-scope timings accumulated over frames. Scopes are identified by their path from the root,
+    // so the same name under different parents is counted separately
+    class ProfileAggregator {
+    public:
+        struct Entry {
+            double GetAverageCpuMilliseconds() const {
+                return count ? cpuTotal / count : 0.0;
+            }
+
+            double GetAverageGpuMilliseconds() const {
+                return gpuCount ? gpuTotal / gpuCount : 0.0;
+            }
+
+            std::string name;
+            uint32_t parent = ProfileScope::NoParent;
+            uint32_t depth = 0;
+            uint64_t count = 0;
+            uint64_t gpuCount = 0;
+            double cpuTotal = 0.0;
+            double cpuMax = 0.0;
+            double gpuTotal = 0.0;
+            double gpuMax = 0.0;
+        };
+
+        void Add(const ProfileFrame& frame) {
+            m_entryOfScope.resize(frame.scopes.size());
+            for (size_t i = 0; i < frame.scopes.size(); ++i) {
+                auto& scope = frame.scopes[i];
+                auto parentEntry = scope.parent == ProfileScope::NoParent ? ProfileScope::NoParent : m_entryOfScope[scope.parent];
+                auto entryIndex = FindOrAddEntry(parentEntry, scope);
+                m_entryOfScope[i] = entryIndex;
+
+                auto& entry = m_entries[entryIndex];
+                auto cpu = frame.GetCpuMilliseconds(scope);
+                ++entry.count;
+                entry.cpuTotal += cpu;
+                entry.cpuMax = std::max(entry.cpuMax, cpu);
+                if (frame.HasGpuTime(scope)) {
+                    auto gpu = frame.GetGpuMilliseconds(scope);
+                    ++entry.gpuCount;
+                    entry.gpuTotal += gpu;
+                    entry.gpuMax = std::max(entry.gpuMax, gpu);
+                }
+            }
+            ++m_framesCount;
+        }
+
+        // In order of first appearance; parents go before children
+        const std::vector<Entry>& GetEntries() const {
+            return m_entries;
+        }
+
+        uint64_t GetFramesCount() const {
+            return m_framesCount;
+        }
+
+        void Clear() {
+            m_entries.clear();
+            m_entryKeys.clear();
+            m_entryIndices.clear();
+            m_framesCount = 0;
+        }
+
+    private:
+        uint32_t FindOrAddEntry(uint32_t parentEntry, const ProfileScope& scope) {
+            uint64_t key = parentEntry == ProfileScope::NoParent ? 0 : m_entryKeys[parentEntry];
+            CombineHash(key, Hasher().Add(scope.name).GetValue());
+
+            auto it = m_entryIndices.find(key);
+            if (it != m_entryIndices.end()) {
+                return it->second;
+            }
+
+            auto index = static_cast<uint32_t>(m_entries.size());
+            Entry entry;
+            entry.name = scope.name;
+            entry.parent = parentEntry;
+            entry.depth = scope.depth;
+            m_entries.push_back(std::move(entry));
+            m_entryKeys.push_back(key);
+            m_entryIndices.emplace(key, index);
+            return index;
+        }
+
+    private:
+        std::vector<Entry> m_entries;
+        std::vector<uint64_t> m_entryKeys;
+        std::unordered_map<uint64_t, uint32_t> m_entryIndices;
+        std::vector<uint32_t> m_entryOfScope;
+        uint64_t m_framesCount = 0;
+    };
+
+    namespace profile_details {
+        inline void WriteJsonString(std::ostream& output, std::string_view str) {
+            static const char hex[] = "0123456789abcdef";
+            output << '"';
+            for (char c : str) {
+                switch (c) {
+                case '"': output << "\\\""; break;
+                case '\\': output << "\\\\"; break;
+                case '\n': output << "\\n"; break;
+                case '\r': output << "\\r"; break;
+                case '\t': output << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        output << "\\u00" << hex[(c >> 4) & 0xF] << hex[c & 0xF];
+                    } else {
+                        output << c;
+                    }
+                }
+            }
+            output << '"';
+        }
+
+        inline void WriteCompleteEvent(std::ostream& output, bool& first, std::string_view name, const char* category,
+            uint32_t threadId, double beginMicroseconds, double durationMicroseconds, uint64_t frameIndex)
+        {
+            output << (first ? "\n" : ",\n");
+            first = false;
+            output << "{\"name\":";
+            WriteJsonString(output, name);
+            output << ",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadId
+                << ",\"ts\":" << beginMicroseconds << ",\"dur\":" << durationMicroseconds
+                << ",\"args\":{\"frame\":" << frameIndex << "}}";
+        }
+    }
+
+    // Writes frames as Chrome trace event JSON (chrome://tracing, Perfetto).
+    // CPU scopes go to thread 1 and GPU scopes to thread 2. GPU clock is not synchronized with CPU one,
+    // so every frame's GPU timeline is placed to start together with its first CPU scope
+    inline void WriteChromeTrace(std::ostream& output, const std::vector<ProfileFrame>& frames) {
+        auto flags = output.flags();
+        output.setf(std::ios::fixed);
+        auto precision = output.precision(3);
+
+        output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        output << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}}";
+        output << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+        bool first = false;
+        for (auto& frame : frames) {
+            if (frame.scopes.empty()) {
+                continue;
+            }
+
+            for (auto& scope : frame.scopes) {
+                profile_details::WriteCompleteEvent(output, first, scope.name, "cpu", 1,
+                    scope.cpuBegin * 1e-3, (scope.cpuEnd - scope.cpuBegin) * 1e-3, frame.frameIndex);
+            }
+
+            const ProfileScope* gpuOrigin = nullptr;
+            for (auto& scope : frame.scopes) {
+                if (frame.HasGpuTime(scope) && (!gpuOrigin || scope.gpuBegin < gpuOrigin->gpuBegin)) {
+                    gpuOrigin = &scope;
+                }
+            }
+            if (!gpuOrigin) {
+                continue;
+            }
+
+            auto origin = frame.scopes.front().cpuBegin * 1e-3;
+            auto ticksToMicroseconds = 1e6 / frame.gpuFrequency;
+            for (auto& scope : frame.scopes) {
+                if (!frame.HasGpuTime(scope)) {
+                    continue;
+                }
+                auto begin = origin + (scope.gpuBegin - gpuOrigin->gpuBegin) * ticksToMicroseconds;
+                profile_details::WriteCompleteEvent(output, first, scope.name, "gpu", 2,
+                    begin, (scope.gpuEnd - scope.gpuBegin) * ticksToMicroseconds, frame.frameIndex);
+            }
+        }
+        output << "\n]}\n";
+
+        output.precision(precision);
+        output.flags(flags);
+    }
+
+    // UTF-16 (or UTF-32 where wchar_t is 32 bit) to UTF-8 for names that come from wide annotation titles
+    inline std::string ConvertToUtf8(std::wstring_view str) {
+        std::string result;
+        result.reserve(str.size());
+        for (size_t i = 0; i < str.size(); ++i) {
+            uint32_t code = static_cast<uint32_t>(str[i]);
+            if (code >= 0xD800 && code <= 0xDBFF && i + 1 < str.size()) {
+                uint32_t low = static_cast<uint32_t>(str[i + 1]);
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    ++i;
+                }
+            }
+
+            if (code < 0x80) {
+                result += static_cast<char>(code);
+            } else if (code < 0x800) {
+                result += static_cast<char>(0xC0 | (code >> 6));
+                result += static_cast<char>(0x80 | (code & 0x3F));
+            } else if (code < 0x10000) {
+                result += static_cast<char>(0xE0 | (code >> 12));
+                result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                result += static_cast<char>(0x80 | (code & 0x3F));
+            } else {
+                result += static_cast<char>(0xF0 | (code >> 18));
+                result += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                result += static_cast<char>(0x80 | (code & 0x3F));
+            }
+        }
+        return result;
+    }
+}
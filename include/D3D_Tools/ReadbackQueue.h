@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <vector>
+#include "Device.h"
+#include "DxgiFormat.h"
+#include "GpuBuffer.h"
+#include "ReadbackTracker.h"
+#include "Texture.h"
+
+namespace d3d_tools {
+    // Mapped copy of a buffer range or a texture subresource. Valid only inside the callback
+    struct ReadbackData {
+        template<typename T>
+        edt::DenseArrayView<const T> GetElements() const {
+            return edt::DenseArrayView<const T>(static_cast<const T*>(data), size / sizeof(T));
+        }
+
+        const void* data;
+        size_t size;
+        // Texture rows may be padded: use rowPitch, not width
+        uint32_t rowPitch;
+        uint32_t width;
+        uint32_t height;
+        uint64_t submitFrame;
+        uint32_t latencyFrames;
+    };
+
+    using ReadbackCallback = std::function<void(const ReadbackData&)>;
+
+    // Copies buffers and textures into staging resources and hands them to callbacks once the GPU is done,
+    // latencyFrames or more frames later. Staging resources are kept per shape (rounded up buffer size or
+    // texture extent and format) in rings of stagingPerShape, so the render thread neither stalls on Map nor
+    // creates resources in steady state. Shapes not read for evictAfterFrames frames are released.
+    // Works on the immediate device only
+    class ReadbackQueue {
+    public:
+        ReadbackQueue(Device* device, uint32_t latencyFrames = 2, uint32_t stagingPerShape = 3, uint32_t evictAfterFrames = 120) :
+            m_device(device->GetDevice()),
+            m_context(device->GetContext()),
+            m_stagingPerShape(stagingPerShape),
+            m_evictAfterFrames(evictAfterFrames),
+            m_tracker(latencyFrames)
+        {
+            CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(!device->IsDeferred(), "Readback requires the immediate device");
+                edt::ThrowIfFailed(stagingPerShape > 0, "At least one staging resource per shape is required");
+            };
+        }
+
+        // size 0 means up to the end of the buffer. Returns false when the ring of this shape is full:
+        // the request is dropped and may be repeated next frame
+        bool ReadBuffer(ID3D11Buffer* source, ReadbackCallback callback, uint32_t offset = 0, uint32_t size = 0) {
+            return CallAndRethrowM + [&] {
+                D3D11_BUFFER_DESC sourceDesc{};
+                source->GetDesc(&sourceDesc);
+                if (size == 0) {
+                    edt::ThrowIfFailed(offset < sourceDesc.ByteWidth, "Readback offset is out of the buffer");
+                    size = sourceDesc.ByteWidth - offset;
+                }
+                edt::ThrowIfFailed(uint64_t(offset) + size <= sourceDesc.ByteWidth, "Readback range is out of the buffer");
+
+                Shape shape{ false, size, 1, DXGI_FORMAT_UNKNOWN };
+                auto staging = AcquireStaging(Shape{ false, ComputeReadbackStagingSize(size), 1, DXGI_FORMAT_UNKNOWN });
+                if (!staging) {
+                    return false;
+                }
+
+                D3D11_BOX box{ offset, 0, 0, offset + size, 1, 1 };
+                m_context->CopySubresourceRegion(staging->GetResource(), 0, 0, 0, 0, source, 0, &box);
+                Enqueue(*staging, shape, std::move(callback));
+                return true;
+            };
+        }
+
+        template<typename ElementType>
+        bool Read(const GpuBuffer<ElementType>& buffer, ReadbackCallback callback) {
+            return ReadBuffer(buffer.GetBuffer(), std::move(callback));
+        }
+
+        // Reads one subresource. Multisampled textures must be resolved first
+        bool ReadTexture(ID3D11Texture2D* source, uint32_t subresource, ReadbackCallback callback) {
+            return CallAndRethrowM + [&] {
+                D3D11_TEXTURE2D_DESC sourceDesc{};
+                source->GetDesc(&sourceDesc);
+                edt::ThrowIfFailed(sourceDesc.SampleDesc.Count == 1, "Multisampled textures can not be read back");
+                edt::ThrowIfFailed(subresource < sourceDesc.MipLevels * sourceDesc.ArraySize, "Subresource is out of the texture");
+
+                auto mip = subresource % sourceDesc.MipLevels;
+                Shape shape{ true, ComputeMipExtent(sourceDesc.Width, mip), ComputeMipExtent(sourceDesc.Height, mip), sourceDesc.Format };
+                auto staging = AcquireStaging(shape);
+                if (!staging) {
+                    return false;
+                }
+
+                m_context->CopySubresourceRegion(staging->GetResource(), 0, 0, 0, 0, source, subresource, nullptr);
+                Enqueue(*staging, shape, std::move(callback));
+                return true;
+            };
+        }
+
+        bool Read(const Texture& texture, ReadbackCallback callback, uint32_t subresource = 0) {
+            return ReadTexture(texture.GetTexture(), subresource, std::move(callback));
+        }
+
+        // Once per frame, after the frame's copies are recorded. Delivers finished copies and never waits
+        void Update() {
+            CallAndRethrowM + [&] {
+                std::exception_ptr callbackError;
+                m_tracker.Poll([&](uint64_t) {
+                    return TryDeliver(D3D11_MAP_FLAG_DO_NOT_WAIT, callbackError);
+                });
+                m_tracker.AdvanceFrame();
+                EvictIdlePools();
+                if (callbackError) {
+                    std::rethrow_exception(callbackError);
+                }
+            };
+        }
+
+        // Waits for every pending copy and delivers it
+        void Flush() {
+            CallAndRethrowM + [&] {
+                std::exception_ptr callbackError;
+                m_tracker.Drain([&](uint64_t) {
+                    TryDeliver(0, callbackError);
+                });
+                if (callbackError) {
+                    std::rethrow_exception(callbackError);
+                }
+            };
+        }
+
+        size_t GetPendingCount() const {
+            return m_tracker.GetPendingCount();
+        }
+
+        size_t GetStagingCount() const {
+            size_t result = 0;
+            for (auto& pool : m_pools) {
+                result += pool.staging.size();
+            }
+            return result;
+        }
+
+        const ReadbackStatistics& GetStatistics() const {
+            return m_tracker.GetStatistics();
+        }
+
+    private:
+        struct Shape {
+            bool operator==(const Shape& other) const {
+                return isTexture == other.isTexture && width == other.width && height == other.height && format == other.format;
+            }
+
+            bool isTexture;
+            // Byte size for buffers
+            uint32_t width;
+            uint32_t height;
+            DXGI_FORMAT format;
+        };
+
+        struct Staging {
+            ID3D11Resource* GetResource() const {
+                return texture.Get() != nullptr ? static_cast<ID3D11Resource*>(texture.Get()) : buffer.Get();
+            }
+
+            // One of them is set, depending on the shape
+            ComPtr<ID3D11Texture2D> texture;
+            ComPtr<ID3D11Buffer> buffer;
+            bool busy = false;
+        };
+
+        struct Pool {
+            Shape shape;
+            std::vector<Staging> staging;
+            uint64_t lastUsedFrame;
+        };
+
+        struct Request {
+            Staging* staging;
+            // Shape of the data read: a buffer may be smaller than its staging buffer
+            Shape shape;
+            ReadbackCallback callback;
+        };
+
+        // Staging vectors never reallocate and pools are only erased when idle,
+        // so staging pointers stay valid while requests are in flight
+        Staging* AcquireStaging(const Shape& shape) {
+            auto pool = std::find_if(m_pools.begin(), m_pools.end(), [&](const Pool& candidate) {
+                return candidate.shape == shape;
+            });
+            if (pool == m_pools.end()) {
+                m_pools.push_back(Pool{ shape, {}, 0 });
+                m_pools.back().staging.reserve(m_stagingPerShape);
+                pool = std::prev(m_pools.end());
+            }
+            pool->lastUsedFrame = m_tracker.GetFrame();
+
+            for (auto& staging : pool->staging) {
+                if (!staging.busy) {
+                    return &staging;
+                }
+            }
+            if (pool->staging.size() < m_stagingPerShape) {
+                pool->staging.push_back(CreateStaging(shape));
+                return &pool->staging.back();
+            }
+
+            m_tracker.Reject();
+            return nullptr;
+        }
+
+        Staging CreateStaging(const Shape& shape) {
+            Staging result;
+            if (shape.isTexture) {
+                D3D11_TEXTURE2D_DESC desc{};
+                desc.Width = shape.width;
+                desc.Height = shape.height;
+                desc.MipLevels = 1;
+                desc.ArraySize = 1;
+                desc.Format = shape.format;
+                desc.SampleDesc.Count = 1;
+                desc.Usage = D3D11_USAGE_STAGING;
+                desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+                WinAPI<char>::ThrowIfError(m_device->CreateTexture2D(&desc, nullptr, result.texture.Receive()));
+            } else {
+                D3D11_BUFFER_DESC desc{};
+                desc.ByteWidth = shape.width;
+                desc.Usage = D3D11_USAGE_STAGING;
+                desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+                WinAPI<char>::ThrowIfError(m_device->CreateBuffer(&desc, nullptr, result.buffer.Receive()));
+            }
+            return result;
+        }
+
+        // Erasing from the list leaves the other pools in place
+        void EvictIdlePools() {
+            auto frame = m_tracker.GetFrame();
+            m_pools.remove_if([&](const Pool& pool) {
+                return frame - pool.lastUsedFrame > m_evictAfterFrames &&
+                    std::none_of(pool.staging.begin(), pool.staging.end(), [](const Staging& staging) { return staging.busy; });
+            });
+        }
+
+        void Enqueue(Staging& staging, const Shape& shape, ReadbackCallback callback) {
+            staging.busy = true;
+            m_tracker.Submit();
+            m_requests.push_back(Request{ &staging, shape, std::move(callback) });
+        }
+
+        // Requests complete in the order of m_requests, which is the order of the tracker. A throwing callback
+        // still completes its request, the first exception is kept for the caller to rethrow after polling
+        bool TryDeliver(unsigned mapFlags, std::exception_ptr& callbackError) {
+            auto& request = m_requests.front();
+            auto resource = request.staging->GetResource();
+            D3D11_MAPPED_SUBRESOURCE mapped{};
+            auto hr = m_context->Map(resource, 0, D3D11_MAP_READ, mapFlags, &mapped);
+            if (hr == DXGI_ERROR_WAS_STILL_DRAWING) {
+                return false;
+            }
+            WinAPI<char>::ThrowIfError(hr);
+
+            ReadbackData data{};
+            data.data = mapped.pData;
+            data.width = request.shape.width;
+            data.height = request.shape.height;
+            data.rowPitch = request.shape.isTexture ? mapped.RowPitch : request.shape.width;
+            // Rows of 4x4 blocks for block compressed formats
+            data.size = size_t(data.rowPitch) * ComputeRowsCount(request.shape.format, data.height);
+            data.submitFrame = m_tracker.GetCompletingSubmitFrame();
+            data.latencyFrames = m_tracker.GetCompletingLatency();
+
+            // The callback may issue new reads: the staging resource stays busy until it is unmapped
+            auto staging = request.staging;
+            auto callback = std::move(request.callback);
+            m_requests.pop_front();
+            try {
+                if (callback) {
+                    callback(data);
+                }
+            } catch (...) {
+                if (!callbackError) {
+                    callbackError = std::current_exception();
+                }
+            }
+            m_context->Unmap(resource, 0);
+            staging->busy = false;
+            return true;
+        }
+
+    private:
+        ComPtr<ID3D11Device> m_device;
+        ComPtr<ID3D11DeviceContext> m_context;
+        uint32_t m_stagingPerShape;
+        uint32_t m_evictAfterFrames;
+        ReadbackTracker m_tracker;
+        std::list<Pool> m_pools;
+        std::deque<Request> m_requests;
+    };
+}
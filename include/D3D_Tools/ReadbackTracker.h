@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+
+namespace d3d_tools {
+    struct ReadbackStatistics {
+        uint64_t submittedCount = 0;
+        uint64_t completedCount = 0;
+        // Completed by Drain before the GPU was known to be done, possibly with a stall
+        uint64_t drainedCount = 0;
+        // Requests refused because every staging resource of their shape was in flight
+        uint64_t rejectedCount = 0;
+        uint32_t minLatencyFrames = std::numeric_limits<uint32_t>::max();
+        uint32_t maxLatencyFrames = 0;
+        uint64_t totalLatencyFrames = 0;
+
+        double GetAverageLatencyFrames() const {
+            return completedCount == 0 ? 0.0 : double(totalLatencyFrames) / double(completedCount);
+        }
+    };
+
+    // Staging buffer size for a buffer readback of the given size: powers of two up to 64KB, multiples of 64KB above.
+    // Reads of slightly different sizes then share staging buffers instead of creating a set each
+    inline uint32_t ComputeReadbackStagingSize(uint32_t size) {
+        constexpr uint64_t Granularity = 64 * 1024;
+        if (size > Granularity) {
+            auto aligned = (uint64_t(size) + Granularity - 1) / Granularity * Granularity;
+            return static_cast<uint32_t>(std::min<uint64_t>(aligned, std::numeric_limits<uint32_t>::max()));
+        }
+        uint32_t result = 16;
+        while (result < size) {
+            result *= 2;
+        }
+        return result;
+    }
+
+    // Frame bookkeeping of GPU to CPU copies. Knows nothing about GPU: the owner submits requests
+    // in the order it records the copies, advances the frame once per frame and polls.
+    // A request is not polled until latencyFrames frames have passed since its submission,
+    // so the owner does not touch resources the GPU can not have finished with.
+    // The GPU completes copies in submission order, so polling stops at the first unfinished request
+    class ReadbackTracker {
+    public:
+        ReadbackTracker(uint32_t latencyFrames = 2) :
+            m_latencyFrames(latencyFrames)
+        {
+        }
+
+        // Returns the request id. Ids increase by one starting from zero
+        uint64_t Submit() {
+            m_pending.push_back(PendingRequest{ m_nextId, m_frame });
+            ++m_statistics.submittedCount;
+            return m_nextId++;
+        }
+
+        void Reject() {
+            ++m_statistics.rejectedCount;
+        }
+
+        void AdvanceFrame() {
+            ++m_frame;
+        }
+
+        // Calls tryComplete(id) for due requests, oldest first, until it returns false.
+        // Returns the number of completed requests
+        template<typename TryComplete>
+        size_t Poll(TryComplete&& tryComplete) {
+            size_t completed = 0;
+            while (!m_pending.empty() && GetAge(m_pending.front()) >= m_latencyFrames) {
+                if (!tryComplete(m_pending.front().id)) {
+                    break;
+                }
+                Complete(false);
+                ++completed;
+            }
+            return completed;
+        }
+
+        // Calls deliver(id) for every pending request regardless of its age. For shutdown and captures that must finish now
+        template<typename Deliver>
+        size_t Drain(Deliver&& deliver) {
+            size_t completed = 0;
+            while (!m_pending.empty()) {
+                deliver(m_pending.front().id);
+                Complete(true);
+                ++completed;
+            }
+            return completed;
+        }
+
+        uint64_t GetFrame() const {
+            return m_frame;
+        }
+
+        uint32_t GetLatencyFrames() const {
+            return m_latencyFrames;
+        }
+
+        size_t GetPendingCount() const {
+            return m_pending.size();
+        }
+
+        // Frames since the submission of the oldest pending request, 0 when nothing is pending
+        uint32_t GetOldestPendingAge() const {
+            return m_pending.empty() ? 0 : GetAge(m_pending.front());
+        }
+
+        // Frames since submission of the request being completed. Valid inside Poll and Drain callbacks
+        uint32_t GetCompletingLatency() const {
+            if (m_pending.empty()) {
+                throw std::logic_error("No readback request is being completed");
+            }
+            return GetAge(m_pending.front());
+        }
+
+        uint64_t GetCompletingSubmitFrame() const {
+            if (m_pending.empty()) {
+                throw std::logic_error("No readback request is being completed");
+            }
+            return m_pending.front().frame;
+        }
+
+        const ReadbackStatistics& GetStatistics() const {
+            return m_statistics;
+        }
+
+    private:
+        struct PendingRequest {
+            uint64_t id;
+            uint64_t frame;
+        };
+
+        uint32_t GetAge(const PendingRequest& request) const {
+            return static_cast<uint32_t>(m_frame - request.frame);
+        }
+
+        void Complete(bool drained) {
+            auto latency = GetAge(m_pending.front());
+            m_pending.pop_front();
+            ++m_statistics.completedCount;
+            if (drained) {
+                ++m_statistics.drainedCount;
+            }
+            m_statistics.minLatencyFrames = std::min(m_statistics.minLatencyFrames, latency);
+            m_statistics.maxLatencyFrames = std::max(m_statistics.maxLatencyFrames, latency);
+            m_statistics.totalLatencyFrames += latency;
+        }
+
+    private:
+        uint32_t m_latencyFrames;
+        uint64_t m_frame = 0;
+        uint64_t m_nextId = 0;
+        std::deque<PendingRequest> m_pending;
+        ReadbackStatistics m_statistics;
+    };
+}
@@ -0,0 +1,600 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "TextureFormat.h"
+
+namespace d3d_tools {
+    struct RenderGraphTexture {
+        static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+        bool IsValid() const {
+            return index != InvalidIndex;
+        }
+
+        bool operator==(const RenderGraphTexture& other) const {
+            return index == other.index;
+        }
+
+        uint32_t index = InvalidIndex;
+    };
+
+    struct RenderGraphTextureDesc {
+        bool operator==(const RenderGraphTextureDesc& other) const {
+            return
+                width == other.width &&
+                height == other.height &&
+                mipLevels == other.mipLevels &&
+                arraySize == other.arraySize &&
+                format == other.format;
+        }
+
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipLevels = 1;
+        uint32_t arraySize = 1;
+        TextureFormat format = TextureFormat::R8_G8_B8_A8_UNORM;
+    };
+
+    // Bit mask of the ways a texture is used during the frame
+    enum RenderGraphTextureUsage : uint32_t {
+        RenderGraphUsageNone = 0,
+        RenderGraphUsageRenderTarget = (1 << 0),
+        RenderGraphUsageDepthStencil = (1 << 1),
+        RenderGraphUsageShaderResource = (1 << 2)
+    };
+
+    struct RenderGraphClear {
+        bool enabled = false;
+        std::array<float, 4> color{};
+        float depth = 1.0f;
+        uint8_t stencil = 0;
+    };
+
+    struct RenderGraphAttachment {
+        uint32_t physicalTexture;
+        RenderGraphClear clear;
+    };
+
+    // What the backend has to bind before the pass callback is executed
+    struct RenderGraphPassBindings {
+        std::string name;
+        std::vector<RenderGraphAttachment> renderTargets;
+        bool hasDepthStencil = false;
+        RenderGraphAttachment depthStencil{};
+        // In the order of Read calls: the backend binds them to consecutive slots starting at 0
+        std::vector<uint32_t> shaderResources;
+    };
+
+    // Physical texture after aliasing. Imported textures are never shared
+    struct RenderGraphPhysicalTexture {
+        RenderGraphTextureDesc desc;
+        uint32_t usage = RenderGraphUsageNone;
+        RenderGraphTexture imported;
+        uint32_t firstPass = 0;
+        uint32_t lastPass = 0;
+    };
+
+    class RenderGraphPassContext;
+
+    // Translates compiled graph into API calls. Passes are numbered in execution order
+    class IRenderGraphBackend {
+    public:
+        virtual ~IRenderGraphBackend() = default;
+        // Called before the first pass that uses the texture
+        virtual void AcquireTexture(uint32_t physicalIndex, const RenderGraphPhysicalTexture& texture) = 0;
+        // Called after the last pass that uses the texture
+        virtual void ReleaseTexture(uint32_t physicalIndex) = 0;
+        virtual void BeginPass(const RenderGraphPassBindings& bindings) = 0;
+        virtual void EndPass(const RenderGraphPassBindings& bindings) = 0;
+    };
+
+    class RenderGraph;
+
+    // Passed to the setup callback of a pass to declare its resources
+    class RenderGraphBuilder {
+    public:
+        RenderGraphTexture CreateTexture(const RenderGraphTextureDesc& desc, std::string name);
+        // Bound to the shader resource slot equal to the number of earlier Read calls of the pass
+        void Read(RenderGraphTexture texture);
+        // Without clear previous content is kept, which makes the pass depend on the previous writer
+        void WriteRenderTarget(RenderGraphTexture texture, RenderGraphClear clear = RenderGraphClear());
+        void WriteDepthStencil(RenderGraphTexture texture, RenderGraphClear clear = RenderGraphClear());
+        // The pass is never culled (i.e. it writes buffers or queries the graph does not know about)
+        void SetSideEffect();
+
+    private:
+        friend class RenderGraph;
+
+        RenderGraphBuilder(RenderGraph& graph, uint32_t passIndex) :
+            m_graph(graph),
+            m_passIndex(passIndex)
+        {
+        }
+
+        RenderGraph& m_graph;
+        uint32_t m_passIndex;
+    };
+
+    // Handed to the execute callback of a pass
+    class RenderGraphPassContext {
+    public:
+        RenderGraphPassContext(const RenderGraph& graph, IRenderGraphBackend& backend) :
+            m_graph(graph),
+            m_backend(backend)
+        {
+        }
+
+        uint32_t GetPhysicalTexture(RenderGraphTexture texture) const;
+
+        IRenderGraphBackend& GetBackend() const {
+            return m_backend;
+        }
+
+    private:
+        const RenderGraph& m_graph;
+        IRenderGraphBackend& m_backend;
+    };
+
+    // Frame graph: passes are declared in submission order with their texture reads and writes.
+    // Compile culls passes whose results are not used, computes texture lifetimes and lets transient textures
+    // with equal descriptions and disjoint lifetimes share one physical texture.
+    // D3D11 can not place resources into shared heaps, so sharing a texture object is the closest form of aliasing
+    class RenderGraph {
+    public:
+        using SetupFunction = std::function<void(RenderGraphBuilder&)>;
+        using ExecuteFunction = std::function<void(RenderGraphPassContext&)>;
+
+        static constexpr uint32_t MaxRenderTargets = 8;
+        static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+        // External texture (i.e. back buffer). Writes to imported textures are the outputs of the graph
+        RenderGraphTexture ImportTexture(const RenderGraphTextureDesc& desc, std::string name) {
+            auto result = AddTexture(desc, std::move(name));
+            m_textures[result.index].imported = true;
+            return result;
+        }
+
+        uint32_t AddPass(std::string name, const SetupFunction& setup, ExecuteFunction execute) {
+            auto index = static_cast<uint32_t>(m_passes.size());
+            Pass pass;
+            pass.name = std::move(name);
+            pass.execute = std::move(execute);
+            m_passes.push_back(std::move(pass));
+
+            RenderGraphBuilder builder(*this, index);
+            setup(builder);
+            m_compiled = false;
+            return index;
+        }
+
+        void Compile() {
+            CullPasses();
+            ComputeLifetimes();
+            AssignPhysicalTextures();
+            m_compiled = true;
+        }
+
+        void Execute(IRenderGraphBackend& backend) {
+            if (!m_compiled) {
+                Compile();
+            }
+
+            RenderGraphPassContext context(*this, backend);
+            for (uint32_t order = 0; order < m_order.size(); ++order) {
+                auto& pass = m_passes[m_order[order]];
+                for (auto physical : pass.acquires) {
+                    backend.AcquireTexture(physical, m_physicalTextures[physical]);
+                }
+
+                backend.BeginPass(pass.bindings);
+                if (pass.execute) {
+                    pass.execute(context);
+                }
+                backend.EndPass(pass.bindings);
+
+                for (auto physical : pass.releases) {
+                    backend.ReleaseTexture(physical);
+                }
+            }
+        }
+
+        // Drops all passes and textures, keeps allocated memory
+        void Reset() {
+            m_passes.clear();
+            m_textures.clear();
+            m_order.clear();
+            m_physicalTextures.clear();
+            m_compiled = false;
+        }
+
+        bool IsPassCulled(uint32_t passIndex) const {
+            return !m_passes[passIndex].alive;
+        }
+
+        // Indices of passes that survived culling in execution order
+        const std::vector<uint32_t>& GetExecutionOrder() const {
+            return m_order;
+        }
+
+        uint32_t GetPhysicalTexture(RenderGraphTexture texture) const {
+            return m_textures.at(texture.index).physical;
+        }
+
+        // Positions in execution order. InvalidIndex if no alive pass uses the texture
+        std::pair<uint32_t, uint32_t> GetTextureLifetime(RenderGraphTexture texture) const {
+            auto& info = m_textures.at(texture.index);
+            return { info.firstPass, info.lastPass };
+        }
+
+        const std::vector<RenderGraphPhysicalTexture>& GetPhysicalTextures() const {
+            return m_physicalTextures;
+        }
+
+        size_t GetPassesCount() const {
+            return m_passes.size();
+        }
+
+        size_t GetTexturesCount() const {
+            return m_textures.size();
+        }
+
+        const std::string& GetTextureName(RenderGraphTexture texture) const {
+            return m_textures.at(texture.index).name;
+        }
+
+    private:
+        friend class RenderGraphBuilder;
+
+        enum class AccessType {
+            Read,
+            RenderTarget,
+            DepthStencil
+        };
+
+        struct Access {
+            uint32_t texture;
+            AccessType type;
+            RenderGraphClear clear;
+        };
+
+        struct Pass {
+            std::string name;
+            ExecuteFunction execute;
+            std::vector<Access> accesses;
+            bool sideEffect = false;
+            bool alive = false;
+            RenderGraphPassBindings bindings;
+            std::vector<uint32_t> acquires;
+            std::vector<uint32_t> releases;
+        };
+
+        struct TextureInfo {
+            std::string name;
+            RenderGraphTextureDesc desc;
+            bool imported = false;
+            uint32_t usage = RenderGraphUsageNone;
+            uint32_t firstPass = InvalidIndex;
+            uint32_t lastPass = InvalidIndex;
+            uint32_t physical = InvalidIndex;
+        };
+
+        RenderGraphTexture AddTexture(const RenderGraphTextureDesc& desc, std::string name) {
+            if (desc.width == 0 || desc.height == 0 || desc.arraySize == 0) {
+                throw std::invalid_argument("Render graph texture must not be empty: " + name);
+            }
+
+            TextureInfo info;
+            info.name = std::move(name);
+            info.desc = desc;
+            m_textures.push_back(std::move(info));
+            m_compiled = false;
+
+            RenderGraphTexture result;
+            result.index = static_cast<uint32_t>(m_textures.size() - 1);
+            return result;
+        }
+
+        void AddAccess(uint32_t passIndex, RenderGraphTexture texture, AccessType type, const RenderGraphClear& clear) {
+            if (texture.index >= m_textures.size()) {
+                throw std::invalid_argument("Unknown render graph texture");
+            }
+
+            auto& pass = m_passes[passIndex];
+            for (auto& access : pass.accesses) {
+                if (access.texture == texture.index) {
+                    throw std::invalid_argument("Texture '" + m_textures[texture.index].name +
+                        "' is accessed twice by pass '" + pass.name + "'");
+                }
+            }
+
+            if (type == AccessType::RenderTarget) {
+                auto count = std::count_if(pass.accesses.begin(), pass.accesses.end(),
+                    [](const Access& access) { return access.type == AccessType::RenderTarget; });
+                if (count >= MaxRenderTargets) {
+                    throw std::invalid_argument("Too many render targets in pass '" + pass.name + "'");
+                }
+            }
+
+            if (type == AccessType::DepthStencil) {
+                auto it = std::find_if(pass.accesses.begin(), pass.accesses.end(),
+                    [](const Access& access) { return access.type == AccessType::DepthStencil; });
+                if (it != pass.accesses.end()) {
+                    throw std::invalid_argument("Pass '" + pass.name + "' has more than one depth stencil");
+                }
+            }
+
+            pass.accesses.push_back(Access{ texture.index, type, clear });
+        }
+
+        static bool IsWrite(const Access& access) {
+            return access.type != AccessType::Read;
+        }
+
+        // Walks passes backwards keeping track of textures whose current content is still needed
+        void CullPasses() {
+            std::vector<bool> needed(m_textures.size(), false);
+            for (auto passIndex = m_passes.size(); passIndex-- > 0;) {
+                auto& pass = m_passes[passIndex];
+                pass.alive = pass.sideEffect;
+                for (auto& access : pass.accesses) {
+                    if (IsWrite(access) && (needed[access.texture] || m_textures[access.texture].imported)) {
+                        pass.alive = true;
+                    }
+                }
+
+                if (!pass.alive) {
+                    continue;
+                }
+
+                for (auto& access : pass.accesses) {
+                    if (IsWrite(access)) {
+                        // A cleared texture does not depend on earlier writers
+                        needed[access.texture] = !access.clear.enabled;
+                    }
+                }
+
+                for (auto& access : pass.accesses) {
+                    if (!IsWrite(access)) {
+                        needed[access.texture] = true;
+                    }
+                }
+            }
+
+            m_order.clear();
+            for (uint32_t passIndex = 0; passIndex < m_passes.size(); ++passIndex) {
+                if (m_passes[passIndex].alive) {
+                    m_order.push_back(passIndex);
+                }
+            }
+        }
+
+        void ComputeLifetimes() {
+            for (auto& texture : m_textures) {
+                texture.usage = RenderGraphUsageNone;
+                texture.firstPass = InvalidIndex;
+                texture.lastPass = InvalidIndex;
+                texture.physical = InvalidIndex;
+            }
+
+            std::vector<bool> written(m_textures.size(), false);
+            for (uint32_t order = 0; order < m_order.size(); ++order) {
+                auto& pass = m_passes[m_order[order]];
+                for (auto& access : pass.accesses) {
+                    auto& texture = m_textures[access.texture];
+                    if (!IsWrite(access) && !written[access.texture] && !texture.imported) {
+                        throw std::logic_error("Pass '" + pass.name + "' reads texture '" + texture.name + "' before it is written");
+                    }
+
+                    if (IsWrite(access)) {
+                        written[access.texture] = true;
+                    }
+
+                    switch (access.type) {
+                    case AccessType::Read: texture.usage |= RenderGraphUsageShaderResource; break;
+                    case AccessType::RenderTarget: texture.usage |= RenderGraphUsageRenderTarget; break;
+                    case AccessType::DepthStencil: texture.usage |= RenderGraphUsageDepthStencil; break;
+                    }
+
+                    if (texture.firstPass == InvalidIndex) {
+                        texture.firstPass = order;
+                    }
+                    texture.lastPass = order;
+                }
+            }
+        }
+
+        // Greedy interval assignment in order of first use: optimal for every class of equal descriptions
+        void AssignPhysicalTextures() {
+            m_physicalTextures.clear();
+
+            std::vector<uint32_t> transient;
+            for (uint32_t index = 0; index < m_textures.size(); ++index) {
+                auto& texture = m_textures[index];
+                if (texture.firstPass == InvalidIndex) {
+                    continue;
+                }
+
+                if (texture.imported) {
+                    RenderGraphPhysicalTexture physical;
+                    physical.desc = texture.desc;
+                    physical.usage = texture.usage;
+                    physical.imported.index = index;
+                    physical.firstPass = texture.firstPass;
+                    physical.lastPass = texture.lastPass;
+                    texture.physical = static_cast<uint32_t>(m_physicalTextures.size());
+                    m_physicalTextures.push_back(physical);
+                } else {
+                    transient.push_back(index);
+                }
+            }
+
+            std::stable_sort(transient.begin(), transient.end(), [&](uint32_t a, uint32_t b) {
+                return m_textures[a].firstPass < m_textures[b].firstPass;
+            });
+
+            for (auto index : transient) {
+                auto& texture = m_textures[index];
+                auto best = InvalidIndex;
+                for (uint32_t candidate = 0; candidate < m_physicalTextures.size(); ++candidate) {
+                    auto& physical = m_physicalTextures[candidate];
+                    if (physical.imported.IsValid() || !(physical.desc == texture.desc) || physical.lastPass >= texture.firstPass) {
+                        continue;
+                    }
+
+                    // Prefer the texture that has been free for the shortest time
+                    if (best == InvalidIndex || physical.lastPass > m_physicalTextures[best].lastPass) {
+                        best = candidate;
+                    }
+                }
+
+                if (best == InvalidIndex) {
+                    RenderGraphPhysicalTexture physical;
+                    physical.desc = texture.desc;
+                    physical.firstPass = texture.firstPass;
+                    best = static_cast<uint32_t>(m_physicalTextures.size());
+                    m_physicalTextures.push_back(physical);
+                }
+
+                auto& physical = m_physicalTextures[best];
+                physical.usage |= texture.usage;
+                physical.lastPass = texture.lastPass;
+                texture.physical = best;
+            }
+
+            BuildPassBindings();
+        }
+
+        void BuildPassBindings() {
+            for (auto& pass : m_passes) {
+                pass.bindings = RenderGraphPassBindings();
+                pass.bindings.name = pass.name;
+                pass.acquires.clear();
+                pass.releases.clear();
+            }
+
+            for (auto& pass : m_passes) {
+                if (!pass.alive) {
+                    continue;
+                }
+
+                for (auto& access : pass.accesses) {
+                    auto physical = m_textures[access.texture].physical;
+                    switch (access.type) {
+                    case AccessType::Read:
+                        pass.bindings.shaderResources.push_back(physical);
+                        break;
+                    case AccessType::RenderTarget:
+                        pass.bindings.renderTargets.push_back(RenderGraphAttachment{ physical, access.clear });
+                        break;
+                    case AccessType::DepthStencil:
+                        pass.bindings.hasDepthStencil = true;
+                        pass.bindings.depthStencil = RenderGraphAttachment{ physical, access.clear };
+                        break;
+                    }
+                }
+            }
+
+            for (uint32_t physical = 0; physical < m_physicalTextures.size(); ++physical) {
+                auto& texture = m_physicalTextures[physical];
+                m_passes[m_order[texture.firstPass]].acquires.push_back(physical);
+                m_passes[m_order[texture.lastPass]].releases.push_back(physical);
+            }
+        }
+
+    private:
+        std::vector<Pass> m_passes;
+        std::vector<TextureInfo> m_textures;
+        std::vector<uint32_t> m_order;
+        std::vector<RenderGraphPhysicalTexture> m_physicalTextures;
+        bool m_compiled = false;
+    };
+
+    // Backend that only remembers what it was asked to do. Useful to inspect or dump a compiled frame
+    class RenderGraphRecorder : public IRenderGraphBackend {
+    public:
+        enum class CommandType {
+            AcquireTexture,
+            ReleaseTexture,
+            BeginPass,
+            EndPass
+        };
+
+        struct Command {
+            CommandType type;
+            uint32_t physicalTexture = RenderGraph::InvalidIndex;
+            std::string passName;
+            RenderGraphPassBindings bindings;
+        };
+
+        virtual void AcquireTexture(uint32_t physicalIndex, const RenderGraphPhysicalTexture&) override {
+            Command command;
+            command.type = CommandType::AcquireTexture;
+            command.physicalTexture = physicalIndex;
+            m_commands.push_back(std::move(command));
+        }
+
+        virtual void ReleaseTexture(uint32_t physicalIndex) override {
+            Command command;
+            command.type = CommandType::ReleaseTexture;
+            command.physicalTexture = physicalIndex;
+            m_commands.push_back(std::move(command));
+        }
+
+        virtual void BeginPass(const RenderGraphPassBindings& bindings) override {
+            Command command;
+            command.type = CommandType::BeginPass;
+            command.passName = bindings.name;
+            command.bindings = bindings;
+            m_commands.push_back(std::move(command));
+        }
+
+        virtual void EndPass(const RenderGraphPassBindings& bindings) override {
+            Command command;
+            command.type = CommandType::EndPass;
+            command.passName = bindings.name;
+            m_commands.push_back(std::move(command));
+        }
+
+        const std::vector<Command>& GetCommands() const {
+            return m_commands;
+        }
+
+        void Clear() {
+            m_commands.clear();
+        }
+
+    private:
+        std::vector<Command> m_commands;
+    };
+
+    inline RenderGraphTexture RenderGraphBuilder::CreateTexture(const RenderGraphTextureDesc& desc, std::string name) {
+        return m_graph.AddTexture(desc, std::move(name));
+    }
+
+    inline void RenderGraphBuilder::Read(RenderGraphTexture texture) {
+        m_graph.AddAccess(m_passIndex, texture, RenderGraph::AccessType::Read, RenderGraphClear());
+    }
+
+    inline void RenderGraphBuilder::WriteRenderTarget(RenderGraphTexture texture, RenderGraphClear clear) {
+        m_graph.AddAccess(m_passIndex, texture, RenderGraph::AccessType::RenderTarget, clear);
+    }
+
+    inline void RenderGraphBuilder::WriteDepthStencil(RenderGraphTexture texture, RenderGraphClear clear) {
+        m_graph.AddAccess(m_passIndex, texture, RenderGraph::AccessType::DepthStencil, clear);
+    }
+
+    inline void RenderGraphBuilder::SetSideEffect() {
+        m_graph.m_passes[m_passIndex].sideEffect = true;
+    }
+
+    inline uint32_t RenderGraphPassContext::GetPhysicalTexture(RenderGraphTexture texture) const {
+        return m_graph.GetPhysicalTexture(texture);
+    }
+}
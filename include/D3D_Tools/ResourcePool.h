@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace d3d_tools {
+    struct ResourcePoolSettings {
+        // Frames a returned resource waits before it may be handed out again
+        uint32_t reuseDelayFrames = 0;
+        // Free resources unused for this many frames are destroyed
+        uint32_t evictAfterFrames = 3;
+    };
+
+    struct ResourcePoolStatistics {
+        uint64_t acquiresCount = 0;
+        uint64_t hitsCount = 0;
+        uint64_t createdCount = 0;
+        uint64_t evictedCount = 0;
+        size_t currentBytes = 0;
+        size_t peakBytes = 0;
+
+        double GetHitRate() const {
+            return acquiresCount == 0 ? 0.0 : static_cast<double>(hitsCount) / acquiresCount;
+        }
+    };
+
+    // Reuses resources with identical descriptions. Factory provides:
+    //   Description, Resource, DescriptionHash and DescriptionEqual types,
+    //   Resource Create(const Description&) and size_t ComputeSize(const Description&).
+    // Not thread safe: meant to be used from the render thread
+    template<typename Factory>
+    class ResourcePool {
+    public:
+        using Description = typename Factory::Description;
+        using Resource = typename Factory::Resource;
+
+        // Owns a resource until destruction, then gives it back to the pool. The pool must outlive its leases
+        class Lease {
+        public:
+            Lease() = default;
+
+            Lease(Lease&& other) noexcept {
+                *this = std::move(other);
+            }
+
+            Lease& operator=(Lease&& other) noexcept {
+                if (this != &other) {
+                    Release();
+                    m_pool = other.m_pool;
+                    m_description = std::move(other.m_description);
+                    m_resource = std::move(other.m_resource);
+                    other.m_pool = nullptr;
+                }
+                return *this;
+            }
+
+            ~Lease() {
+                Release();
+            }
+
+            bool IsValid() const {
+                return m_pool != nullptr;
+            }
+
+            const Resource& Get() const {
+                return m_resource;
+            }
+
+            const Description& GetDescription() const {
+                return m_description;
+            }
+
+            void Release() {
+                if (m_pool) {
+                    m_pool->Return(m_description, std::move(m_resource));
+                    m_pool = nullptr;
+                }
+            }
+
+        private:
+            friend class ResourcePool;
+
+            ResourcePool* m_pool = nullptr;
+            Description m_description{};
+            Resource m_resource{};
+        };
+
+        ResourcePool(Factory factory, ResourcePoolSettings settings = ResourcePoolSettings()) :
+            m_factory(std::move(factory)),
+            m_settings(settings)
+        {
+        }
+
+        ResourcePool(const ResourcePool&) = delete;
+        ResourcePool& operator=(const ResourcePool&) = delete;
+
+        Lease Acquire(const Description& description) {
+            ++m_statistics.acquiresCount;
+
+            // The pool is attached last: a lease that returns to the pool must hold a counted resource
+            Lease lease;
+            lease.m_description = description;
+
+            auto it = m_free.find(description);
+            if (it != m_free.end() && !it->second.empty() &&
+                it->second.front().releasedFrame + m_settings.reuseDelayFrames <= m_frame) {
+                auto& bucket = it->second;
+                lease.m_resource = std::move(bucket.front().resource);
+                bucket.pop_front();
+                ++m_statistics.hitsCount;
+                lease.m_pool = this;
+                return lease;
+            }
+
+            auto size = m_factory.ComputeSize(description);
+            lease.m_resource = m_factory.Create(description);
+            ++m_statistics.createdCount;
+            m_statistics.currentBytes += size;
+            m_statistics.peakBytes = std::max(m_statistics.peakBytes, m_statistics.currentBytes);
+            lease.m_pool = this;
+            return lease;
+        }
+
+        // Advances frame counter and destroys resources that stayed unused for too long
+        void EndFrame() {
+            ++m_frame;
+            for (auto it = m_free.begin(); it != m_free.end();) {
+                auto& bucket = it->second;
+                // Buckets are ordered by release frame
+                while (!bucket.empty() && bucket.front().releasedFrame + m_settings.evictAfterFrames < m_frame) {
+                    Destroy(it->first);
+                    bucket.pop_front();
+                }
+
+                if (bucket.empty()) {
+                    it = m_free.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        // Destroys all free resources. Leased ones are not affected
+        void Trim() {
+            for (auto& bucket : m_free) {
+                for (size_t i = 0; i < bucket.second.size(); ++i) {
+                    Destroy(bucket.first);
+                }
+            }
+            m_free.clear();
+        }
+
+        size_t GetFreeCount() const {
+            size_t result = 0;
+            for (auto& bucket : m_free) {
+                result += bucket.second.size();
+            }
+            return result;
+        }
+
+        uint64_t GetFrame() const {
+            return m_frame;
+        }
+
+        const ResourcePoolStatistics& GetStatistics() const {
+            return m_statistics;
+        }
+
+        void SetSettings(ResourcePoolSettings settings) {
+            m_settings = settings;
+        }
+
+        Factory& GetFactory() {
+            return m_factory;
+        }
+
+    private:
+        struct FreeResource {
+            Resource resource;
+            uint64_t releasedFrame;
+        };
+
+        void Return(const Description& description, Resource&& resource) {
+            m_free[description].push_back(FreeResource{ std::move(resource), m_frame });
+        }
+
+        void Destroy(const Description& description) {
+            m_statistics.currentBytes -= m_factory.ComputeSize(description);
+            ++m_statistics.evictedCount;
+        }
+
+    private:
+        using FreeMap = std::unordered_map<
+            Description,
+            std::deque<FreeResource>,
+            typename Factory::DescriptionHash,
+            typename Factory::DescriptionEqual>;
+
+        Factory m_factory;
+        ResourcePoolSettings m_settings;
+        ResourcePoolStatistics m_statistics;
+        FreeMap m_free;
+        uint64_t m_frame = 0;
+    };
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+
+namespace d3d_tools {
+    struct RingAllocation {
+        bool IsValid() const {
+            return valid;
+        }
+
+        size_t offset = 0;
+        // Allocation has been placed at the beginning of the ring.
+        // Previous content of the buffer must be discarded before writing
+        bool wrapped = false;
+        bool valid = false;
+    };
+
+    // Linear allocator over a ring of bytes. Knows nothing about GPU:
+    // the owner reports finished frames with increasing fence values and
+    // then tells which fence has been completed to release the memory
+    class RingAllocator {
+    public:
+        RingAllocator(size_t capacity) :
+            m_capacity(capacity)
+        {
+            if (capacity == 0) {
+                throw std::invalid_argument("Ring allocator capacity must not be zero");
+            }
+        }
+
+        // Alignment must be a power of two
+        RingAllocation Allocate(size_t size, size_t alignment = 1) {
+            if (size > m_capacity) {
+                throw std::invalid_argument("Requested allocation does not fit into the ring");
+            }
+
+            if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+                throw std::invalid_argument("Alignment must be a power of two");
+            }
+
+            RingAllocation result;
+            if (m_used == 0) {
+                // Nothing is in flight: continue from the current position without wrapping
+                m_tail = m_head;
+            }
+
+            auto aligned = AlignUp(m_head, alignment);
+            if (m_head >= m_tail && m_used < m_capacity) {
+                if (aligned + size <= m_capacity) {
+                    Commit(result, aligned, size, aligned + size - m_head);
+                } else if (size <= m_tail || m_used == 0) {
+                    Commit(result, 0, size, m_capacity - m_head + size);
+                    result.wrapped = true;
+                }
+            } else if (aligned + size <= m_tail) {
+                Commit(result, aligned, size, aligned + size - m_head);
+            }
+
+            return result;
+        }
+
+        // Marks all allocations since previous call as belonging to the frame with this fence value
+        void FinishFrame(uint64_t fence) {
+            FrameInfo frame;
+            frame.fence = fence;
+            frame.endOffset = m_head;
+            frame.size = m_currentFrameSize;
+            m_frames.push_back(frame);
+            m_currentFrameSize = 0;
+        }
+
+        // Releases memory of all frames with fence less than or equal to completedFence
+        void Retire(uint64_t completedFence) {
+            while (!m_frames.empty() && m_frames.front().fence <= completedFence) {
+                auto& frame = m_frames.front();
+                m_tail = frame.endOffset;
+                m_used -= frame.size;
+                m_frames.pop_front();
+            }
+        }
+
+        // Forget about all allocations. Use it only if the memory has been renamed/discarded
+        void Reset() {
+            m_frames.clear();
+            m_head = 0;
+            m_tail = 0;
+            m_used = 0;
+            m_currentFrameSize = 0;
+        }
+
+        size_t GetCapacity() const {
+            return m_capacity;
+        }
+
+        size_t GetUsedSize() const {
+            return m_used;
+        }
+
+        size_t GetFramesInFlight() const {
+            return m_frames.size();
+        }
+
+        static size_t AlignUp(size_t value, size_t alignment) {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+    private:
+        // consumed includes alignment padding and the unused tail of the ring on wrap
+        void Commit(RingAllocation& allocation, size_t offset, size_t size, size_t consumed) {
+            allocation.offset = offset;
+            allocation.valid = true;
+            m_head = offset + size;
+            m_used += consumed;
+            m_currentFrameSize += consumed;
+        }
+
+        struct FrameInfo {
+            uint64_t fence;
+            size_t endOffset;
+            size_t size;
+        };
+
+        size_t m_capacity;
+        size_t m_head = 0;
+        size_t m_tail = 0;
+        size_t m_used = 0;
+        size_t m_currentFrameSize = 0;
+        std::deque<FrameInfo> m_frames;
+    };
+}
@@ -6,6 +6,9 @@
 #include "EverydayTools\Array\ArrayView.h"
 #include "WinWrappers\ComPtr.h"
 #include "WinWrappers\WinWrappers.h"
+#include "ShaderCache.h"
+#include "BindingLayout.h"
+#include <algorithm>
 #include <vector>
 
 namespace d3d_tools {
@@ -24,11 +27,6 @@ namespace d3d_tools {
         _4_0,
     };
 
-	struct ShaderMacro {
-		std::string_view name;
-		std::string_view value;
-	};
-
     namespace shader_details {
     
         template<typename Interface>
@@ -157,11 +155,29 @@ namespace d3d_tools {
         };
     }
 
-    inline ComPtr<ID3DBlob> CompileShaderToBlob(const char* code, const char* entryPoint, ShaderType shaderType, ShaderVersion shaderVersion,
-		edt::SparseArrayView<const ShaderMacro> definitionsView = edt::SparseArrayView<const ShaderMacro>()) {
+    inline UINT GetShaderCompileFlags() {
+        return 0
+        #ifdef _DEBUG
+            | D3DCOMPILE_DEBUG
+            | D3DCOMPILE_SKIP_OPTIMIZATION
+            | D3DCOMPILE_WARNINGS_ARE_ERRORS
+            | D3DCOMPILE_ALL_RESOURCES_BOUND
+        #endif
+            ;
+    }
+
+    inline ComPtr<ID3DBlob> MakeBlob(const void* data, size_t size) {
+        return CallAndRethrowM + [&] {
+            ComPtr<ID3DBlob> blob;
+            WinAPI<char>::ThrowIfError(D3DCreateBlob(size, blob.Receive()));
+            std::memcpy(blob->GetBufferPointer(), data, size);
+            return blob;
+        };
+    }
+
+    // ShaderCompiler that calls D3DCompile
+    inline std::vector<uint8_t> CompileWithD3DCompiler(const ShaderCompileRequest& request) {
         return CallAndRethrowM + [&] {
-            auto datasize = std::char_traits<char>::length(code);
-            auto shaderTarget = ShaderTypeToShaderTarget(shaderType, shaderVersion);
             ComPtr<ID3DBlob> shaderBlob;
             ComPtr<ID3DBlob> errorBlob;
             // This lambda combines described windows error code with d3d compiler error
@@ -175,44 +191,171 @@ namespace d3d_tools {
                 }
                 throw std::runtime_error(std::move(errorMessage));
             };
-    
-            UINT flags1 = 0
-            #ifdef _DEBUG
-                | D3DCOMPILE_DEBUG
-                | D3DCOMPILE_SKIP_OPTIMIZATION
-                | D3DCOMPILE_WARNINGS_ARE_ERRORS
-                | D3DCOMPILE_ALL_RESOURCES_BOUND
-            #endif;
-                ;
-
-			std::vector<D3D_SHADER_MACRO> definitions;
-			D3D_SHADER_MACRO nullDefinition {};
-			const D3D_SHADER_MACRO* definitionsPtr = &nullDefinition;
-
-			auto definitionsCount = definitionsView.GetSize();
-			if (definitionsCount > 0) {
-				definitions.reserve(definitionsCount + 1);
-				for (auto& definition : definitionsView) {
-					definitions.push_back(D3D_SHADER_MACRO { definition.name.data(), definition.value.data()});
-				}
-				definitions.push_back(nullDefinition);
-				definitionsPtr = definitions.data();
-			}
-    
+
+            // D3DCompile takes null-terminated strings
+            std::string entryPoint(request.entryPoint);
+            std::string target(request.target);
+            std::vector<std::string> strings;
+            strings.reserve(request.macros.size() * 2);
+            std::vector<D3D_SHADER_MACRO> definitions;
+            definitions.reserve(request.macros.size() + 1);
+            for (auto& macro : request.macros) {
+                strings.emplace_back(macro.name);
+                strings.emplace_back(macro.value);
+                definitions.push_back(D3D_SHADER_MACRO{ strings[strings.size() - 2].c_str(), strings.back().c_str() });
+            }
+            definitions.push_back(D3D_SHADER_MACRO{});
+
             WinAPI<char>::HandleError(D3DCompile(
-                code,
-                datasize,
+                request.source.data(),
+                request.source.size(),
                 nullptr,              // May be used for debugging
-				definitionsPtr,       // Null-terminated array of macro definitions
+                definitions.data(),   // Null-terminated array of macro definitions
                 nullptr,              // Includes
-                entryPoint,           // Main function of shader
-                shaderTarget,         // shader target
-                flags1,               // Flags for compile constants
+                entryPoint.c_str(),   // Main function of shader
+                target.c_str(),       // shader target
+                request.flags,        // Flags for compile constants
                 0,                    // Flags for compile effects constants
                 shaderBlob.Receive(), // Output compiled shader
                 errorBlob.Receive()   // Compile error messages
             ), onCompileError);
-            return shaderBlob;
+
+            auto data = static_cast<const uint8_t*>(shaderBlob->GetBufferPointer());
+            return std::vector<uint8_t>(data, data + shaderBlob->GetBufferSize());
+        };
+    }
+
+    inline ShaderCompileRequest MakeShaderCompileRequest(const char* code, const char* entryPoint, ShaderType shaderType, ShaderVersion shaderVersion,
+        edt::SparseArrayView<const ShaderMacro> definitions = edt::SparseArrayView<const ShaderMacro>()) {
+        ShaderCompileRequest request;
+        request.source = code;
+        request.macros.assign(definitions.begin(), definitions.end());
+        request.entryPoint = entryPoint;
+        request.target = ShaderTypeToShaderTarget(shaderType, shaderVersion);
+        request.flags = GetShaderCompileFlags();
+        return request;
+    }
+
+    // Null compiler means D3DCompile
+    inline ComPtr<ID3DBlob> CompileShaderToBlob(const char* code, const char* entryPoint, ShaderType shaderType, ShaderVersion shaderVersion,
+        edt::SparseArrayView<const ShaderMacro> definitionsView = edt::SparseArrayView<const ShaderMacro>(),
+        ShaderCache* cache = nullptr, const ShaderCompiler& compiler = nullptr) {
+        return CallAndRethrowM + [&] {
+            auto request = MakeShaderCompileRequest(code, entryPoint, shaderType, shaderVersion, definitionsView);
+            auto bytecode = CompileShaderBytecode(request, compiler ? compiler : ShaderCompiler(CompileWithD3DCompiler), cache);
+            return MakeBlob(bytecode.data(), bytecode.size());
+        };
+    }
+
+    namespace shader_details {
+        inline HlslScalarType ConvertScalarType(D3D_SHADER_VARIABLE_TYPE type) {
+            switch (type) {
+            case D3D_SVT_FLOAT: return HlslScalarType::Float;
+            case D3D_SVT_INT: return HlslScalarType::Int;
+            case D3D_SVT_UINT: return HlslScalarType::UInt;
+            case D3D_SVT_BOOL: return HlslScalarType::Bool;
+            default: return HlslScalarType::Other;
+            }
+        }
+
+        inline HlslTypeClass ConvertTypeClass(D3D_SHADER_VARIABLE_CLASS typeClass) {
+            switch (typeClass) {
+            case D3D_SVC_SCALAR: return HlslTypeClass::Scalar;
+            case D3D_SVC_VECTOR: return HlslTypeClass::Vector;
+            case D3D_SVC_MATRIX_ROWS: return HlslTypeClass::MatrixRows;
+            case D3D_SVC_MATRIX_COLUMNS: return HlslTypeClass::MatrixColumns;
+            case D3D_SVC_STRUCT: return HlslTypeClass::Struct;
+            default: throw std::invalid_argument("Unsupported constant buffer variable class");
+            }
+        }
+
+        inline ShaderBindingKind ConvertInputType(D3D_SHADER_INPUT_TYPE type) {
+            switch (type) {
+            case D3D_SIT_CBUFFER:
+                return ShaderBindingKind::ConstantBuffer;
+            case D3D_SIT_TBUFFER:
+            case D3D_SIT_TEXTURE:
+            case D3D_SIT_STRUCTURED:
+            case D3D_SIT_BYTEADDRESS:
+                return ShaderBindingKind::ShaderResource;
+            case D3D_SIT_SAMPLER:
+                return ShaderBindingKind::Sampler;
+            default:
+                return ShaderBindingKind::UnorderedAccess;
+            }
+        }
+
+        inline ConstantVariableLayout ReflectVariable(ID3D11ShaderReflectionVariable* reflection) {
+            D3D11_SHADER_VARIABLE_DESC variableDesc;
+            WinAPI<char>::ThrowIfError(reflection->GetDesc(&variableDesc));
+            D3D11_SHADER_TYPE_DESC typeDesc;
+            WinAPI<char>::ThrowIfError(reflection->GetType()->GetDesc(&typeDesc));
+
+            ConstantVariableLayout variable;
+            variable.name = variableDesc.Name;
+            variable.offset = variableDesc.StartOffset;
+            variable.size = variableDesc.Size;
+            variable.type.typeClass = ConvertTypeClass(typeDesc.Class);
+            variable.type.scalarType = ConvertScalarType(typeDesc.Type);
+            variable.type.rows = typeDesc.Rows;
+            variable.type.columns = typeDesc.Columns;
+            variable.type.elements = typeDesc.Elements;
+            if (variable.type.typeClass == HlslTypeClass::Struct) {
+                // Reflection gives the size of the whole variable: every element but the last is register aligned
+                auto elementsCount = std::max(typeDesc.Elements, 1u);
+                auto stride = hlsl_packing::AlignToRegister(variableDesc.Size) / elementsCount;
+                variable.type.structSize = variableDesc.Size - (elementsCount - 1) * stride;
+            }
+            return variable;
+        }
+    }
+
+    // Works for bytecode of any shader type
+    inline BindingLayout ReflectBindingLayout(const void* bytecode, size_t size) {
+        return CallAndRethrowM + [&] {
+            ComPtr<ID3D11ShaderReflection> reflection;
+            WinAPI<char>::ThrowIfError(
+                D3DReflect(bytecode, size, __uuidof(ID3D11ShaderReflection), (void**)reflection.Receive()));
+
+            D3D11_SHADER_DESC shaderDesc;
+            WinAPI<char>::ThrowIfError(reflection->GetDesc(&shaderDesc));
+
+            BindingLayout layout;
+            for (uint32_t i = 0; i < shaderDesc.BoundResources; ++i) {
+                D3D11_SHADER_INPUT_BIND_DESC bindDesc;
+                WinAPI<char>::ThrowIfError(reflection->GetResourceBindingDesc(i, &bindDesc));
+                layout.bindings.push_back(ShaderBinding{
+                    bindDesc.Name,
+                    shader_details::ConvertInputType(bindDesc.Type),
+                    bindDesc.BindPoint,
+                    bindDesc.BindCount });
+            }
+            std::sort(layout.bindings.begin(), layout.bindings.end(), [](const ShaderBinding& a, const ShaderBinding& b) {
+                return a.kind != b.kind ? a.kind < b.kind : a.slot < b.slot;
+            });
+
+            for (uint32_t i = 0; i < shaderDesc.ConstantBuffers; ++i) {
+                auto bufferReflection = reflection->GetConstantBufferByIndex(i);
+                D3D11_SHADER_BUFFER_DESC bufferDesc;
+                WinAPI<char>::ThrowIfError(bufferReflection->GetDesc(&bufferDesc));
+                // Texture buffers and structured buffer descriptions are reported here too
+                if (bufferDesc.Type != D3D_CT_CBUFFER) {
+                    continue;
+                }
+
+                ConstantBufferLayout buffer;
+                buffer.name = bufferDesc.Name;
+                buffer.size = bufferDesc.Size;
+                buffer.slot = layout.GetSlot(ShaderBindingKind::ConstantBuffer, buffer.name);
+                for (uint32_t j = 0; j < bufferDesc.Variables; ++j) {
+                    buffer.variables.push_back(shader_details::ReflectVariable(bufferReflection->GetVariableByIndex(j)));
+                }
+                layout.constantBuffers.push_back(std::move(buffer));
+            }
+            std::sort(layout.constantBuffers.begin(), layout.constantBuffers.end(), [](const ConstantBufferLayout& a, const ConstantBufferLayout& b) {
+                return a.slot < b.slot;
+            });
+            return layout;
         };
     }
 
@@ -302,9 +445,9 @@ namespace d3d_tools {
         using Interface = typename Traits::Interface;
     
         void Compile(const char* code, const char* entryPoint, ShaderVersion shaderVersion, edt::SparseArrayView<const ShaderMacro> definitions =
-			edt::SparseArrayView<const ShaderMacro>()) {
+			edt::SparseArrayView<const ShaderMacro>(), ShaderCache* cache = nullptr, const ShaderCompiler& compiler = nullptr) {
             CallAndRethrowM + [&] {
-                bytecode = CompileShaderToBlob(code, entryPoint, shaderType, shaderVersion, definitions);
+                bytecode = CompileShaderToBlob(code, entryPoint, shaderType, shaderVersion, definitions, cache, compiler);
             };
         }
     
@@ -317,6 +460,13 @@ namespace d3d_tools {
             };
         }
     
+        BindingLayout ReflectBindingLayout() const {
+            return CallAndRethrowM + [&] {
+                edt::ThrowIfFailed<std::logic_error>(bytecode.Get() != nullptr, "Bytecode is nullptr!");
+                return ::d3d_tools::ReflectBindingLayout(bytecode->GetBufferPointer(), bytecode->GetBufferSize());
+            };
+        }
+
         ComPtr<ID3D10Blob> bytecode;
         ComPtr<Interface> shader;
     };
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <future>
+#include <string>
+#include <vector>
+#include "Device.h"
+#include "ShaderBytecodeBatch.h"
+#include "ThreadPool.h"
+
+namespace d3d_tools {
+    template<ShaderType shaderType>
+    struct ShaderCompileJob {
+        std::string code;
+        std::string entryPoint;
+        ShaderVersion version = ShaderVersion::_5_0;
+        std::vector<ShaderMacroDefinition> macros;
+    };
+
+    // Compiles shader permutations on the thread pool. Null compiler means D3DCompile.
+    // Shader objects are created on worker threads, so the device must not be created with noDeviceMultithreading
+    class ShaderBatchCompiler {
+    public:
+        ShaderBatchCompiler(Device* device, ThreadPool& threadPool, ShaderCache* cache = nullptr, ShaderCompiler compiler = nullptr) :
+            m_device(device),
+            m_bytecode(threadPool, compiler ? std::move(compiler) : ShaderCompiler(CompileWithD3DCompiler), cache)
+        {
+            edt::ThrowIfFailed(device->IsMultithreaded(), "Batch compilation requires multithreaded device");
+        }
+
+        template<ShaderType shaderType>
+        std::future<Shader<shaderType>> Submit(ShaderCompileJob<shaderType> job) {
+            ShaderBytecodeJob bytecodeJob;
+            bytecodeJob.code = std::move(job.code);
+            bytecodeJob.entryPoint = std::move(job.entryPoint);
+            bytecodeJob.target = ShaderTypeToShaderTarget(shaderType, job.version);
+            bytecodeJob.flags = GetShaderCompileFlags();
+            bytecodeJob.macros = std::move(job.macros);
+
+            return m_bytecode.GetThreadPool().Submit(
+                [device = m_device, compiler = m_bytecode.GetCompiler(), cache = m_bytecode.GetCache(), job = std::move(bytecodeJob)] {
+                    return CallAndRethrowM + [&] {
+                        auto bytecode = CompileShaderBytecode(job, compiler, cache);
+                        Shader<shaderType> result;
+                        result.bytecode = MakeBlob(bytecode.data(), bytecode.size());
+                        result.Create(device->GetDevice().Get());
+                        return result;
+                    };
+                });
+        }
+
+        template<ShaderType shaderType>
+        std::vector<std::future<Shader<shaderType>>> Submit(std::vector<ShaderCompileJob<shaderType>> jobs) {
+            std::vector<std::future<Shader<shaderType>>> result;
+            result.reserve(jobs.size());
+            for (auto& job : jobs) {
+                result.push_back(Submit(std::move(job)));
+            }
+            return result;
+        }
+
+        // Waits for the shader helping the pool with other jobs
+        template<ShaderType shaderType>
+        Shader<shaderType> Get(std::future<Shader<shaderType>>& future) {
+            return m_bytecode.GetThreadPool().Wait(future);
+        }
+
+    private:
+        Device* m_device;
+        ShaderBytecodeBatchCompiler m_bytecode;
+    };
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "ShaderCache.h"
+#include "ThreadPool.h"
+
+namespace d3d_tools {
+    // Owning version of ShaderMacro: jobs outlive the caller's strings
+    struct ShaderMacroDefinition {
+        std::string name;
+        std::string value;
+    };
+
+    // Owning version of ShaderCompileRequest
+    struct ShaderBytecodeJob {
+        std::string code;
+        std::string entryPoint;
+        std::string target;
+        uint32_t flags = 0;
+        std::vector<ShaderMacroDefinition> macros;
+    };
+
+    inline std::vector<uint8_t> CompileShaderBytecode(const ShaderBytecodeJob& job, const ShaderCompiler& compile, ShaderCache* cache) {
+        ShaderCompileRequest request;
+        request.source = job.code;
+        request.macros.reserve(job.macros.size());
+        for (auto& macro : job.macros) {
+            request.macros.push_back(ShaderMacro{ macro.name, macro.value });
+        }
+        request.entryPoint = job.entryPoint;
+        request.target = job.target;
+        request.flags = job.flags;
+        return CompileShaderBytecode(request, compile, cache);
+    }
+
+    // Compiles bytecode of shader permutations on the thread pool. Knows nothing about D3D:
+    // the compiler is any ShaderCompiler, ShaderBatchCompiler builds shader objects on top of it.
+    // The compiler is called from worker threads concurrently
+    class ShaderBytecodeBatchCompiler {
+    public:
+        ShaderBytecodeBatchCompiler(ThreadPool& threadPool, ShaderCompiler compiler, ShaderCache* cache = nullptr) :
+            m_threadPool(threadPool),
+            m_compiler(std::move(compiler)),
+            m_cache(cache)
+        {
+            if (!m_compiler) {
+                throw std::invalid_argument("Shader compiler is required");
+            }
+        }
+
+        std::future<std::vector<uint8_t>> Submit(ShaderBytecodeJob job) {
+            return m_threadPool.Submit([compiler = m_compiler, cache = m_cache, job = std::move(job)] {
+                return CompileShaderBytecode(job, compiler, cache);
+            });
+        }
+
+        std::vector<std::future<std::vector<uint8_t>>> Submit(std::vector<ShaderBytecodeJob> jobs) {
+            std::vector<std::future<std::vector<uint8_t>>> result;
+            result.reserve(jobs.size());
+            for (auto& job : jobs) {
+                result.push_back(Submit(std::move(job)));
+            }
+            return result;
+        }
+
+        // Waits for the bytecode helping the pool with other jobs
+        std::vector<uint8_t> Get(std::future<std::vector<uint8_t>>& future) {
+            return m_threadPool.Wait(future);
+        }
+
+        ThreadPool& GetThreadPool() const {
+            return m_threadPool;
+        }
+
+        const ShaderCompiler& GetCompiler() const {
+            return m_compiler;
+        }
+
+        ShaderCache* GetCache() const {
+            return m_cache;
+        }
+
+    private:
+        ThreadPool& m_threadPool;
+        ShaderCompiler m_compiler;
+        ShaderCache* m_cache;
+    };
+}
@@ -0,0 +1,446 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Hash.h"
+#include "MappedFile.h"
+
+namespace d3d_tools {
+    struct ShaderMacro {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    // Everything that determines the bytecode
+    struct ShaderCompileRequest {
+        std::string_view source;
+        std::vector<ShaderMacro> macros;
+        std::string_view entryPoint;
+        std::string_view target;
+        uint32_t flags = 0;
+    };
+
+    // Turns source into bytecode and throws on errors. Shader.h has the D3DCompile one;
+    // tools and tests may use any other compiler
+    using ShaderCompiler = std::function<std::vector<uint8_t>(const ShaderCompileRequest&)>;
+
+    namespace shader_cache_details {
+        // Change it when the key or file layout changes
+        static constexpr uint32_t FormatVersion = 1;
+        static constexpr uint32_t EntryMagic = 0x45534444; // 'DDSE'
+        static constexpr uint32_t IndexMagic = 0x49534444; // 'DDSI'
+
+        struct EntryHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t key;
+            uint64_t size;
+            uint64_t checksum;
+        };
+
+        struct IndexHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t entriesCount;
+            uint64_t checksum;
+        };
+
+        inline std::string KeyToString(uint64_t key) {
+            static const char digits[] = "0123456789abcdef";
+            std::string result(16, '0');
+            for (size_t i = 0; i < 16; ++i) {
+                result[15 - i] = digits[(key >> (i * 4)) & 0xF];
+            }
+            return result;
+        }
+
+        inline uint64_t GetCurrentTick() {
+            using namespace std::chrono;
+            return static_cast<uint64_t>(duration_cast<seconds>(system_clock::now().time_since_epoch()).count());
+        }
+
+        // Unique name in the same directory to make the final rename atomic
+        inline std::filesystem::path MakeTemporaryPath(const std::filesystem::path& target) {
+            static std::atomic<uint64_t> counter{ 0 };
+            uint64_t unique = std::hash<std::thread::id>()(std::this_thread::get_id());
+            CombineHash(unique, static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+            CombineHash(unique, counter++);
+            auto result = target;
+            result += "." + KeyToString(unique) + ".tmp";
+            return result;
+        }
+
+        // Writes the file next to the target and renames it. Readers never observe partially written file
+        inline bool WriteFileAtomically(const std::filesystem::path& target, const void* data, size_t size) {
+            auto temporary = MakeTemporaryPath(target);
+            {
+                std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+                stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+                if (!stream) {
+                    stream.close();
+                    std::error_code ignored;
+                    std::filesystem::remove(temporary, ignored);
+                    return false;
+                }
+            }
+
+            std::error_code error;
+            std::filesystem::rename(temporary, target, error);
+            if (error) {
+                std::filesystem::remove(temporary, error);
+                return false;
+            }
+
+            return true;
+        }
+    }
+
+    template<typename Macros>
+    uint64_t ComputeShaderCacheKey(
+        std::string_view source,
+        const Macros& macros,
+        std::string_view entryPoint,
+        std::string_view target,
+        uint32_t compileFlags)
+    {
+        Hasher hasher;
+        hasher.AddValue(shader_cache_details::FormatVersion);
+        hasher.Add(source);
+        uint64_t macrosCount = 0;
+        for (auto& macro : macros) {
+            hasher.Add(macro.name);
+            hasher.Add(macro.value);
+            ++macrosCount;
+        }
+        hasher.AddValue(macrosCount);
+        hasher.Add(entryPoint);
+        hasher.Add(target);
+        hasher.AddValue(compileFlags);
+        return hasher.GetValue();
+    }
+
+    inline uint64_t ComputeShaderCacheKey(const ShaderCompileRequest& request) {
+        return ComputeShaderCacheKey(request.source, request.macros, request.entryPoint, request.target, request.flags);
+    }
+
+    struct ShaderCacheIndexEntry {
+        uint64_t key;
+        uint64_t size;
+        uint64_t lastUse;
+    };
+
+    class ShaderCacheIndex {
+    public:
+        std::vector<uint8_t> Serialize() const {
+            using namespace shader_cache_details;
+            std::vector<ShaderCacheIndexEntry> entries;
+            entries.reserve(m_entries.size());
+            for (auto& item : m_entries) {
+                entries.push_back(item.second);
+            }
+
+            // Stable order makes the file content independent of hash map layout
+            std::sort(entries.begin(), entries.end(), [](auto& a, auto& b) { return a.key < b.key; });
+
+            IndexHeader header{};
+            header.magic = IndexMagic;
+            header.version = FormatVersion;
+            header.entriesCount = entries.size();
+            header.checksum = ComputeHash(entries.data(), entries.size() * sizeof(ShaderCacheIndexEntry));
+
+            std::vector<uint8_t> result(sizeof(header) + entries.size() * sizeof(ShaderCacheIndexEntry));
+            std::memcpy(result.data(), &header, sizeof(header));
+            if (!entries.empty()) {
+                std::memcpy(result.data() + sizeof(header), entries.data(), entries.size() * sizeof(ShaderCacheIndexEntry));
+            }
+            return result;
+        }
+
+        // Returns false and leaves the index empty if data is damaged or has another version
+        bool Parse(const uint8_t* data, size_t size) {
+            using namespace shader_cache_details;
+            m_entries.clear();
+            if (size < sizeof(IndexHeader)) {
+                return false;
+            }
+
+            IndexHeader header;
+            std::memcpy(&header, data, sizeof(header));
+            if (header.magic != IndexMagic || header.version != FormatVersion) {
+                return false;
+            }
+
+            auto payloadSize = size - sizeof(header);
+            if (header.entriesCount != payloadSize / sizeof(ShaderCacheIndexEntry) ||
+                payloadSize % sizeof(ShaderCacheIndexEntry) != 0 ||
+                header.checksum != ComputeHash(data + sizeof(header), payloadSize)) {
+                return false;
+            }
+
+            for (uint64_t i = 0; i < header.entriesCount; ++i) {
+                ShaderCacheIndexEntry entry;
+                std::memcpy(&entry, data + sizeof(header) + i * sizeof(entry), sizeof(entry));
+                m_entries[entry.key] = entry;
+            }
+
+            return true;
+        }
+
+        // Keeps the most recent use of each entry
+        void Merge(const ShaderCacheIndex& other) {
+            for (auto& item : other.m_entries) {
+                auto it = m_entries.find(item.first);
+                if (it == m_entries.end()) {
+                    m_entries.insert(item);
+                } else {
+                    it->second.lastUse = std::max(it->second.lastUse, item.second.lastUse);
+                }
+            }
+        }
+
+        void Touch(uint64_t key, uint64_t size, uint64_t tick) {
+            auto& entry = m_entries[key];
+            entry.key = key;
+            entry.size = size;
+            entry.lastUse = std::max(entry.lastUse, tick);
+        }
+
+        void Remove(uint64_t key) {
+            m_entries.erase(key);
+        }
+
+        uint64_t GetTotalSize() const {
+            uint64_t result = 0;
+            for (auto& item : m_entries) {
+                result += item.second.size;
+            }
+            return result;
+        }
+
+        // Least recently used entries that must be removed to fit into maxSize
+        std::vector<uint64_t> SelectEvictions(uint64_t maxSize) const {
+            std::vector<ShaderCacheIndexEntry> entries;
+            entries.reserve(m_entries.size());
+            for (auto& item : m_entries) {
+                entries.push_back(item.second);
+            }
+
+            std::sort(entries.begin(), entries.end(), [](auto& a, auto& b) {
+                return a.lastUse != b.lastUse ? a.lastUse < b.lastUse : a.key < b.key;
+            });
+
+            std::vector<uint64_t> result;
+            auto totalSize = GetTotalSize();
+            for (auto& entry : entries) {
+                if (totalSize <= maxSize) {
+                    break;
+                }
+                totalSize -= entry.size;
+                result.push_back(entry.key);
+            }
+
+            return result;
+        }
+
+        size_t GetEntriesCount() const {
+            return m_entries.size();
+        }
+
+    private:
+        std::unordered_map<uint64_t, ShaderCacheIndexEntry> m_entries;
+    };
+
+    // Compiled bytecode that lives in mapped cache file
+    class ShaderCacheEntry {
+    public:
+        ShaderCacheEntry() = default;
+
+        ShaderCacheEntry(MappedFile&& file) :
+            m_file(std::move(file))
+        {
+        }
+
+        bool IsValid() const {
+            return m_file.IsValid();
+        }
+
+        const uint8_t* GetData() const {
+            return m_file.GetData() + sizeof(shader_cache_details::EntryHeader);
+        }
+
+        size_t GetSize() const {
+            return m_file.GetSize() - sizeof(shader_cache_details::EntryHeader);
+        }
+
+    private:
+        MappedFile m_file;
+    };
+
+    // Content-addressed storage of compiled shaders. Every entry is a separate file named by its key.
+    // Files are written to temporary location and renamed, so several processes may share the directory.
+    // The index is advisory: it only drives eviction and is merged with the on-disk copy on every write
+    class ShaderCache {
+    public:
+        ShaderCache(std::filesystem::path directory, uint64_t maxSize = 256ull * 1024 * 1024) :
+            m_directory(std::move(directory)),
+            m_maxSize(maxSize)
+        {
+            std::filesystem::create_directories(m_directory);
+            ReadIndex(m_index);
+        }
+
+        ~ShaderCache() {
+            try {
+                Flush();
+            } catch (...) {
+            }
+        }
+
+        ShaderCacheEntry Load(uint64_t key) {
+            using namespace shader_cache_details;
+            MappedFile file(GetEntryPath(key));
+            if (!file.IsValid() || file.GetSize() < sizeof(EntryHeader)) {
+                ++m_misses;
+                return ShaderCacheEntry();
+            }
+
+            EntryHeader header;
+            std::memcpy(&header, file.GetData(), sizeof(header));
+            auto payload = file.GetData() + sizeof(header);
+            auto payloadSize = file.GetSize() - sizeof(header);
+            if (header.magic != EntryMagic || header.version != FormatVersion || header.key != key ||
+                header.size != payloadSize || header.checksum != ComputeHash(payload, payloadSize)) {
+                ++m_misses;
+                return ShaderCacheEntry();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_index.Touch(key, file.GetSize(), GetCurrentTick());
+                m_indexChanged = true;
+            }
+
+            ++m_hits;
+            return ShaderCacheEntry(std::move(file));
+        }
+
+        void Store(uint64_t key, const void* data, size_t size) {
+            using namespace shader_cache_details;
+            auto path = GetEntryPath(key);
+
+            // Same key means same content: nothing to do if someone has already written it
+            std::error_code error;
+            if (!std::filesystem::exists(path, error)) {
+                EntryHeader header{};
+                header.magic = EntryMagic;
+                header.version = FormatVersion;
+                header.key = key;
+                header.size = size;
+                header.checksum = ComputeHash(data, size);
+
+                std::vector<uint8_t> content(sizeof(header) + size);
+                std::memcpy(content.data(), &header, sizeof(header));
+                std::memcpy(content.data() + sizeof(header), data, size);
+                WriteFileAtomically(path, content.data(), content.size());
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_index.Touch(key, sizeof(EntryHeader) + size, GetCurrentTick());
+            m_indexChanged = true;
+            if (m_index.GetTotalSize() > m_maxSize) {
+                FlushLocked();
+            }
+        }
+
+        // Merges the index with the on-disk copy, evicts old entries and writes the index back
+        void Flush() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            FlushLocked();
+        }
+
+        uint64_t GetHitsCount() const {
+            return m_hits;
+        }
+
+        uint64_t GetMissesCount() const {
+            return m_misses;
+        }
+
+    private:
+        void FlushLocked() {
+            if (!m_indexChanged) {
+                return;
+            }
+
+            ShaderCacheIndex onDisk;
+            ReadIndex(onDisk);
+            m_index.Merge(onDisk);
+
+            for (auto key : m_index.SelectEvictions(m_maxSize)) {
+                std::error_code ignored;
+                // May fail on Windows if another process has the file mapped. It will be retried later
+                if (std::filesystem::remove(GetEntryPath(key), ignored) ||
+                    !std::filesystem::exists(GetEntryPath(key), ignored)) {
+                    m_index.Remove(key);
+                }
+            }
+
+            auto content = m_index.Serialize();
+            shader_cache_details::WriteFileAtomically(GetIndexPath(), content.data(), content.size());
+            m_indexChanged = false;
+        }
+
+        void ReadIndex(ShaderCacheIndex& index) const {
+            MappedFile file(GetIndexPath());
+            if (file.IsValid()) {
+                index.Parse(file.GetData(), file.GetSize());
+            }
+        }
+
+        std::filesystem::path GetEntryPath(uint64_t key) const {
+            return m_directory / (shader_cache_details::KeyToString(key) + ".dxbc");
+        }
+
+        std::filesystem::path GetIndexPath() const {
+            return m_directory / "index.bin";
+        }
+
+    private:
+        std::filesystem::path m_directory;
+        uint64_t m_maxSize;
+        std::mutex m_mutex;
+        ShaderCacheIndex m_index;
+        bool m_indexChanged = false;
+        std::atomic<uint64_t> m_hits{ 0 };
+        std::atomic<uint64_t> m_misses{ 0 };
+    };
+
+    // Bytecode from the cache, or compiled and stored there on a miss. cache may be null
+    inline std::vector<uint8_t> CompileShaderBytecode(const ShaderCompileRequest& request, const ShaderCompiler& compile, ShaderCache* cache) {
+        uint64_t key = 0;
+        if (cache) {
+            key = ComputeShaderCacheKey(request);
+            auto entry = cache->Load(key);
+            if (entry.IsValid()) {
+                return std::vector<uint8_t>(entry.GetData(), entry.GetData() + entry.GetSize());
+            }
+        }
+
+        auto bytecode = compile(request);
+        if (cache) {
+            cache->Store(key, bytecode.data(), bytecode.size());
+        }
+        return bytecode;
+    }
+}
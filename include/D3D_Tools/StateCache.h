@@ -0,0 +1,410 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <stdexcept>
+
+namespace d3d_tools {
+    struct StateCacheStatistics {
+        // Returns the passed value to allow filtering in place
+        bool Count(bool changed) {
+            if (changed) {
+                ++issuedBinds;
+            } else {
+                ++redundantBinds;
+            }
+            return changed;
+        }
+
+        uint64_t issuedBinds = 0;
+        uint64_t redundantBinds = 0;
+    };
+
+    // Shadow copy of single piece of pipeline state.
+    // Knows nothing about device so it could be used with any context implementation
+    template<typename T>
+    class CachedValue {
+    public:
+        // Returns true if the value differs from the one that is already bound
+        bool Update(const T& value) {
+            if (m_valid && m_value == value) {
+                return false;
+            }
+
+            m_value = value;
+            m_valid = true;
+            return true;
+        }
+
+        void Invalidate() {
+            m_valid = false;
+        }
+
+        bool IsValid() const {
+            return m_valid;
+        }
+
+        const T& Get() const {
+            return m_value;
+        }
+
+    private:
+        T m_value{};
+        bool m_valid = false;
+    };
+
+    // Shadow copy of slot-based pipeline state (shader resources, samplers, etc.).
+    // Changes are accumulated and sent to the device on Flush as few contiguous ranges as possible
+    template<typename T, size_t slotsCount>
+    class PendingSlots {
+    public:
+        static constexpr size_t SlotsCount = slotsCount;
+
+        // Returns false if the value is already bound or is going to be bound on next flush
+        bool Set(uint32_t slot, const T& value) {
+            if (m_requested[slot] == value && (m_valid[slot] || m_changed[slot])) {
+                return false;
+            }
+
+            m_requested[slot] = value;
+            m_changed[slot] = true;
+            m_pendingBegin = std::min(m_pendingBegin, slot);
+            m_pendingEnd = std::max(m_pendingEnd, slot + 1);
+            return true;
+        }
+
+        bool HasPendingChanges() const {
+            return m_pendingBegin < m_pendingEnd;
+        }
+
+        // Calls f(startSlot, count, values) for every run of changed slots. A run may span slots that
+        // are known to hold the same value on the device, but never a slot whose device value is unknown:
+        // sending a stale value there would overwrite state bound bypassing the cache.
+        // Returns the number of calls
+        template<typename F>
+        size_t Flush(F&& f) {
+            auto begin = m_pendingBegin;
+            auto end = m_pendingEnd;
+            m_pendingBegin = static_cast<uint32_t>(slotsCount);
+            m_pendingEnd = 0;
+
+            size_t calls = 0;
+            auto slot = begin;
+            while (slot < end) {
+                while (slot < end && !NeedsSending(slot)) {
+                    ++slot;
+                }
+                if (slot == end) {
+                    break;
+                }
+
+                auto runBegin = slot;
+                auto runEnd = ++slot;
+                while (slot < end && (NeedsSending(slot) || IsApplied(slot))) {
+                    if (NeedsSending(slot)) {
+                        runEnd = slot + 1;
+                    }
+                    ++slot;
+                }
+
+                f(runBegin, runEnd - runBegin, &m_requested[runBegin]);
+                for (auto applied = runBegin; applied < runEnd; ++applied) {
+                    m_applied[applied] = m_requested[applied];
+                    m_valid[applied] = true;
+                }
+                ++calls;
+            }
+
+            for (slot = begin; slot < end; ++slot) {
+                m_changed[slot] = false;
+            }
+            return calls;
+        }
+
+        // Forget what is bound to the device. Pending changes are kept
+        void Invalidate() {
+            m_valid.reset();
+        }
+
+        const T& Get(uint32_t slot) const {
+            return m_requested[slot];
+        }
+
+    private:
+        bool IsApplied(uint32_t slot) const {
+            return m_valid[slot] && m_applied[slot] == m_requested[slot];
+        }
+
+        bool NeedsSending(uint32_t slot) const {
+            return m_changed[slot] && !IsApplied(slot);
+        }
+
+    private:
+        std::array<T, slotsCount> m_requested{};
+        std::array<T, slotsCount> m_applied{};
+        std::bitset<slotsCount> m_valid;
+        // Set since the last flush
+        std::bitset<slotsCount> m_changed;
+        uint32_t m_pendingBegin = static_cast<uint32_t>(slotsCount);
+        uint32_t m_pendingEnd = 0;
+    };
+
+    // Shadow copy of everything Device binds. Calls reach the context only when they change something.
+    // Context is a small adapter that performs the calls and names the handle types:
+    //     using Shader, ShaderResource, Sampler, Buffer, InputLayout, BlendState, DepthStencilState,
+    //         RasterizerState (pointed to), Topology and IndexFormat (passed by value);
+    //     static constexpr uint32_t StagesCount, ShaderResourceSlotsCount, SamplerSlotsCount,
+    //         ConstantBufferSlotsCount, VertexBufferSlotsCount;
+    //     SetShader(stage, shader), SetShaderResources(stage, startSlot, count, views),
+    //     SetSamplers(stage, startSlot, count, samplers), SetConstantBuffers(stage, startSlot, count, buffers),
+    //     SetVertexBuffers(startSlot, count, buffers, strides, offsets), SetIndexBuffer(buffer, format, offset),
+    //     SetInputLayout(layout), SetPrimitiveTopology(topology), SetBlendState(state, factor, sampleMask),
+    //     SetDepthStencilState(state, stencilRef), SetRasterizerState(state).
+    // Device uses one over ID3D11DeviceContext, so the cache itself knows nothing about D3D
+    template<typename Context>
+    class BindingCache {
+    public:
+        using Shader = typename Context::Shader;
+        using ShaderResource = typename Context::ShaderResource;
+        using Sampler = typename Context::Sampler;
+        using Buffer = typename Context::Buffer;
+        using InputLayout = typename Context::InputLayout;
+        using Topology = typename Context::Topology;
+        using IndexFormat = typename Context::IndexFormat;
+        using BlendState = typename Context::BlendState;
+        using DepthStencilState = typename Context::DepthStencilState;
+        using RasterizerState = typename Context::RasterizerState;
+
+        explicit BindingCache(Context context = Context()) :
+            m_context(std::move(context))
+        {
+        }
+
+        void SetShader(uint32_t stage, Shader* shader) {
+            if (m_statistics.Count(GetStage(stage).shader.Update(shader))) {
+                m_context.SetShader(stage, shader);
+            }
+        }
+
+        // Slot changes are sent on Flush
+        void SetShaderResources(uint32_t stage, uint32_t startSlot, uint32_t count, ShaderResource* const* views) {
+            SetSlots(GetStage(stage).shaderResources, startSlot, count, views);
+        }
+
+        void SetSamplers(uint32_t stage, uint32_t startSlot, uint32_t count, Sampler* const* samplers) {
+            SetSlots(GetStage(stage).samplers, startSlot, count, samplers);
+        }
+
+        void SetConstantBuffers(uint32_t stage, uint32_t startSlot, uint32_t count, Buffer* const* buffers) {
+            SetSlots(GetStage(stage).constantBuffers, startSlot, count, buffers);
+        }
+
+        void SetVertexBuffers(uint32_t startSlot, uint32_t count, Buffer* const* buffers, const uint32_t* strides, const uint32_t* offsets) {
+            ThrowIfOutOfRange(startSlot, count, Context::VertexBufferSlotsCount);
+            for (uint32_t i = 0; i < count; ++i) {
+                if (!m_vertexBuffers.Set(startSlot + i, VertexBufferBinding{ buffers[i], strides[i], offsets[i] })) {
+                    ++m_statistics.redundantBinds;
+                }
+            }
+        }
+
+        void SetIndexBuffer(Buffer* buffer, IndexFormat format, uint32_t offset) {
+            if (m_statistics.Count(m_indexBuffer.Update(IndexBufferBinding{ buffer, format, offset }))) {
+                m_context.SetIndexBuffer(buffer, format, offset);
+            }
+        }
+
+        void SetInputLayout(InputLayout* layout) {
+            if (m_statistics.Count(m_inputLayout.Update(layout))) {
+                m_context.SetInputLayout(layout);
+            }
+        }
+
+        void SetPrimitiveTopology(Topology topology) {
+            if (m_statistics.Count(m_topology.Update(topology))) {
+                m_context.SetPrimitiveTopology(topology);
+            }
+        }
+
+        // Null blend factor means { 1, 1, 1, 1 }
+        void SetBlendState(BlendState* state, const float* blendFactor, uint32_t sampleMask) {
+            BlendStateBinding binding{ state, { 1.0f, 1.0f, 1.0f, 1.0f }, sampleMask };
+            if (blendFactor) {
+                std::copy(blendFactor, blendFactor + 4, binding.factor);
+            }
+            if (m_statistics.Count(m_blend.Update(binding))) {
+                m_context.SetBlendState(state, binding.factor, sampleMask);
+            }
+        }
+
+        void SetDepthStencilState(DepthStencilState* state, uint32_t stencilRef) {
+            if (m_statistics.Count(m_depthStencil.Update(DepthStencilStateBinding{ state, stencilRef }))) {
+                m_context.SetDepthStencilState(state, stencilRef);
+            }
+        }
+
+        void SetRasterizerState(RasterizerState* state) {
+            if (m_statistics.Count(m_rasterizer.Update(state))) {
+                m_context.SetRasterizerState(state);
+            }
+        }
+
+        // Sends accumulated slot changes to the context
+        void Flush() {
+            for (uint32_t stage = 0; stage < Context::StagesCount; ++stage) {
+                auto& state = m_stages[stage];
+                FlushSlots(state.shaderResources, [&](uint32_t startSlot, uint32_t count, ShaderResource* const* views) {
+                    m_context.SetShaderResources(stage, startSlot, count, views);
+                });
+                FlushSlots(state.samplers, [&](uint32_t startSlot, uint32_t count, Sampler* const* samplers) {
+                    m_context.SetSamplers(stage, startSlot, count, samplers);
+                });
+                FlushSlots(state.constantBuffers, [&](uint32_t startSlot, uint32_t count, Buffer* const* buffers) {
+                    m_context.SetConstantBuffers(stage, startSlot, count, buffers);
+                });
+            }
+
+            FlushSlots(m_vertexBuffers, [&](uint32_t startSlot, uint32_t count, const VertexBufferBinding* bindings) {
+                Buffer* buffers[Context::VertexBufferSlotsCount];
+                uint32_t strides[Context::VertexBufferSlotsCount];
+                uint32_t offsets[Context::VertexBufferSlotsCount];
+                for (uint32_t i = 0; i < count; ++i) {
+                    buffers[i] = bindings[i].buffer;
+                    strides[i] = bindings[i].stride;
+                    offsets[i] = bindings[i].offset;
+                }
+                m_context.SetVertexBuffers(startSlot, count, buffers, strides, offsets);
+            });
+        }
+
+        // The device silently unbinds shader resources that become outputs, so the cached ones can not be trusted
+        void InvalidateShaderResources() {
+            for (auto& stage : m_stages) {
+                stage.shaderResources.Invalidate();
+            }
+        }
+
+        // Must be called if the context state was changed bypassing the cache
+        void Invalidate() {
+            for (auto& stage : m_stages) {
+                stage.shader.Invalidate();
+                stage.shaderResources.Invalidate();
+                stage.samplers.Invalidate();
+                stage.constantBuffers.Invalidate();
+            }
+            m_inputLayout.Invalidate();
+            m_topology.Invalidate();
+            m_vertexBuffers.Invalidate();
+            m_indexBuffer.Invalidate();
+            m_blend.Invalidate();
+            m_depthStencil.Invalidate();
+            m_rasterizer.Invalidate();
+        }
+
+        const StateCacheStatistics& GetStatistics() const {
+            return m_statistics;
+        }
+
+        void ResetStatistics() {
+            m_statistics = StateCacheStatistics();
+        }
+
+        // For binds the owner filtered out before they reached the cache
+        void CountRedundantBind() {
+            ++m_statistics.redundantBinds;
+        }
+
+        Context& GetContext() {
+            return m_context;
+        }
+
+    private:
+        struct VertexBufferBinding {
+            bool operator==(const VertexBufferBinding& other) const {
+                return buffer == other.buffer && stride == other.stride && offset == other.offset;
+            }
+
+            Buffer* buffer;
+            uint32_t stride;
+            uint32_t offset;
+        };
+
+        struct IndexBufferBinding {
+            bool operator==(const IndexBufferBinding& other) const {
+                return buffer == other.buffer && format == other.format && offset == other.offset;
+            }
+
+            Buffer* buffer;
+            IndexFormat format;
+            uint32_t offset;
+        };
+
+        struct BlendStateBinding {
+            bool operator==(const BlendStateBinding& other) const {
+                return state == other.state && std::equal(factor, factor + 4, other.factor) && sampleMask == other.sampleMask;
+            }
+
+            BlendState* state;
+            float factor[4];
+            uint32_t sampleMask;
+        };
+
+        struct DepthStencilStateBinding {
+            bool operator==(const DepthStencilStateBinding& other) const {
+                return state == other.state && stencilRef == other.stencilRef;
+            }
+
+            DepthStencilState* state;
+            uint32_t stencilRef;
+        };
+
+        struct StageState {
+            CachedValue<Shader*> shader;
+            PendingSlots<ShaderResource*, Context::ShaderResourceSlotsCount> shaderResources;
+            PendingSlots<Sampler*, Context::SamplerSlotsCount> samplers;
+            PendingSlots<Buffer*, Context::ConstantBufferSlotsCount> constantBuffers;
+        };
+
+        static void ThrowIfOutOfRange(uint32_t startSlot, uint32_t count, size_t slotsCount) {
+            if (uint64_t(startSlot) + count > slotsCount) {
+                throw std::out_of_range("Slot index is out of range");
+            }
+        }
+
+        StageState& GetStage(uint32_t stage) {
+            if (stage >= Context::StagesCount) {
+                throw std::out_of_range("Not implemented for this shader type");
+            }
+            return m_stages[stage];
+        }
+
+        template<typename Slots, typename T>
+        void SetSlots(Slots& slots, uint32_t startSlot, uint32_t count, const T* values) {
+            ThrowIfOutOfRange(startSlot, count, Slots::SlotsCount);
+            for (uint32_t i = 0; i < count; ++i) {
+                if (!slots.Set(startSlot + i, values[i])) {
+                    ++m_statistics.redundantBinds;
+                }
+            }
+        }
+
+        template<typename Slots, typename F>
+        void FlushSlots(Slots& slots, F&& f) {
+            m_statistics.issuedBinds += slots.Flush(f);
+        }
+
+    private:
+        Context m_context;
+        std::array<StageState, Context::StagesCount> m_stages;
+        CachedValue<InputLayout*> m_inputLayout;
+        CachedValue<Topology> m_topology;
+        PendingSlots<VertexBufferBinding, Context::VertexBufferSlotsCount> m_vertexBuffers;
+        CachedValue<IndexBufferBinding> m_indexBuffer;
+        CachedValue<BlendStateBinding> m_blend;
+        CachedValue<DepthStencilStateBinding> m_depthStencil;
+        CachedValue<RasterizerState*> m_rasterizer;
+        StateCacheStatistics m_statistics;
+    };
+}
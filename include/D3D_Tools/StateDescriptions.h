@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include "d3d11.h"
+#include "Hash.h"
+
+namespace d3d_tools {
+    namespace state_details {
+        // Field-wise so that padding never takes part. Zero floats are normalized because 0.0f == -0.0f
+        inline void AddFloat(Hasher& hasher, float value) {
+            hasher.AddValue(value == 0.0f ? 0.0f : value);
+        }
+
+        inline void AddDescription(Hasher& hasher, const D3D11_SAMPLER_DESC& desc) {
+            hasher.AddValue(desc.Filter).AddValue(desc.AddressU).AddValue(desc.AddressV).AddValue(desc.AddressW);
+            AddFloat(hasher, desc.MipLODBias);
+            hasher.AddValue(desc.MaxAnisotropy).AddValue(desc.ComparisonFunc);
+            for (auto value : desc.BorderColor) {
+                AddFloat(hasher, value);
+            }
+            AddFloat(hasher, desc.MinLOD);
+            AddFloat(hasher, desc.MaxLOD);
+        }
+
+        inline bool AreEqual(const D3D11_SAMPLER_DESC& a, const D3D11_SAMPLER_DESC& b) {
+            return
+                a.Filter == b.Filter &&
+                a.AddressU == b.AddressU &&
+                a.AddressV == b.AddressV &&
+                a.AddressW == b.AddressW &&
+                a.MipLODBias == b.MipLODBias &&
+                a.MaxAnisotropy == b.MaxAnisotropy &&
+                a.ComparisonFunc == b.ComparisonFunc &&
+                std::equal(a.BorderColor, a.BorderColor + 4, b.BorderColor) &&
+                a.MinLOD == b.MinLOD &&
+                a.MaxLOD == b.MaxLOD;
+        }
+
+        // Render targets past the first are ignored by D3D when independent blend is off
+        inline UINT GetBlendTargetsCount(const D3D11_BLEND_DESC& desc) {
+            return desc.IndependentBlendEnable ? 8 : 1;
+        }
+
+        inline void AddDescription(Hasher& hasher, const D3D11_BLEND_DESC& desc) {
+            hasher.AddValue(desc.AlphaToCoverageEnable != FALSE).AddValue(desc.IndependentBlendEnable != FALSE);
+            for (UINT i = 0; i < GetBlendTargetsCount(desc); ++i) {
+                auto& target = desc.RenderTarget[i];
+                hasher.AddValue(target.BlendEnable != FALSE);
+                hasher.AddValue(target.SrcBlend).AddValue(target.DestBlend).AddValue(target.BlendOp);
+                hasher.AddValue(target.SrcBlendAlpha).AddValue(target.DestBlendAlpha).AddValue(target.BlendOpAlpha);
+                hasher.AddValue(target.RenderTargetWriteMask);
+            }
+        }
+
+        inline bool AreEqual(const D3D11_RENDER_TARGET_BLEND_DESC& a, const D3D11_RENDER_TARGET_BLEND_DESC& b) {
+            return
+                (a.BlendEnable != FALSE) == (b.BlendEnable != FALSE) &&
+                a.SrcBlend == b.SrcBlend &&
+                a.DestBlend == b.DestBlend &&
+                a.BlendOp == b.BlendOp &&
+                a.SrcBlendAlpha == b.SrcBlendAlpha &&
+                a.DestBlendAlpha == b.DestBlendAlpha &&
+                a.BlendOpAlpha == b.BlendOpAlpha &&
+                a.RenderTargetWriteMask == b.RenderTargetWriteMask;
+        }
+
+        inline bool AreEqual(const D3D11_BLEND_DESC& a, const D3D11_BLEND_DESC& b) {
+            if ((a.AlphaToCoverageEnable != FALSE) != (b.AlphaToCoverageEnable != FALSE) ||
+                (a.IndependentBlendEnable != FALSE) != (b.IndependentBlendEnable != FALSE)) {
+                return false;
+            }
+
+            for (UINT i = 0; i < GetBlendTargetsCount(a); ++i) {
+                if (!AreEqual(a.RenderTarget[i], b.RenderTarget[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        inline void AddDescription(Hasher& hasher, const D3D11_RASTERIZER_DESC& desc) {
+            hasher.AddValue(desc.FillMode).AddValue(desc.CullMode).AddValue(desc.FrontCounterClockwise != FALSE);
+            hasher.AddValue(desc.DepthBias);
+            AddFloat(hasher, desc.DepthBiasClamp);
+            AddFloat(hasher, desc.SlopeScaledDepthBias);
+            hasher.AddValue(desc.DepthClipEnable != FALSE).AddValue(desc.ScissorEnable != FALSE);
+            hasher.AddValue(desc.MultisampleEnable != FALSE).AddValue(desc.AntialiasedLineEnable != FALSE);
+        }
+
+        inline bool AreEqual(const D3D11_RASTERIZER_DESC& a, const D3D11_RASTERIZER_DESC& b) {
+            return
+                a.FillMode == b.FillMode &&
+                a.CullMode == b.CullMode &&
+                (a.FrontCounterClockwise != FALSE) == (b.FrontCounterClockwise != FALSE) &&
+                a.DepthBias == b.DepthBias &&
+                a.DepthBiasClamp == b.DepthBiasClamp &&
+                a.SlopeScaledDepthBias == b.SlopeScaledDepthBias &&
+                (a.DepthClipEnable != FALSE) == (b.DepthClipEnable != FALSE) &&
+                (a.ScissorEnable != FALSE) == (b.ScissorEnable != FALSE) &&
+                (a.MultisampleEnable != FALSE) == (b.MultisampleEnable != FALSE) &&
+                (a.AntialiasedLineEnable != FALSE) == (b.AntialiasedLineEnable != FALSE);
+        }
+
+        inline void AddDescription(Hasher& hasher, const D3D11_DEPTH_STENCILOP_DESC& desc) {
+            hasher.AddValue(desc.StencilFailOp).AddValue(desc.StencilDepthFailOp).AddValue(desc.StencilPassOp).AddValue(desc.StencilFunc);
+        }
+
+        inline bool AreEqual(const D3D11_DEPTH_STENCILOP_DESC& a, const D3D11_DEPTH_STENCILOP_DESC& b) {
+            return
+                a.StencilFailOp == b.StencilFailOp &&
+                a.StencilDepthFailOp == b.StencilDepthFailOp &&
+                a.StencilPassOp == b.StencilPassOp &&
+                a.StencilFunc == b.StencilFunc;
+        }
+
+        inline void AddDescription(Hasher& hasher, const D3D11_DEPTH_STENCIL_DESC& desc) {
+            hasher.AddValue(desc.DepthEnable != FALSE).AddValue(desc.DepthWriteMask).AddValue(desc.DepthFunc);
+            hasher.AddValue(desc.StencilEnable != FALSE).AddValue(desc.StencilReadMask).AddValue(desc.StencilWriteMask);
+            AddDescription(hasher, desc.FrontFace);
+            AddDescription(hasher, desc.BackFace);
+        }
+
+        inline bool AreEqual(const D3D11_DEPTH_STENCIL_DESC& a, const D3D11_DEPTH_STENCIL_DESC& b) {
+            return
+                (a.DepthEnable != FALSE) == (b.DepthEnable != FALSE) &&
+                a.DepthWriteMask == b.DepthWriteMask &&
+                a.DepthFunc == b.DepthFunc &&
+                (a.StencilEnable != FALSE) == (b.StencilEnable != FALSE) &&
+                a.StencilReadMask == b.StencilReadMask &&
+                a.StencilWriteMask == b.StencilWriteMask &&
+                AreEqual(a.FrontFace, b.FrontFace) &&
+                AreEqual(a.BackFace, b.BackFace);
+        }
+    }
+
+    // Defaults are the ones D3D11 uses when no state object is bound
+    inline D3D11_SAMPLER_DESC MakeDefaultSamplerDescription() {
+        D3D11_SAMPLER_DESC desc{};
+        desc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+        desc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+        desc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+        desc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+        desc.MipLODBias = 0.0f;
+        desc.MaxAnisotropy = 1;
+        desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+        for (auto& value : desc.BorderColor) {
+            value = 1.0f;
+        }
+        desc.MinLOD = -D3D11_FLOAT32_MAX;
+        desc.MaxLOD = D3D11_FLOAT32_MAX;
+        return desc;
+    }
+
+    inline D3D11_BLEND_DESC MakeDefaultBlendDescription() {
+        D3D11_BLEND_DESC desc{};
+        desc.AlphaToCoverageEnable = FALSE;
+        desc.IndependentBlendEnable = FALSE;
+        for (auto& target : desc.RenderTarget) {
+            target.BlendEnable = FALSE;
+            target.SrcBlend = D3D11_BLEND_ONE;
+            target.DestBlend = D3D11_BLEND_ZERO;
+            target.BlendOp = D3D11_BLEND_OP_ADD;
+            target.SrcBlendAlpha = D3D11_BLEND_ONE;
+            target.DestBlendAlpha = D3D11_BLEND_ZERO;
+            target.BlendOpAlpha = D3D11_BLEND_OP_ADD;
+            target.RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+        }
+        return desc;
+    }
+
+    inline D3D11_RASTERIZER_DESC MakeDefaultRasterizerDescription() {
+        D3D11_RASTERIZER_DESC desc{};
+        desc.FillMode = D3D11_FILL_SOLID;
+        desc.CullMode = D3D11_CULL_BACK;
+        desc.FrontCounterClockwise = FALSE;
+        desc.DepthBias = 0;
+        desc.DepthBiasClamp = 0.0f;
+        desc.SlopeScaledDepthBias = 0.0f;
+        desc.DepthClipEnable = TRUE;
+        desc.ScissorEnable = FALSE;
+        desc.MultisampleEnable = FALSE;
+        desc.AntialiasedLineEnable = FALSE;
+        return desc;
+    }
+
+    inline D3D11_DEPTH_STENCIL_DESC MakeDefaultDepthStencilDescription() {
+        D3D11_DEPTH_STENCIL_DESC desc{};
+        desc.DepthEnable = TRUE;
+        desc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+        desc.DepthFunc = D3D11_COMPARISON_LESS;
+        desc.StencilEnable = FALSE;
+        desc.StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK;
+        desc.StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK;
+        D3D11_DEPTH_STENCILOP_DESC face{ D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_ALWAYS };
+        desc.FrontFace = face;
+        desc.BackFace = face;
+        return desc;
+    }
+
+    // Hash and equality for D3D11 state descriptions. Two descriptions that D3D treats as the same state
+    // compare equal, e.g. blend targets past the first are ignored unless independent blend is on
+    struct StateDescriptionHash {
+        template<typename Description>
+        size_t operator()(const Description& desc) const {
+            Hasher hasher;
+            state_details::AddDescription(hasher, desc);
+            return static_cast<size_t>(hasher.GetValue());
+        }
+    };
+
+    struct StateDescriptionEqual {
+        template<typename Description>
+        bool operator()(const Description& a, const Description& b) const {
+            return state_details::AreEqual(a, b);
+        }
+    };
+}
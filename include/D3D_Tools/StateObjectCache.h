@@ -0,0 +1,104 @@
+#pragma once
+
+#include <unordered_map>
+#include "Device.h"
+#include "StateDescriptions.h"
+
+namespace d3d_tools {
+    struct StateObjectCounters {
+        // Requests that found an existing object: the duplicates that were not created
+        uint64_t GetHitsCount() const {
+            return requestsCount - createdCount;
+        }
+
+        uint64_t requestsCount = 0;
+        uint64_t createdCount = 0;
+    };
+
+    struct StateObjectCacheStatistics {
+        StateObjectCounters samplers;
+        StateObjectCounters blendStates;
+        StateObjectCounters rasterizerStates;
+        StateObjectCounters depthStencilStates;
+    };
+
+    namespace state_details {
+        // D3D11 fails to create more than 4096 unique objects of each state type per device
+        static constexpr size_t MaxUniqueObjectsCount = 4096;
+
+        template<typename Description, typename Interface, HRESULT (ID3D11Device::*create)(const Description*, Interface**)>
+        class StateObjectTable {
+        public:
+            Interface* GetOrCreate(ID3D11Device* device, const Description& description, StateObjectCounters& counters) {
+                ++counters.requestsCount;
+                auto it = m_objects.find(description);
+                if (it != m_objects.end()) {
+                    return it->second.Get();
+                }
+
+                edt::ThrowIfFailed(m_objects.size() < MaxUniqueObjectsCount, "Too many unique state objects of one type");
+                ComPtr<Interface> object;
+                WinAPI<char>::ThrowIfError((device->*create)(&description, object.Receive()));
+                ++counters.createdCount;
+                return m_objects.emplace(description, std::move(object)).first->second.Get();
+            }
+
+            size_t GetSize() const {
+                return m_objects.size();
+            }
+
+        private:
+            std::unordered_map<Description, ComPtr<Interface>, StateDescriptionHash, StateDescriptionEqual> m_objects;
+        };
+    }
+
+    // Creates every distinct sampler, blend, rasterizer and depth stencil state once.
+    // Objects live as long as the cache, so returned pointers may be kept. Not thread safe
+    class StateObjectCache {
+    public:
+        StateObjectCache(Device* device) :
+            m_device(device->GetDevice())
+        {
+        }
+
+        ID3D11SamplerState* GetSamplerState(const D3D11_SAMPLER_DESC& description) {
+            return CallAndRethrowM + [&] {
+                return m_samplers.GetOrCreate(m_device.Get(), description, m_statistics.samplers);
+            };
+        }
+
+        ID3D11BlendState* GetBlendState(const D3D11_BLEND_DESC& description) {
+            return CallAndRethrowM + [&] {
+                return m_blendStates.GetOrCreate(m_device.Get(), description, m_statistics.blendStates);
+            };
+        }
+
+        ID3D11RasterizerState* GetRasterizerState(const D3D11_RASTERIZER_DESC& description) {
+            return CallAndRethrowM + [&] {
+                return m_rasterizerStates.GetOrCreate(m_device.Get(), description, m_statistics.rasterizerStates);
+            };
+        }
+
+        ID3D11DepthStencilState* GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& description) {
+            return CallAndRethrowM + [&] {
+                return m_depthStencilStates.GetOrCreate(m_device.Get(), description, m_statistics.depthStencilStates);
+            };
+        }
+
+        size_t GetObjectsCount() const {
+            return m_samplers.GetSize() + m_blendStates.GetSize() + m_rasterizerStates.GetSize() + m_depthStencilStates.GetSize();
+        }
+
+        const StateObjectCacheStatistics& GetStatistics() const {
+            return m_statistics;
+        }
+
+    private:
+        ComPtr<ID3D11Device> m_device;
+        state_details::StateObjectTable<D3D11_SAMPLER_DESC, ID3D11SamplerState, &ID3D11Device::CreateSamplerState> m_samplers;
+        state_details::StateObjectTable<D3D11_BLEND_DESC, ID3D11BlendState, &ID3D11Device::CreateBlendState> m_blendStates;
+        state_details::StateObjectTable<D3D11_RASTERIZER_DESC, ID3D11RasterizerState, &ID3D11Device::CreateRasterizerState> m_rasterizerStates;
+        state_details::StateObjectTable<D3D11_DEPTH_STENCIL_DESC, ID3D11DepthStencilState, &ID3D11Device::CreateDepthStencilState> m_depthStencilStates;
+        StateObjectCacheStatistics m_statistics;
+    };
+}
@@ -1,10 +1,13 @@
 #pragma once
 
 #include "d3d11.h"
+#include "EverydayTools\Array\ArrayView.h"
 #include "EverydayTools\EnumFlag.h"
 #include "EverydayTools\Exception\CallAndRethrow.h"
+#include "EverydayTools\Exception\ThrowIfFailed.h"
 #include "WinWrappers\ComPtr.h"
 #include "WinWrappers\WinWrappers.h"
+#include "TextureFormat.h"
 
 namespace d3d_tools {
     enum class ResourceViewType {
@@ -14,14 +17,6 @@ namespace d3d_tools {
         RandomAccess
     };
     
-    enum class TextureFormat {
-        R8_G8_B8_A8_UNORM,
-        R24_G8_TYPELESS,
-        D24_UNORM_S8_UINT,
-        R24_UNORM_X8_TYPELESS,
-        R8_UNORM
-    };
-    
     enum class TextureFlags {
         None           = 0,
         RenderTarget   = (1 << 0),
@@ -40,6 +35,11 @@ namespace d3d_tools {
                 case TextureFormat::D24_UNORM_S8_UINT: return DXGI_FORMAT_D24_UNORM_S8_UINT;
                 case TextureFormat::R24_UNORM_X8_TYPELESS: return DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
                 case TextureFormat::R8_UNORM: return DXGI_FORMAT_R8_UNORM;
+                case TextureFormat::BC1_UNORM: return DXGI_FORMAT_BC1_UNORM;
+                case TextureFormat::BC3_UNORM: return DXGI_FORMAT_BC3_UNORM;
+                case TextureFormat::BC4_UNORM: return DXGI_FORMAT_BC4_UNORM;
+                case TextureFormat::BC5_UNORM: return DXGI_FORMAT_BC5_UNORM;
+                case TextureFormat::BC7_UNORM: return DXGI_FORMAT_BC7_UNORM;
                 default: throw std::runtime_error("This texture format is not implemented here");
                 }
             };
@@ -53,6 +53,11 @@ namespace d3d_tools {
                 case DXGI_FORMAT_D24_UNORM_S8_UINT: return TextureFormat::D24_UNORM_S8_UINT;
                 case DXGI_FORMAT_R24_UNORM_X8_TYPELESS: return TextureFormat::R24_UNORM_X8_TYPELESS;
                 case DXGI_FORMAT_R8_UNORM: return TextureFormat::R8_UNORM;
+                case DXGI_FORMAT_BC1_UNORM: return TextureFormat::BC1_UNORM;
+                case DXGI_FORMAT_BC3_UNORM: return TextureFormat::BC3_UNORM;
+                case DXGI_FORMAT_BC4_UNORM: return TextureFormat::BC4_UNORM;
+                case DXGI_FORMAT_BC5_UNORM: return TextureFormat::BC5_UNORM;
+                case DXGI_FORMAT_BC7_UNORM: return TextureFormat::BC7_UNORM;
                 default: throw std::runtime_error("This texture format is not implemented here");
                 }
             };
@@ -122,6 +127,13 @@ namespace d3d_tools {
             static decltype(auto) CreateDescription(TextureFormat format) {
                 return CreateBaseDescription(format);
             }
+
+            static void MakeArrayDescription(Description& desc, UINT arraySize) {
+                desc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
+                desc.Texture2DArray.MipSlice = 0;
+                desc.Texture2DArray.FirstArraySlice = 0;
+                desc.Texture2DArray.ArraySize = arraySize;
+            }
         };
         
         template<>
@@ -136,6 +148,13 @@ namespace d3d_tools {
             static decltype(auto) CreateDescription(TextureFormat format) {
                 return CreateBaseDescription(format);
             }
+
+            static void MakeArrayDescription(Description& desc, UINT arraySize) {
+                desc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+                desc.Texture2DArray.MipSlice = 0;
+                desc.Texture2DArray.FirstArraySlice = 0;
+                desc.Texture2DArray.ArraySize = arraySize;
+            }
         };
         
         template<>
@@ -153,6 +172,14 @@ namespace d3d_tools {
                 res.Texture2D.MostDetailedMip = 0;
                 return res;
             }
+
+            static void MakeArrayDescription(Description& desc, UINT arraySize) {
+                desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+                desc.Texture2DArray.MostDetailedMip = 0;
+                desc.Texture2DArray.MipLevels = (UINT)-1;
+                desc.Texture2DArray.FirstArraySlice = 0;
+                desc.Texture2DArray.ArraySize = arraySize;
+            }
         };
         
         template<>
@@ -167,6 +194,13 @@ namespace d3d_tools {
             static decltype(auto) CreateDescription(TextureFormat format) {
                 return CreateBaseDescription(format);
             }
+
+            static void MakeArrayDescription(Description& desc, UINT arraySize) {
+                desc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2DARRAY;
+                desc.Texture2DArray.MipSlice = 0;
+                desc.Texture2DArray.FirstArraySlice = 0;
+                desc.Texture2DArray.ArraySize = arraySize;
+            }
         };
         
         template<ResourceViewType type>
@@ -194,6 +228,11 @@ namespace d3d_tools {
         {
             CallAndRethrowM + [&] {
                 auto desc = Traits::CreateDescription(format);
+                D3D11_TEXTURE2D_DESC textureDesc{};
+                tex->GetDesc(&textureDesc);
+                if (textureDesc.ArraySize > 1) {
+                    Traits::MakeArrayDescription(desc, textureDesc.ArraySize);
+                }
                 m_view = Traits::MakeInstance(device, tex, &desc);
             };
         }
@@ -254,13 +293,18 @@ namespace d3d_tools {
             };
         }
     
-        static D3D11_TEXTURE2D_DESC MakeTextureDescription(uint32_t w, uint32_t h, TextureFormat format, TextureFlags flags) {
+        // mipLevels == 0 means the full chain
+        static D3D11_TEXTURE2D_DESC MakeTextureDescription(
+            uint32_t w, uint32_t h, TextureFormat format, TextureFlags flags,
+            uint32_t mipLevels = 1, uint32_t arraySize = 1)
+        {
             return CallAndRethrowM + [&] {
+                edt::ThrowIfFailed(arraySize > 0, "Texture array must have at least one slice");
                 D3D11_TEXTURE2D_DESC d{};
                 d.Width = w;
                 d.Height = h;
-                d.MipLevels = 1;
-                d.ArraySize = 1;
+                d.MipLevels = mipLevels == 0 ? ComputeMipLevelsCount(w, h) : mipLevels;
+                d.ArraySize = arraySize;
                 d.Format = texture_details::ConvertFormat(format);
                 d.SampleDesc.Count = 1;
                 d.Usage = D3D11_USAGE_DEFAULT;
@@ -269,6 +313,7 @@ namespace d3d_tools {
             };
         }
 
+        // Throws for block compressed formats: use ComputeRowPitch/ComputeSlicePitch for them
         static size_t ComputeBytesPerPixel(TextureFormat format) {
             return CallAndRethrowM + [&] {
                 switch (format) {
@@ -287,6 +332,11 @@ namespace d3d_tools {
                 throw std::exception("This format is not supported here");
             };
         }
+
+        // Same as D3D11CalcSubresource
+        static UINT ComputeSubresourceIndex(uint32_t mipLevel, uint32_t arraySlice, uint32_t mipLevels) {
+            return mipLevel + arraySlice * mipLevels;
+        }
     
         Texture(ID3D11Device* device, uint32_t w, uint32_t h, TextureFormat format, TextureFlags flags, void* initialData = nullptr) :
             m_format(format)
@@ -297,7 +347,7 @@ namespace d3d_tools {
                 if (initialData) {
                     D3D11_SUBRESOURCE_DATA subresource{};
                     subresource.pSysMem = initialData;
-					subresource.SysMemPitch = static_cast<UINT>(w * ComputeBytesPerPixel(format));
+					subresource.SysMemPitch = ComputeRowPitch(format, w);
                     hres = device->CreateTexture2D(&desc, &subresource, m_texture.Receive());
                 } else {
                     hres = device->CreateTexture2D(&desc, nullptr, m_texture.Receive());
@@ -306,6 +356,26 @@ namespace d3d_tools {
             };
         }
 
+        // Mip chain and/or texture array. initialData is either empty or holds mipLevels * arraySize
+        // subresources in D3D order: all mips of slice 0, then all mips of slice 1 and so on
+        Texture(
+            ID3D11Device* device, uint32_t w, uint32_t h, TextureFormat format, TextureFlags flags,
+            uint32_t mipLevels, uint32_t arraySize,
+            edt::DenseArrayView<const D3D11_SUBRESOURCE_DATA> initialData = edt::DenseArrayView<const D3D11_SUBRESOURCE_DATA>()) :
+            m_format(format)
+        {
+            CallAndRethrowM + [&] {
+                auto desc = MakeTextureDescription(w, h, format, flags, mipLevels, arraySize);
+                auto hasData = initialData.GetSize() > 0;
+                if (hasData) {
+                    edt::ThrowIfFailed(initialData.GetSize() == desc.MipLevels * desc.ArraySize,
+                        "Initial data must be provided for every subresource");
+                }
+                auto hres = device->CreateTexture2D(&desc, hasData ? initialData.GetData() : nullptr, m_texture.Receive());
+                WinAPI<char>::ThrowIfError(hres);
+            };
+        }
+
         Texture(ComPtr<ID3D11Texture2D> texure)
         {
             CallAndRethrowM + [&] {
@@ -319,7 +389,7 @@ namespace d3d_tools {
         template<ResourceViewType type>
         TextureView<type> MakeView(ID3D11Device* device, TextureFormat format) {
             return CallAndRethrowM + [&] {
-                return TextureView<type>(device, this, format);
+                return TextureView<type>(device, m_texture.Get(), format);
             };
         }
     
@@ -330,6 +400,20 @@ namespace d3d_tools {
         TextureFormat GetTextureFormat() const {
             return m_format;
         }
+
+        D3D11_TEXTURE2D_DESC GetDescription() const {
+            D3D11_TEXTURE2D_DESC desc{};
+            m_texture->GetDesc(&desc);
+            return desc;
+        }
+
+        uint32_t GetMipLevelsCount() const {
+            return GetDescription().MipLevels;
+        }
+
+        uint32_t GetArraySize() const {
+            return GetDescription().ArraySize;
+        }
     
     private:
         TextureFormat m_format;
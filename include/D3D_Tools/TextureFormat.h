@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+namespace d3d_tools {
+    enum class TextureFormat {
+        R8_G8_B8_A8_UNORM,
+        R24_G8_TYPELESS,
+        D24_UNORM_S8_UINT,
+        R24_UNORM_X8_TYPELESS,
+        R8_UNORM,
+        BC1_UNORM,
+        BC3_UNORM,
+        BC4_UNORM,
+        BC5_UNORM,
+        BC7_UNORM
+    };
+
+    inline bool IsBlockCompressed(TextureFormat format) {
+        switch (format) {
+        case TextureFormat::BC1_UNORM:
+        case TextureFormat::BC3_UNORM:
+        case TextureFormat::BC4_UNORM:
+        case TextureFormat::BC5_UNORM:
+        case TextureFormat::BC7_UNORM:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Width and height of the smallest addressable unit: 4 for BCn, 1 for everything else
+    inline uint32_t GetFormatBlockExtent(TextureFormat format) {
+        return IsBlockCompressed(format) ? 4 : 1;
+    }
+
+    // Bytes per block for BCn, bytes per pixel otherwise
+    inline uint32_t GetFormatBlockBytes(TextureFormat format) {
+        switch (format) {
+        case TextureFormat::R8_G8_B8_A8_UNORM:
+        case TextureFormat::R24_G8_TYPELESS:
+        case TextureFormat::D24_UNORM_S8_UINT:
+        case TextureFormat::R24_UNORM_X8_TYPELESS:
+            return 4;
+        case TextureFormat::R8_UNORM:
+            return 1;
+        case TextureFormat::BC1_UNORM:
+        case TextureFormat::BC4_UNORM:
+            return 8;
+        case TextureFormat::BC3_UNORM:
+        case TextureFormat::BC5_UNORM:
+        case TextureFormat::BC7_UNORM:
+            return 16;
+        default:
+            throw std::invalid_argument("This texture format is not implemented here");
+        }
+    }
+
+    // Rows of blocks in a subresource of the given height
+    inline uint32_t ComputeRowsCount(TextureFormat format, uint32_t height) {
+        auto extent = GetFormatBlockExtent(format);
+        return (height + extent - 1) / extent;
+    }
+
+    // Tightly packed pitches. Partial blocks at the edges of BCn textures take a whole block
+    inline uint32_t ComputeRowPitch(TextureFormat format, uint32_t width) {
+        auto extent = GetFormatBlockExtent(format);
+        return (width + extent - 1) / extent * GetFormatBlockBytes(format);
+    }
+
+    inline uint32_t ComputeSlicePitch(TextureFormat format, uint32_t width, uint32_t height) {
+        return ComputeRowPitch(format, width) * ComputeRowsCount(format, height);
+    }
+
+    // Levels count of the full mip chain down to 1x1
+    inline uint32_t ComputeMipLevelsCount(uint32_t width, uint32_t height) {
+        uint32_t result = 1;
+        auto size = std::max(width, height);
+        while (size > 1) {
+            size >>= 1;
+            ++result;
+        }
+        return result;
+    }
+
+    inline uint32_t ComputeMipExtent(uint32_t extent, uint32_t level) {
+        return std::max(1u, extent >> level);
+    }
+}
@@ -0,0 +1,359 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "TextureFormat.h"
+#include "ThreadPool.h"
+
+namespace d3d_tools {
+    // Reusable CPU memory for data that waits to be uploaded.
+    // The limit is soft: Acquire never blocks because loads run on ThreadPool, and a pool task that waits
+    // for memory may be executed inline by the very thread that has to release it. Instead the owner
+    // checks IsOverLimit before starting more work
+    class StagingBufferPool {
+    public:
+        class Buffer {
+        public:
+            Buffer() = default;
+
+            Buffer(Buffer&& other) noexcept {
+                *this = std::move(other);
+            }
+
+            Buffer& operator=(Buffer&& other) noexcept {
+                if (this != &other) {
+                    Return();
+                    m_pool = other.m_pool;
+                    m_storage = std::move(other.m_storage);
+                    m_size = other.m_size;
+                    other.m_pool = nullptr;
+                    other.m_size = 0;
+                }
+                return *this;
+            }
+
+            ~Buffer() {
+                Return();
+            }
+
+            uint8_t* GetData() {
+                return m_storage.data();
+            }
+
+            const uint8_t* GetData() const {
+                return m_storage.data();
+            }
+
+            size_t GetSize() const {
+                return m_size;
+            }
+
+        private:
+            friend class StagingBufferPool;
+
+            void Return() {
+                if (m_pool) {
+                    m_pool->Release(std::move(m_storage));
+                    m_pool = nullptr;
+                }
+            }
+
+            StagingBufferPool* m_pool = nullptr;
+            std::vector<uint8_t> m_storage;
+            size_t m_size = 0;
+        };
+
+        StagingBufferPool(size_t maxBytes) :
+            m_maxBytes(maxBytes)
+        {
+        }
+
+        Buffer Acquire(size_t size) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Buffer result;
+            result.m_pool = this;
+            result.m_size = size;
+
+            // Best fit among free buffers
+            auto best = m_free.end();
+            for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+                if (it->capacity() >= size && (best == m_free.end() || it->capacity() < best->capacity())) {
+                    best = it;
+                }
+            }
+
+            if (best != m_free.end()) {
+                result.m_storage = std::move(*best);
+                m_freeBytes -= result.m_storage.capacity();
+                m_free.erase(best);
+                ++m_reusesCount;
+            } else {
+                ++m_allocationsCount;
+            }
+
+            result.m_storage.resize(size);
+            m_outstandingBytes += result.m_storage.capacity();
+            return result;
+        }
+
+        bool IsOverLimit() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_outstandingBytes >= m_maxBytes;
+        }
+
+        size_t GetOutstandingBytes() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_outstandingBytes;
+        }
+
+        uint64_t GetAllocationsCount() const {
+            return m_allocationsCount;
+        }
+
+        uint64_t GetReusesCount() const {
+            return m_reusesCount;
+        }
+
+    private:
+        void Release(std::vector<uint8_t>&& storage) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto capacity = storage.capacity();
+            m_outstandingBytes -= capacity;
+            if (m_outstandingBytes + m_freeBytes + capacity <= m_maxBytes) {
+                m_freeBytes += capacity;
+                m_free.push_back(std::move(storage));
+            }
+        }
+
+    private:
+        size_t m_maxBytes;
+        size_t m_outstandingBytes = 0;
+        size_t m_freeBytes = 0;
+        std::atomic<uint64_t> m_allocationsCount{ 0 };
+        std::atomic<uint64_t> m_reusesCount{ 0 };
+        std::vector<std::vector<uint8_t>> m_free;
+        mutable std::mutex m_mutex;
+    };
+
+    struct StreamedSubresource {
+        size_t offset;
+        size_t size;
+        uint32_t rowPitch;
+        uint32_t slicePitch;
+    };
+
+    struct StreamedTextureDesc {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipLevels = 1;
+        uint32_t arraySize = 1;
+        TextureFormat format = TextureFormat::R8_G8_B8_A8_UNORM;
+    };
+
+    // Result of loading: texture description and all subresources (D3D order: mips of slice 0, mips of slice 1, ...)
+    struct StreamedTexture {
+        StreamedTextureDesc desc;
+        StagingBufferPool::Buffer pixels;
+        std::vector<StreamedSubresource> subresources;
+    };
+
+    // Receives uploads on the render thread. If BeginTexture, UploadSubresource or EndTexture throws,
+    // the texture is abandoned and reported to OnLoadFailed
+    class ITextureUploadSink {
+    public:
+        virtual ~ITextureUploadSink() = default;
+        virtual void BeginTexture(uint64_t id, const StreamedTextureDesc& desc) = 0;
+        virtual void UploadSubresource(uint64_t id, uint32_t subresource, const void* data, uint32_t rowPitch, uint32_t slicePitch) = 0;
+        virtual void EndTexture(uint64_t id) = 0;
+        virtual void OnLoadFailed(uint64_t id, std::exception_ptr error) = 0;
+    };
+
+    // Loads texture data on worker threads and uploads it on the render thread within per-frame byte budget.
+    // Requests wait in a queue and are started while staging memory is under the limit, at most one per
+    // worker thread at a time, so loaded but not yet uploaded data is bounded without blocking workers
+    class TextureStreamer {
+    public:
+        // Executed on a worker thread. Must acquire memory for pixels from the passed pool
+        using LoadFunction = std::function<StreamedTexture(StagingBufferPool&)>;
+
+        TextureStreamer(ThreadPool& threadPool, size_t stagingBytesLimit) :
+            m_threadPool(threadPool),
+            m_stagingPool(stagingBytesLimit)
+        {
+        }
+
+        ~TextureStreamer() {
+            // Loading tasks reference this object: wait for started ones, drop the rest
+            m_current.reset();
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_waiting.clear();
+            m_allLoaded.wait(lock, [&] { return m_loadingCount == 0; });
+            m_ready.clear();
+        }
+
+        uint64_t Request(LoadFunction load) {
+            uint64_t id;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                id = ++m_lastId;
+                m_waiting.push_back(WaitingItem{ id, std::move(load) });
+            }
+
+            StartLoads();
+            return id;
+        }
+
+        // Called on the render thread once per frame. Uploads subresources in request order until budget is spent.
+        // At least one subresource is uploaded per call so huge mips can not stall the queue forever.
+        // Returns uploaded bytes count
+        size_t Pump(ITextureUploadSink& sink, size_t budgetBytes) {
+            size_t uploaded = 0;
+            while (true) {
+                if (!m_current) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (m_ready.empty()) {
+                        break;
+                    }
+
+                    m_current = std::make_unique<LoadedItem>(std::move(m_ready.front()));
+                    m_ready.pop_front();
+                    m_nextSubresource = 0;
+                }
+
+                auto& item = *m_current;
+                if (item.error) {
+                    auto id = item.id;
+                    auto error = item.error;
+                    m_current.reset();
+                    sink.OnLoadFailed(id, error);
+                    continue;
+                }
+
+                try {
+                    if (UploadCurrent(sink, budgetBytes, uploaded)) {
+                        break;
+                    }
+                } catch (...) {
+                    // The item is dropped rather than retried next frame with the same result
+                    auto id = item.id;
+                    m_current.reset();
+                    sink.OnLoadFailed(id, std::current_exception());
+                }
+            }
+
+            m_lastPumpBytes = uploaded;
+            // Uploads have released staging memory
+            StartLoads();
+            return uploaded;
+        }
+
+        // Requests that are waiting, loading or waiting for upload
+        size_t GetPendingCount() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_waiting.size() + m_loadingCount + m_ready.size() + (m_current ? 1 : 0);
+        }
+
+        size_t GetLastPumpBytes() const {
+            return m_lastPumpBytes;
+        }
+
+        const StagingBufferPool& GetStagingPool() const {
+            return m_stagingPool;
+        }
+
+    private:
+        struct WaitingItem {
+            uint64_t id;
+            LoadFunction load;
+        };
+
+        struct LoadedItem {
+            uint64_t id = 0;
+            StreamedTexture texture;
+            std::exception_ptr error;
+            // BeginTexture has been called
+            bool begun = false;
+        };
+
+        // Returns true if the budget is spent before the current item is finished
+        bool UploadCurrent(ITextureUploadSink& sink, size_t budgetBytes, size_t& uploaded) {
+            auto& item = *m_current;
+            auto& texture = item.texture;
+            while (m_nextSubresource < texture.subresources.size()) {
+                auto& subresource = texture.subresources[m_nextSubresource];
+                if (uploaded > 0 && uploaded + subresource.size > budgetBytes) {
+                    return true;
+                }
+
+                if (!item.begun) {
+                    sink.BeginTexture(item.id, texture.desc);
+                    item.begun = true;
+                }
+
+                sink.UploadSubresource(item.id, static_cast<uint32_t>(m_nextSubresource),
+                    texture.pixels.GetData() + subresource.offset, subresource.rowPitch, subresource.slicePitch);
+                uploaded += subresource.size;
+                ++m_nextSubresource;
+            }
+
+            if (!item.begun) {
+                sink.BeginTexture(item.id, texture.desc);
+            }
+            sink.EndTexture(item.id);
+            // Returns pixels to the staging pool
+            m_current.reset();
+            return false;
+        }
+
+        // Called whenever staging memory or a worker may have become free
+        void StartLoads() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            StartLoadsLocked();
+        }
+
+        void StartLoadsLocked() {
+            while (!m_waiting.empty() && m_loadingCount < m_threadPool.GetThreadsCount() && !m_stagingPool.IsOverLimit()) {
+                auto waiting = std::move(m_waiting.front());
+                m_waiting.pop_front();
+                ++m_loadingCount;
+                m_threadPool.Submit([this, waiting = std::move(waiting)] {
+                    LoadedItem item;
+                    item.id = waiting.id;
+                    try {
+                        item.texture = waiting.load(m_stagingPool);
+                    } catch (...) {
+                        item.error = std::current_exception();
+                    }
+
+                    // This object must not be touched after the lock is released: the destructor may be waiting
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_ready.push_back(std::move(item));
+                    --m_loadingCount;
+                    StartLoadsLocked();
+                    m_allLoaded.notify_all();
+                });
+            }
+        }
+
+        ThreadPool& m_threadPool;
+        StagingBufferPool m_stagingPool;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_allLoaded;
+        std::deque<WaitingItem> m_waiting;
+        std::deque<LoadedItem> m_ready;
+        std::unique_ptr<LoadedItem> m_current;
+        size_t m_nextSubresource = 0;
+        size_t m_loadingCount = 0;
+        size_t m_lastPumpBytes = 0;
+        uint64_t m_lastId = 0;
+    };
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+#include "Device.h"
+#include "TextureStreaming.h"
+
+namespace d3d_tools {
+    // Creates textures for TextureStreamer and fills them with UpdateSubresource
+    class DeviceTextureUploadSink : public ITextureUploadSink {
+    public:
+        using TextureReadyCallback = std::function<void(uint64_t id, Texture texture)>;
+        using LoadFailedCallback = std::function<void(uint64_t id, std::exception_ptr error)>;
+
+        DeviceTextureUploadSink(
+            Device* device,
+            TextureReadyCallback onReady,
+            LoadFailedCallback onFailed = nullptr,
+            TextureFlags flags = TextureFlags::ShaderResource) :
+            m_device(device),
+            m_onReady(std::move(onReady)),
+            m_onFailed(std::move(onFailed)),
+            m_flags(flags)
+        {
+        }
+
+        virtual void BeginTexture(uint64_t id, const StreamedTextureDesc& desc) override {
+            CallAndRethrowM + [&] {
+                auto d = Texture::MakeTextureDescription(desc.width, desc.height, desc.format, m_flags, desc.mipLevels, desc.arraySize);
+
+                ComPtr<ID3D11Texture2D> texture;
+                WinAPI<char>::ThrowIfError(m_device->GetDevice()->CreateTexture2D(&d, nullptr, texture.Receive()));
+                m_inProgress[id] = std::move(texture);
+            };
+        }
+
+        virtual void UploadSubresource(uint64_t id, uint32_t subresource, const void* data, uint32_t rowPitch, uint32_t slicePitch) override {
+            CallAndRethrowM + [&] {
+                auto it = m_inProgress.find(id);
+                edt::ThrowIfFailed(it != m_inProgress.end(), "Texture upload has not been started");
+                m_device->GetContext()->UpdateSubresource(it->second.Get(), subresource, nullptr, data, rowPitch, slicePitch);
+            };
+        }
+
+        virtual void EndTexture(uint64_t id) override {
+            CallAndRethrowM + [&] {
+                auto it = m_inProgress.find(id);
+                edt::ThrowIfFailed(it != m_inProgress.end(), "Texture upload has not been started");
+                auto texture = std::move(it->second);
+                m_inProgress.erase(it);
+                m_onReady(id, Texture(std::move(texture)));
+            };
+        }
+
+        virtual void OnLoadFailed(uint64_t id, std::exception_ptr error) override {
+            // Upload may have failed half way
+            m_inProgress.erase(id);
+            if (m_onFailed) {
+                m_onFailed(id, error);
+            }
+        }
+
+    private:
+        Device* m_device;
+        TextureReadyCallback m_onReady;
+        LoadFailedCallback m_onFailed;
+        TextureFlags m_flags;
+        std::unordered_map<uint64_t, ComPtr<ID3D11Texture2D>> m_inProgress;
+    };
+}
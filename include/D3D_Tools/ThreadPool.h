@@ -0,0 +1,226 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace d3d_tools {
+    // Work-stealing pool: every worker owns a queue, takes tasks from its back
+    // and steals from the front of other queues when it runs out of work
+    class ThreadPool {
+    public:
+        explicit ThreadPool(size_t threadsCount = 0) {
+            if (threadsCount == 0) {
+                threadsCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+            }
+
+            m_queues.reserve(threadsCount);
+            for (size_t i = 0; i < threadsCount; ++i) {
+                m_queues.push_back(std::make_unique<WorkerQueue>());
+            }
+
+            m_threads.reserve(threadsCount);
+            for (size_t i = 0; i < threadsCount; ++i) {
+                m_threads.emplace_back([this, i] { WorkerLoop(i); });
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(m_sleepMutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (auto& thread : m_threads) {
+                thread.join();
+            }
+        }
+
+        template<typename F>
+        auto Submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+            using Result = std::invoke_result_t<std::decay_t<F>>;
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+            auto future = task->get_future();
+            Push([task] { (*task)(); });
+            return future;
+        }
+
+        // Calls f(begin, end) for chunks of [0, count) in parallel and waits for all of them.
+        // May be called from a worker thread: the caller executes pending tasks while waiting
+        template<typename F>
+        void ParallelFor(size_t count, size_t grain, F&& f) {
+            if (count == 0) {
+                return;
+            }
+
+            grain = std::max<size_t>(grain, 1);
+            std::vector<std::future<void>> futures;
+            futures.reserve(count / grain + 1);
+            for (size_t begin = grain; begin < count; begin += grain) {
+                auto end = std::min(begin + grain, count);
+                futures.push_back(Submit([&f, begin, end] { f(begin, end); }));
+            }
+
+            std::exception_ptr error;
+            try {
+                f(size_t(0), std::min(grain, count));
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            for (auto& future : futures) {
+                try {
+                    Wait(future);
+                } catch (...) {
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        // Waits for the future executing other tasks in the meantime
+        template<typename T>
+        T Wait(std::future<T>& future) {
+            while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                if (!RunPendingTask()) {
+                    std::this_thread::yield();
+                }
+            }
+            return future.get();
+        }
+
+        // Executes one queued task on the calling thread. Returns false if there was nothing to do
+        bool RunPendingTask() {
+            Task task;
+            auto index = GetCurrentWorkerIndex();
+            if (!TryPop(index, task) && !TrySteal(index, task)) {
+                return false;
+            }
+
+            task();
+            return true;
+        }
+
+        size_t GetThreadsCount() const {
+            return m_threads.size();
+        }
+
+    private:
+        using Task = std::function<void()>;
+
+        struct WorkerQueue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        struct WorkerIdentity {
+            const ThreadPool* pool = nullptr;
+            size_t index = 0;
+        };
+
+        static WorkerIdentity& GetWorkerIdentity() {
+            static thread_local WorkerIdentity identity;
+            return identity;
+        }
+
+        size_t GetCurrentWorkerIndex() {
+            auto& identity = GetWorkerIdentity();
+            if (identity.pool == this) {
+                return identity.index;
+            }
+
+            // External threads spread their tasks between queues
+            return m_nextQueue++ % m_queues.size();
+        }
+
+        void Push(Task task) {
+            {
+                // Counted before the task becomes visible so the counter never goes below zero
+                std::lock_guard<std::mutex> lock(m_sleepMutex);
+                ++m_pendingTasks;
+            }
+
+            auto& queue = *m_queues[GetCurrentWorkerIndex()];
+            {
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.tasks.push_back(std::move(task));
+            }
+            m_wake.notify_one();
+        }
+
+        bool TryPop(size_t index, Task& task) {
+            auto& queue = *m_queues[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                return false;
+            }
+
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            --m_pendingTasks;
+            return true;
+        }
+
+        bool TrySteal(size_t thief, Task& task) {
+            for (size_t i = 1; i < m_queues.size(); ++i) {
+                auto& queue = *m_queues[(thief + i) % m_queues.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (!queue.tasks.empty()) {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                    --m_pendingTasks;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void WorkerLoop(size_t index) {
+            auto& identity = GetWorkerIdentity();
+            identity.pool = this;
+            identity.index = index;
+
+            while (true) {
+                Task task;
+                if (TryPop(index, task) || TrySteal(index, task)) {
+                    task();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(m_sleepMutex);
+                m_wake.wait(lock, [&] { return m_stop || m_pendingTasks > 0; });
+                if (m_stop && m_pendingTasks == 0) {
+                    return;
+                }
+            }
+        }
+
+    private:
+        std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+        std::vector<std::thread> m_threads;
+        std::mutex m_sleepMutex;
+        std::condition_variable m_wake;
+        std::atomic<size_t> m_pendingTasks{ 0 };
+        std::atomic<size_t> m_nextQueue{ 0 };
+        bool m_stop = false;
+    };
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstring>
+#include <deque>
+#include <vector>
+#include "Device.h"
+#include "BufferMapper.h"
+#include "RingAllocator.h"
+
+namespace d3d_tools {
+    // One big dynamic buffer for per-frame data (vertices, instances, etc.).
+    // Allocations are written with MAP_WRITE_NO_OVERWRITE, the buffer is discarded only when the ring wraps.
+    // Dynamic constant buffers may be used here only if the driver supports no-overwrite maps for them
+    // and they are bound with *SetConstantBuffers1 (offset must be aligned to 256 bytes)
+    class TransientUploadBuffer {
+    public:
+        struct Allocation {
+            ID3D11Buffer* buffer;
+            uint32_t offset;
+        };
+
+        TransientUploadBuffer(Device* device, uint32_t capacity, UINT bindFlags = D3D11_BIND_VERTEX_BUFFER) :
+            m_allocator(capacity)
+        {
+            CallAndRethrowM + [&] {
+                D3D11_BUFFER_DESC desc{};
+                desc.Usage = D3D11_USAGE_DYNAMIC;
+                desc.ByteWidth = capacity;
+                desc.BindFlags = bindFlags;
+                desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+                m_buffer = device->CreateBuffer(desc);
+            };
+        }
+
+        template<typename T>
+        Allocation Upload(Device* device, edt::DenseArrayView<const T> elements, size_t alignment = alignof(T)) {
+            return Upload(device, elements.GetData(), elements.GetSize() * sizeof(T), alignment);
+        }
+
+        Allocation Upload(Device* device, const void* data, size_t size, size_t alignment = 16) {
+            return CallAndRethrowM + [&] {
+                auto allocation = m_allocator.Allocate(size, alignment);
+                if (!allocation.IsValid()) {
+                    // The whole ring is used by frames in flight. Discard renames the buffer
+                    // so it is safe to start from the beginning
+                    m_allocator.Reset();
+                    allocation = m_allocator.Allocate(size, alignment);
+                    allocation.wrapped = true;
+                    ++m_forcedDiscards;
+                }
+
+                auto mapType = allocation.wrapped || m_firstMap ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+                m_firstMap = false;
+                {
+                    BufferMapper<uint8_t> mapper(m_buffer, device->GetContext(), mapType);
+                    std::memcpy(mapper.GetDataPtr() + allocation.offset, data, size);
+                }
+
+                Allocation result;
+                result.buffer = m_buffer.Get();
+                result.offset = static_cast<uint32_t>(allocation.offset);
+                return result;
+            };
+        }
+
+        // Must be called once per frame after the last draw that uses data from this buffer
+        void EndFrame(Device* device) {
+            CallAndRethrowM + [&] {
+                ComPtr<ID3D11Query> query;
+                if (m_freeQueries.empty()) {
+                    D3D11_QUERY_DESC desc{};
+                    desc.Query = D3D11_QUERY_EVENT;
+                    WinAPI<char>::ThrowIfError(device->GetDevice()->CreateQuery(&desc, query.Receive()));
+                } else {
+                    query = m_freeQueries.back();
+                    m_freeQueries.pop_back();
+                }
+
+                device->GetContext()->End(query.Get());
+                auto fence = ++m_lastIssuedFence;
+                m_allocator.FinishFrame(fence);
+                m_pendingFrames.push_back(PendingFrame{ fence, query });
+                RetireCompletedFrames(device);
+            };
+        }
+
+        uint64_t GetForcedDiscardsCount() const {
+            return m_forcedDiscards;
+        }
+
+        const RingAllocator& GetAllocator() const {
+            return m_allocator;
+        }
+
+    private:
+        void RetireCompletedFrames(Device* device) {
+            auto context = device->GetContext();
+            uint64_t completedFence = 0;
+            while (!m_pendingFrames.empty()) {
+                auto& frame = m_pendingFrames.front();
+                BOOL done = FALSE;
+                auto hres = context->GetData(frame.query.Get(), &done, sizeof(done), D3D11_ASYNC_GETDATA_DONOTFLUSH);
+                if (hres != S_OK || !done) {
+                    break;
+                }
+
+                completedFence = frame.fence;
+                m_freeQueries.push_back(frame.query);
+                m_pendingFrames.pop_front();
+            }
+
+            if (completedFence != 0) {
+                m_allocator.Retire(completedFence);
+            }
+        }
+
+        struct PendingFrame {
+            uint64_t fence;
+            ComPtr<ID3D11Query> query;
+        };
+
+        bool m_firstMap = true;
+        uint64_t m_lastIssuedFence = 0;
+        uint64_t m_forcedDiscards = 0;
+        RingAllocator m_allocator;
+        ComPtr<ID3D11Buffer> m_buffer;
+        std::deque<PendingFrame> m_pendingFrames;
+        std::vector<ComPtr<ID3D11Query>> m_freeQueries;
+    };
+}
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace d3d_tools {
+    enum class VertexFormat : uint8_t {
+        Unknown,
+        R32_FLOAT,
+        R32_G32_FLOAT,
+        R32_G32_B32_FLOAT,
+        R32_G32_B32_A32_FLOAT,
+        R32_UINT,
+        R32_G32_UINT,
+        R32_G32_B32_UINT,
+        R32_G32_B32_A32_UINT,
+        R32_SINT,
+        R32_G32_SINT,
+        R32_G32_B32_SINT,
+        R32_G32_B32_A32_SINT,
+        R16_G16_FLOAT,
+        R16_G16_B16_A16_FLOAT,
+        R16_G16_UNORM,
+        R16_G16_B16_A16_UNORM,
+        R16_G16_SNORM,
+        R16_G16_B16_A16_SNORM,
+        R16_G16_UINT,
+        R16_G16_B16_A16_UINT,
+        R16_G16_SINT,
+        R16_G16_B16_A16_SINT,
+        R8_G8_B8_A8_UNORM,
+        R8_G8_B8_A8_SNORM,
+        R8_G8_B8_A8_UINT,
+        R10_G10_B10_A2_UNORM
+    };
+
+    constexpr uint32_t GetVertexFormatSize(VertexFormat format) {
+        switch (format) {
+        case VertexFormat::R32_FLOAT:
+        case VertexFormat::R32_UINT:
+        case VertexFormat::R32_SINT:
+        case VertexFormat::R16_G16_FLOAT:
+        case VertexFormat::R16_G16_UNORM:
+        case VertexFormat::R16_G16_SNORM:
+        case VertexFormat::R16_G16_UINT:
+        case VertexFormat::R16_G16_SINT:
+        case VertexFormat::R8_G8_B8_A8_UNORM:
+        case VertexFormat::R8_G8_B8_A8_SNORM:
+        case VertexFormat::R8_G8_B8_A8_UINT:
+        case VertexFormat::R10_G10_B10_A2_UNORM:
+            return 4;
+        case VertexFormat::R32_G32_FLOAT:
+        case VertexFormat::R32_G32_UINT:
+        case VertexFormat::R32_G32_SINT:
+        case VertexFormat::R16_G16_B16_A16_FLOAT:
+        case VertexFormat::R16_G16_B16_A16_UNORM:
+        case VertexFormat::R16_G16_B16_A16_SNORM:
+        case VertexFormat::R16_G16_B16_A16_UINT:
+        case VertexFormat::R16_G16_B16_A16_SINT:
+            return 8;
+        case VertexFormat::R32_G32_B32_FLOAT:
+        case VertexFormat::R32_G32_B32_UINT:
+        case VertexFormat::R32_G32_B32_SINT:
+            return 12;
+        case VertexFormat::R32_G32_B32_A32_FLOAT:
+        case VertexFormat::R32_G32_B32_A32_UINT:
+        case VertexFormat::R32_G32_B32_A32_SINT:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+
+    // Format a vertex struct member gets when the layout does not name one.
+    // Specialize for math library types, e.g. VertexFormatOf<Vector3> : VertexFormatOf<float[3]>
+    template<typename T>
+    struct VertexFormatOf {
+        static constexpr VertexFormat value = VertexFormat::Unknown;
+    };
+
+    namespace vertex_layout_details {
+        template<typename Component>
+        struct ComponentFormats {
+            static constexpr VertexFormat formats[5] = {};
+        };
+
+        template<>
+        struct ComponentFormats<float> {
+            static constexpr VertexFormat formats[5] = { VertexFormat::Unknown,
+                VertexFormat::R32_FLOAT, VertexFormat::R32_G32_FLOAT, VertexFormat::R32_G32_B32_FLOAT, VertexFormat::R32_G32_B32_A32_FLOAT };
+        };
+
+        template<>
+        struct ComponentFormats<uint32_t> {
+            static constexpr VertexFormat formats[5] = { VertexFormat::Unknown,
+                VertexFormat::R32_UINT, VertexFormat::R32_G32_UINT, VertexFormat::R32_G32_B32_UINT, VertexFormat::R32_G32_B32_A32_UINT };
+        };
+
+        template<>
+        struct ComponentFormats<int32_t> {
+            static constexpr VertexFormat formats[5] = { VertexFormat::Unknown,
+                VertexFormat::R32_SINT, VertexFormat::R32_G32_SINT, VertexFormat::R32_G32_B32_SINT, VertexFormat::R32_G32_B32_A32_SINT };
+        };
+
+        // 8 and 16 bit integers have no three component formats
+        template<>
+        struct ComponentFormats<uint16_t> {
+            static constexpr VertexFormat formats[5] = { VertexFormat::Unknown,
+                VertexFormat::Unknown, VertexFormat::R16_G16_UINT, VertexFormat::Unknown, VertexFormat::R16_G16_B16_A16_UINT };
+        };
+
+        template<>
+        struct ComponentFormats<int16_t> {
+            static constexpr VertexFormat formats[5] = { VertexFormat::Unknown,
+                VertexFormat::Unknown, VertexFormat::R16_G16_SINT, VertexFormat::Unknown, VertexFormat::R16_G16_B16_A16_SINT };
+        };
+
+        template<>
+        struct ComponentFormats<uint8_t> {
+            static constexpr VertexFormat formats[5] = { VertexFormat::Unknown,
+                VertexFormat::Unknown, VertexFormat::Unknown, VertexFormat::Unknown, VertexFormat::R8_G8_B8_A8_UINT };
+        };
+    }
+
+    template<>
+    struct VertexFormatOf<float> {
+        static constexpr VertexFormat value = VertexFormat::R32_FLOAT;
+    };
+
+    template<>
+    struct VertexFormatOf<uint32_t> {
+        static constexpr VertexFormat value = VertexFormat::R32_UINT;
+    };
+
+    template<>
+    struct VertexFormatOf<int32_t> {
+        static constexpr VertexFormat value = VertexFormat::R32_SINT;
+    };
+
+    template<typename Component, size_t count>
+    struct VertexFormatOf<Component[count]> {
+        static constexpr VertexFormat value = count <= 4 ?
+            vertex_layout_details::ComponentFormats<Component>::formats[count <= 4 ? count : 0] :
+            VertexFormat::Unknown;
+    };
+
+    template<typename Component, size_t count>
+    struct VertexFormatOf<std::array<Component, count>> : VertexFormatOf<Component[count]> {
+    };
+
+    struct VertexElement {
+        std::string_view semantic;
+        uint32_t semanticIndex;
+        VertexFormat format;
+        uint32_t offset;
+        // sizeof the struct member
+        uint32_t size;
+    };
+
+    template<size_t elementsCount>
+    struct VertexLayout {
+        static constexpr size_t ElementsCount = elementsCount;
+
+        std::array<VertexElement, elementsCount> elements;
+        uint32_t stride;
+    };
+
+    template<typename Vertex>
+    struct VertexLayoutTag {
+    };
+
+    template<typename Vertex, typename... Elements>
+    constexpr VertexLayout<sizeof...(Elements)> BuildVertexLayout(Elements... elements) {
+        return VertexLayout<sizeof...(Elements)>{ { { elements... } }, static_cast<uint32_t>(sizeof(Vertex)) };
+    }
+
+    // Compile time checks of a layout against its struct. Each returns true when the layout is fine
+    namespace vertex_layout_details {
+        template<size_t count>
+        constexpr bool HasKnownFormats(const VertexLayout<count>& layout) {
+            for (auto& element : layout.elements) {
+                if (element.format == VertexFormat::Unknown) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template<size_t count>
+        constexpr bool FormatsMatchMembers(const VertexLayout<count>& layout) {
+            for (auto& element : layout.elements) {
+                if (GetVertexFormatSize(element.format) != element.size) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template<size_t count>
+        constexpr bool HasNoOverlaps(const VertexLayout<count>& layout) {
+            for (size_t i = 0; i < count; ++i) {
+                auto& a = layout.elements[i];
+                if (a.offset + a.size > layout.stride) {
+                    return false;
+                }
+                for (size_t j = i + 1; j < count; ++j) {
+                    auto& b = layout.elements[j];
+                    if (a.offset < b.offset + b.size && b.offset < a.offset + a.size) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        // Every byte of the vertex is described: a forgotten member or hidden padding breaks this
+        template<size_t count>
+        constexpr bool CoversVertex(const VertexLayout<count>& layout) {
+            uint32_t size = 0;
+            for (auto& element : layout.elements) {
+                size += element.size;
+            }
+            return size == layout.stride;
+        }
+
+        template<size_t count>
+        constexpr bool HasUniqueSemantics(const VertexLayout<count>& layout) {
+            for (size_t i = 0; i < count; ++i) {
+                for (size_t j = i + 1; j < count; ++j) {
+                    auto& a = layout.elements[i];
+                    auto& b = layout.elements[j];
+                    if (a.semanticIndex == b.semanticIndex && a.semantic == b.semantic) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    }
+
+    // Layout of a vertex struct declared with D3D_TOOLS_VERTEX_LAYOUT. Found by argument dependent lookup,
+    // so the struct may live in any namespace
+    template<typename Vertex>
+    constexpr auto GetVertexLayoutOf() {
+        return GetVertexLayout(VertexLayoutTag<Vertex>{});
+    }
+
+    template<typename Vertex>
+    inline constexpr auto VertexLayoutOf = GetVertexLayoutOf<Vertex>();
+}
+
+// Member with the format deduced from its type
+#define D3D_TOOLS_VERTEX_ELEMENT(Vertex, member, semantic, semanticIndex) \
+    ::d3d_tools::VertexElement{ semantic, semanticIndex, \
+        ::d3d_tools::VertexFormatOf<decltype(Vertex::member)>::value, \
+        static_cast<uint32_t>(offsetof(Vertex, member)), static_cast<uint32_t>(sizeof(Vertex::member)) }
+
+// Member with an explicit format, e.g. uint8_t[4] read as R8_G8_B8_A8_UNORM
+#define D3D_TOOLS_VERTEX_ELEMENT_AS(Vertex, member, semantic, semanticIndex, vertexFormat) \
+    ::d3d_tools::VertexElement{ semantic, semanticIndex, ::d3d_tools::VertexFormat::vertexFormat, \
+        static_cast<uint32_t>(offsetof(Vertex, member)), static_cast<uint32_t>(sizeof(Vertex::member)) }
+
+// Declares the layout of a standard layout vertex struct. Must be used in the namespace of the struct:
+//     D3D_TOOLS_VERTEX_LAYOUT(Vertex,
+//         D3D_TOOLS_VERTEX_ELEMENT(Vertex, position, "POSITION", 0),
+//         D3D_TOOLS_VERTEX_ELEMENT_AS(Vertex, color, "COLOR", 0, R8_G8_B8_A8_UNORM));
+#define D3D_TOOLS_VERTEX_LAYOUT(Vertex, ...) \
+    constexpr auto GetVertexLayout(::d3d_tools::VertexLayoutTag<Vertex>) { \
+        static_assert(std::is_standard_layout_v<Vertex>, #Vertex " must be a standard layout type"); \
+        return ::d3d_tools::BuildVertexLayout<Vertex>(__VA_ARGS__); \
+    } \
+    static_assert(::d3d_tools::vertex_layout_details::HasKnownFormats(GetVertexLayout(::d3d_tools::VertexLayoutTag<Vertex>{})), \
+        #Vertex ": format of a member can not be deduced, use D3D_TOOLS_VERTEX_ELEMENT_AS"); \
+    static_assert(::d3d_tools::vertex_layout_details::FormatsMatchMembers(GetVertexLayout(::d3d_tools::VertexLayoutTag<Vertex>{})), \
+        #Vertex ": format size differs from member size"); \
+    static_assert(::d3d_tools::vertex_layout_details::HasNoOverlaps(GetVertexLayout(::d3d_tools::VertexLayoutTag<Vertex>{})), \
+        #Vertex ": elements overlap"); \
+    static_assert(::d3d_tools::vertex_layout_details::CoversVertex(GetVertexLayout(::d3d_tools::VertexLayoutTag<Vertex>{})), \
+        #Vertex ": layout does not describe every member of the vertex"); \
+    static_assert(::d3d_tools::vertex_layout_details::HasUniqueSemantics(GetVertexLayout(::d3d_tools::VertexLayoutTag<Vertex>{})), \
+        #Vertex ": semantic is used twice")
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "VertexLayout.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define D3D_TOOLS_VERTEX_QUANTIZATION_SSE2
+#endif
+
+// Hardware half conversion. GCC and Clang enable F16C separately from AVX2 (-mf16c or -march),
+// MSVC has no F16C switch and every /arch:AVX2 CPU has it
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#include <immintrin.h>
+#define D3D_TOOLS_VERTEX_QUANTIZATION_F16C
+#endif
+
+namespace d3d_tools {
+    // Scalar conversions. Rounding is to nearest even, the same as the SIMD kernels produce
+    namespace quantization {
+        inline uint16_t FloatToHalf(float value) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            uint32_t sign = (bits >> 16) & 0x8000;
+            uint32_t exponent = (bits >> 23) & 0xff;
+            uint32_t mantissa = bits & 0x7fffff;
+
+            if (exponent == 0xff) {
+                // Infinity stays infinity, NaN stays quiet NaN
+                return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+            }
+
+            int32_t halfExponent = static_cast<int32_t>(exponent) - 127 + 15;
+            if (halfExponent >= 31) {
+                return static_cast<uint16_t>(sign | 0x7c00);
+            }
+
+            if (halfExponent <= 0) {
+                // Denormal half or zero
+                if (halfExponent < -10) {
+                    return static_cast<uint16_t>(sign);
+                }
+                mantissa |= 0x800000;
+                uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+                uint32_t result = mantissa >> shift;
+                uint32_t rest = mantissa & ((1u << shift) - 1);
+                uint32_t halfway = 1u << (shift - 1);
+                if (rest > halfway || (rest == halfway && (result & 1))) {
+                    ++result;
+                }
+                return static_cast<uint16_t>(sign | result);
+            }
+
+            // Carry from rounding moves into the exponent, up to infinity
+            uint32_t result = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+            uint32_t rest = mantissa & 0x1fff;
+            if (rest > 0x1000 || (rest == 0x1000 && (result & 1))) {
+                ++result;
+            }
+            return static_cast<uint16_t>(sign | result);
+        }
+
+        inline float HalfToFloat(uint16_t value) {
+            uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+            uint32_t exponent = (value >> 10) & 0x1f;
+            uint32_t mantissa = value & 0x3ff;
+
+            uint32_t bits;
+            if (exponent == 0x1f) {
+                bits = sign | 0x7f800000 | (mantissa << 13);
+            }
+            else if (exponent != 0) {
+                bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+            }
+            else if (mantissa == 0) {
+                bits = sign;
+            }
+            else {
+                // Denormal half is a normal float
+                exponent = 127 - 15 + 1;
+                while ((mantissa & 0x400) == 0) {
+                    mantissa <<= 1;
+                    --exponent;
+                }
+                bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+            }
+
+            float result;
+            std::memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+
+        inline int16_t FloatToSnorm16(float value) {
+            return static_cast<int16_t>(std::lrintf(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+        }
+
+        inline float Snorm16ToFloat(int16_t value) {
+            // Both -32768 and -32767 mean -1
+            return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+        }
+
+        // Components in [-1, 1] are stored biased to [0, 1]; the shader restores them with v * 2 - 1.
+        // Alpha keeps the sign of w, e.g. tangent handedness
+        inline uint32_t EncodeR10G10B10A2(float x, float y, float z, float w) {
+            auto encode = [](float value, float scale) {
+                return static_cast<uint32_t>(std::lrintf(std::clamp(value * 0.5f + 0.5f, 0.0f, 1.0f) * scale));
+            };
+            return encode(x, 1023.0f) | (encode(y, 1023.0f) << 10) | (encode(z, 1023.0f) << 20) | (encode(w, 3.0f) << 30);
+        }
+
+        inline void DecodeR10G10B10A2(uint32_t packed, float* result) {
+            result[0] = static_cast<float>(packed & 0x3ff) / 1023.0f * 2.0f - 1.0f;
+            result[1] = static_cast<float>((packed >> 10) & 0x3ff) / 1023.0f * 2.0f - 1.0f;
+            result[2] = static_cast<float>((packed >> 20) & 0x3ff) / 1023.0f * 2.0f - 1.0f;
+            result[3] = static_cast<float>(packed >> 30) / 3.0f * 2.0f - 1.0f;
+        }
+
+        // Unit vector projected onto an octahedron and unfolded into [-1, 1]^2
+        inline void EncodeOctahedral(float x, float y, float z, float& u, float& v) {
+            auto length = std::abs(x) + std::abs(y) + std::abs(z);
+            auto inverseLength = length > 0.0f ? 1.0f / length : 0.0f;
+            u = x * inverseLength;
+            v = y * inverseLength;
+            if (z < 0.0f) {
+                auto foldedU = (1.0f - std::abs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+                auto foldedV = (1.0f - std::abs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+                u = foldedU;
+                v = foldedV;
+            }
+        }
+
+        // Same as the shader has to do. Result is normalized
+        inline void DecodeOctahedral(float u, float v, float* result) {
+            auto z = 1.0f - std::abs(u) - std::abs(v);
+            if (z < 0.0f) {
+                auto unfoldedU = (1.0f - std::abs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+                auto unfoldedV = (1.0f - std::abs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+                u = unfoldedU;
+                v = unfoldedV;
+            }
+            auto inverseLength = 1.0f / std::sqrt(u * u + v * v + z * z);
+            result[0] = u * inverseLength;
+            result[1] = v * inverseLength;
+            result[2] = z * inverseLength;
+        }
+    }
+
+    // Bulk kernels. Sources are arrays of vectors with `components` floats each
+    namespace quantization {
+        inline void EncodeHalfs(const float* source, uint16_t* result, size_t count) {
+            size_t i = 0;
+#ifdef D3D_TOOLS_VERTEX_QUANTIZATION_F16C
+            for (; i + 8 <= count; i += 8) {
+                auto halfs = _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), halfs);
+            }
+#endif
+            for (; i < count; ++i) {
+                result[i] = FloatToHalf(source[i]);
+            }
+        }
+
+        inline void EncodeSnorm16(const float* source, int16_t* result, size_t count) {
+            size_t i = 0;
+#ifdef D3D_TOOLS_VERTEX_QUANTIZATION_SSE2
+            const auto minusOne = _mm_set1_ps(-1.0f);
+            const auto one = _mm_set1_ps(1.0f);
+            const auto scale = _mm_set1_ps(32767.0f);
+            for (; i + 8 <= count; i += 8) {
+                auto lo = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i), minusOne), one), scale);
+                auto hi = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i + 4), minusOne), one), scale);
+                auto packed = _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), packed);
+            }
+#endif
+            for (; i < count; ++i) {
+                result[i] = FloatToSnorm16(source[i]);
+            }
+        }
+
+        // components is 3 or 4; missing w is 1
+        inline void EncodeR10G10B10A2(const float* source, uint32_t components, uint32_t* result, size_t count) {
+            size_t i = 0;
+#ifdef D3D_TOOLS_VERTEX_QUANTIZATION_SSE2
+            // Four vectors at a time, one component per register
+            const auto half = _mm_set1_ps(0.5f);
+            const auto zero = _mm_setzero_ps();
+            const auto one = _mm_set1_ps(1.0f);
+            auto encode = [&](__m128 value, float scale) {
+                auto biased = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(value, half), half), zero), one);
+                return _mm_cvtps_epi32(_mm_mul_ps(biased, _mm_set1_ps(scale)));
+            };
+            for (; i + 4 <= count; i += 4) {
+                auto v = source + i * components;
+                auto x = _mm_setr_ps(v[0], v[components], v[2 * components], v[3 * components]);
+                auto y = _mm_setr_ps(v[1], v[components + 1], v[2 * components + 1], v[3 * components + 1]);
+                auto z = _mm_setr_ps(v[2], v[components + 2], v[2 * components + 2], v[3 * components + 2]);
+                auto w = components == 4 ? _mm_setr_ps(v[3], v[7], v[11], v[15]) : one;
+                auto packed = _mm_or_si128(
+                    _mm_or_si128(encode(x, 1023.0f), _mm_slli_epi32(encode(y, 1023.0f), 10)),
+                    _mm_or_si128(_mm_slli_epi32(encode(z, 1023.0f), 20), _mm_slli_epi32(encode(w, 3.0f), 30)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), packed);
+            }
+#endif
+            for (; i < count; ++i) {
+                auto v = source + i * components;
+                result[i] = EncodeR10G10B10A2(v[0], v[1], v[2], components == 4 ? v[3] : 1.0f);
+            }
+        }
+
+        // Two snorm16 per normal. Source has `components` floats per normal, first three are used
+        inline void EncodeOctahedralSnorm16(const float* source, uint32_t components, int16_t* result, size_t count) {
+            size_t i = 0;
+#ifdef D3D_TOOLS_VERTEX_QUANTIZATION_SSE2
+            const auto signMask = _mm_set1_ps(-0.0f);
+            const auto zero = _mm_setzero_ps();
+            const auto one = _mm_set1_ps(1.0f);
+            const auto minusOne = _mm_set1_ps(-1.0f);
+            const auto scale = _mm_set1_ps(32767.0f);
+            auto abs = [&](__m128 value) { return _mm_andnot_ps(signMask, value); };
+            // +1 for non-negative lanes, -1 for negative ones
+            auto sign = [&](__m128 value) { return _mm_or_ps(one, _mm_and_ps(_mm_cmplt_ps(value, zero), signMask)); };
+            auto select = [](__m128 mask, __m128 a, __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); };
+            for (; i + 4 <= count; i += 4) {
+                auto n = source + i * components;
+                auto x = _mm_setr_ps(n[0], n[components], n[2 * components], n[3 * components]);
+                auto y = _mm_setr_ps(n[1], n[components + 1], n[2 * components + 1], n[3 * components + 1]);
+                auto z = _mm_setr_ps(n[2], n[components + 2], n[2 * components + 2], n[3 * components + 2]);
+
+                auto length = _mm_add_ps(_mm_add_ps(abs(x), abs(y)), abs(z));
+                auto nonZero = _mm_cmpgt_ps(length, zero);
+                auto inverseLength = _mm_and_ps(nonZero, _mm_div_ps(one, select(nonZero, length, one)));
+                auto u = _mm_mul_ps(x, inverseLength);
+                auto v = _mm_mul_ps(y, inverseLength);
+
+                auto lowerHalf = _mm_cmplt_ps(z, zero);
+                auto foldedU = _mm_mul_ps(_mm_sub_ps(one, abs(v)), sign(u));
+                auto foldedV = _mm_mul_ps(_mm_sub_ps(one, abs(u)), sign(v));
+                u = select(lowerHalf, foldedU, u);
+                v = select(lowerHalf, foldedV, v);
+
+                auto encodedU = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(u, minusOne), one), scale));
+                auto encodedV = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(v, minusOne), one), scale));
+                // u0 v0 u1 v1 ...
+                auto packedU = _mm_packs_epi32(encodedU, encodedU);
+                auto packedV = _mm_packs_epi32(encodedV, encodedV);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(result + i * 2), _mm_unpacklo_epi16(packedU, packedV));
+            }
+#endif
+            for (; i < count; ++i) {
+                auto n = source + i * components;
+                float u, v;
+                EncodeOctahedral(n[0], n[1], n[2], u, v);
+                result[i * 2] = FloatToSnorm16(u);
+                result[i * 2 + 1] = FloatToSnorm16(v);
+            }
+        }
+    }
+
+    enum class VertexEncoding : uint8_t {
+        // As is: R32 formats with 1-4 components
+        Float32,
+        // 2 components: R16_G16_FLOAT; 3-4 components: R16_G16_B16_A16_FLOAT, missing w is 1
+        Half,
+        // Values in [-1, 1]. 2 components: R16_G16_SNORM; 3-4 components: R16_G16_B16_A16_SNORM
+        Snorm16,
+        // Values in [-1, 1], biased to unorm. 3-4 components, w keeps its sign only
+        R10G10B10A2,
+        // Unit vectors as R16_G16_SNORM. 3 or more components, only xyz are used
+        OctahedralSnorm16
+    };
+
+    namespace quantization {
+        inline VertexFormat GetEncodedFormat(VertexEncoding encoding, uint32_t components) {
+            switch (encoding) {
+            case VertexEncoding::Float32:
+                switch (components) {
+                case 1: return VertexFormat::R32_FLOAT;
+                case 2: return VertexFormat::R32_G32_FLOAT;
+                case 3: return VertexFormat::R32_G32_B32_FLOAT;
+                case 4: return VertexFormat::R32_G32_B32_A32_FLOAT;
+                }
+                break;
+            case VertexEncoding::Half:
+                if (components == 2) return VertexFormat::R16_G16_FLOAT;
+                if (components == 3 || components == 4) return VertexFormat::R16_G16_B16_A16_FLOAT;
+                break;
+            case VertexEncoding::Snorm16:
+                if (components == 2) return VertexFormat::R16_G16_SNORM;
+                if (components == 3 || components == 4) return VertexFormat::R16_G16_B16_A16_SNORM;
+                break;
+            case VertexEncoding::R10G10B10A2:
+                if (components == 3 || components == 4) return VertexFormat::R10_G10_B10_A2_UNORM;
+                break;
+            case VertexEncoding::OctahedralSnorm16:
+                if (components >= 3 && components <= 4) return VertexFormat::R16_G16_SNORM;
+                break;
+            }
+            throw std::invalid_argument("Vertex encoding does not support this number of components");
+        }
+
+        // Copies vectors into `outComponents` wide ones, filling missing components with `fill`
+        inline std::vector<float> Widen(const float* source, uint32_t components, uint32_t outComponents, size_t count, float fill) {
+            std::vector<float> result(count * outComponents, fill);
+            for (size_t i = 0; i < count; ++i) {
+                std::copy(source + i * components, source + i * components + std::min(components, outComponents), result.data() + i * outComponents);
+            }
+            return result;
+        }
+    }
+
+    // Interleaves float vertex attributes into one stream, compressing each with its own encoding.
+    // Typical choice: Half positions and UVs, octahedral normals, R10G10B10A2 tangents, which takes
+    // a 48-byte float vertex down to 20 bytes
+    class QuantizedVertexStreamBuilder {
+    public:
+        explicit QuantizedVertexStreamBuilder(size_t vertexCount) :
+            m_vertexCount(vertexCount)
+        {
+        }
+
+        // Data is not copied: it must live until Build. components is the number of floats per vertex
+        void AddAttribute(std::string semantic, uint32_t semanticIndex, const float* data, uint32_t components, VertexEncoding encoding) {
+            Attribute attribute;
+            attribute.semantic = std::move(semantic);
+            attribute.semanticIndex = semanticIndex;
+            attribute.data = data;
+            attribute.components = components;
+            attribute.encoding = encoding;
+            attribute.format = quantization::GetEncodedFormat(encoding, components);
+            attribute.offset = m_stride;
+            m_stride += GetVertexFormatSize(attribute.format);
+            m_attributes.push_back(std::move(attribute));
+        }
+
+        size_t GetVertexCount() const {
+            return m_vertexCount;
+        }
+
+        uint32_t GetStride() const {
+            return m_stride;
+        }
+
+        // Semantics point into the builder: elements are valid while it lives
+        std::vector<VertexElement> GetElements() const {
+            std::vector<VertexElement> elements;
+            elements.reserve(m_attributes.size());
+            for (auto& attribute : m_attributes) {
+                elements.push_back(VertexElement{
+                    attribute.semantic,
+                    attribute.semanticIndex,
+                    attribute.format,
+                    attribute.offset,
+                    GetVertexFormatSize(attribute.format) });
+            }
+            return elements;
+        }
+
+        std::vector<uint8_t> Build() const {
+            std::vector<uint8_t> result(m_vertexCount * m_stride);
+            std::vector<uint8_t> encoded;
+            for (auto& attribute : m_attributes) {
+                Encode(attribute, encoded);
+                // Scatter the packed attribute into the interleaved stream
+                auto size = GetVertexFormatSize(attribute.format);
+                for (size_t i = 0; i < m_vertexCount; ++i) {
+                    std::memcpy(result.data() + i * m_stride + attribute.offset, encoded.data() + i * size, size);
+                }
+            }
+            return result;
+        }
+
+    private:
+        struct Attribute {
+            std::string semantic;
+            uint32_t semanticIndex;
+            const float* data;
+            uint32_t components;
+            VertexEncoding encoding;
+            VertexFormat format;
+            uint32_t offset;
+        };
+
+        void Encode(const Attribute& attribute, std::vector<uint8_t>& encoded) const {
+            using namespace quantization;
+            auto count = m_vertexCount;
+            encoded.resize(count * GetVertexFormatSize(attribute.format));
+            switch (attribute.encoding) {
+            case VertexEncoding::Float32:
+                std::memcpy(encoded.data(), attribute.data, encoded.size());
+                break;
+            case VertexEncoding::Half:
+            case VertexEncoding::Snorm16: {
+                // Three component vectors are stored as four
+                auto outComponents = attribute.components == 2 ? 2u : 4u;
+                std::vector<float> widened;
+                auto source = attribute.data;
+                if (outComponents != attribute.components) {
+                    widened = Widen(attribute.data, attribute.components, outComponents, count, 1.0f);
+                    source = widened.data();
+                }
+                if (attribute.encoding == VertexEncoding::Half) {
+                    EncodeHalfs(source, reinterpret_cast<uint16_t*>(encoded.data()), count * outComponents);
+                }
+                else {
+                    EncodeSnorm16(source, reinterpret_cast<int16_t*>(encoded.data()), count * outComponents);
+                }
+                break;
+            }
+            case VertexEncoding::R10G10B10A2:
+                quantization::EncodeR10G10B10A2(attribute.data, attribute.components, reinterpret_cast<uint32_t*>(encoded.data()), count);
+                break;
+            case VertexEncoding::OctahedralSnorm16:
+                EncodeOctahedralSnorm16(attribute.data, attribute.components, reinterpret_cast<int16_t*>(encoded.data()), count);
+                break;
+            }
+        }
+
+    private:
+        std::vector<Attribute> m_attributes;
+        size_t m_vertexCount;
+        uint32_t m_stride = 0;
+    };
+}
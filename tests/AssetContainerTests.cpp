@@ -0,0 +1,226 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "D3D_Tools/AssetContainer.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    struct Vertex {
+        float position[3];
+        float uv[2];
+    };
+
+    D3D_TOOLS_VERTEX_LAYOUT(Vertex,
+        D3D_TOOLS_VERTEX_ELEMENT(Vertex, position, "POSITION", 0),
+        D3D_TOOLS_VERTEX_ELEMENT(Vertex, uv, "TEXCOORD", 0));
+
+    // Container file in the temporary directory, removed when the test ends
+    struct TemporaryFile {
+        explicit TemporaryFile(const char* name) :
+            path(std::filesystem::temp_directory_path() / (std::string("d3d_tools_") + name + ".dda"))
+        {
+        }
+
+        ~TemporaryFile() {
+            std::error_code error;
+            std::filesystem::remove(path, error);
+        }
+
+        std::vector<uint8_t> Read() const {
+            std::ifstream input(path, std::ios::binary);
+            return std::vector<uint8_t>(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        }
+
+        void Write(const std::vector<uint8_t>& bytes) const {
+            std::ofstream output(path, std::ios::binary | std::ios::trunc);
+            output.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        }
+
+        std::filesystem::path path;
+    };
+
+    // Table without data: header, the records and names, with a valid checksum
+    std::vector<uint8_t> MakeTable(const std::vector<asset_details::AssetRecord>& assets, const std::string& names) {
+        using namespace asset_details;
+        FileHeader header{};
+        header.magic = FileMagic;
+        header.version = FormatVersion;
+        header.assetsCount = static_cast<uint32_t>(assets.size());
+        header.namesSize = static_cast<uint32_t>(names.size());
+        header.tableSize = sizeof(FileHeader) + assets.size() * sizeof(AssetRecord) + names.size();
+        header.fileSize = header.tableSize;
+
+        std::vector<uint8_t> bytes(header.tableSize);
+        if (!assets.empty()) {
+            std::memcpy(bytes.data() + sizeof(FileHeader), assets.data(), assets.size() * sizeof(AssetRecord));
+        }
+        std::memcpy(bytes.data() + sizeof(FileHeader) + assets.size() * sizeof(AssetRecord), names.data(), names.size());
+        header.tableChecksum = ComputeHash(bytes.data() + sizeof(FileHeader), bytes.size() - sizeof(FileHeader));
+        std::memcpy(bytes.data(), &header, sizeof(FileHeader));
+        return bytes;
+    }
+
+    asset_details::AssetRecord MakeRecord(AssetType type) {
+        asset_details::AssetRecord record{};
+        record.type = type;
+        record.nameSize = 1;
+        return record;
+    }
+
+    bool Equals(const void* data, const void* expected, size_t size) {
+        return std::memcmp(data, expected, size) == 0;
+    }
+}
+
+TEST_CASE(AllAssetTypesRoundTrip) {
+    TextureAssetDesc textureDesc{ 64, 32, 3, 2, TextureFormat::BC1_UNORM };
+    std::vector<std::vector<uint8_t>> texels;
+    std::vector<AssetSubresource> subresources;
+    for (uint32_t slice = 0; slice < textureDesc.arraySize; ++slice) {
+        for (uint32_t mip = 0; mip < textureDesc.mipLevels; ++mip) {
+            auto width = ComputeMipExtent(textureDesc.width, mip);
+            auto height = ComputeMipExtent(textureDesc.height, mip);
+            texels.emplace_back(ComputeSlicePitch(textureDesc.format, width, height));
+            std::iota(texels.back().begin(), texels.back().end(), static_cast<uint8_t>(slice * 10 + mip));
+            subresources.push_back(AssetSubresource{ texels.back().data(), texels.back().size(), 0, 0 });
+        }
+    }
+
+    std::vector<Vertex> vertices(1000);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i] = Vertex{ { float(i), 1.0f, 2.0f }, { 3.0f, float(i) } };
+    }
+    std::vector<uint16_t> indices(3000);
+    std::iota(indices.begin(), indices.end(), uint16_t(0));
+    std::vector<uint8_t> bytecode(333, 0xAB);
+
+    AssetContainerWriter writer;
+    writer.AddTexture("texture", textureDesc, subresources);
+    writer.AddVertexStream("mesh/vertices", vertices);
+    writer.AddIndexStream("mesh/indices", static_cast<uint32_t>(indices.size()), 2, indices.data());
+    writer.AddShader("shader", 3, bytecode.data(), bytecode.size());
+
+    TemporaryFile file("round_trip");
+    auto written = writer.WriteFile(file.path);
+    CHECK(written == std::filesystem::file_size(file.path));
+    CHECK(written % asset_details::DataAlignment == 0);
+
+    AssetContainer container(file.path);
+    CHECK(container.GetAssetsCount() == 4);
+    CHECK(container.GetAssetType(0) == AssetType::Texture);
+    CHECK(container.GetAssetName(1) == "mesh/vertices");
+    CHECK(container.FindAsset("mesh/indices") == 2);
+    CHECK(container.FindAsset("missing") == AssetContainer::NotFound);
+
+    auto texture = container.GetTexture("texture");
+    CHECK(texture.desc.width == 64 && texture.desc.height == 32);
+    CHECK(texture.desc.mipLevels == 3 && texture.desc.arraySize == 2);
+    CHECK(texture.desc.format == TextureFormat::BC1_UNORM);
+    CHECK(texture.subresources.size() == texels.size());
+    for (size_t i = 0; i < texels.size(); ++i) {
+        auto& subresource = texture.subresources[i];
+        auto mip = static_cast<uint32_t>(i % textureDesc.mipLevels);
+        CHECK(subresource.size == texels[i].size());
+        CHECK(subresource.rowPitch == ComputeRowPitch(textureDesc.format, ComputeMipExtent(textureDesc.width, mip)));
+        CHECK(reinterpret_cast<uintptr_t>(subresource.data) % asset_details::DataAlignment == 0);
+        CHECK(Equals(subresource.data, texels[i].data(), texels[i].size()));
+    }
+
+    auto vertexStream = container.GetVertexStream("mesh/vertices");
+    CHECK(vertexStream.vertexCount == vertices.size());
+    CHECK(vertexStream.stride == sizeof(Vertex));
+    CHECK(vertexStream.elements.size() == 2);
+    CHECK(vertexStream.elements[1].semantic == "TEXCOORD");
+    CHECK(vertexStream.elements[1].offset == offsetof(Vertex, uv));
+    CHECK(vertexStream.elements[1].format == VertexFormat::R32_G32_FLOAT);
+    CHECK(Equals(vertexStream.data, vertices.data(), vertices.size() * sizeof(Vertex)));
+
+    auto indexStream = container.GetIndexStream("mesh/indices");
+    CHECK(indexStream.indexCount == indices.size() && indexStream.indexSize == 2);
+    CHECK(Equals(indexStream.data, indices.data(), indices.size() * sizeof(uint16_t)));
+
+    auto shader = container.GetShader("shader");
+    CHECK(shader.shaderType == 3);
+    CHECK(shader.size == bytecode.size());
+    CHECK(Equals(shader.bytecode, bytecode.data(), bytecode.size()));
+
+    CHECK_THROWS(container.GetShader("texture"), std::invalid_argument);
+    CHECK_THROWS(container.GetTexture("missing"), std::out_of_range);
+}
+
+TEST_CASE(EmptyContainerOpens) {
+    TemporaryFile file("empty");
+    AssetContainerWriter().WriteFile(file.path);
+    AssetContainer container(file.path);
+    CHECK(container.GetAssetsCount() == 0);
+}
+
+TEST_CASE(CorruptedFilesThrow) {
+    std::vector<uint8_t> bytecode(100, 1);
+    AssetContainerWriter writer;
+    writer.AddShader("shader", 0, bytecode.data(), bytecode.size());
+    TemporaryFile file("corrupted");
+    writer.WriteFile(file.path);
+    auto original = file.Read();
+
+    // Name byte is covered by the table checksum
+    auto bytes = original;
+    bytes[sizeof(asset_details::FileHeader) + sizeof(asset_details::AssetRecord) + sizeof(asset_details::ChunkRecord)] ^= 1;
+    file.Write(bytes);
+    CHECK_THROWS(AssetContainer(file.path), std::runtime_error);
+
+    bytes = original;
+    bytes[0] ^= 1;
+    file.Write(bytes);
+    CHECK_THROWS(AssetContainer(file.path), std::runtime_error);
+
+    bytes = original;
+    bytes.resize(bytes.size() - asset_details::DataAlignment);
+    file.Write(bytes);
+    CHECK_THROWS(AssetContainer(file.path), std::runtime_error);
+
+    bytes.resize(sizeof(asset_details::FileHeader) - 1);
+    file.Write(bytes);
+    CHECK_THROWS(AssetContainer(file.path), std::runtime_error);
+
+    CHECK_THROWS(AssetContainer(file.path.string() + ".missing"), std::runtime_error);
+}
+
+TEST_CASE(AssetsWithoutChunksThrow) {
+    // Valid checksums and an empty chunk table: validation must not touch the chunks
+    TemporaryFile file("no_chunks");
+    for (auto type : { AssetType::VertexStream, AssetType::IndexStream, AssetType::Shader }) {
+        auto record = MakeRecord(type);
+        record.parameters[1] = 2;
+        file.Write(MakeTable({ record }, std::string("a\0", 2)));
+        CHECK_THROWS(AssetContainer(file.path), std::runtime_error);
+    }
+
+    auto record = MakeRecord(AssetType::VertexStream);
+    record.chunksCount = 1;
+    file.Write(MakeTable({ record }, std::string("a\0", 2)));
+    CHECK_THROWS(AssetContainer(file.path), std::runtime_error);
+
+    record = MakeRecord(static_cast<AssetType>(7));
+    file.Write(MakeTable({ record }, std::string("a\0", 2)));
+    CHECK_THROWS(AssetContainer(file.path), std::runtime_error);
+
+    // Texture of no subresources has nothing to check, so it opens
+    record = MakeRecord(AssetType::Texture);
+    file.Write(MakeTable({ record }, std::string("a\0", 2)));
+    AssetContainer container(file.path);
+    CHECK(container.GetTexture("a").subresources.empty());
+}
+
+TEST_CASE(WriterRejectsInvalidAssets) {
+    AssetContainerWriter writer;
+    uint8_t data[64]{};
+    CHECK_THROWS(writer.AddTexture("texture", TextureAssetDesc{ 4, 4, 2, 1 }, { AssetSubresource{ data, sizeof(data), 0, 0 } }), std::invalid_argument);
+    CHECK_THROWS(writer.AddTexture("texture", TextureAssetDesc{ 8, 8, 1, 1 }, { AssetSubresource{ data, sizeof(data), 0, 0 } }), std::invalid_argument);
+    CHECK_THROWS(writer.AddIndexStream("indices", 4, 1, data), std::invalid_argument);
+}
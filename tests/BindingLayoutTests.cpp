@@ -0,0 +1,146 @@
+#include <cstring>
+#include "D3D_Tools/BindingLayout.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+// Expected offsets are the ones fxc reports for the same cbuffer declarations
+
+TEST_CASE(VariablesThatDoNotFitRegisterStartNewOne) {
+    // float a; float3 b; float2 c; float2 d; float e; float4 f;
+    HlslConstantPacker packer;
+    CHECK(packer.Add(HlslType::MakeScalar()) == 0);
+    CHECK(packer.Add(HlslType::MakeVector(3)) == 4);
+    CHECK(packer.Add(HlslType::MakeVector(2)) == 16);
+    CHECK(packer.Add(HlslType::MakeVector(2)) == 24);
+    CHECK(packer.Add(HlslType::MakeScalar()) == 32);
+    CHECK(packer.Add(HlslType::MakeVector(4)) == 48);
+    CHECK(packer.GetSize() == 64);
+    CHECK(packer.GetBufferSize() == 64);
+
+    // float3 a; float2 b; would straddle the register boundary at 16
+    HlslConstantPacker straddling;
+    straddling.Add(HlslType::MakeVector(3));
+    CHECK(straddling.Add(HlslType::MakeVector(2)) == 16);
+    CHECK(straddling.GetBufferSize() == 32);
+}
+
+TEST_CASE(ArrayElementsTakeWholeRegistersButTheLast) {
+    auto floats = HlslType::MakeScalar(HlslScalarType::Float, 3);
+    CHECK(hlsl_packing::ComputeSize(floats) == 36);
+    CHECK(hlsl_packing::ComputeArrayStride(floats) == 16);
+
+    // float x; float arr[3]; float y; float2 z;
+    HlslConstantPacker packer;
+    packer.Add(HlslType::MakeScalar());
+    CHECK(packer.Add(floats) == 16);
+    // Fits the rest of the last element's register
+    CHECK(packer.Add(HlslType::MakeScalar()) == 52);
+    CHECK(packer.Add(HlslType::MakeVector(2)) == 56);
+    CHECK(packer.GetBufferSize() == 64);
+
+    auto vectors = HlslType::MakeVector(3, HlslScalarType::Int, 2);
+    CHECK(hlsl_packing::ComputeSize(vectors) == 28);
+}
+
+TEST_CASE(ColumnMajorMatrixTakesRegisterPerColumn) {
+    CHECK(hlsl_packing::ComputeSize(HlslType::MakeMatrix(4, 4)) == 64);
+    // float4x3: 3 columns of 4 components
+    CHECK(hlsl_packing::ComputeSize(HlslType::MakeMatrix(4, 3)) == 48);
+    // float3x4: 4 columns of 3 components
+    CHECK(hlsl_packing::ComputeSize(HlslType::MakeMatrix(3, 4)) == 60);
+
+    // float a; float3x3 m; float b;
+    HlslConstantPacker packer;
+    packer.Add(HlslType::MakeScalar());
+    CHECK(packer.Add(HlslType::MakeMatrix(3, 3)) == 16);
+    CHECK(packer.Add(HlslType::MakeScalar()) == 60);
+}
+
+TEST_CASE(RowMajorMatrixTakesRegisterPerRow) {
+    // row_major float4x3: 4 rows of 3 components
+    CHECK(hlsl_packing::ComputeSize(HlslType::MakeMatrix(4, 3, true)) == 60);
+    CHECK(hlsl_packing::ComputeSize(HlslType::MakeMatrix(3, 4, true)) == 48);
+    // Even a single row starts a register
+    HlslConstantPacker packer;
+    packer.Add(HlslType::MakeScalar());
+    CHECK(packer.Add(HlslType::MakeMatrix(1, 2, true)) == 16);
+    CHECK(packer.GetSize() == 24);
+}
+
+TEST_CASE(MatrixArraysUseRegisterAlignedStride) {
+    auto matrices = HlslType::MakeMatrix(3, 2, true, 2);
+    CHECK(hlsl_packing::ComputeElementSize(matrices) == 40);
+    CHECK(hlsl_packing::ComputeArrayStride(matrices) == 48);
+    CHECK(hlsl_packing::ComputeSize(matrices) == 88);
+    CHECK(hlsl_packing::ComputeSize(HlslType::MakeMatrix(4, 4, false, 2)) == 128);
+}
+
+TEST_CASE(StructsStartRegisterAndPackTheirSize) {
+    // struct S { float3 a; float b; float2 c; };
+    HlslConstantPacker member;
+    member.Add(HlslType::MakeVector(3));
+    member.Add(HlslType::MakeScalar());
+    member.Add(HlslType::MakeVector(2));
+    CHECK(member.GetSize() == 24);
+
+    // float x; S s[2]; float y;
+    auto structs = HlslType::MakeStruct(member.GetSize(), 2);
+    CHECK(hlsl_packing::ComputeArrayStride(structs) == 32);
+    HlslConstantPacker packer;
+    packer.Add(HlslType::MakeScalar());
+    CHECK(packer.Add(structs) == 16);
+    CHECK(packer.GetSize() == 16 + 32 + 24);
+    CHECK(packer.Add(HlslType::MakeScalar()) == 72);
+    CHECK(packer.GetBufferSize() == 80);
+}
+
+TEST_CASE(EmptyBufferTakesOneRegister) {
+    HlslConstantPacker packer;
+    CHECK(packer.GetSize() == 0);
+    CHECK(packer.GetBufferSize() == 16);
+}
+
+TEST_CASE(LayoutMatchesPacker) {
+    ConstantBufferLayout layout;
+    layout.name = "PerDraw";
+    layout.AddVariable("a", HlslType::MakeScalar());
+    layout.AddVariable("b", HlslType::MakeVector(3));
+    layout.AddVariable("world", HlslType::MakeMatrix(4, 4, true));
+    layout.AddVariable("weights", HlslType::MakeScalar(HlslScalarType::Float, 4));
+    CHECK(layout.variables[1].offset == 4);
+    CHECK(layout.variables[2].offset == 16);
+    CHECK(layout.variables[3].offset == 80);
+    CHECK(layout.size == 144);
+    CHECK(layout.FindVariable("world") == 2);
+    CHECK(layout.FindVariable("missing") == ConstantBufferLayout::NotFound);
+}
+
+TEST_CASE(WriterTracksChangedBytes) {
+    ConstantBufferLayout layout;
+    layout.name = "PerDraw";
+    layout.AddVariable("a", HlslType::MakeScalar());
+    layout.AddVariable("b", HlslType::MakeVector(3));
+    layout.AddVariable("weights", HlslType::MakeScalar(HlslScalarType::Float, 4));
+
+    ConstantBufferWriter writer(layout);
+    CHECK(writer.IsDirty());
+    writer.ClearDirty();
+    CHECK(!writer.Set("a", 0.0f));
+    CHECK(!writer.IsDirty());
+    CHECK(writer.Set("a", 1.0f));
+    CHECK(writer.GetDirtyBegin() == 0 && writer.GetDirtyEnd() == 4);
+
+    writer.ClearDirty();
+    CHECK(writer.SetElement(2, 3, 5.0f));
+    CHECK(writer.GetDirtyBegin() == 64 && writer.GetDirtyEnd() == 68);
+    float value = 0.0f;
+    std::memcpy(&value, writer.GetData() + 64, sizeof(value));
+    CHECK(value == 5.0f);
+
+    CHECK_THROWS(writer.SetElement(2, 4, 1.0f), std::out_of_range);
+    CHECK_THROWS(writer.Set("a", 1.0), std::invalid_argument);
+    CHECK_THROWS(writer.Set("missing", 1.0f), std::out_of_range);
+    CHECK(writer.GetStatistics().writesCount == 3);
+    CHECK(writer.GetStatistics().changesCount == 2);
+}
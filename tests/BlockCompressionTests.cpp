@@ -0,0 +1,178 @@
+#include <cstdlib>
+#include <vector>
+#include "D3D_Tools/BlockCompression.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    std::vector<uint8_t> MakeSolid(uint32_t width, uint32_t height, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+        std::vector<uint8_t> pixels(size_t(width) * height * 4);
+        for (size_t i = 0; i < pixels.size(); i += 4) {
+            pixels[i] = r;
+            pixels[i + 1] = g;
+            pixels[i + 2] = b;
+            pixels[i + 3] = a;
+        }
+        return pixels;
+    }
+
+    std::vector<uint8_t> RoundTrip(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, TextureFormat format) {
+        auto blocks = CompressTexture(pixels.data(), width, height, width * 4, TextureFormat::R8_G8_B8_A8_UNORM, format);
+        CHECK(blocks.size() == ComputeSlicePitch(format, width, height));
+        return DecompressTexture(blocks.data(), width, height, format);
+    }
+
+    uint16_t ReadEndpoint(const std::vector<uint8_t>& blocks, size_t offset) {
+        return static_cast<uint16_t>(blocks[offset] | (blocks[offset + 1] << 8));
+    }
+
+    uint8_t Expand5(uint32_t value) {
+        return static_cast<uint8_t>((value << 3) | (value >> 2));
+    }
+
+    uint8_t Expand6(uint32_t value) {
+        return static_cast<uint8_t>((value << 2) | (value >> 4));
+    }
+}
+
+TEST_CASE(SolidColorsRepresentableIn565AreExact) {
+    // Partial blocks at the edges are covered by the 5x3 size
+    for (uint32_t value = 0; value < 32; ++value) {
+        auto pixels = MakeSolid(5, 3, Expand5(value), Expand6(63 - value * 2), Expand5(31 - value), 255);
+        CHECK(RoundTrip(pixels, 5, 3, TextureFormat::BC1_UNORM) == pixels);
+    }
+}
+
+TEST_CASE(SolidBlocksAreExactInEveryFormat) {
+    auto rgba = MakeSolid(8, 8, Expand5(20), Expand6(40), Expand5(10), 77);
+    auto bc3 = RoundTrip(rgba, 8, 8, TextureFormat::BC3_UNORM);
+    CHECK(bc3 == rgba);
+
+    // BC4 and BC5 keep any value of their channels exactly and decode the rest as 0 with opaque alpha
+    for (uint32_t value = 0; value < 256; value += 15) {
+        auto pixels = MakeSolid(4, 4, static_cast<uint8_t>(value), static_cast<uint8_t>(255 - value), 99, 13);
+        auto bc4 = RoundTrip(pixels, 4, 4, TextureFormat::BC4_UNORM);
+        CHECK((bc4 == MakeSolid(4, 4, static_cast<uint8_t>(value), 0, 0, 255)));
+        auto bc5 = RoundTrip(pixels, 4, 4, TextureFormat::BC5_UNORM);
+        CHECK((bc5 == MakeSolid(4, 4, static_cast<uint8_t>(value), static_cast<uint8_t>(255 - value), 0, 255)));
+    }
+}
+
+TEST_CASE(Bc1EncoderUsesOpaqueFourColorMode) {
+    // Gradient along red: endpoints differ, so color0 must be greater than color1
+    std::vector<uint8_t> pixels(4 * 4 * 4);
+    for (uint32_t i = 0; i < 16; ++i) {
+        pixels[i * 4] = static_cast<uint8_t>(i * 17);
+        pixels[i * 4 + 1] = 64;
+        pixels[i * 4 + 2] = static_cast<uint8_t>(255 - i * 17);
+        pixels[i * 4 + 3] = 255;
+    }
+    auto blocks = CompressTexture(pixels.data(), 4, 4, 16, TextureFormat::R8_G8_B8_A8_UNORM, TextureFormat::BC1_UNORM);
+    CHECK(ReadEndpoint(blocks, 0) > ReadEndpoint(blocks, 2));
+
+    auto decoded = DecompressTexture(blocks.data(), 4, 4, TextureFormat::BC1_UNORM);
+    for (uint32_t i = 0; i < 16; ++i) {
+        CHECK(decoded[i * 4 + 3] == 255);
+        CHECK(std::abs(decoded[i * 4] - pixels[i * 4]) <= 48);
+    }
+}
+
+TEST_CASE(Bc1DecoderHonorsEndpointOrder) {
+    // Indices 0, 1, 2, 3 in the first four pixels, the rest use index 0
+    uint16_t white = 0xFFFF;
+    uint16_t black = 0x0000;
+    std::vector<uint8_t> fourColors{
+        static_cast<uint8_t>(white), static_cast<uint8_t>(white >> 8), static_cast<uint8_t>(black), static_cast<uint8_t>(black >> 8),
+        0xE4, 0, 0, 0 };
+    auto decoded = DecompressTexture(fourColors.data(), 4, 4, TextureFormat::BC1_UNORM);
+    uint8_t expectedFour[4][4] = { { 255, 255, 255, 255 }, { 0, 0, 0, 255 }, { 170, 170, 170, 255 }, { 85, 85, 85, 255 } };
+    for (uint32_t i = 0; i < 4; ++i) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            CHECK(decoded[i * 4 + c] == expectedFour[i][c]);
+        }
+    }
+
+    // color0 <= color1 switches to three colors and transparent black
+    std::vector<uint8_t> threeColors{
+        static_cast<uint8_t>(black), static_cast<uint8_t>(black >> 8), static_cast<uint8_t>(white), static_cast<uint8_t>(white >> 8),
+        0xE4, 0, 0, 0 };
+    decoded = DecompressTexture(threeColors.data(), 4, 4, TextureFormat::BC1_UNORM);
+    uint8_t expectedThree[4][4] = { { 0, 0, 0, 255 }, { 255, 255, 255, 255 }, { 128, 128, 128, 255 }, { 0, 0, 0, 0 } };
+    for (uint32_t i = 0; i < 4; ++i) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            CHECK(decoded[i * 4 + c] == expectedThree[i][c]);
+        }
+    }
+
+    // The color part of BC3 is always four colors
+    std::vector<uint8_t> bc3(16, 0);
+    bc3[0] = 255;
+    bc3[1] = 255;
+    std::copy(threeColors.begin(), threeColors.end(), bc3.begin() + 8);
+    decoded = DecompressTexture(bc3.data(), 4, 4, TextureFormat::BC3_UNORM);
+    CHECK(decoded[2 * 4] == 85);
+    CHECK(decoded[3 * 4] == 170 && decoded[3 * 4 + 3] == 255);
+}
+
+TEST_CASE(ChannelExtremesAreExact) {
+    // Only 0 and 255 in red and the opposite in green: both fall on the endpoints
+    std::vector<uint8_t> pixels(4 * 4 * 4);
+    for (uint32_t i = 0; i < 16; ++i) {
+        uint8_t value = (i % 3 == 0) ? 255 : 0;
+        pixels[i * 4] = value;
+        pixels[i * 4 + 1] = static_cast<uint8_t>(255 - value);
+        pixels[i * 4 + 2] = 0;
+        pixels[i * 4 + 3] = 255;
+    }
+    auto blocks = CompressTexture(pixels.data(), 4, 4, 16, TextureFormat::R8_G8_B8_A8_UNORM, TextureFormat::BC5_UNORM);
+    // Eight value mode: the first endpoint is the greater one
+    CHECK(blocks[0] == 255 && blocks[1] == 0);
+    CHECK(blocks[8] == 255 && blocks[9] == 0);
+    CHECK(DecompressTexture(blocks.data(), 4, 4, TextureFormat::BC5_UNORM) == pixels);
+
+    auto bc4 = RoundTrip(pixels, 4, 4, TextureFormat::BC4_UNORM);
+    for (uint32_t i = 0; i < 16; ++i) {
+        CHECK(bc4[i * 4] == pixels[i * 4]);
+    }
+}
+
+TEST_CASE(ChannelGradientStaysWithinOneStep) {
+    std::vector<uint8_t> pixels(4 * 4);
+    for (uint32_t i = 0; i < 16; ++i) {
+        pixels[i] = static_cast<uint8_t>(i * 17);
+    }
+    auto blocks = CompressTexture(pixels.data(), 4, 4, 4, TextureFormat::R8_UNORM, TextureFormat::BC4_UNORM);
+    auto decoded = DecompressTexture(blocks.data(), 4, 4, TextureFormat::BC4_UNORM);
+    // Half of a 255 / 7 step
+    for (uint32_t i = 0; i < 16; ++i) {
+        CHECK(std::abs(decoded[i * 4] - pixels[i]) <= 19);
+    }
+    CHECK(decoded[0] == 0 && decoded[15 * 4] == 255);
+}
+
+TEST_CASE(Bc4DecoderSixValueMode) {
+    // value0 <= value1: four interpolated values, then explicit 0 and 255
+    std::vector<uint8_t> block{ 50, 200, 0, 0, 0, 0, 0, 0 };
+    uint64_t indices = 0;
+    for (uint64_t i = 0; i < 8; ++i) {
+        indices |= i << (i * 3);
+    }
+    for (uint32_t i = 0; i < 6; ++i) {
+        block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+    auto decoded = DecompressTexture(block.data(), 4, 4, TextureFormat::BC4_UNORM);
+    uint8_t expected[8] = { 50, 200, 80, 110, 140, 170, 0, 255 };
+    for (uint32_t i = 0; i < 8; ++i) {
+        CHECK(decoded[i * 4] == expected[i]);
+    }
+}
+
+TEST_CASE(InvalidFormatsThrow) {
+    uint8_t pixels[64]{};
+    CHECK_THROWS(CompressTexture(pixels, 4, 4, 16, TextureFormat::R8_G8_B8_A8_UNORM, TextureFormat::R8_UNORM), std::invalid_argument);
+    CHECK_THROWS(CompressTexture(pixels, 4, 4, 16, TextureFormat::BC1_UNORM, TextureFormat::BC1_UNORM), std::invalid_argument);
+    CHECK_THROWS(CompressTexture(pixels, 0, 4, 16, TextureFormat::R8_G8_B8_A8_UNORM, TextureFormat::BC1_UNORM), std::invalid_argument);
+    CHECK_THROWS(CompressTexture(pixels, 4, 4, 16, TextureFormat::R8_G8_B8_A8_UNORM, TextureFormat::BC7_UNORM), std::invalid_argument);
+    CHECK_THROWS(DecompressTexture(pixels, 4, 4, TextureFormat::R8_UNORM), std::invalid_argument);
+}
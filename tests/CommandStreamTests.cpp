@@ -0,0 +1,201 @@
+#include <string>
+#include <vector>
+#include "D3D_Tools/CommandStream.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    const void* Handle(uintptr_t value) {
+        return reinterpret_cast<const void*>(value);
+    }
+
+    std::string Name(const void* handle) {
+        return std::to_string(reinterpret_cast<uintptr_t>(handle));
+    }
+
+    std::string Names(const void* const* handles, uint32_t count) {
+        std::string result;
+        for (uint32_t i = 0; i < count; ++i) {
+            result += " " + Name(handles[i]);
+        }
+        return result;
+    }
+
+    // Turns every replayed command into a line of text
+    struct Printer {
+        void SetShader(uint32_t stage, const void* shader) {
+            lines.push_back("Shader " + std::to_string(stage) + " " + Name(shader));
+        }
+
+        void SetShaderResources(uint32_t stage, uint32_t startSlot, const void* const* views, uint32_t count) {
+            lines.push_back("ShaderResources " + std::to_string(stage) + " " + std::to_string(startSlot) + ":" + Names(views, count));
+        }
+
+        void SetSamplers(uint32_t stage, uint32_t startSlot, const void* const* samplers, uint32_t count) {
+            lines.push_back("Samplers " + std::to_string(stage) + " " + std::to_string(startSlot) + ":" + Names(samplers, count));
+        }
+
+        void SetConstantBuffers(uint32_t stage, uint32_t startSlot, const void* const* buffers, uint32_t count) {
+            lines.push_back("ConstantBuffers " + std::to_string(stage) + " " + std::to_string(startSlot) + ":" + Names(buffers, count));
+        }
+
+        void SetVertexBuffers(uint32_t startSlot, const RecordedVertexBuffer* buffers, uint32_t count) {
+            std::string line = "VertexBuffers " + std::to_string(startSlot) + ":";
+            for (uint32_t i = 0; i < count; ++i) {
+                line += " " + Name(buffers[i].buffer) + "/" + std::to_string(buffers[i].stride) + "/" + std::to_string(buffers[i].offset);
+            }
+            lines.push_back(line);
+        }
+
+        void SetInputLayout(const void* layout) {
+            lines.push_back("InputLayout " + Name(layout));
+        }
+
+        void SetPrimitiveTopology(uint32_t topology) {
+            lines.push_back("Topology " + std::to_string(topology));
+        }
+
+        void SetViewports(const RecordedViewport* viewports, uint32_t count) {
+            std::string line = "Viewports:";
+            for (uint32_t i = 0; i < count; ++i) {
+                line += " " + std::to_string(int(viewports[i].width)) + "x" + std::to_string(int(viewports[i].height));
+            }
+            lines.push_back(line);
+        }
+
+        void SetRenderTargets(const void* const* views, uint32_t count, const void* depthStencil) {
+            lines.push_back("RenderTargets:" + Names(views, count) + " depth " + Name(depthStencil));
+        }
+
+        void ClearRenderTarget(const void* view, const float (&color)[4]) {
+            lines.push_back("ClearRenderTarget " + Name(view) + " " + std::to_string(int(color[2] * 100)));
+        }
+
+        void ClearDepthStencil(const void* view, float depth, uint8_t stencil, uint32_t flags) {
+            lines.push_back("ClearDepthStencil " + Name(view) + " " + std::to_string(int(depth * 100)) + " " +
+                std::to_string(stencil) + " " + std::to_string(flags));
+        }
+
+        void Draw(uint32_t vertexCount, uint32_t startVertex) {
+            lines.push_back("Draw " + std::to_string(vertexCount) + " " + std::to_string(startVertex));
+        }
+
+        void SetIndexBuffer(const void* buffer, uint32_t format, uint32_t offset) {
+            lines.push_back("IndexBuffer " + Name(buffer) + " " + std::to_string(format) + " " + std::to_string(offset));
+        }
+
+        void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) {
+            lines.push_back("DrawIndexed " + std::to_string(indexCount) + " " + std::to_string(startIndex) + " " + std::to_string(baseVertex));
+        }
+
+        void DrawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance) {
+            lines.push_back("DrawInstanced " + std::to_string(vertexCount) + " " + std::to_string(instanceCount) + " " +
+                std::to_string(startVertex) + " " + std::to_string(startInstance));
+        }
+
+        void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) {
+            lines.push_back("DrawIndexedInstanced " + std::to_string(indexCount) + " " + std::to_string(instanceCount) + " " +
+                std::to_string(startIndex) + " " + std::to_string(baseVertex) + " " + std::to_string(startInstance));
+        }
+
+        std::vector<std::string> lines;
+    };
+
+    std::vector<std::string> Replay(const CommandRecorder& recorder) {
+        Printer printer;
+        recorder.Replay(printer);
+        return printer.lines;
+    }
+}
+
+TEST_CASE(EveryCommandIsReplayedWithItsArguments) {
+    CommandRecorder recorder;
+    const void* views[3]{ Handle(1), Handle(2), Handle(3) };
+    RecordedVertexBuffer vertexBuffers[2]{ { Handle(9), 12, 0 }, { Handle(10), 16, 64 } };
+    RecordedViewport viewports[1]{ { 0.0f, 0.0f, 640.0f, 480.0f, 0.0f, 1.0f } };
+    float color[4]{ 0.0f, 0.0f, 0.5f, 1.0f };
+
+    recorder.SetShader(4, Handle(77));
+    recorder.SetShaderResources(4, 2, views, 3);
+    recorder.SetSamplers(4, 1, views, 1);
+    recorder.SetConstantBuffers(5, 0, views, 2);
+    recorder.SetVertexBuffers(1, vertexBuffers, 2);
+    recorder.SetInputLayout(Handle(5));
+    recorder.SetPrimitiveTopology(4);
+    recorder.SetViewports(viewports, 1);
+    recorder.SetRenderTargets(views, 2, Handle(8));
+    recorder.ClearRenderTarget(Handle(1), color);
+    recorder.ClearDepthStencil(Handle(8), 1.0f, 7, 3);
+    recorder.Draw(36, 6);
+    recorder.SetIndexBuffer(Handle(11), 57, 128);
+    recorder.DrawIndexed(300, 30, -5);
+    recorder.DrawInstanced(36, 100, 0, 7);
+    recorder.DrawIndexedInstanced(300, 100, 30, -5, 7);
+
+    CHECK(recorder.GetCommandsCount() == 16);
+    CHECK((Replay(recorder) == std::vector<std::string>{
+        "Shader 4 77",
+        "ShaderResources 4 2: 1 2 3",
+        "Samplers 4 1: 1",
+        "ConstantBuffers 5 0: 1 2",
+        "VertexBuffers 1: 9/12/0 10/16/64",
+        "InputLayout 5",
+        "Topology 4",
+        "Viewports: 640x480",
+        "RenderTargets: 1 2 depth 8",
+        "ClearRenderTarget 1 50",
+        "ClearDepthStencil 8 100 7 3",
+        "Draw 36 6",
+        "IndexBuffer 11 57 128",
+        "DrawIndexed 300 30 -5",
+        "DrawInstanced 36 100 0 7",
+        "DrawIndexedInstanced 300 100 30 -5 7" }));
+}
+
+TEST_CASE(RenderTargetsMayBeUnbound) {
+    CommandRecorder recorder;
+    recorder.SetRenderTargets(nullptr, 0, nullptr);
+    CHECK((Replay(recorder) == std::vector<std::string>{ "RenderTargets: depth 0" }));
+}
+
+TEST_CASE(PacketsKeepPayloadsAligned) {
+    CommandRecorder recorder;
+    // Odd payload sizes: one pointer, then a 4 byte index
+    recorder.SetShader(0, Handle(1));
+    recorder.DrawIndexed(3);
+    recorder.SetShader(0, Handle(2));
+    CHECK(recorder.GetSizeInBytes() % 8 == 0);
+    CHECK((Replay(recorder) == std::vector<std::string>{ "Shader 0 1", "DrawIndexed 3 0 0", "Shader 0 2" }));
+}
+
+TEST_CASE(ClearForgetsCommands) {
+    CommandRecorder recorder;
+    recorder.Draw(3);
+    recorder.Clear();
+    CHECK(recorder.GetCommandsCount() == 0);
+    CHECK(recorder.GetSizeInBytes() == 0);
+    CHECK(Replay(recorder).empty());
+
+    recorder.Draw(6);
+    CHECK((Replay(recorder) == std::vector<std::string>{ "Draw 6 0" }));
+}
+
+TEST_CASE(ParallelRecordingIsDeterministic) {
+    ThreadPool threadPool(4);
+    std::vector<CommandRecorder> recorders;
+    for (int frame = 0; frame < 3; ++frame) {
+        RecordCommandsInParallel(threadPool, recorders, 16, [](size_t job, CommandRecorder& recorder) {
+            for (uint32_t i = 0; i < 100; ++i) {
+                recorder.Draw(static_cast<uint32_t>(job), i);
+            }
+        });
+    }
+
+    CHECK(recorders.size() == 16);
+    for (size_t job = 0; job < recorders.size(); ++job) {
+        auto lines = Replay(recorders[job]);
+        CHECK(lines.size() == 100);
+        CHECK(lines[99] == "Draw " + std::to_string(job) + " 99");
+    }
+}
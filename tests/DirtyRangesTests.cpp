@@ -0,0 +1,58 @@
+#include "D3D_Tools/DirtyRanges.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    bool RangesAre(const DirtyRangeTracker& tracker, std::vector<ElementRange> expected) {
+        auto& ranges = tracker.GetRanges();
+        if (ranges.size() != expected.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            if (ranges[i].begin != expected[i].begin || ranges[i].end != expected[i].end) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE(RangesAreKeptSortedAndMergedWithinGap) {
+    DirtyRangeTracker tracker(4);
+    tracker.Add(100, 10);
+    tracker.Add(0, 5);
+    tracker.Add(50, 1);
+    CHECK(RangesAre(tracker, { { 0, 5 }, { 50, 51 }, { 100, 110 } }));
+
+    tracker.Add(8, 2);
+    tracker.Add(114, 1);
+    CHECK(RangesAre(tracker, { { 0, 10 }, { 50, 51 }, { 100, 115 } }));
+
+    tracker.Add(20, 200);
+    CHECK(RangesAre(tracker, { { 0, 10 }, { 20, 220 } }));
+    CHECK(tracker.GetDirtyCount() == 210);
+}
+
+TEST_CASE(EmptyRangeIsIgnored) {
+    DirtyRangeTracker tracker;
+    tracker.Add(10, 0);
+    CHECK(tracker.IsEmpty());
+}
+
+TEST_CASE(BiggerMergeGapMergesTrackedRanges) {
+    DirtyRangeTracker tracker;
+    tracker.Add(0, 5);
+    tracker.Add(10, 5);
+    tracker.Add(30, 5);
+    tracker.Add(36, 1);
+    CHECK(tracker.GetRanges().size() == 4);
+
+    tracker.SetMergeGap(5);
+    CHECK(RangesAre(tracker, { { 0, 15 }, { 30, 37 } }));
+
+    // Smaller gap does not split anything, it only affects new ranges
+    tracker.SetMergeGap(0);
+    tracker.Add(40, 1);
+    CHECK(RangesAre(tracker, { { 0, 15 }, { 30, 37 }, { 40, 41 } }));
+}
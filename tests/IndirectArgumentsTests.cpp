@@ -0,0 +1,93 @@
+#include "D3D_Tools/IndirectArguments.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+TEST_CASE(ArgumentsLocationMustBeAlignedAndInsideBuffer) {
+    CHECK(ValidateArgumentsLocation<DrawIndexedInstancedIndirectArgs>(40, 20) == IndirectArgumentsError::None);
+    CHECK(ValidateArgumentsLocation<DrawIndexedInstancedIndirectArgs>(40, 24) == IndirectArgumentsError::OutOfBufferBounds);
+    CHECK(ValidateArgumentsLocation<DispatchIndirectArgs>(40, 2) == IndirectArgumentsError::MisalignedOffset);
+    CHECK(ValidateArgumentsLocation<DispatchIndirectArgs>(8, 100) == IndirectArgumentsError::OutOfBufferBounds);
+    CHECK(ValidateArgumentsLocation<DispatchIndirectArgs>(8, 0) == IndirectArgumentsError::OutOfBufferBounds);
+    // Offset near the top of the range must not wrap around when the size is added
+    CHECK(ValidateArgumentsLocation<DispatchIndirectArgs>(64, UINT64_MAX - 3) == IndirectArgumentsError::OutOfBufferBounds);
+}
+
+TEST_CASE(RangesNearTheLimitDoNotOverflow) {
+    CHECK(indirect_details::RangeFits(0, 100, 100));
+    CHECK(!indirect_details::RangeFits(1, 100, 100));
+    CHECK(!indirect_details::RangeFits(101, 0, 100));
+    CHECK(!indirect_details::RangeFits(UINT64_MAX, 2, 100));
+    CHECK(!indirect_details::RangeFits(2, UINT64_MAX, 100));
+
+    CHECK(ValidateArguments(DrawInstancedIndirectArgs{ 3, 1, 0xFFFFFFFF, 0 }, 100) == IndirectArgumentsError::VertexRangeOutOfBounds);
+    CHECK(ValidateArguments(DrawInstancedIndirectArgs{ 3, 0xFFFFFFFF, 0, 2 }, 100, 10) == IndirectArgumentsError::InstanceRangeOutOfBounds);
+    // Instances are not checked by default
+    CHECK(ValidateArguments(DrawInstancedIndirectArgs{ 3, 0xFFFFFFFF, 0, 0 }, 100) == IndirectArgumentsError::None);
+}
+
+TEST_CASE(IndexedDrawChecksIndicesAndInstances) {
+    CHECK(ValidateArguments(DrawIndexedInstancedIndirectArgs{ 36, 10, 0, -5, 5 }, 36, 15) == IndirectArgumentsError::None);
+    CHECK(ValidateArguments(DrawIndexedInstancedIndirectArgs{ 36, 10, 0, -5, 6 }, 36, 15) == IndirectArgumentsError::InstanceRangeOutOfBounds);
+    CHECK(ValidateArguments(DrawIndexedInstancedIndirectArgs{ 36, 1, 1, 0, 0 }, 36) == IndirectArgumentsError::IndexRangeOutOfBounds);
+}
+
+TEST_CASE(ThreadGroupsAreLimitedPerDimension) {
+    CHECK(ValidateArguments(DispatchIndirectArgs{ 65535, 65535, 65535 }) == IndirectArgumentsError::None);
+    CHECK(ValidateArguments(DispatchIndirectArgs{ 1, 65536, 1 }) == IndirectArgumentsError::TooManyThreadGroups);
+}
+
+TEST_CASE(DispatchSpillsIntoSecondDimension) {
+    auto args = MakeDispatchArguments(1000, 64);
+    CHECK(args.threadGroupsX == 16 && args.threadGroupsY == 1 && args.threadGroupsZ == 1);
+
+    args = MakeDispatchArguments(65535 * 64, 64);
+    CHECK(args.threadGroupsX == 65535 && args.threadGroupsY == 1);
+
+    args = MakeDispatchArguments(70000 * 64, 64);
+    CHECK(args.threadGroupsX == 65535 && args.threadGroupsY == 2 && args.threadGroupsZ == 1);
+    CHECK(ValidateArguments(args) == IndirectArgumentsError::None);
+
+    // Every item is covered even for the largest count
+    args = MakeDispatchArguments(UINT32_MAX, 2);
+    CHECK(uint64_t(args.threadGroupsX) * args.threadGroupsY * 2 >= UINT32_MAX);
+    CHECK(ValidateArguments(args) == IndirectArgumentsError::None);
+
+    // Two dimensions are not enough for that many single item groups, which validation reports
+    args = MakeDispatchArguments(UINT32_MAX, 1);
+    CHECK(args.threadGroupsY == 65537);
+    CHECK(ValidateArguments(args) == IndirectArgumentsError::TooManyThreadGroups);
+
+    args = MakeDispatchArguments(0, 64);
+    CHECK(args.threadGroupsX == 0 && args.threadGroupsY == 1);
+}
+
+TEST_CASE(ZeroGroupSizeThrows) {
+    CHECK_THROWS(ComputeThreadGroupsCount(100, 0), std::invalid_argument);
+    CHECK_THROWS(ComputeThreadGroupsCount(0, 0), std::invalid_argument);
+    CHECK_THROWS(MakeDispatchArguments(100, 0), std::invalid_argument);
+    CHECK(ComputeThreadGroupsCount(100, 1) == 100);
+}
+
+TEST_CASE(WriterReturnsOffsetsOfPackedRecords) {
+    IndirectArgumentsWriter writer;
+    auto dispatch = writer.Append(DispatchIndirectArgs{ 1, 2, 3 });
+    auto indexed = writer.Append(DrawIndexedInstancedIndirectArgs{ 36, 2, 3, -4, 5 });
+    auto draw = writer.Append(DrawInstancedIndirectArgs{ 3, 1, 6, 0 });
+    CHECK(dispatch == 0);
+    CHECK(indexed == 12);
+    CHECK(draw == 32);
+    CHECK(writer.GetSizeInBytes() == 48);
+
+    CHECK(ValidateArgumentsLocation<DrawIndexedInstancedIndirectArgs>(writer.GetSizeInBytes(), indexed) == IndirectArgumentsError::None);
+    CHECK(ValidateArgumentsLocation<DrawInstancedIndirectArgs>(writer.GetSizeInBytes(), draw) == IndirectArgumentsError::None);
+
+    auto args = writer.Read<DrawIndexedInstancedIndirectArgs>(indexed);
+    CHECK(args.indexCountPerInstance == 36 && args.baseVertex == -4 && args.startInstance == 5);
+    CHECK(writer.Read<DispatchIndirectArgs>(dispatch).threadGroupsZ == 3);
+    CHECK(writer.Read<DrawInstancedIndirectArgs>(draw).startVertex == 6);
+
+    writer.Clear();
+    CHECK(writer.GetSizeInBytes() == 0);
+    CHECK(writer.Append(DispatchIndirectArgs{ 1, 1, 1 }) == 0);
+}
@@ -0,0 +1,151 @@
+#include <string>
+#include <utility>
+#include <vector>
+#include "D3D_Tools/InstanceBatcher.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    struct Instance {
+        int id;
+    };
+
+    using Batcher = InstanceBatcher<std::string, Instance>;
+
+    std::vector<int> GetIds(const Batcher& batcher, const Batcher::Batch& batch) {
+        std::vector<int> result;
+        for (uint32_t i = 0; i < batch.instancesCount; ++i) {
+            result.push_back(batcher.GetInstances()[batch.firstInstance + i].id);
+        }
+        return result;
+    }
+
+    // Batches tile the instance array without gaps or overlaps
+    void CheckContiguous(const Batcher& batcher) {
+        uint32_t next = 0;
+        for (auto& batch : batcher.GetBatches()) {
+            CHECK(batch.firstInstance == next);
+            CHECK(batch.instancesCount > 0);
+            next += batch.instancesCount;
+        }
+        CHECK(next == batcher.GetInstances().size());
+        CHECK(next == batcher.GetInstancesCount());
+    }
+}
+
+TEST_CASE(BatchesKeepFirstAddedOrder) {
+    Batcher batcher;
+    batcher.Add("rock", Instance{ 0 });
+    batcher.Add("tree", Instance{ 1 });
+    batcher.Add("rock", Instance{ 2 });
+    batcher.Add("grass", Instance{ 3 });
+    batcher.Add("tree", Instance{ 4 });
+    batcher.Add("rock", Instance{ 5 });
+    CHECK(!batcher.IsBuilt());
+    batcher.Build();
+    CHECK(batcher.IsBuilt());
+
+    auto& batches = batcher.GetBatches();
+    CHECK(batches.size() == 3);
+    CHECK(batches[0].key == "rock" && batches[1].key == "tree" && batches[2].key == "grass");
+    CHECK((GetIds(batcher, batches[0]) == std::vector<int>{ 0, 2, 5 }));
+    CHECK((GetIds(batcher, batches[1]) == std::vector<int>{ 1, 4 }));
+    CHECK((GetIds(batcher, batches[2]) == std::vector<int>{ 3 }));
+    CheckContiguous(batcher);
+}
+
+TEST_CASE(RangesAreContiguousForManyKeys) {
+    Batcher batcher;
+    for (int i = 0; i < 1000; ++i) {
+        batcher.Add("mesh" + std::to_string(i * 7 % 13), Instance{ i });
+    }
+    batcher.Build();
+    CHECK(batcher.GetBatches().size() == 13);
+    CheckContiguous(batcher);
+
+    // Instance order within every batch is the order of Add
+    for (auto& batch : batcher.GetBatches()) {
+        auto ids = GetIds(batcher, batch);
+        for (size_t i = 1; i < ids.size(); ++i) {
+            CHECK(ids[i - 1] < ids[i]);
+        }
+        for (auto id : ids) {
+            CHECK(batch.key == "mesh" + std::to_string(id * 7 % 13));
+        }
+    }
+}
+
+TEST_CASE(EmptyBuild) {
+    Batcher batcher;
+    batcher.Build();
+    CHECK(batcher.IsBuilt());
+    CHECK(batcher.GetBatches().empty());
+    CHECK(batcher.GetInstances().empty());
+    CHECK(batcher.GetInstancesCount() == 0);
+}
+
+TEST_CASE(AddAfterBuildInvalidatesIt) {
+    Batcher batcher;
+    batcher.Add("a", Instance{ 0 });
+    batcher.Build();
+    batcher.Add("b", Instance{ 1 });
+    batcher.Add("a", Instance{ 2 });
+    CHECK(!batcher.IsBuilt());
+    batcher.Build();
+    CHECK((GetIds(batcher, batcher.GetBatches()[0]) == std::vector<int>{ 0, 2 }));
+    CHECK((GetIds(batcher, batcher.GetBatches()[1]) == std::vector<int>{ 1 }));
+    CheckContiguous(batcher);
+}
+
+TEST_CASE(ClearAndRebuild) {
+    Batcher batcher;
+    batcher.Add("a", Instance{ 0 });
+    batcher.Add("b", Instance{ 1 });
+    batcher.Add("a", Instance{ 2 });
+    batcher.Build();
+
+    batcher.Clear();
+    CHECK(!batcher.IsBuilt());
+    CHECK(batcher.GetInstancesCount() == 0);
+    CHECK(batcher.GetBatches().empty());
+
+    // Next frame: nothing of the previous one is left, batch order follows the new adds
+    batcher.Add("b", Instance{ 10 });
+    batcher.Add("c", Instance{ 11 });
+    batcher.Add("b", Instance{ 12 });
+    batcher.Build();
+    auto& batches = batcher.GetBatches();
+    CHECK(batches.size() == 2);
+    CHECK(batches[0].key == "b" && batches[1].key == "c");
+    CHECK((GetIds(batcher, batches[0]) == std::vector<int>{ 10, 12 }));
+    CHECK((GetIds(batcher, batches[1]) == std::vector<int>{ 11 }));
+    CheckContiguous(batcher);
+}
+
+TEST_CASE(CustomHashAndEqual) {
+    // Keys equal by their first member only
+    struct Key {
+        int mesh;
+        int debugTag;
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<int>()(key.mesh);
+        }
+    };
+    struct KeyEqual {
+        bool operator()(const Key& a, const Key& b) const {
+            return a.mesh == b.mesh;
+        }
+    };
+
+    InstanceBatcher<Key, Instance, KeyHash, KeyEqual> batcher;
+    batcher.Add(Key{ 1, 100 }, Instance{ 0 });
+    batcher.Add(Key{ 1, 200 }, Instance{ 1 });
+    batcher.Add(Key{ 2, 100 }, Instance{ 2 });
+    batcher.Build();
+    CHECK(batcher.GetBatches().size() == 2);
+    CHECK(batcher.GetBatches()[0].instancesCount == 2);
+    CHECK(batcher.GetBatches()[0].key.debugTag == 100);
+}
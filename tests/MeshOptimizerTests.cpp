@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+#include "D3D_Tools/MeshOptimizer.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    struct Position {
+        float x, y, z;
+
+        bool operator==(const Position& other) const {
+            return x == other.x && y == other.y && z == other.z;
+        }
+
+        bool operator<(const Position& other) const {
+            return std::tie(x, y, z) < std::tie(other.x, other.y, other.z);
+        }
+    };
+
+    using Triangle = std::array<Position, 3>;
+
+    // Triangles with the same corners and winding compare equal whatever corner goes first
+    std::multiset<std::tuple<Position, Position, Position>> CollectTriangles(const std::vector<Triangle>& triangles) {
+        std::multiset<std::tuple<Position, Position, Position>> result;
+        for (auto triangle : triangles) {
+            auto first = std::min_element(triangle.begin(), triangle.end()) - triangle.begin();
+            std::rotate(triangle.begin(), triangle.begin() + first, triangle.end());
+            result.emplace(triangle[0], triangle[1], triangle[2]);
+        }
+        return result;
+    }
+
+    std::vector<Triangle> GetTriangles(const std::vector<Position>& vertices, const std::vector<uint32_t>& indices) {
+        std::vector<Triangle> result;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            result.push_back({ vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]] });
+        }
+        return result;
+    }
+
+    // size x size quads in the z = 0 plane, triangles in random order
+    std::vector<Triangle> MakeShuffledGrid(int size) {
+        std::vector<Triangle> triangles;
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                Position a{ float(x), float(y), 0.0f };
+                Position b{ float(x + 1), float(y), 0.0f };
+                Position c{ float(x), float(y + 1), 0.0f };
+                Position d{ float(x + 1), float(y + 1), 0.0f };
+                triangles.push_back({ a, b, c });
+                triangles.push_back({ b, d, c });
+            }
+        }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(3));
+        return triangles;
+    }
+
+    // Indexed grid of quads at height z facing +z, appended to the mesh
+    void AddGrid(std::vector<Position>& vertices, std::vector<uint32_t>& indices, int size, float z) {
+        auto base = static_cast<uint32_t>(vertices.size());
+        for (int y = 0; y <= size; ++y) {
+            for (int x = 0; x <= size; ++x) {
+                vertices.push_back({ float(x), float(y), z });
+            }
+        }
+        auto row = static_cast<uint32_t>(size + 1);
+        for (uint32_t y = 0; y < uint32_t(size); ++y) {
+            for (uint32_t x = 0; x < uint32_t(size); ++x) {
+                auto a = base + y * row + x;
+                indices.insert(indices.end(), { a, a + 1, a + row, a + 1, a + row + 1, a + row });
+            }
+        }
+    }
+}
+
+TEST_CASE(DeduplicationMergesEqualVerticesAndDropsUnused) {
+    float vertices[]{ 0, 1, 5, 5, 0, 1, 7, 7 };
+    uint32_t indices[]{ 0, 2, 1, 2, 0, 1 };
+    auto remap = DeduplicateVertices(vertices, 4, 2 * sizeof(float), indices, 6);
+    CHECK(remap.vertexCount == 2);
+    CHECK(remap.remap[0] == remap.remap[2]);
+    CHECK(remap.remap[1] != remap.remap[0]);
+    CHECK(remap.remap[3] == VertexRemap::InvalidIndex);
+
+    auto unindexed = DeduplicateVertices(vertices, 4, 2 * sizeof(float));
+    CHECK(unindexed.vertexCount == 3);
+    CHECK((RemapIndices(unindexed, nullptr, 0) == std::vector<uint32_t>{ 0, 1, 0, 2 }));
+}
+
+TEST_CASE(CacheAnalysisCountsFifoMisses) {
+    uint32_t strip[]{ 0, 1, 2, 2, 1, 3 };
+    auto statistics = AnalyzeVertexCache(strip, 6, 4, 3);
+    CHECK(statistics.verticesTransformed == 4);
+    CHECK(statistics.acmr == 2.0);
+    CHECK(statistics.atvr == 1.0);
+
+    // 0 falls out of a cache of 2 before it is used again
+    uint32_t far[]{ 0, 1, 2, 0, 2, 3 };
+    CHECK(AnalyzeVertexCache(far, 6, 4, 2).verticesTransformed == 6);
+
+    CHECK_THROWS(AnalyzeVertexCache(strip, 5, 4), std::invalid_argument);
+    CHECK_THROWS(AnalyzeVertexCache(strip, 6, 3), std::out_of_range);
+}
+
+TEST_CASE(OptimizedMeshKeepsTrianglesAndImprovesCache) {
+    const int size = 40;
+    auto triangles = MakeShuffledGrid(size);
+    std::vector<Position> vertices;
+    for (auto& triangle : triangles) {
+        vertices.insert(vertices.end(), triangle.begin(), triangle.end());
+    }
+
+    std::vector<uint32_t> indices;
+    auto report = OptimizeMesh(vertices, indices);
+    CHECK(report.inputVertexCount == triangles.size() * 3);
+    CHECK(report.outputVertexCount == (size + 1) * (size + 1));
+    CHECK(vertices.size() == report.outputVertexCount);
+    CHECK(report.before.acmr == 3.0);
+    CHECK(report.after.acmr < 0.8);
+    CHECK(CollectTriangles(GetTriangles(vertices, indices)) == CollectTriangles(triangles));
+
+    // Vertices are numbered in the order of first use
+    uint32_t next = 0;
+    bool ordered = true;
+    for (auto index : indices) {
+        ordered = ordered && index <= next;
+        next = std::max(next, index + 1);
+    }
+    CHECK(ordered);
+}
+
+TEST_CASE(EmptyMeshIsFine) {
+    std::vector<uint32_t> indices;
+    CHECK(OptimizeVertexCache(indices.data(), 0, 0).empty());
+    CHECK(OptimizeOverdraw(indices.data(), 0, nullptr, 0, 12, 0, VertexFormat::R32_G32_B32_FLOAT).empty());
+}
+
+TEST_CASE(OverdrawOrderDrawsOuterSurfacesFirst) {
+    // Two layers seen from +z: the one at z = 0 is hidden behind the one at z = 1, but comes first
+    std::vector<Position> vertices;
+    std::vector<uint32_t> indices;
+    AddGrid(vertices, indices, 8, 0.0f);
+    AddGrid(vertices, indices, 8, 1.0f);
+    auto vertexCount = static_cast<uint32_t>(vertices.size());
+    indices = OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+
+    auto ordered = OptimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertexCount, sizeof(Position), 0,
+        VertexFormat::R32_G32_B32_FLOAT);
+    CHECK(ordered.size() == indices.size());
+    CHECK(CollectTriangles(GetTriangles(vertices, ordered)) == CollectTriangles(GetTriangles(vertices, indices)));
+    CHECK(vertices[ordered.front()].z == 1.0f);
+    CHECK(vertices[ordered.back()].z == 0.0f);
+
+    // Clusters stay cache friendly
+    auto before = AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+    auto after = AnalyzeVertexCache(ordered.data(), ordered.size(), vertexCount);
+    CHECK(after.acmr <= before.acmr * 1.1);
+}
+
+TEST_CASE(OverdrawReadsPositionsOfAnyFormat) {
+    std::vector<Position> positions;
+    std::vector<uint32_t> indices;
+    AddGrid(positions, indices, 4, 0.0f);
+    AddGrid(positions, indices, 4, 1.0f);
+    auto vertexCount = static_cast<uint32_t>(positions.size());
+    auto expected = OptimizeOverdraw(indices.data(), indices.size(), positions.data(), vertexCount, sizeof(Position), 0,
+        VertexFormat::R32_G32_B32_FLOAT);
+
+    // 4 bytes of something else, then half position
+    struct Vertex {
+        uint32_t color;
+        uint16_t position[4];
+    };
+    std::vector<Vertex> vertices;
+    for (auto& position : positions) {
+        Vertex vertex{ 0xffffffff, {} };
+        quantization::EncodeHalfs(&position.x, vertex.position, 3);
+        vertices.push_back(vertex);
+    }
+    auto ordered = OptimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertexCount, sizeof(Vertex),
+        offsetof(Vertex, position), VertexFormat::R16_G16_B16_A16_FLOAT);
+    CHECK(ordered == expected);
+
+    CHECK_THROWS(OptimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertexCount, sizeof(Vertex),
+        offsetof(Vertex, position), VertexFormat::R32_G32_FLOAT), std::invalid_argument);
+    CHECK_THROWS(OptimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertexCount, sizeof(Vertex),
+        offsetof(Vertex, position), VertexFormat::R32_G32_B32_FLOAT), std::invalid_argument);
+}
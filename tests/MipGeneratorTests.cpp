@@ -0,0 +1,106 @@
+#include <cstdlib>
+#include <random>
+#include "D3D_Tools/MipGenerator.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    std::vector<uint8_t> MakeNoise(size_t size) {
+        std::mt19937 random(1);
+        std::vector<uint8_t> result(size);
+        for (auto& value : result) {
+            value = static_cast<uint8_t>(random());
+        }
+        return result;
+    }
+
+    // Splits RGBA8 pixels into 4 R8 images
+    std::vector<std::vector<uint8_t>> SplitChannels(const std::vector<uint8_t>& pixels) {
+        std::vector<std::vector<uint8_t>> result(4);
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            result[i % 4].push_back(pixels[i]);
+        }
+        return result;
+    }
+}
+
+TEST_CASE(ChainHasAllLevelsTightlyPacked) {
+    std::vector<uint8_t> pixels(37 * 19 * 4);
+    auto chain = GenerateMipChain(pixels.data(), 37, 19, 37 * 4, TextureFormat::R8_G8_B8_A8_UNORM, MipFilter::Box);
+    CHECK(chain.levels.size() == 6);
+    CHECK(chain.levels[1].width == 18 && chain.levels[1].height == 9);
+    CHECK(chain.levels[5].width == 1 && chain.levels[5].height == 1);
+    CHECK(chain.levels[1].offset == 37 * 19 * 4);
+    CHECK(chain.data.size() == chain.levels.back().offset + 4);
+
+    auto limited = GenerateMipChain(pixels.data(), 37, 19, 37 * 4, TextureFormat::R8_G8_B8_A8_UNORM, MipFilter::Box, nullptr, 2);
+    CHECK(limited.levels.size() == 2);
+}
+
+TEST_CASE(BoxFilterAveragesAndClampsOddEdges) {
+    for (auto format : { TextureFormat::R8_G8_B8_A8_UNORM, TextureFormat::R8_UNORM }) {
+        uint32_t channels = format == TextureFormat::R8_UNORM ? 1 : 4;
+        uint32_t width = 37;
+        uint32_t height = 19;
+        auto pixels = MakeNoise(size_t(width) * height * channels);
+        auto chain = GenerateMipChain(pixels.data(), width, height, width * channels, format, MipFilter::Box);
+
+        auto& level = chain.levels[1];
+        auto at = [&](uint32_t x, uint32_t y, uint32_t c) -> uint32_t {
+            x = std::min(x, width - 1);
+            y = std::min(y, height - 1);
+            return pixels[(size_t(y) * width + x) * channels + c];
+        };
+        for (uint32_t y = 0; y < level.height; ++y) {
+            for (uint32_t x = 0; x < level.width; ++x) {
+                for (uint32_t c = 0; c < channels; ++c) {
+                    auto sum = at(2 * x, 2 * y, c) + at(2 * x + 1, 2 * y, c) + at(2 * x, 2 * y + 1, c) + at(2 * x + 1, 2 * y + 1, c);
+                    CHECK(chain.data[level.offset + y * level.rowPitch + x * channels + c] == (sum + 2) / 4);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(KaiserKeepsConstantImageConstant) {
+    std::vector<uint8_t> pixels(64 * 48 * 4, 77);
+    auto chain = GenerateMipChain(pixels.data(), 64, 48, 64 * 4, TextureFormat::R8_G8_B8_A8_UNORM, MipFilter::Kaiser);
+    for (auto value : chain.data) {
+        CHECK(value == 77);
+    }
+}
+
+TEST_CASE(KaiserRgbaMatchesSingleChannelPath) {
+    // RGBA8 takes the SIMD path where available, R8 is always scalar
+    uint32_t width = 45;
+    uint32_t height = 30;
+    auto pixels = MakeNoise(size_t(width) * height * 4);
+    auto rgba = GenerateMipChain(pixels.data(), width, height, width * 4, TextureFormat::R8_G8_B8_A8_UNORM, MipFilter::Kaiser);
+    auto channels = SplitChannels(pixels);
+    for (uint32_t c = 0; c < 4; ++c) {
+        auto single = GenerateMipChain(channels[c].data(), width, height, width, TextureFormat::R8_UNORM, MipFilter::Kaiser);
+        CHECK(single.levels.size() == rgba.levels.size());
+        for (size_t i = 0; i < single.data.size(); ++i) {
+            CHECK(std::abs(int(single.data[i]) - int(rgba.data[i * 4 + c])) <= 1);
+        }
+    }
+}
+
+TEST_CASE(ParallelResultMatchesSerial) {
+    ThreadPool threadPool(4);
+    uint32_t width = 300;
+    uint32_t height = 200;
+    auto pixels = MakeNoise(size_t(width) * height * 4);
+    for (auto filter : { MipFilter::Box, MipFilter::Kaiser }) {
+        auto serial = GenerateMipChain(pixels.data(), width, height, width * 4, TextureFormat::R8_G8_B8_A8_UNORM, filter);
+        auto parallel = GenerateMipChain(pixels.data(), width, height, width * 4, TextureFormat::R8_G8_B8_A8_UNORM, filter, &threadPool);
+        CHECK(serial.data == parallel.data);
+    }
+}
+
+TEST_CASE(UnsupportedInputThrows) {
+    std::vector<uint8_t> pixels(16);
+    CHECK_THROWS(GenerateMipChain(pixels.data(), 0, 4, 0, TextureFormat::R8_UNORM, MipFilter::Box), std::invalid_argument);
+    CHECK_THROWS(GenerateMipChain(pixels.data(), 2, 2, 16, TextureFormat::BC1_UNORM, MipFilter::Box), std::invalid_argument);
+}
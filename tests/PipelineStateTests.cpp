@@ -0,0 +1,173 @@
+#include <cstring>
+#include <functional>
+#include <vector>
+#include "D3D_Tools/PipelineState.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    // Stand-ins for D3D objects: only their addresses are compared and hashed
+    char g_objects[16];
+
+    template<typename Interface>
+    Interface* MakeObject(size_t index) {
+        return reinterpret_cast<Interface*>(&g_objects[index]);
+    }
+
+    // Filled with garbage first, so that padding differs between descriptions
+    PipelineStateDescription Dirty(const PipelineStateDescription& desc, int pattern) {
+        PipelineStateDescription result;
+        std::memset(static_cast<void*>(&result), pattern, sizeof(result));
+        result = desc;
+        return result;
+    }
+
+    bool AreSame(const PipelineStateDescription& a, const PipelineStateDescription& b) {
+        return PipelineStateDescriptionEqual()(a, b) && PipelineStateDescriptionHash()(a) == PipelineStateDescriptionHash()(b);
+    }
+
+    bool AreDifferent(const PipelineStateDescription& a, const PipelineStateDescription& b) {
+        return !PipelineStateDescriptionEqual()(a, b) && PipelineStateDescriptionHash()(a) != PipelineStateDescriptionHash()(b);
+    }
+
+    PipelineStateDescription MakeDescription() {
+        PipelineStateDescription desc;
+        desc.vertexShader = MakeObject<ID3D11VertexShader>(0);
+        desc.pixelShader = MakeObject<ID3D11PixelShader>(1);
+        desc.inputLayout = MakeObject<ID3D11InputLayout>(2);
+        return desc;
+    }
+
+    // Every change touches exactly one field of the description
+    std::vector<std::function<void(PipelineStateDescription&)>> MakeSingleFieldChanges() {
+        return {
+            [](PipelineStateDescription& desc) { desc.vertexShader = MakeObject<ID3D11VertexShader>(3); },
+            [](PipelineStateDescription& desc) { desc.hullShader = MakeObject<ID3D11HullShader>(4); },
+            [](PipelineStateDescription& desc) { desc.domainShader = MakeObject<ID3D11DomainShader>(5); },
+            [](PipelineStateDescription& desc) { desc.geometryShader = MakeObject<ID3D11GeometryShader>(6); },
+            [](PipelineStateDescription& desc) { desc.pixelShader = nullptr; },
+            [](PipelineStateDescription& desc) { desc.inputLayout = MakeObject<ID3D11InputLayout>(7); },
+            [](PipelineStateDescription& desc) { desc.topology = D3D11_PRIMITIVE_TOPOLOGY_LINELIST; },
+            [](PipelineStateDescription& desc) { desc.blend.AlphaToCoverageEnable = TRUE; },
+            [](PipelineStateDescription& desc) { desc.blend.RenderTarget[0].BlendEnable = TRUE; },
+            [](PipelineStateDescription& desc) { desc.rasterizer.CullMode = D3D11_CULL_NONE; },
+            [](PipelineStateDescription& desc) { desc.rasterizer.DepthBias = 10; },
+            [](PipelineStateDescription& desc) { desc.depthStencil.DepthFunc = D3D11_COMPARISON_GREATER; },
+            [](PipelineStateDescription& desc) { desc.depthStencil.StencilEnable = TRUE; },
+            [](PipelineStateDescription& desc) { desc.blendFactor[0] = 0.5f; },
+            [](PipelineStateDescription& desc) { desc.blendFactor[3] = 0.0f; },
+            [](PipelineStateDescription& desc) { desc.sampleMask = 1; },
+            [](PipelineStateDescription& desc) { desc.stencilRef = 1; },
+        };
+    }
+
+    // Hands out one object per distinct description and counts the calls, like StateObjectCache does
+    struct FakeStateObjects {
+        template<typename Interface, typename Description>
+        Interface* Get(std::vector<Description>& created, const Description& description) {
+            ++requestsCount;
+            for (size_t i = 0; i < created.size(); ++i) {
+                if (StateDescriptionEqual()(created[i], description)) {
+                    return MakeObject<Interface>(i);
+                }
+            }
+            created.push_back(description);
+            return MakeObject<Interface>(created.size() - 1);
+        }
+
+        ID3D11BlendState* GetBlendState(const D3D11_BLEND_DESC& description) {
+            return Get<ID3D11BlendState>(blendStates, description);
+        }
+
+        ID3D11RasterizerState* GetRasterizerState(const D3D11_RASTERIZER_DESC& description) {
+            return Get<ID3D11RasterizerState>(rasterizerStates, description);
+        }
+
+        ID3D11DepthStencilState* GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& description) {
+            return Get<ID3D11DepthStencilState>(depthStencilStates, description);
+        }
+
+        std::vector<D3D11_BLEND_DESC> blendStates;
+        std::vector<D3D11_RASTERIZER_DESC> rasterizerStates;
+        std::vector<D3D11_DEPTH_STENCIL_DESC> depthStencilStates;
+        size_t requestsCount = 0;
+    };
+}
+
+TEST_CASE(EqualDescriptionsAreSame) {
+    CHECK(AreSame(PipelineStateDescription(), PipelineStateDescription()));
+    CHECK(AreSame(Dirty(MakeDescription(), 0x00), Dirty(MakeDescription(), 0xCD)));
+
+    // Negative zero blend factor is the same value
+    auto desc = MakeDescription();
+    auto negative = desc;
+    desc.blendFactor[1] = 0.0f;
+    negative.blendFactor[1] = -0.0f;
+    CHECK(AreSame(desc, negative));
+}
+
+TEST_CASE(AnySingleFieldChangeDiffers) {
+    auto base = MakeDescription();
+    auto changes = MakeSingleFieldChanges();
+    std::vector<PipelineStateDescription> changed;
+    for (auto& change : changes) {
+        auto desc = base;
+        change(desc);
+        CHECK(AreDifferent(base, desc));
+        changed.push_back(desc);
+    }
+
+    // Changes of different fields also differ from each other
+    for (size_t i = 0; i < changed.size(); ++i) {
+        for (size_t j = i + 1; j < changed.size(); ++j) {
+            CHECK(!PipelineStateDescriptionEqual()(changed[i], changed[j]));
+        }
+    }
+}
+
+TEST_CASE(GetOrCreateDeduplicates) {
+    FakeStateObjects stateObjects;
+    BasicPipelineStateCache<FakeStateObjects> cache(&stateObjects);
+    CHECK(&cache.GetStateObjects() == &stateObjects);
+
+    auto& first = cache.GetOrCreate(MakeDescription());
+    auto& again = cache.GetOrCreate(Dirty(MakeDescription(), 0x77));
+    CHECK(&first == &again);
+    CHECK(first.GetId() == 0);
+    CHECK(cache.GetSize() == 1);
+    CHECK(cache.GetStatistics().requestsCount == 2);
+    CHECK(cache.GetStatistics().createdCount == 1);
+    // State objects are requested only for new pipelines
+    CHECK(stateObjects.requestsCount == 3);
+
+    // Other shaders: a new pipeline that shares state objects with the first one
+    auto desc = MakeDescription();
+    desc.pixelShader = MakeObject<ID3D11PixelShader>(8);
+    auto& other = cache.GetOrCreate(desc);
+    CHECK(&other != &first);
+    CHECK(other.GetId() == 1);
+    CHECK(other.GetBlendState() == first.GetBlendState());
+    CHECK(other.GetRasterizerState() == first.GetRasterizerState());
+    CHECK(other.GetDepthStencilState() == first.GetDepthStencilState());
+    CHECK(other.GetDescription().pixelShader == desc.pixelShader);
+
+    // Other rasterizer state: only that object is new
+    desc.rasterizer.CullMode = D3D11_CULL_FRONT;
+    auto& culled = cache.GetOrCreate(desc);
+    CHECK(culled.GetId() == 2);
+    CHECK(culled.GetRasterizerState() != first.GetRasterizerState());
+    CHECK(culled.GetBlendState() == first.GetBlendState());
+    CHECK(stateObjects.rasterizerStates.size() == 2);
+    CHECK(stateObjects.blendStates.size() == 1);
+
+    // Every pipeline created once, every request counted
+    for (auto& change : MakeSingleFieldChanges()) {
+        auto changed = MakeDescription();
+        change(changed);
+        cache.GetOrCreate(changed);
+        cache.GetOrCreate(changed);
+    }
+    CHECK(cache.GetSize() == cache.GetStatistics().createdCount);
+    CHECK(&cache.GetOrCreate(MakeDescription()) == &first);
+}
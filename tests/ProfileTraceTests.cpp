@@ -0,0 +1,127 @@
+#include <sstream>
+#include <string>
+#include <vector>
+#include "D3D_Tools/ProfileTrace.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    // Frame -> { Shadows, GBuffer -> { Shadows } } with times in microseconds from the frame start.
+    // GPU clock runs at 1 MHz, so ticks are microseconds too
+    ProfileFrame MakeFrame(uint64_t frameIndex, uint64_t gpuExtra = 0, bool disjoint = false) {
+        uint64_t base = frameIndex * 20000000;
+        ProfileFrameBuilder builder;
+        builder.Reset(frameIndex);
+        auto frame = builder.BeginScope("Frame", base);
+        auto shadows = builder.BeginScope("Shadows", base + 1000000);
+        builder.EndScope(shadows, base + 4000000);
+        auto gbuffer = builder.BeginScope("GBuffer", base + 4000000);
+        auto nested = builder.BeginScope("Shadows", base + 5000000);
+        builder.EndScope(nested, base + 6000000);
+        builder.EndScope(gbuffer, base + 9000000);
+        builder.EndScope(frame, base + 10000000);
+
+        builder.SetGpuTime(frame, 5000, 15000 + gpuExtra);
+        builder.SetGpuTime(shadows, 6000, 8000);
+        builder.SetGpuTime(gbuffer, 8000, 14000);
+        builder.SetGpuClock(1000000, disjoint);
+        return builder.GetFrame();
+    }
+
+    bool Contains(const std::string& str, const std::string& part) {
+        return str.find(part) != std::string::npos;
+    }
+}
+
+TEST_CASE(BuilderRecordsHierarchy) {
+    auto frame = MakeFrame(0);
+    CHECK(frame.scopes.size() == 4);
+    CHECK(frame.scopes[0].parent == ProfileScope::NoParent && frame.scopes[0].depth == 0);
+    CHECK(frame.scopes[1].parent == 0 && frame.scopes[1].depth == 1);
+    CHECK(frame.scopes[3].parent == 2 && frame.scopes[3].depth == 2);
+    CHECK_NEAR(frame.GetCpuMilliseconds(frame.scopes[0]), 10.0, 1e-9);
+    CHECK_NEAR(frame.GetGpuMilliseconds(frame.scopes[2]), 6.0, 1e-9);
+    // Not measured on GPU
+    CHECK(!frame.HasGpuTime(frame.scopes[3]));
+    CHECK(frame.GetGpuMilliseconds(frame.scopes[3]) == 0.0);
+}
+
+TEST_CASE(ImproperlyNestedEndIsIgnored) {
+    ProfileFrameBuilder builder;
+    builder.Reset(0);
+    auto outer = builder.BeginScope("Outer", 0);
+    auto inner = builder.BeginScope("Inner", 1);
+    CHECK(!builder.EndScope(outer, 2));
+    CHECK(!builder.EndScope(7, 2));
+    CHECK(builder.GetOpenScopesCount() == 2);
+    CHECK(builder.EndScope(inner, 3));
+    CHECK(builder.EndScope(outer, 4));
+    CHECK(!builder.EndScope(outer, 5));
+    CHECK(builder.GetFrame().scopes[0].cpuEnd == 4);
+}
+
+TEST_CASE(AggregatorKeysScopesByPath) {
+    ProfileAggregator aggregator;
+    aggregator.Add(MakeFrame(0));
+    aggregator.Add(MakeFrame(1, 2000));
+
+    auto& entries = aggregator.GetEntries();
+    CHECK(aggregator.GetFramesCount() == 2);
+    CHECK(entries.size() == 4);
+    // Shadows under the frame and under GBuffer are different entries
+    CHECK(entries[1].name == "Shadows" && entries[1].parent == 0);
+    CHECK(entries[3].name == "Shadows" && entries[3].parent == 2);
+    CHECK(entries[3].depth == 2);
+
+    CHECK(entries[0].count == 2);
+    CHECK_NEAR(entries[0].GetAverageCpuMilliseconds(), 10.0, 1e-9);
+    CHECK_NEAR(entries[0].GetAverageGpuMilliseconds(), 11.0, 1e-9);
+    CHECK_NEAR(entries[0].gpuMax, 12.0, 1e-9);
+    CHECK(entries[3].gpuCount == 0);
+    CHECK(entries[3].GetAverageGpuMilliseconds() == 0.0);
+
+    aggregator.Clear();
+    CHECK(aggregator.GetEntries().empty());
+    aggregator.Add(MakeFrame(2));
+    CHECK(aggregator.GetEntries().size() == 4);
+}
+
+TEST_CASE(DisjointFramesHaveNoGpuTime) {
+    ProfileAggregator aggregator;
+    aggregator.Add(MakeFrame(0));
+    aggregator.Add(MakeFrame(1, 0, true));
+    auto& frame = aggregator.GetEntries()[0];
+    CHECK(frame.count == 2);
+    CHECK(frame.gpuCount == 1);
+    CHECK_NEAR(frame.GetAverageCpuMilliseconds(), 10.0, 1e-9);
+}
+
+TEST_CASE(ChromeTraceHasCpuAndGpuEvents) {
+    std::vector<ProfileFrame> frames{ MakeFrame(0), MakeFrame(1, 0, true) };
+    frames[0].scopes[1].name = "Shadows \"cascade\"\n";
+
+    std::ostringstream output;
+    WriteChromeTrace(output, frames);
+    auto json = output.str();
+
+    CHECK(Contains(json, "{\"name\":\"Frame\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":0.000,\"dur\":10000.000,\"args\":{\"frame\":0}}"));
+    CHECK(Contains(json, "\"name\":\"Shadows \\\"cascade\\\"\\n\""));
+    // GPU timeline starts with the first CPU scope of the frame
+    CHECK(Contains(json, "{\"name\":\"Frame\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":0.000,\"dur\":10000.000,\"args\":{\"frame\":0}}"));
+    CHECK(Contains(json, "{\"name\":\"GBuffer\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":3000.000,\"dur\":6000.000,\"args\":{\"frame\":0}}"));
+    // The disjoint frame only has CPU events
+    CHECK(Contains(json, "\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":20000.000,\"dur\":10000.000,\"args\":{\"frame\":1}}"));
+    CHECK(!Contains(json, "\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":20000.000"));
+    CHECK(json.compare(json.size() - 4, 4, "\n]}\n") == 0);
+
+    // Stream formatting is restored
+    output << 1.5;
+    CHECK(output.str().compare(output.str().size() - 3, 3, "1.5") == 0);
+}
+
+TEST_CASE(WideTitlesConvertToUtf8) {
+    CHECK(ConvertToUtf8(L"Pass") == "Pass");
+    CHECK(ConvertToUtf8(L"Pass\u00e9\u4e2d") == "Pass\xc3\xa9\xe4\xb8\xad");
+    CHECK(ConvertToUtf8(std::wstring(1, wchar_t(0x1F600))) == "\xf0\x9f\x98\x80");
+}
@@ -0,0 +1,119 @@
+#include <cstdint>
+#include <vector>
+#include "D3D_Tools/ReadbackTracker.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+TEST_CASE(RequestsWaitForLatencyFrames) {
+    ReadbackTracker tracker(2);
+    CHECK(tracker.Submit() == 0);
+    CHECK(tracker.Submit() == 1);
+
+    std::vector<uint64_t> completed;
+    auto gpuDone = [&](uint64_t id) {
+        completed.push_back(id);
+        return true;
+    };
+    CHECK(tracker.Poll(gpuDone) == 0);
+    tracker.AdvanceFrame();
+    CHECK(tracker.Poll(gpuDone) == 0);
+    CHECK(completed.empty());
+
+    auto late = tracker.Submit();
+    tracker.AdvanceFrame();
+    std::vector<uint32_t> latencies;
+    CHECK(tracker.Poll([&](uint64_t id) {
+        latencies.push_back(tracker.GetCompletingLatency());
+        completed.push_back(id);
+        return true;
+    }) == 2);
+    CHECK((completed == std::vector<uint64_t>{ 0, 1 }));
+    CHECK((latencies == std::vector<uint32_t>{ 2, 2 }));
+    CHECK(tracker.GetPendingCount() == 1);
+
+    tracker.AdvanceFrame();
+    CHECK(tracker.Poll(gpuDone) == 1);
+    CHECK(completed.back() == late);
+    CHECK(tracker.GetPendingCount() == 0);
+    CHECK(tracker.GetOldestPendingAge() == 0);
+}
+
+TEST_CASE(PollStopsAtFirstUnfinishedRequest) {
+    ReadbackTracker tracker(1);
+    tracker.Submit();
+    tracker.Submit();
+    tracker.AdvanceFrame();
+    tracker.AdvanceFrame();
+
+    // GPU completes copies in order: a later request is not asked for while an earlier one is not done
+    std::vector<uint64_t> asked;
+    CHECK(tracker.Poll([&](uint64_t id) {
+        asked.push_back(id);
+        return false;
+    }) == 0);
+    CHECK((asked == std::vector<uint64_t>{ 0 }));
+    CHECK(tracker.GetOldestPendingAge() == 2);
+    CHECK(tracker.GetCompletingSubmitFrame() == 0);
+
+    CHECK(tracker.Poll([](uint64_t) { return true; }) == 2);
+    CHECK(tracker.GetStatistics().minLatencyFrames == 2);
+}
+
+TEST_CASE(ZeroLatencyCompletesInSameFrame) {
+    ReadbackTracker tracker(0);
+    tracker.Submit();
+    CHECK(tracker.Poll([](uint64_t) { return true; }) == 1);
+    CHECK(tracker.GetStatistics().maxLatencyFrames == 0);
+}
+
+TEST_CASE(DrainCompletesEverythingAndCountsStatistics) {
+    ReadbackTracker tracker(2);
+    tracker.Submit();
+    tracker.AdvanceFrame();
+    tracker.AdvanceFrame();
+    tracker.AdvanceFrame();
+    CHECK(tracker.Poll([](uint64_t) { return true; }) == 1);
+
+    tracker.Submit();
+    tracker.Submit();
+    tracker.Reject();
+    std::vector<uint64_t> drained;
+    CHECK(tracker.Drain([&](uint64_t id) { drained.push_back(id); }) == 2);
+    CHECK((drained == std::vector<uint64_t>{ 1, 2 }));
+    CHECK(tracker.GetPendingCount() == 0);
+
+    auto& statistics = tracker.GetStatistics();
+    CHECK(statistics.submittedCount == 3);
+    CHECK(statistics.completedCount == 3);
+    CHECK(statistics.drainedCount == 2);
+    CHECK(statistics.rejectedCount == 1);
+    CHECK(statistics.minLatencyFrames == 0);
+    CHECK(statistics.maxLatencyFrames == 3);
+    CHECK_NEAR(statistics.GetAverageLatencyFrames(), 1.0, 1e-9);
+}
+
+TEST_CASE(CompletingRequestIsOnlyKnownWhilePending) {
+    ReadbackTracker tracker;
+    CHECK_THROWS(tracker.GetCompletingLatency(), std::logic_error);
+    CHECK_THROWS(tracker.GetCompletingSubmitFrame(), std::logic_error);
+    CHECK(tracker.GetStatistics().GetAverageLatencyFrames() == 0.0);
+}
+
+TEST_CASE(StagingSizesAreRounded) {
+    CHECK(ComputeReadbackStagingSize(1) == 16);
+    CHECK(ComputeReadbackStagingSize(16) == 16);
+    CHECK(ComputeReadbackStagingSize(17) == 32);
+    CHECK(ComputeReadbackStagingSize(1000) == 1024);
+    CHECK(ComputeReadbackStagingSize(65536) == 65536);
+    CHECK(ComputeReadbackStagingSize(65537) == 131072);
+    CHECK(ComputeReadbackStagingSize(200000) == 262144);
+    CHECK(ComputeReadbackStagingSize(0xFFFFFFFFu) == 0xFFFFFFFFu);
+
+    // Every size gets a staging buffer it fits in, at most twice as large below 64KB
+    for (uint32_t size = 1; size < (1u << 20); size += 97) {
+        auto staging = ComputeReadbackStagingSize(size);
+        CHECK(staging >= size);
+        CHECK(staging < 2 * size + 16 || staging - size < 65536);
+    }
+}
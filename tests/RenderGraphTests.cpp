@@ -0,0 +1,129 @@
+#include <memory>
+#include "D3D_Tools/RenderGraph.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    const RenderGraphTextureDesc ColorDesc{ 1920, 1080, 1, 1, TextureFormat::R8_G8_B8_A8_UNORM };
+    const RenderGraphTextureDesc DepthDesc{ 1920, 1080, 1, 1, TextureFormat::D24_UNORM_S8_UINT };
+
+    struct Frame {
+        RenderGraph graph;
+        RenderGraphTexture backBuffer;
+        RenderGraphTexture scene;
+        RenderGraphTexture depth;
+        RenderGraphTexture bloomA;
+        RenderGraphTexture bloomB;
+        RenderGraphTexture debug;
+    };
+
+    // gbuffer -> bloomA -> bloomB -> composite, with a debug pass nobody reads
+    void BuildFrame(Frame& frame) {
+        RenderGraphClear clear;
+        clear.enabled = true;
+        auto& graph = frame.graph;
+        frame.backBuffer = graph.ImportTexture(ColorDesc, "backbuffer");
+        graph.AddPass("gbuffer", [&](RenderGraphBuilder& builder) {
+            frame.scene = builder.CreateTexture(ColorDesc, "scene");
+            frame.depth = builder.CreateTexture(DepthDesc, "depth");
+            builder.WriteRenderTarget(frame.scene, clear);
+            builder.WriteDepthStencil(frame.depth, clear);
+        }, nullptr);
+        graph.AddPass("debug", [&](RenderGraphBuilder& builder) {
+            frame.debug = builder.CreateTexture(ColorDesc, "debug");
+            builder.Read(frame.depth);
+            builder.WriteRenderTarget(frame.debug, clear);
+        }, nullptr);
+        graph.AddPass("bloomA", [&](RenderGraphBuilder& builder) {
+            frame.bloomA = builder.CreateTexture(ColorDesc, "bloomA");
+            builder.Read(frame.scene);
+            builder.WriteRenderTarget(frame.bloomA, clear);
+        }, nullptr);
+        graph.AddPass("bloomB", [&](RenderGraphBuilder& builder) {
+            frame.bloomB = builder.CreateTexture(ColorDesc, "bloomB");
+            builder.Read(frame.bloomA);
+            builder.WriteRenderTarget(frame.bloomB, clear);
+        }, nullptr);
+        graph.AddPass("composite", [&](RenderGraphBuilder& builder) {
+            builder.Read(frame.bloomB);
+            builder.Read(frame.scene);
+            builder.WriteRenderTarget(frame.backBuffer);
+        }, nullptr);
+    }
+
+    std::vector<std::string> GetBegunPasses(const RenderGraphRecorder& recorder) {
+        std::vector<std::string> result;
+        for (auto& command : recorder.GetCommands()) {
+            if (command.type == RenderGraphRecorder::CommandType::BeginPass) {
+                result.push_back(command.passName);
+            }
+        }
+        return result;
+    }
+}
+
+TEST_CASE(UnusedPassesAreCulled) {
+    Frame frame;
+    BuildFrame(frame);
+    frame.graph.Compile();
+    CHECK(frame.graph.IsPassCulled(1));
+    CHECK(!frame.graph.IsPassCulled(0) && !frame.graph.IsPassCulled(4));
+    CHECK(frame.graph.GetExecutionOrder().size() == 4);
+    CHECK(frame.graph.GetPhysicalTexture(frame.debug) == RenderGraph::InvalidIndex);
+}
+
+TEST_CASE(TexturesWithDisjointLifetimesShareMemory) {
+    Frame frame;
+    BuildFrame(frame);
+    frame.graph.Compile();
+    auto& graph = frame.graph;
+    // bloomA is dead once bloomB is written, scene lives until composite
+    CHECK(graph.GetPhysicalTexture(frame.bloomA) != graph.GetPhysicalTexture(frame.scene));
+    CHECK(graph.GetPhysicalTexture(frame.bloomB) != graph.GetPhysicalTexture(frame.scene));
+    CHECK(graph.GetPhysicalTexture(frame.backBuffer) != graph.GetPhysicalTexture(frame.bloomA));
+    CHECK(graph.GetPhysicalTextures().size() == 5);
+}
+
+TEST_CASE(ReadsAreBoundInDeclarationOrder) {
+    Frame frame;
+    BuildFrame(frame);
+    frame.graph.Compile();
+    RenderGraphRecorder recorder;
+    frame.graph.Execute(recorder);
+
+    auto& graph = frame.graph;
+    for (auto& command : recorder.GetCommands()) {
+        if (command.type == RenderGraphRecorder::CommandType::BeginPass && command.passName == "composite") {
+            auto& reads = command.bindings.shaderResources;
+            CHECK(reads.size() == 2);
+            CHECK(reads[0] == graph.GetPhysicalTexture(frame.bloomB));
+            CHECK(reads[1] == graph.GetPhysicalTexture(frame.scene));
+        }
+    }
+}
+
+TEST_CASE(CompiledGraphCanBeCopied) {
+    std::unique_ptr<Frame> frame(new Frame());
+    BuildFrame(*frame);
+    frame->graph.Compile();
+
+    // Bindings of the copy must not refer to the original
+    auto graph = frame->graph;
+    frame.reset();
+
+    RenderGraphRecorder recorder;
+    graph.Execute(recorder);
+    CHECK((GetBegunPasses(recorder) == std::vector<std::string>{ "gbuffer", "bloomA", "bloomB", "composite" }));
+}
+
+TEST_CASE(ReadBeforeWriteIsRejected) {
+    RenderGraph graph;
+    auto backBuffer = graph.ImportTexture(ColorDesc, "backbuffer");
+    graph.AddPass("read", [&](RenderGraphBuilder& builder) {
+        auto texture = builder.CreateTexture(ColorDesc, "texture");
+        builder.Read(texture);
+        builder.WriteRenderTarget(backBuffer);
+    }, nullptr);
+    CHECK_THROWS(graph.Compile(), std::logic_error);
+}
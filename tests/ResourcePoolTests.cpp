@@ -0,0 +1,100 @@
+#include <functional>
+#include <memory>
+#include "D3D_Tools/ResourcePool.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    // Descriptions are sizes in bytes. Negative sizes make ComputeSize throw, zero makes Create throw
+    struct CountingFactory {
+        using Description = int;
+        using Resource = std::shared_ptr<int>;
+        using DescriptionHash = std::hash<int>;
+        using DescriptionEqual = std::equal_to<int>;
+
+        Resource Create(int description) {
+            if (description == 0) {
+                throw std::runtime_error("Creation failed");
+            }
+            ++*live;
+            return Resource(new int(description), [live = live](int* resource) {
+                --*live;
+                delete resource;
+            });
+        }
+
+        size_t ComputeSize(int description) {
+            if (description < 0) {
+                throw std::invalid_argument("Unknown size");
+            }
+            return static_cast<size_t>(description);
+        }
+
+        int* live;
+    };
+
+    using Pool = ResourcePool<CountingFactory>;
+}
+
+TEST_CASE(ReturnedResourcesAreReused) {
+    int live = 0;
+    Pool pool(CountingFactory{ &live });
+    int* first = nullptr;
+    int* second = nullptr;
+    {
+        auto a = pool.Acquire(100);
+        auto b = pool.Acquire(100);
+        first = a.Get().get();
+        second = b.Get().get();
+        CHECK(live == 2);
+    }
+    CHECK(pool.GetFreeCount() == 2);
+
+    auto c = pool.Acquire(100);
+    CHECK(c.Get().get() == first || c.Get().get() == second);
+    CHECK(pool.GetStatistics().hitsCount == 1);
+    CHECK(pool.GetStatistics().createdCount == 2);
+    CHECK(pool.GetStatistics().peakBytes == 200);
+}
+
+TEST_CASE(UnusedResourcesAreEvicted) {
+    int live = 0;
+    Pool pool(CountingFactory{ &live }, ResourcePoolSettings{ 0, 2 });
+    pool.Acquire(100);
+    pool.EndFrame();
+    pool.EndFrame();
+    CHECK(live == 1);
+    pool.EndFrame();
+    CHECK(live == 0);
+    CHECK(pool.GetStatistics().currentBytes == 0);
+    CHECK(pool.GetStatistics().evictedCount == 1);
+}
+
+TEST_CASE(ReuseDelayIsRespected) {
+    int live = 0;
+    Pool pool(CountingFactory{ &live }, ResourcePoolSettings{ 1, 5 });
+    pool.Acquire(7);
+    pool.Acquire(7);
+    CHECK(pool.GetStatistics().hitsCount == 0);
+    pool.EndFrame();
+    pool.Acquire(7);
+    CHECK(pool.GetStatistics().hitsCount == 1);
+
+    pool.Trim();
+    CHECK(live == 0);
+    CHECK(pool.GetStatistics().currentBytes == 0);
+}
+
+TEST_CASE(FailedAcquireLeavesPoolUntouched) {
+    int live = 0;
+    Pool pool(CountingFactory{ &live });
+    CHECK_THROWS(pool.Acquire(0), std::runtime_error);
+    CHECK_THROWS(pool.Acquire(-1), std::invalid_argument);
+    CHECK(pool.GetFreeCount() == 0);
+    CHECK(pool.GetStatistics().currentBytes == 0);
+    CHECK(pool.GetStatistics().createdCount == 0);
+
+    pool.Trim();
+    CHECK(pool.GetStatistics().currentBytes == 0);
+}
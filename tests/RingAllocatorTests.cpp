@@ -0,0 +1,97 @@
+#include "D3D_Tools/RingAllocator.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+TEST_CASE(AllocationsAreAlignedAndSequential) {
+    RingAllocator ring(256);
+    auto first = ring.Allocate(100, 16);
+    auto second = ring.Allocate(100, 16);
+    CHECK(first.IsValid() && first.offset == 0 && !first.wrapped);
+    CHECK(second.IsValid() && second.offset == 112 && !second.wrapped);
+    // Padding counts as used
+    CHECK(ring.GetUsedSize() == 212);
+}
+
+TEST_CASE(MemoryIsReleasedOnlyWhenFenceIsCompleted) {
+    RingAllocator ring(256);
+    ring.Allocate(100, 16);
+    ring.Allocate(100, 16);
+    ring.FinishFrame(1);
+    CHECK(!ring.Allocate(100, 16).IsValid());
+
+    ring.Retire(0);
+    CHECK(!ring.Allocate(100, 16).IsValid());
+    CHECK(ring.GetFramesInFlight() == 1);
+
+    ring.Retire(1);
+    CHECK(ring.GetUsedSize() == 0);
+    CHECK(ring.GetFramesInFlight() == 0);
+}
+
+TEST_CASE(AllocationWrapsWhenTailIsTooShort) {
+    RingAllocator ring(256);
+    ring.Allocate(200, 16);
+    ring.FinishFrame(1);
+    ring.Allocate(40, 16);
+    ring.FinishFrame(2);
+    ring.Retire(1);
+
+    // 16 bytes are left at the end, the start of the ring is free
+    auto wrapped = ring.Allocate(100, 16);
+    CHECK(wrapped.IsValid() && wrapped.wrapped && wrapped.offset == 0);
+    // The skipped tail is consumed too
+    CHECK(ring.GetUsedSize() == 40 + 16 + 100);
+}
+
+TEST_CASE(AllocationNeverOverlapsFramesInFlight) {
+    RingAllocator ring(256);
+    ring.Allocate(100, 16);
+    ring.FinishFrame(1);
+    ring.Allocate(100, 16);
+    ring.FinishFrame(2);
+    ring.Retire(1);
+
+    auto wrapped = ring.Allocate(90, 16);
+    CHECK(wrapped.IsValid() && wrapped.wrapped && wrapped.offset == 0);
+    // Frame 2 occupies [100, 212) together with its alignment padding
+    CHECK(!ring.Allocate(8, 16).IsValid());
+    auto small = ring.Allocate(8, 4);
+    CHECK(small.IsValid() && small.offset == 92 && !small.wrapped);
+    CHECK(!ring.Allocate(1).IsValid());
+}
+
+TEST_CASE(EmptyRingContinuesWithoutWrapping) {
+    RingAllocator ring(256);
+    ring.Allocate(100, 1);
+    ring.FinishFrame(1);
+    ring.Retire(1);
+
+    auto next = ring.Allocate(100, 1);
+    CHECK(next.IsValid() && next.offset == 100 && !next.wrapped);
+}
+
+TEST_CASE(WholeCapacityCanBeAllocated) {
+    RingAllocator ring(256);
+    auto all = ring.Allocate(256);
+    CHECK(all.IsValid() && all.offset == 0);
+    CHECK(!ring.Allocate(1).IsValid());
+}
+
+TEST_CASE(InvalidArgumentsThrow) {
+    CHECK_THROWS(RingAllocator(0), std::invalid_argument);
+    RingAllocator ring(256);
+    CHECK_THROWS(ring.Allocate(257), std::invalid_argument);
+    CHECK_THROWS(ring.Allocate(16, 0), std::invalid_argument);
+    CHECK_THROWS(ring.Allocate(16, 12), std::invalid_argument);
+}
+
+TEST_CASE(ResetForgetsFramesInFlight) {
+    RingAllocator ring(256);
+    ring.Allocate(200);
+    ring.FinishFrame(1);
+    ring.Reset();
+    CHECK(ring.GetUsedSize() == 0 && ring.GetFramesInFlight() == 0);
+    auto allocation = ring.Allocate(200);
+    CHECK(allocation.IsValid() && allocation.offset == 0);
+}
@@ -0,0 +1,103 @@
+#include <atomic>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "D3D_Tools/ShaderBytecodeBatch.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    // "Bytecode" is the text of the request, so results can be matched to jobs
+    std::vector<uint8_t> StubCompile(const ShaderCompileRequest& request) {
+        if (request.entryPoint == "broken") {
+            throw std::runtime_error("syntax error");
+        }
+        std::string text = std::string(request.target) + ":" + std::string(request.entryPoint);
+        for (auto& macro : request.macros) {
+            text += " " + std::string(macro.name) + "=" + std::string(macro.value);
+        }
+        return std::vector<uint8_t>(text.begin(), text.end());
+    }
+
+    std::string ToString(const std::vector<uint8_t>& bytecode) {
+        return std::string(bytecode.begin(), bytecode.end());
+    }
+
+    std::vector<ShaderBytecodeJob> MakePermutations(size_t count) {
+        std::vector<ShaderBytecodeJob> jobs;
+        for (size_t i = 0; i < count; ++i) {
+            ShaderBytecodeJob job;
+            job.code = "float4 main() : SV_Target { return VALUE; }";
+            job.entryPoint = "main";
+            job.target = "ps_5_0";
+            job.macros.push_back(ShaderMacroDefinition{ "VALUE", std::to_string(i) });
+            jobs.push_back(std::move(job));
+        }
+        return jobs;
+    }
+}
+
+TEST_CASE(BatchResultsMatchJobs) {
+    ThreadPool pool(4);
+    ShaderBytecodeBatchCompiler compiler(pool, StubCompile);
+    auto futures = compiler.Submit(MakePermutations(200));
+    CHECK(futures.size() == 200);
+    for (size_t i = 0; i < futures.size(); ++i) {
+        CHECK(ToString(compiler.Get(futures[i])) == "ps_5_0:main VALUE=" + std::to_string(i));
+    }
+}
+
+TEST_CASE(EmptyBatchSubmitsNothing) {
+    ThreadPool pool(2);
+    ShaderBytecodeBatchCompiler compiler(pool, StubCompile);
+    CHECK(compiler.Submit(std::vector<ShaderBytecodeJob>()).empty());
+    CHECK(!pool.RunPendingTask());
+}
+
+TEST_CASE(CompileErrorsGoToTheirFutures) {
+    ThreadPool pool(2);
+    ShaderBytecodeBatchCompiler compiler(pool, StubCompile);
+    auto jobs = MakePermutations(3);
+    jobs[1].entryPoint = "broken";
+    auto futures = compiler.Submit(std::move(jobs));
+    CHECK(ToString(compiler.Get(futures[0])) == "ps_5_0:main VALUE=0");
+    CHECK_THROWS(compiler.Get(futures[1]), std::runtime_error);
+    CHECK(ToString(compiler.Get(futures[2])) == "ps_5_0:main VALUE=2");
+}
+
+TEST_CASE(CompilerIsRequired) {
+    ThreadPool pool(1);
+    CHECK_THROWS(ShaderBytecodeBatchCompiler(pool, nullptr), std::invalid_argument);
+}
+
+TEST_CASE(BatchSharesCache) {
+    auto directory = std::filesystem::temp_directory_path() / "d3d_tools_shader_batch_cache";
+    std::filesystem::remove_all(directory);
+    {
+        std::atomic<int> callsCount{ 0 };
+        ShaderCompiler counting = [&](const ShaderCompileRequest& request) {
+            ++callsCount;
+            return StubCompile(request);
+        };
+        ShaderCache cache(directory);
+        ThreadPool pool(4);
+        ShaderBytecodeBatchCompiler compiler(pool, counting, &cache);
+
+        auto first = compiler.Submit(MakePermutations(50));
+        for (auto& future : first) {
+            compiler.Get(future);
+        }
+        CHECK(callsCount == 50);
+
+        auto second = compiler.Submit(MakePermutations(50));
+        for (size_t i = 0; i < second.size(); ++i) {
+            CHECK(ToString(compiler.Get(second[i])) == "ps_5_0:main VALUE=" + std::to_string(i));
+        }
+        CHECK(callsCount == 50);
+        CHECK(cache.GetHitsCount() == 50);
+    }
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+}
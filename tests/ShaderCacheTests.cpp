@@ -0,0 +1,268 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "D3D_Tools/ShaderCache.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    // Cache directory in the temporary directory, removed when the test ends
+    struct TemporaryDirectory {
+        explicit TemporaryDirectory(const char* name) :
+            path(std::filesystem::temp_directory_path() / (std::string("d3d_tools_") + name))
+        {
+            std::filesystem::remove_all(path);
+        }
+
+        ~TemporaryDirectory() {
+            std::error_code error;
+            std::filesystem::remove_all(path, error);
+        }
+
+        std::filesystem::path path;
+    };
+
+    ShaderCompileRequest MakeRequest() {
+        ShaderCompileRequest request;
+        request.source = "float4 main() : SV_Target { return COLOR; }";
+        request.macros = { ShaderMacro{ "COLOR", "1" }, ShaderMacro{ "SHADOWS", "" } };
+        request.entryPoint = "main";
+        request.target = "ps_5_0";
+        request.flags = 0;
+        return request;
+    }
+
+    // Stands in for D3DCompile: "bytecode" is the target and entry point, and calls are counted
+    struct StubCompiler {
+        std::vector<uint8_t> operator()(const ShaderCompileRequest& request) const {
+            ++*callsCount;
+            std::string text = std::string(request.target) + ":" + std::string(request.entryPoint);
+            for (auto& macro : request.macros) {
+                text += " " + std::string(macro.name) + "=" + std::string(macro.value);
+            }
+            return std::vector<uint8_t>(text.begin(), text.end());
+        }
+
+        int* callsCount;
+    };
+
+    std::vector<uint8_t> ToVector(const ShaderCacheEntry& entry) {
+        return std::vector<uint8_t>(entry.GetData(), entry.GetData() + entry.GetSize());
+    }
+}
+
+TEST_CASE(KeyDependsOnEveryInput) {
+    auto request = MakeRequest();
+    auto key = ComputeShaderCacheKey(request);
+    CHECK(ComputeShaderCacheKey(MakeRequest()) == key);
+
+    auto changed = MakeRequest();
+    changed.source = "float4 main() : SV_Target { return COLOR * 2; }";
+    CHECK(ComputeShaderCacheKey(changed) != key);
+
+    changed = MakeRequest();
+    changed.macros[0].value = "2";
+    CHECK(ComputeShaderCacheKey(changed) != key);
+
+    changed = MakeRequest();
+    changed.macros.pop_back();
+    CHECK(ComputeShaderCacheKey(changed) != key);
+
+    // Boundaries between macro names and values are part of the key
+    changed = MakeRequest();
+    changed.macros[0] = ShaderMacro{ "COLO", "R1" };
+    CHECK(ComputeShaderCacheKey(changed) != key);
+
+    changed = MakeRequest();
+    changed.entryPoint = "main2";
+    CHECK(ComputeShaderCacheKey(changed) != key);
+
+    changed = MakeRequest();
+    changed.target = "ps_4_0";
+    CHECK(ComputeShaderCacheKey(changed) != key);
+
+    changed = MakeRequest();
+    changed.flags = 1;
+    CHECK(ComputeShaderCacheKey(changed) != key);
+}
+
+TEST_CASE(IndexRoundTrips) {
+    ShaderCacheIndex index;
+    index.Touch(3, 300, 10);
+    index.Touch(1, 100, 20);
+    index.Touch(2, 200, 30);
+    auto data = index.Serialize();
+
+    ShaderCacheIndex parsed;
+    CHECK(parsed.Parse(data.data(), data.size()));
+    CHECK(parsed.GetEntriesCount() == 3);
+    CHECK(parsed.GetTotalSize() == 600);
+    CHECK(parsed.Serialize() == data);
+
+    ShaderCacheIndex empty;
+    auto emptyData = empty.Serialize();
+    CHECK(parsed.Parse(emptyData.data(), emptyData.size()));
+    CHECK(parsed.GetEntriesCount() == 0);
+}
+
+TEST_CASE(IndexRejectsDamagedData) {
+    ShaderCacheIndex index;
+    index.Touch(1, 100, 10);
+    index.Touch(2, 200, 20);
+    auto data = index.Serialize();
+
+    ShaderCacheIndex parsed;
+    for (size_t size = 0; size < data.size(); ++size) {
+        CHECK(!parsed.Parse(data.data(), size));
+        CHECK(parsed.GetEntriesCount() == 0);
+    }
+
+    // Every byte is either in the header fields or in the checksummed entries
+    for (size_t i = 0; i < data.size(); ++i) {
+        auto damaged = data;
+        damaged[i] ^= 0x40;
+        CHECK(!parsed.Parse(damaged.data(), damaged.size()));
+    }
+
+    auto longer = data;
+    longer.push_back(0);
+    CHECK(!parsed.Parse(longer.data(), longer.size()));
+}
+
+TEST_CASE(IndexMergeKeepsLatestUse) {
+    ShaderCacheIndex a;
+    a.Touch(1, 100, 10);
+    a.Touch(2, 100, 40);
+    ShaderCacheIndex b;
+    b.Touch(1, 100, 30);
+    b.Touch(3, 100, 20);
+    a.Merge(b);
+    CHECK(a.GetEntriesCount() == 3);
+    // 1 is now newer than 3, so 3 goes first
+    CHECK((a.SelectEvictions(100) == std::vector<uint64_t>{ 3, 1 }));
+}
+
+TEST_CASE(EvictionsAreLeastRecentlyUsedWithinBudget) {
+    ShaderCacheIndex index;
+    index.Touch(10, 100, 3);
+    index.Touch(20, 100, 1);
+    index.Touch(30, 100, 2);
+    index.Touch(40, 100, 2);
+    CHECK(index.SelectEvictions(400).empty());
+    CHECK(index.SelectEvictions(1000).empty());
+    CHECK((index.SelectEvictions(399) == std::vector<uint64_t>{ 20 }));
+    // Same last use: lower key first
+    CHECK((index.SelectEvictions(200) == std::vector<uint64_t>{ 20, 30 }));
+    CHECK((index.SelectEvictions(0) == std::vector<uint64_t>{ 20, 30, 40, 10 }));
+
+    // Touch makes an entry the most recent one
+    index.Touch(20, 100, 5);
+    CHECK((index.SelectEvictions(300) == std::vector<uint64_t>{ 30 }));
+
+    index.Remove(30);
+    CHECK(index.GetTotalSize() == 300);
+    CHECK(index.SelectEvictions(300).empty());
+}
+
+TEST_CASE(StoredEntriesLoadBack) {
+    TemporaryDirectory directory("shader_cache_store");
+    std::vector<uint8_t> bytecode{ 1, 2, 3, 4, 5 };
+    {
+        ShaderCache cache(directory.path);
+        CHECK(!cache.Load(7).IsValid());
+        cache.Store(7, bytecode.data(), bytecode.size());
+        auto entry = cache.Load(7);
+        CHECK(entry.IsValid());
+        CHECK(ToVector(entry) == bytecode);
+        CHECK(cache.GetHitsCount() == 1 && cache.GetMissesCount() == 1);
+    }
+
+    // Another instance, as another run or process would see it
+    ShaderCache cache(directory.path);
+    auto entry = cache.Load(7);
+    CHECK(entry.IsValid());
+    CHECK(ToVector(entry) == bytecode);
+    CHECK(!cache.Load(8).IsValid());
+}
+
+TEST_CASE(CorruptedEntryIsMiss) {
+    TemporaryDirectory directory("shader_cache_corrupted");
+    std::vector<uint8_t> bytecode(64, 7);
+    ShaderCache cache(directory.path);
+    cache.Store(7, bytecode.data(), bytecode.size());
+    auto path = directory.path / (shader_cache_details::KeyToString(7) + ".dxbc");
+    CHECK(std::filesystem::exists(path));
+
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(sizeof(shader_cache_details::EntryHeader) + 10);
+        file.put(8);
+    }
+    CHECK(!cache.Load(7).IsValid());
+
+    std::filesystem::resize_file(path, sizeof(shader_cache_details::EntryHeader) - 1);
+    CHECK(!cache.Load(7).IsValid());
+    CHECK(cache.GetMissesCount() == 2 && cache.GetHitsCount() == 0);
+
+    // Entry stored under another key is not accepted for this one
+    cache.Store(8, bytecode.data(), bytecode.size());
+    std::filesystem::copy_file(directory.path / (shader_cache_details::KeyToString(8) + ".dxbc"), path,
+        std::filesystem::copy_options::overwrite_existing);
+    CHECK(!cache.Load(7).IsValid());
+}
+
+TEST_CASE(StoreEvictsOverBudget) {
+    TemporaryDirectory directory("shader_cache_budget");
+    std::vector<uint8_t> bytecode(1000, 1);
+    auto entrySize = sizeof(shader_cache_details::EntryHeader) + bytecode.size();
+    ShaderCache cache(directory.path, entrySize * 2);
+    cache.Store(1, bytecode.data(), bytecode.size());
+    cache.Store(2, bytecode.data(), bytecode.size());
+    cache.Store(3, bytecode.data(), bytecode.size());
+
+    int entriesCount = 0;
+    for (auto& file : std::filesystem::directory_iterator(directory.path)) {
+        entriesCount += file.path().extension() == ".dxbc";
+    }
+    CHECK(entriesCount == 2);
+    CHECK(cache.Load(3).IsValid());
+}
+
+TEST_CASE(CompilerIsCalledOnlyOnMiss) {
+    TemporaryDirectory directory("shader_cache_compiler");
+    int callsCount = 0;
+    StubCompiler compiler{ &callsCount };
+    ShaderCache cache(directory.path);
+
+    auto request = MakeRequest();
+    auto compiled = CompileShaderBytecode(request, compiler, &cache);
+    CHECK(callsCount == 1);
+    CHECK(compiled == compiler(request));
+    callsCount = 0;
+
+    CHECK(CompileShaderBytecode(request, compiler, &cache) == compiled);
+    CHECK(callsCount == 0);
+
+    request.macros[0].value = "0";
+    CHECK(CompileShaderBytecode(request, compiler, &cache) != compiled);
+    CHECK(callsCount == 1);
+
+    // Without a cache every call compiles
+    CompileShaderBytecode(request, compiler, nullptr);
+    CHECK(callsCount == 2);
+}
+
+TEST_CASE(CompilerErrorsAreNotCached) {
+    TemporaryDirectory directory("shader_cache_errors");
+    ShaderCache cache(directory.path);
+    int callsCount = 0;
+    ShaderCompiler failing = [&](const ShaderCompileRequest&) -> std::vector<uint8_t> {
+        ++callsCount;
+        throw std::runtime_error("syntax error");
+    };
+    CHECK_THROWS(CompileShaderBytecode(MakeRequest(), failing, &cache), std::runtime_error);
+    CHECK_THROWS(CompileShaderBytecode(MakeRequest(), failing, &cache), std::runtime_error);
+    CHECK(callsCount == 2);
+}
@@ -0,0 +1,286 @@
+#include <string>
+#include <vector>
+#include "D3D_Tools/StateCache.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    // Stand-ins for D3D objects: only their identity matters to the cache
+    struct Object {
+        int id;
+    };
+
+    std::string Name(const Object* object) {
+        return object ? std::to_string(object->id) : "null";
+    }
+
+    // Records every call the cache makes, one line per call
+    struct RecordingContext {
+        using Shader = Object;
+        using ShaderResource = Object;
+        using Sampler = Object;
+        using Buffer = Object;
+        using InputLayout = Object;
+        using Topology = int;
+        using IndexFormat = int;
+        using BlendState = Object;
+        using DepthStencilState = Object;
+        using RasterizerState = Object;
+
+        static constexpr uint32_t StagesCount = 2;
+        static constexpr uint32_t ShaderResourceSlotsCount = 8;
+        static constexpr uint32_t SamplerSlotsCount = 4;
+        static constexpr uint32_t ConstantBufferSlotsCount = 4;
+        static constexpr uint32_t VertexBufferSlotsCount = 4;
+
+        void SetShader(uint32_t stage, Object* shader) {
+            Record("Shader " + std::to_string(stage) + " " + Name(shader));
+        }
+
+        void SetShaderResources(uint32_t stage, uint32_t startSlot, uint32_t count, Object* const* views) {
+            RecordSlots("ShaderResources", stage, startSlot, count, views);
+        }
+
+        void SetSamplers(uint32_t stage, uint32_t startSlot, uint32_t count, Object* const* samplers) {
+            RecordSlots("Samplers", stage, startSlot, count, samplers);
+        }
+
+        void SetConstantBuffers(uint32_t stage, uint32_t startSlot, uint32_t count, Object* const* buffers) {
+            RecordSlots("ConstantBuffers", stage, startSlot, count, buffers);
+        }
+
+        void SetVertexBuffers(uint32_t startSlot, uint32_t count, Object* const* buffers, const uint32_t* strides, const uint32_t* offsets) {
+            std::string call = "VertexBuffers " + std::to_string(startSlot) + ":";
+            for (uint32_t i = 0; i < count; ++i) {
+                call += " " + Name(buffers[i]) + "/" + std::to_string(strides[i]) + "/" + std::to_string(offsets[i]);
+            }
+            Record(call);
+        }
+
+        void SetIndexBuffer(Object* buffer, int format, uint32_t offset) {
+            Record("IndexBuffer " + Name(buffer) + " " + std::to_string(format) + " " + std::to_string(offset));
+        }
+
+        void SetInputLayout(Object* layout) {
+            Record("InputLayout " + Name(layout));
+        }
+
+        void SetPrimitiveTopology(int topology) {
+            Record("Topology " + std::to_string(topology));
+        }
+
+        void SetBlendState(Object* state, const float* factor, uint32_t sampleMask) {
+            Record("Blend " + Name(state) + " " + std::to_string(factor[0]) + " " + std::to_string(sampleMask));
+        }
+
+        void SetDepthStencilState(Object* state, uint32_t stencilRef) {
+            Record("DepthStencil " + Name(state) + " " + std::to_string(stencilRef));
+        }
+
+        void SetRasterizerState(Object* state) {
+            Record("Rasterizer " + Name(state));
+        }
+
+        void RecordSlots(const char* method, uint32_t stage, uint32_t startSlot, uint32_t count, Object* const* values) {
+            std::string call = std::string(method) + " " + std::to_string(stage) + " " + std::to_string(startSlot) + ":";
+            for (uint32_t i = 0; i < count; ++i) {
+                call += " " + Name(values[i]);
+            }
+            Record(call);
+        }
+
+        void Record(std::string call) {
+            calls.push_back(std::move(call));
+        }
+
+        std::vector<std::string> calls;
+    };
+
+    using Cache = BindingCache<RecordingContext>;
+
+    std::vector<std::string> TakeCalls(Cache& cache) {
+        auto result = std::move(cache.GetContext().calls);
+        cache.GetContext().calls.clear();
+        return result;
+    }
+}
+
+TEST_CASE(RedundantShaderBindsAreFiltered) {
+    Cache cache;
+    Object a{ 1 };
+    Object b{ 2 };
+    cache.SetShader(0, &a);
+    cache.SetShader(0, &a);
+    cache.SetShader(1, &a);
+    cache.SetShader(0, &b);
+    CHECK((TakeCalls(cache) == std::vector<std::string>{ "Shader 0 1", "Shader 1 1", "Shader 0 2" }));
+    CHECK(cache.GetStatistics().issuedBinds == 3);
+    CHECK(cache.GetStatistics().redundantBinds == 1);
+}
+
+TEST_CASE(FirstBindIsIssuedEvenForNull) {
+    // Nothing is known about the context initially, so even null must reach it
+    Cache cache;
+    cache.SetRasterizerState(nullptr);
+    cache.SetRasterizerState(nullptr);
+    CHECK((TakeCalls(cache) == std::vector<std::string>{ "Rasterizer null" }));
+}
+
+TEST_CASE(SlotsAreSentOnFlushAsOneRange) {
+    Cache cache;
+    Object views[3]{ { 1 }, { 2 }, { 3 } };
+    Object* bound[3]{ &views[0], &views[1], &views[2] };
+    cache.SetShaderResources(1, 2, 3, bound);
+    CHECK(TakeCalls(cache).empty());
+
+    cache.Flush();
+    CHECK((TakeCalls(cache) == std::vector<std::string>{ "ShaderResources 1 2: 1 2 3" }));
+
+    cache.SetShaderResources(1, 2, 3, bound);
+    cache.Flush();
+    CHECK(TakeCalls(cache).empty());
+    CHECK(cache.GetStatistics().redundantBinds == 3);
+}
+
+TEST_CASE(ChangeRevertedBeforeFlushIsNotSent) {
+    Cache cache;
+    Object a{ 1 };
+    Object b{ 2 };
+    Object* first = &a;
+    Object* second = &b;
+    cache.SetSamplers(0, 0, 1, &first);
+    cache.Flush();
+    TakeCalls(cache);
+
+    cache.SetSamplers(0, 0, 1, &second);
+    cache.SetSamplers(0, 0, 1, &first);
+    cache.Flush();
+    CHECK(TakeCalls(cache).empty());
+}
+
+TEST_CASE(VertexBuffersAreFlushedWithStridesAndOffsets) {
+    Cache cache;
+    Object a{ 1 };
+    Object b{ 2 };
+    Object* buffers[2]{ &a, &b };
+    uint32_t strides[2]{ 16, 32 };
+    uint32_t offsets[2]{ 0, 64 };
+    cache.SetVertexBuffers(1, 2, buffers, strides, offsets);
+    cache.Flush();
+    CHECK((TakeCalls(cache) == std::vector<std::string>{ "VertexBuffers 1: 1/16/0 2/32/64" }));
+
+    // Same buffer with another offset is a different binding
+    offsets[1] = 128;
+    cache.SetVertexBuffers(1, 2, buffers, strides, offsets);
+    cache.Flush();
+    CHECK((TakeCalls(cache) == std::vector<std::string>{ "VertexBuffers 2: 2/32/128" }));
+}
+
+TEST_CASE(FixedFunctionStateComparesAllParameters) {
+    Cache cache;
+    Object blend{ 1 };
+    Object depth{ 2 };
+    Object buffer{ 3 };
+    float ones[4]{ 1.0f, 1.0f, 1.0f, 1.0f };
+    float halves[4]{ 0.5f, 0.5f, 0.5f, 0.5f };
+
+    cache.SetBlendState(&blend, nullptr, 0xffffffff);
+    // Null factor means ones
+    cache.SetBlendState(&blend, ones, 0xffffffff);
+    cache.SetBlendState(&blend, halves, 0xffffffff);
+    cache.SetDepthStencilState(&depth, 0);
+    cache.SetDepthStencilState(&depth, 1);
+    cache.SetIndexBuffer(&buffer, 57, 0);
+    cache.SetIndexBuffer(&buffer, 57, 0);
+    cache.SetIndexBuffer(&buffer, 42, 0);
+    cache.SetPrimitiveTopology(4);
+    cache.SetPrimitiveTopology(4);
+    CHECK((TakeCalls(cache) == std::vector<std::string>{
+        "Blend 1 1.000000 4294967295",
+        "Blend 1 0.500000 4294967295",
+        "DepthStencil 2 0",
+        "DepthStencil 2 1",
+        "IndexBuffer 3 57 0",
+        "IndexBuffer 3 42 0",
+        "Topology 4" }));
+}
+
+TEST_CASE(InvalidateForgetsWhatIsBound) {
+    Cache cache;
+    Object layout{ 1 };
+    Object view{ 2 };
+    Object* views[1]{ &view };
+    cache.SetInputLayout(&layout);
+    cache.SetConstantBuffers(0, 0, 1, views);
+    cache.Flush();
+    TakeCalls(cache);
+
+    cache.Invalidate();
+    cache.SetInputLayout(&layout);
+    cache.SetConstantBuffers(0, 0, 1, views);
+    cache.Flush();
+    CHECK((TakeCalls(cache) == std::vector<std::string>{ "InputLayout 1", "ConstantBuffers 0 0: 2" }));
+}
+
+TEST_CASE(InvalidateShaderResourcesKeepsOtherState) {
+    Cache cache;
+    Object view{ 1 };
+    Object sampler{ 2 };
+    Object* views[1]{ &view };
+    Object* samplers[1]{ &sampler };
+    cache.SetShaderResources(0, 0, 1, views);
+    cache.SetSamplers(0, 0, 1, samplers);
+    cache.Flush();
+    TakeCalls(cache);
+
+    cache.InvalidateShaderResources();
+    cache.SetShaderResources(0, 0, 1, views);
+    cache.SetSamplers(0, 0, 1, samplers);
+    cache.Flush();
+    CHECK((TakeCalls(cache) == std::vector<std::string>{ "ShaderResources 0 0: 1" }));
+}
+
+TEST_CASE(OutOfRangeSlotsThrow) {
+    Cache cache;
+    Object view{ 1 };
+    Object* views[2]{ &view, &view };
+    CHECK_THROWS(cache.SetShaderResources(0, 7, 2, views), std::out_of_range);
+    CHECK_THROWS(cache.SetShaderResources(2, 0, 1, views), std::out_of_range);
+    CHECK_THROWS(cache.SetShader(2, &view), std::out_of_range);
+}
+
+TEST_CASE(FlushSkipsSlotsWithUnknownDeviceValue) {
+    Cache cache;
+    Object views[4]{ { 1 }, { 2 }, { 3 }, { 4 } };
+    Object* bound[4]{ &views[0], &views[1], &views[2], &views[3] };
+    cache.SetShaderResources(0, 0, 4, bound);
+    cache.Flush();
+    TakeCalls(cache);
+
+    // Slots 1 and 2 may have been changed externally: their cached values must not be sent again
+    cache.Invalidate();
+    Object* first[1]{ &views[3] };
+    Object* last[1]{ &views[0] };
+    cache.SetShaderResources(0, 0, 1, first);
+    cache.SetShaderResources(0, 3, 1, last);
+    cache.Flush();
+    CHECK((TakeCalls(cache) == std::vector<std::string>{ "ShaderResources 0 0: 4", "ShaderResources 0 3: 1" }));
+    CHECK(cache.GetStatistics().issuedBinds == 3);
+}
+
+TEST_CASE(FlushBridgesSlotsKnownToBeBound) {
+    Cache cache;
+    Object views[5]{ { 1 }, { 2 }, { 3 }, { 4 }, { 5 } };
+    Object* bound[4]{ &views[0], &views[1], &views[2], &views[3] };
+    cache.SetShaderResources(0, 0, 4, bound);
+    cache.Flush();
+    TakeCalls(cache);
+
+    // Slots 1 and 2 hold known values, so resending them is harmless and saves a call
+    Object* changed[1]{ &views[4] };
+    cache.SetShaderResources(0, 0, 1, changed);
+    cache.SetShaderResources(0, 3, 1, changed);
+    cache.Flush();
+    CHECK((TakeCalls(cache) == std::vector<std::string>{ "ShaderResources 0 0: 5 2 3 5" }));
+}
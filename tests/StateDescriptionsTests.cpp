@@ -0,0 +1,142 @@
+#include <cstring>
+#include <unordered_set>
+#include <vector>
+#include "D3D_Tools/StateDescriptions.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    // Filled with garbage first, so that padding differs between descriptions
+    template<typename Description>
+    Description Dirty(const Description& desc, int pattern) {
+        Description result;
+        std::memset(&result, pattern, sizeof(result));
+        result = desc;
+        return result;
+    }
+
+    template<typename Description>
+    bool AreSame(const Description& a, const Description& b) {
+        return StateDescriptionEqual()(a, b) && StateDescriptionHash()(a) == StateDescriptionHash()(b);
+    }
+
+    template<typename Description>
+    bool AreDifferent(const Description& a, const Description& b) {
+        return !StateDescriptionEqual()(a, b) && StateDescriptionHash()(a) != StateDescriptionHash()(b);
+    }
+
+    // Equal descriptions must hash equally, whatever pair is taken
+    template<typename Description>
+    bool IsHashConsistent(const std::vector<Description>& descriptions) {
+        for (auto& a : descriptions) {
+            for (auto& b : descriptions) {
+                if (StateDescriptionEqual()(a, b) && StateDescriptionHash()(a) != StateDescriptionHash()(b)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE(NegativeZeroEqualsZero) {
+    auto sampler = MakeDefaultSamplerDescription();
+    auto negative = Dirty(sampler, 0xAB);
+    negative.MipLODBias = -0.0f;
+    negative.BorderColor[0] = 0.0f;
+    sampler.BorderColor[0] = -0.0f;
+    CHECK(AreSame(sampler, negative));
+
+    auto rasterizer = MakeDefaultRasterizerDescription();
+    auto negativeRasterizer = rasterizer;
+    negativeRasterizer.DepthBiasClamp = -0.0f;
+    negativeRasterizer.SlopeScaledDepthBias = -0.0f;
+    CHECK(AreSame(rasterizer, negativeRasterizer));
+
+    negativeRasterizer.SlopeScaledDepthBias = -1.0f;
+    CHECK(AreDifferent(rasterizer, negativeRasterizer));
+}
+
+TEST_CASE(AnyNonZeroBoolIsTrue) {
+    auto rasterizer = MakeDefaultRasterizerDescription();
+    auto other = Dirty(rasterizer, 0x5A);
+    other.DepthClipEnable = 5;
+    CHECK(AreSame(rasterizer, other));
+    other.DepthClipEnable = FALSE;
+    CHECK(AreDifferent(rasterizer, other));
+
+    auto depthStencil = MakeDefaultDepthStencilDescription();
+    auto otherDepthStencil = depthStencil;
+    otherDepthStencil.DepthEnable = -1;
+    CHECK(AreSame(depthStencil, otherDepthStencil));
+
+    auto blend = MakeDefaultBlendDescription();
+    blend.RenderTarget[0].BlendEnable = TRUE;
+    auto otherBlend = blend;
+    otherBlend.RenderTarget[0].BlendEnable = 2;
+    CHECK(AreSame(blend, otherBlend));
+}
+
+TEST_CASE(BlendTargetsPastFirstAreIgnoredWithoutIndependentBlend) {
+    auto blend = MakeDefaultBlendDescription();
+    auto other = blend;
+    other.RenderTarget[3].BlendEnable = TRUE;
+    other.RenderTarget[7].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+    CHECK(AreSame(blend, other));
+
+    other.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+    CHECK(AreDifferent(blend, other));
+
+    blend.IndependentBlendEnable = TRUE;
+    other = blend;
+    other.RenderTarget[7].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+    CHECK(AreDifferent(blend, other));
+}
+
+TEST_CASE(EveryFieldTakesPart) {
+    auto sampler = MakeDefaultSamplerDescription();
+    auto otherSampler = sampler;
+    otherSampler.BorderColor[2] = 0.5f;
+    CHECK(AreDifferent(sampler, otherSampler));
+    otherSampler = sampler;
+    otherSampler.MaxLOD = 4.0f;
+    CHECK(AreDifferent(sampler, otherSampler));
+
+    auto depthStencil = MakeDefaultDepthStencilDescription();
+    auto otherDepthStencil = depthStencil;
+    otherDepthStencil.BackFace.StencilFunc = D3D11_COMPARISON_LESS;
+    CHECK(AreDifferent(depthStencil, otherDepthStencil));
+    otherDepthStencil = depthStencil;
+    otherDepthStencil.StencilWriteMask = 0x0F;
+    CHECK(AreDifferent(depthStencil, otherDepthStencil));
+}
+
+TEST_CASE(HashIsConsistentWithEquality) {
+    std::vector<D3D11_SAMPLER_DESC> samplers;
+    for (int i = 0; i < 32; ++i) {
+        auto desc = Dirty(MakeDefaultSamplerDescription(), i);
+        desc.MaxAnisotropy = i % 4;
+        desc.MipLODBias = i % 3 == 0 ? -0.0f : 0.0f;
+        desc.AddressU = i % 5 == 0 ? D3D11_TEXTURE_ADDRESS_WRAP : D3D11_TEXTURE_ADDRESS_CLAMP;
+        samplers.push_back(desc);
+    }
+    CHECK(IsHashConsistent(samplers));
+
+    std::unordered_set<D3D11_SAMPLER_DESC, StateDescriptionHash, StateDescriptionEqual> uniqueSamplers(samplers.begin(), samplers.end());
+    CHECK(uniqueSamplers.size() == 8);
+
+    std::vector<D3D11_BLEND_DESC> blends;
+    for (int i = 0; i < 16; ++i) {
+        auto desc = MakeDefaultBlendDescription();
+        desc.IndependentBlendEnable = i % 2;
+        desc.RenderTarget[i % 8].BlendEnable = i;
+        blends.push_back(desc);
+    }
+    CHECK(IsHashConsistent(blends));
+
+    std::unordered_set<D3D11_BLEND_DESC, StateDescriptionHash, StateDescriptionEqual> uniqueBlends(blends.begin(), blends.end());
+    // Without independent blend only the first target counts: disabled (i == 0) or enabled (i == 8).
+    // With it odd i enable targets 1, 3, 5 and 7
+    CHECK(uniqueBlends.size() == 2 + 4);
+}
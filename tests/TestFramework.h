@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Minimal self-registering test cases. Every test executable links TestMain.cpp, which runs them all
+namespace d3d_tools_tests {
+    struct TestCase {
+        const char* name;
+        void (*function)();
+    };
+
+    inline std::vector<TestCase>& GetTestCases() {
+        static std::vector<TestCase> testCases;
+        return testCases;
+    }
+
+    struct TestRegistration {
+        TestRegistration(const char* name, void (*function)()) {
+            GetTestCases().push_back(TestCase{ name, function });
+        }
+    };
+
+    class CheckFailure : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    [[noreturn]] inline void Fail(const char* file, int line, const std::string& message) {
+        throw CheckFailure(std::string(file) + ":" + std::to_string(line) + ": " + message);
+    }
+
+    inline int RunTests() {
+        int failed = 0;
+        for (auto& testCase : GetTestCases()) {
+            try {
+                testCase.function();
+                std::printf("[ OK   ] %s\n", testCase.name);
+            } catch (const std::exception& e) {
+                std::printf("[ FAIL ] %s\n    %s\n", testCase.name, e.what());
+                ++failed;
+            }
+        }
+        std::printf("%zu tests, %d failed\n", GetTestCases().size(), failed);
+        return failed == 0 ? 0 : 1;
+    }
+}
+
+#define D3D_TOOLS_TEST_CONCAT_IMPL(a, b) a##b
+#define D3D_TOOLS_TEST_CONCAT(a, b) D3D_TOOLS_TEST_CONCAT_IMPL(a, b)
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static ::d3d_tools_tests::TestRegistration D3D_TOOLS_TEST_CONCAT(name, _registration)(#name, &name); \
+    static void name()
+
+#define CHECK(expression) \
+    do { \
+        if (!(expression)) { \
+            ::d3d_tools_tests::Fail(__FILE__, __LINE__, "CHECK(" #expression ") failed"); \
+        } \
+    } while (false)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do { \
+        auto checkActual = (actual); \
+        auto checkExpected = (expected); \
+        if (!(std::fabs(checkActual - checkExpected) <= (tolerance))) { \
+            ::d3d_tools_tests::Fail(__FILE__, __LINE__, "CHECK_NEAR(" #actual ", " #expected "): " + \
+                std::to_string(checkActual) + " vs " + std::to_string(checkExpected)); \
+        } \
+    } while (false)
+
+#define CHECK_THROWS(expression, exceptionType) \
+    do { \
+        bool checkThrown = false; \
+        try { \
+            (void)(expression); \
+        } catch (const exceptionType&) { \
+            checkThrown = true; \
+        } \
+        if (!checkThrown) { \
+            ::d3d_tools_tests::Fail(__FILE__, __LINE__, "CHECK_THROWS(" #expression ", " #exceptionType ") did not throw"); \
+        } \
+    } while (false)
@@ -0,0 +1,5 @@
+#include "TestFramework.h"
+
+int main() {
+    return d3d_tools_tests::RunTests();
+}
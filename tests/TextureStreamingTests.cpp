@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <map>
+#include <thread>
+#include "D3D_Tools/TextureStreaming.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace {
+    struct RecordingSink : ITextureUploadSink {
+        virtual void BeginTexture(uint64_t id, const StreamedTextureDesc&) override {
+            ++begun[id];
+        }
+
+        virtual void UploadSubresource(uint64_t id, uint32_t, const void* data, uint32_t, uint32_t) override {
+            if (id == throwOnId) {
+                throw std::runtime_error("Upload failed");
+            }
+            if (*static_cast<const uint8_t*>(data) != 7) {
+                throw std::logic_error("Unexpected pixels");
+            }
+            ++uploaded[id];
+        }
+
+        virtual void EndTexture(uint64_t id) override {
+            ++ended[id];
+        }
+
+        virtual void OnLoadFailed(uint64_t id, std::exception_ptr) override {
+            ++failed[id];
+        }
+
+        std::map<uint64_t, int> begun;
+        std::map<uint64_t, int> uploaded;
+        std::map<uint64_t, int> ended;
+        std::map<uint64_t, int> failed;
+        uint64_t throwOnId = 0;
+    };
+
+    // Texture with one subresource per size
+    TextureStreamer::LoadFunction MakeLoad(std::vector<size_t> sizes) {
+        return [sizes](StagingBufferPool& pool) {
+            size_t total = 0;
+            StreamedTexture texture;
+            for (auto size : sizes) {
+                texture.subresources.push_back(StreamedSubresource{ total, size, 0, 0 });
+                total += size;
+            }
+            texture.desc.mipLevels = static_cast<uint32_t>(sizes.size());
+            texture.pixels = pool.Acquire(total);
+            std::fill(texture.pixels.GetData(), texture.pixels.GetData() + total, uint8_t(7));
+            return texture;
+        };
+    }
+
+    size_t PumpAll(TextureStreamer& streamer, ITextureUploadSink& sink, size_t budget) {
+        size_t frames = 0;
+        while (streamer.GetPendingCount() > 0) {
+            auto uploaded = streamer.Pump(sink, budget);
+            if (uploaded > budget) {
+                throw std::logic_error("Budget exceeded");
+            }
+            ++frames;
+            std::this_thread::yield();
+        }
+        return frames;
+    }
+}
+
+TEST_CASE(StagingBuffersAreReused) {
+    StagingBufferPool pool(4096);
+    {
+        auto buffer = pool.Acquire(1000);
+        CHECK(buffer.GetSize() == 1000);
+        CHECK(pool.GetOutstandingBytes() >= 1000);
+    }
+    CHECK(pool.GetOutstandingBytes() == 0);
+    auto buffer = pool.Acquire(500);
+    CHECK(pool.GetAllocationsCount() == 1);
+    CHECK(pool.GetReusesCount() == 1);
+}
+
+TEST_CASE(StagingLimitIsSoft) {
+    StagingBufferPool pool(1000);
+    auto first = pool.Acquire(1000);
+    CHECK(pool.IsOverLimit());
+    // Must not block even though the limit is reached
+    auto second = pool.Acquire(1000);
+    CHECK(pool.GetOutstandingBytes() >= 2000);
+}
+
+TEST_CASE(EveryTextureIsBegunAndEndedOnce) {
+    ThreadPool threadPool(4);
+    RecordingSink sink;
+    {
+        TextureStreamer streamer(threadPool, 4096);
+        for (int i = 0; i < 20; ++i) {
+            // Every other texture has a single subresource, so the budget often runs out right
+            // after a texture is finished and before the next one has uploaded anything
+            streamer.Request(MakeLoad(i % 2 ? std::vector<size_t>{ 800 } : std::vector<size_t>{ 800, 200 }));
+        }
+        PumpAll(streamer, sink, 900);
+    }
+
+    CHECK(sink.ended.size() == 20);
+    for (auto& [id, count] : sink.begun) {
+        CHECK(count == 1);
+        CHECK(sink.ended[id] == 1);
+    }
+}
+
+TEST_CASE(FailedLoadIsReported) {
+    ThreadPool threadPool(2);
+    RecordingSink sink;
+    TextureStreamer streamer(threadPool, 4096);
+    streamer.Request(MakeLoad({ 100 }));
+    auto failing = streamer.Request([](StagingBufferPool&) -> StreamedTexture {
+        throw std::runtime_error("Load failed");
+    });
+    streamer.Request(MakeLoad({ 100 }));
+    PumpAll(streamer, sink, 1000);
+
+    CHECK(sink.failed.size() == 1 && sink.failed[failing] == 1);
+    CHECK(sink.ended.size() == 2);
+    CHECK(sink.begun.count(failing) == 0);
+}
+
+TEST_CASE(ThrowingSinkDropsTheTexture) {
+    ThreadPool threadPool(2);
+    RecordingSink sink;
+    TextureStreamer streamer(threadPool, 4096);
+    streamer.Request(MakeLoad({ 100 }));
+    sink.throwOnId = streamer.Request(MakeLoad({ 100, 100 }));
+    streamer.Request(MakeLoad({ 100 }));
+    PumpAll(streamer, sink, 1000);
+
+    CHECK(sink.failed.size() == 1 && sink.failed[sink.throwOnId] == 1);
+    CHECK(sink.ended.size() == 2 && sink.ended.count(sink.throwOnId) == 0);
+    CHECK(streamer.GetStagingPool().GetOutstandingBytes() == 0);
+}
+
+TEST_CASE(LoadsWaitForStagingMemoryWithoutBlockingWorkers) {
+    ThreadPool threadPool(1);
+    RecordingSink sink;
+    TextureStreamer streamer(threadPool, 1000);
+    for (int i = 0; i < 4; ++i) {
+        streamer.Request(MakeLoad({ 1000 }));
+    }
+
+    // Waiting runs queued loads on this thread: a load that blocked for memory would hang here
+    threadPool.ParallelFor(16, 1, [](size_t, size_t) {});
+    while (streamer.GetStagingPool().GetOutstandingBytes() == 0) {
+        std::this_thread::yield();
+    }
+    // The first load filled staging memory, the others are not started until it is uploaded
+    CHECK(streamer.GetStagingPool().GetAllocationsCount() == 1);
+    CHECK(streamer.GetPendingCount() == 4);
+
+    PumpAll(streamer, sink, 1000);
+    CHECK(sink.ended.size() == 4);
+    CHECK(streamer.GetStagingPool().GetAllocationsCount() == 1);
+}
@@ -0,0 +1,95 @@
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <vector>
+#include "D3D_Tools/ThreadPool.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+TEST_CASE(SubmittedTasksComplete) {
+    ThreadPool pool(4);
+    CHECK(pool.GetThreadsCount() == 4);
+    std::vector<std::future<size_t>> futures;
+    for (size_t i = 0; i < 1000; ++i) {
+        futures.push_back(pool.Submit([i] { return i * i; }));
+    }
+    for (size_t i = 0; i < futures.size(); ++i) {
+        CHECK(pool.Wait(futures[i]) == i * i);
+    }
+}
+
+TEST_CASE(ParallelForVisitsEveryIndexOnce) {
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> visits(10007);
+    pool.ParallelFor(visits.size(), 64, [&](size_t begin, size_t end) {
+        CHECK(begin < end && end <= visits.size());
+        for (auto i = begin; i < end; ++i) {
+            ++visits[i];
+        }
+    });
+    for (auto& count : visits) {
+        CHECK(count == 1);
+    }
+
+    // Zero grain is treated as one
+    std::atomic<size_t> sum{ 0 };
+    pool.ParallelFor(100, 0, [&](size_t begin, size_t end) {
+        CHECK(end == begin + 1);
+        sum += begin;
+    });
+    CHECK(sum == 4950);
+}
+
+TEST_CASE(ParallelForWithoutJobsDoesNothing) {
+    ThreadPool pool(2);
+    bool called = false;
+    pool.ParallelFor(0, 16, [&](size_t, size_t) { called = true; });
+    CHECK(!called);
+    CHECK(!pool.RunPendingTask());
+}
+
+TEST_CASE(ParallelForRethrowsAfterAllChunksFinish) {
+    ThreadPool pool(4);
+    std::atomic<size_t> finished{ 0 };
+    // Thrown from a chunk run on a worker
+    CHECK_THROWS(pool.ParallelFor(64, 1, [&](size_t begin, size_t) {
+        if (begin == 37) {
+            throw std::runtime_error("chunk failed");
+        }
+        ++finished;
+    }), std::runtime_error);
+    CHECK(finished == 63);
+
+    // Thrown from the chunk the caller runs itself
+    finished = 0;
+    CHECK_THROWS(pool.ParallelFor(64, 1, [&](size_t begin, size_t) {
+        if (begin == 0) {
+            throw std::logic_error("first chunk failed");
+        }
+        ++finished;
+    }), std::logic_error);
+    CHECK(finished == 63);
+
+    // The pool is still usable
+    auto future = pool.Submit([] { return 5; });
+    CHECK(pool.Wait(future) == 5);
+}
+
+TEST_CASE(TaskExceptionsGoToFutures) {
+    ThreadPool pool(2);
+    auto future = pool.Submit([]() -> int { throw std::invalid_argument("task failed"); });
+    CHECK_THROWS(pool.Wait(future), std::invalid_argument);
+}
+
+TEST_CASE(NestedParallelForDoesNotDeadlock) {
+    // Every worker waits inside the outer loop, so inner chunks must be run by the waiting threads
+    ThreadPool pool(2);
+    std::atomic<size_t> count{ 0 };
+    pool.ParallelFor(8, 1, [&](size_t, size_t) {
+        pool.ParallelFor(100, 10, [&](size_t begin, size_t end) {
+            count += end - begin;
+        });
+    });
+    CHECK(count == 800);
+}
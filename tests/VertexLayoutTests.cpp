@@ -0,0 +1,141 @@
+#include "D3D_Tools/VertexLayout.h"
+#include "TestFramework.h"
+
+using namespace d3d_tools;
+
+namespace app {
+    struct Vertex {
+        float position[3];
+        float normal[3];
+        float uv[2];
+        uint8_t color[4];
+    };
+
+    D3D_TOOLS_VERTEX_LAYOUT(Vertex,
+        D3D_TOOLS_VERTEX_ELEMENT(Vertex, position, "POSITION", 0),
+        D3D_TOOLS_VERTEX_ELEMENT(Vertex, normal, "NORMAL", 0),
+        D3D_TOOLS_VERTEX_ELEMENT(Vertex, uv, "TEXCOORD", 0),
+        D3D_TOOLS_VERTEX_ELEMENT_AS(Vertex, color, "COLOR", 0, R8_G8_B8_A8_UNORM));
+
+    struct SkinnedVertex {
+        std::array<float, 3> position;
+        std::array<uint16_t, 4> bones;
+        std::array<uint16_t, 4> weights;
+        std::array<float, 2> uv0;
+        std::array<float, 2> uv1;
+    };
+
+    D3D_TOOLS_VERTEX_LAYOUT(SkinnedVertex,
+        D3D_TOOLS_VERTEX_ELEMENT(SkinnedVertex, position, "POSITION", 0),
+        D3D_TOOLS_VERTEX_ELEMENT(SkinnedVertex, bones, "BLENDINDICES", 0),
+        D3D_TOOLS_VERTEX_ELEMENT_AS(SkinnedVertex, weights, "BLENDWEIGHT", 0, R16_G16_B16_A16_UNORM),
+        D3D_TOOLS_VERTEX_ELEMENT(SkinnedVertex, uv0, "TEXCOORD", 0),
+        D3D_TOOLS_VERTEX_ELEMENT(SkinnedVertex, uv1, "TEXCOORD", 1));
+}
+
+// Offsets and formats deduced from the struct
+constexpr auto& vertexLayout = VertexLayoutOf<app::Vertex>;
+static_assert(vertexLayout.ElementsCount == 4);
+static_assert(vertexLayout.stride == 36);
+static_assert(vertexLayout.elements[0].offset == 0 && vertexLayout.elements[0].format == VertexFormat::R32_G32_B32_FLOAT);
+static_assert(vertexLayout.elements[1].offset == 12 && vertexLayout.elements[1].format == VertexFormat::R32_G32_B32_FLOAT);
+static_assert(vertexLayout.elements[2].offset == 24 && vertexLayout.elements[2].format == VertexFormat::R32_G32_FLOAT);
+static_assert(vertexLayout.elements[3].offset == 32 && vertexLayout.elements[3].format == VertexFormat::R8_G8_B8_A8_UNORM);
+
+constexpr auto& skinnedLayout = VertexLayoutOf<app::SkinnedVertex>;
+static_assert(skinnedLayout.stride == 44);
+static_assert(skinnedLayout.elements[1].offset == 12 && skinnedLayout.elements[1].format == VertexFormat::R16_G16_B16_A16_UINT);
+static_assert(skinnedLayout.elements[2].offset == 20 && skinnedLayout.elements[2].format == VertexFormat::R16_G16_B16_A16_UNORM);
+static_assert(skinnedLayout.elements[4].offset == 36 && skinnedLayout.elements[4].semanticIndex == 1);
+
+static_assert(VertexFormatOf<float>::value == VertexFormat::R32_FLOAT);
+static_assert(VertexFormatOf<int32_t[4]>::value == VertexFormat::R32_G32_B32_A32_SINT);
+static_assert(VertexFormatOf<std::array<uint32_t, 2>>::value == VertexFormat::R32_G32_UINT);
+static_assert(VertexFormatOf<uint8_t[4]>::value == VertexFormat::R8_G8_B8_A8_UINT);
+// No such formats
+static_assert(VertexFormatOf<uint16_t[3]>::value == VertexFormat::Unknown);
+static_assert(VertexFormatOf<float[5]>::value == VertexFormat::Unknown);
+static_assert(VertexFormatOf<double>::value == VertexFormat::Unknown);
+
+namespace {
+    using namespace vertex_layout_details;
+
+    struct Pair {
+        float a[3];
+        float b;
+    };
+
+    constexpr VertexElement Element(const char* semantic, uint32_t semanticIndex, VertexFormat format, uint32_t offset, uint32_t size) {
+        return VertexElement{ semantic, semanticIndex, format, offset, size };
+    }
+
+    constexpr auto valid = BuildVertexLayout<Pair>(
+        Element("A", 0, VertexFormat::R32_G32_B32_FLOAT, 0, 12),
+        Element("B", 0, VertexFormat::R32_FLOAT, 12, 4));
+    static_assert(HasKnownFormats(valid) && FormatsMatchMembers(valid) && HasNoOverlaps(valid) && CoversVertex(valid) && HasUniqueSemantics(valid));
+
+    // double member
+    constexpr auto unknownFormat = BuildVertexLayout<Pair>(
+        Element("A", 0, VertexFormat::R32_G32_B32_FLOAT, 0, 12),
+        Element("B", 0, VertexFormat::Unknown, 12, 4));
+    static_assert(!HasKnownFormats(unknownFormat));
+
+    // float3 member read as float2
+    constexpr auto sizeMismatch = BuildVertexLayout<Pair>(
+        Element("A", 0, VertexFormat::R32_G32_FLOAT, 0, 12),
+        Element("B", 0, VertexFormat::R32_FLOAT, 12, 4));
+    static_assert(HasKnownFormats(sizeMismatch) && !FormatsMatchMembers(sizeMismatch));
+
+    constexpr auto overlap = BuildVertexLayout<Pair>(
+        Element("A", 0, VertexFormat::R32_G32_B32_FLOAT, 0, 12),
+        Element("B", 0, VertexFormat::R32_FLOAT, 8, 4));
+    static_assert(!HasNoOverlaps(overlap));
+
+    constexpr auto pastStride = BuildVertexLayout<Pair>(
+        Element("A", 0, VertexFormat::R32_G32_B32_FLOAT, 0, 12),
+        Element("B", 0, VertexFormat::R32_FLOAT, 16, 4));
+    static_assert(!HasNoOverlaps(pastStride));
+
+    constexpr auto forgottenMember = BuildVertexLayout<Pair>(
+        Element("A", 0, VertexFormat::R32_G32_B32_FLOAT, 0, 12));
+    static_assert(HasNoOverlaps(forgottenMember) && !CoversVertex(forgottenMember));
+
+    constexpr auto sameSemantic = BuildVertexLayout<Pair>(
+        Element("A", 0, VertexFormat::R32_G32_B32_FLOAT, 0, 12),
+        Element("A", 0, VertexFormat::R32_FLOAT, 12, 4));
+    static_assert(!HasUniqueSemantics(sameSemantic));
+
+    constexpr auto otherIndex = BuildVertexLayout<Pair>(
+        Element("A", 0, VertexFormat::R32_G32_B32_FLOAT, 0, 12),
+        Element("A", 1, VertexFormat::R32_FLOAT, 12, 4));
+    static_assert(HasUniqueSemantics(otherIndex));
+}
+
+// Same checks at run time, so that a failure is also reported by the test run
+
+TEST_CASE(LayoutIsBuiltFromStruct) {
+    auto& layout = VertexLayoutOf<app::Vertex>;
+    CHECK(layout.stride == sizeof(app::Vertex));
+    CHECK(layout.elements[2].semantic == "TEXCOORD");
+    CHECK(layout.elements[2].size == 8);
+    CHECK(layout.elements[3].offset == 32);
+    CHECK(layout.elements[3].format == VertexFormat::R8_G8_B8_A8_UNORM);
+}
+
+TEST_CASE(FormatSizes) {
+    CHECK(GetVertexFormatSize(VertexFormat::Unknown) == 0);
+    CHECK(GetVertexFormatSize(VertexFormat::R10_G10_B10_A2_UNORM) == 4);
+    CHECK(GetVertexFormatSize(VertexFormat::R16_G16_B16_A16_FLOAT) == 8);
+    CHECK(GetVertexFormatSize(VertexFormat::R32_G32_B32_SINT) == 12);
+    CHECK(GetVertexFormatSize(VertexFormat::R32_G32_B32_A32_UINT) == 16);
+}
+
+TEST_CASE(EveryRuleRejectsItsCase) {
+    CHECK(!HasKnownFormats(unknownFormat));
+    CHECK(!FormatsMatchMembers(sizeMismatch));
+    CHECK(!HasNoOverlaps(overlap));
+    CHECK(!HasNoOverlaps(pastStride));
+    CHECK(!CoversVertex(forgottenMember));
+    CHECK(!HasUniqueSemantics(sameSemantic));
+    CHECK(HasUniqueSemantics(otherIndex));
+}